@@ -0,0 +1,577 @@
+/**
+ * omt_bench_compare — regression gate for the benchmark suite: compares
+ * JSON results against a stored per-machine baseline and fails when a
+ * tracked number got worse by more than its tolerance.
+ *
+ * Understands the --json output of omt_bench_loopback (fan-out fps, CPU per
+ * frame, send → demuxed latency, drops) and omt_bench_decode (demux, decode
+ * and convert time), and Google Benchmark's --benchmark_out JSON from
+ * omt_bench_kernels (time per iteration; the median when run with
+ * repetitions). Each tracked field has a direction and a default tolerance:
+ * a relative limit plus an absolute slack for numbers that are noisy near
+ * zero (latency percentiles). The baseline keeps both per metric, so they can
+ * be tuned by hand for a noisy machine; --update rewrites the values and
+ * keeps the tuning.
+ *
+ * Results from several files for the same metric keep the best value, so
+ * repeated runs (loopback.1.json loopback.2.json ...) absorb scheduler noise.
+ * A baseline only applies to the machine it was recorded on (host name, CPU
+ * model and count); comparing elsewhere is refused unless --any-machine.
+ *
+ *   omt_bench_loopback --res 1080p --fps 60 --receivers 1,4 --json loopback.json
+ *   omt_bench_decode capture.omt --json decode.json
+ *   omt_bench_kernels --benchmark_repetitions=3 --benchmark_out=kernels.json --benchmark_out_format=json
+ *   omt_bench_compare --baseline bench-$(hostname).json --update loopback.json decode.json kernels.json
+ *   omt_bench_compare --baseline bench-$(hostname).json loopback.json decode.json kernels.json
+ *
+ * Exit status: 0 within tolerance, 1 regression, 2 usage / unreadable input
+ * / machine mismatch.
+ */
+#define LOG_TAG "omt_bench_compare"
+#include "omt_log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// ---- Minimal JSON reader (the benchmark outputs and baselines only) ----
+
+struct Json {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members;
+
+    const Json* get(const char* key) const {
+        for (const auto& m : members)
+            if (m.first == key) return &m.second;
+        return nullptr;
+    }
+    double num(const char* key, double fallback = 0) const {
+        const Json* v = get(key);
+        return v && v->type == NUMBER ? v->number : fallback;
+    }
+    std::string str(const char* key) const {
+        const Json* v = get(key);
+        return v && v->type == STRING ? v->string : std::string();
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_p(text.c_str()), m_begin(text.c_str()) {}
+
+    bool parse(Json* out) {
+        if (!value(out, 0)) return false;
+        skipSpace();
+        return *m_p == '\0' || fail("trailing characters");
+    }
+    const char* error() const { return m_error.c_str(); }
+
+private:
+    static constexpr int MAX_DEPTH = 32;
+
+    bool fail(const char* what) {
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "%s at offset %ld", what, (long)(m_p - m_begin));
+        m_error = buf;
+        return false;
+    }
+    void skipSpace() {
+        while (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r') m_p++;
+    }
+    bool literal(const char* word) {
+        const size_t n = std::strlen(word);
+        if (std::strncmp(m_p, word, n) != 0) return fail("bad literal");
+        m_p += n;
+        return true;
+    }
+
+    bool string(std::string* out) {
+        if (*m_p != '"') return fail("expected string");
+        m_p++;
+        out->clear();
+        while (*m_p != '"') {
+            if (!*m_p) return fail("unterminated string");
+            if (*m_p != '\\') { *out += *m_p++; continue; }
+            m_p++;
+            switch (*m_p) {
+            case '"': case '\\': case '/': *out += *m_p; break;
+            case 'b': *out += '\b'; break;
+            case 'f': *out += '\f'; break;
+            case 'n': *out += '\n'; break;
+            case 'r': *out += '\r'; break;
+            case 't': *out += '\t'; break;
+            case 'u': {
+                // Names in these files are ASCII; anything wider becomes '?'.
+                unsigned code = 0;
+                for (int i = 1; i <= 4; i++) {
+                    if (!std::isxdigit((unsigned char)m_p[i])) return fail("bad \\u escape");
+                    code = code * 16 + (unsigned)(std::isdigit((unsigned char)m_p[i]) ? m_p[i] - '0'
+                                                                                      : (m_p[i] | 0x20) - 'a' + 10);
+                }
+                *out += code < 0x80 ? (char)code : '?';
+                m_p += 4;
+                break;
+            }
+            default: return fail("bad escape");
+            }
+            m_p++;
+        }
+        m_p++;
+        return true;
+    }
+
+    bool value(Json* out, int depth) {
+        if (depth > MAX_DEPTH) return fail("nested too deeply");
+        skipSpace();
+        switch (*m_p) {
+        case '{': {
+            out->type = Json::OBJECT;
+            m_p++;
+            skipSpace();
+            if (*m_p == '}') { m_p++; return true; }
+            for (;;) {
+                skipSpace();
+                std::pair<std::string, Json> member;
+                if (!string(&member.first)) return false;
+                skipSpace();
+                if (*m_p++ != ':') return fail("expected ':'");
+                if (!value(&member.second, depth + 1)) return false;
+                out->members.push_back(std::move(member));
+                skipSpace();
+                if (*m_p == ',') { m_p++; continue; }
+                if (*m_p++ == '}') return true;
+                return fail("expected ',' or '}'");
+            }
+        }
+        case '[': {
+            out->type = Json::ARRAY;
+            m_p++;
+            skipSpace();
+            if (*m_p == ']') { m_p++; return true; }
+            for (;;) {
+                out->items.emplace_back();
+                if (!value(&out->items.back(), depth + 1)) return false;
+                skipSpace();
+                if (*m_p == ',') { m_p++; continue; }
+                if (*m_p++ == ']') return true;
+                return fail("expected ',' or ']'");
+            }
+        }
+        case '"':
+            out->type = Json::STRING;
+            return string(&out->string);
+        case 't': out->type = Json::BOOL; out->boolean = true; return literal("true");
+        case 'f': out->type = Json::BOOL; return literal("false");
+        case 'n': return literal("null");
+        default: {
+            char* end = nullptr;
+            out->type = Json::NUMBER;
+            out->number = std::strtod(m_p, &end);
+            if (end == m_p) return fail("unexpected character");
+            m_p = end;
+            return true;
+        }
+        }
+    }
+
+    const char* m_p;
+    const char* m_begin;
+    std::string m_error;
+};
+
+bool readJson(const char* path, Json* out) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        LOGE("cannot read %s", path);
+        return false;
+    }
+    std::string text;
+    char buf[65536];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+    JsonParser parser(text);
+    if (!parser.parse(out)) {
+        LOGE("%s: %s", path, parser.error());
+        return false;
+    }
+    return true;
+}
+
+std::string quoted(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// ---- Tracked metrics ----
+
+enum Better { LOWER, HIGHER };
+
+struct Rule {
+    const char* bench;
+    const char* field;
+    Better better;
+    double tolerancePct; // worse by more than this (relative) ...
+    double slack;        // ... and by more than this (absolute, in the field's unit) fails
+};
+
+// Counts (drops, failed) use no tolerance: any increase over the baseline fails.
+constexpr Rule kRules[] = {
+    { "loopback", "fps_min", HIGHER, 3, 0.5 },
+    { "loopback", "cpu_us_per_frame", LOWER, 15, 5 },
+    { "loopback", "latency_p50_us", LOWER, 25, 100 },
+    { "loopback", "latency_p99_us", LOWER, 50, 500 },
+    { "loopback", "drops", LOWER, 0, 0 },
+    { "decode", "demux_us", LOWER, 15, 1 },
+    { "decode", "decode_us", LOWER, 10, 50 },
+    { "decode", "convert_us", LOWER, 10, 20 },
+    { "decode", "failed", LOWER, 0, 0 },
+    { "kernels", "time_ns", LOWER, 10, 0 },
+};
+
+struct Metric {
+    double value = 0;
+    Better better = LOWER;
+    double tolerancePct = 0;
+    double slack = 0;
+};
+
+using Metrics = std::map<std::string, Metric>;
+
+/** Keep the best value when several result files report the same metric. */
+void addResult(Metrics& out, const std::string& key, const Rule& rule, double value) {
+    auto it = out.find(key);
+    if (it == out.end()) {
+        out[key] = Metric{ value, rule.better, rule.tolerancePct, rule.slack };
+        return;
+    }
+    Metric& m = it->second;
+    m.value = m.better == LOWER ? std::min(m.value, value) : std::max(m.value, value);
+}
+
+/** omt_bench_loopback / omt_bench_decode: {"bench": ..., "results": [{"name": ..., fields...}]}. */
+void collectOmtBench(const Json& doc, const std::string& bench, Metrics& out) {
+    const Json* results = doc.get("results");
+    if (!results || results->type != Json::ARRAY) return;
+    std::string prefix = bench + "/";
+    const std::string payload = doc.str("payload"); // loopback: synthetic or nv12 payloads differ in size
+    if (!payload.empty()) prefix += payload + "/";
+    for (const Json& r : results->items) {
+        const std::string name = r.str("name");
+        if (name.empty()) continue;
+        for (const Rule& rule : kRules) {
+            if (bench != rule.bench) continue;
+            const Json* v = r.get(rule.field);
+            if (v && v->type == Json::NUMBER) addResult(out, prefix + name + "/" + rule.field, rule, v->number);
+        }
+    }
+}
+
+double unitToNs(const std::string& unit) {
+    if (unit == "us") return 1e3;
+    if (unit == "ms") return 1e6;
+    if (unit == "s") return 1e9;
+    return 1;
+}
+
+/**
+ * Google Benchmark output: real time for UseRealTime() cases, CPU time for
+ * the rest. Medians win over single iterations when repetitions were run.
+ */
+void collectGoogleBenchmark(const Json& doc, Metrics& out) {
+    const Json* list = doc.get("benchmarks");
+    const Rule* rule = nullptr;
+    for (const Rule& r : kRules)
+        if (!std::strcmp(r.bench, "kernels")) rule = &r;
+    std::map<std::string, double> medians;
+    Metrics iterations;
+    for (const Json& b : list->items) {
+        const Json* failed = b.get("error_occurred");
+        if (failed && failed->boolean) continue;
+        std::string name = b.str("run_name");
+        if (name.empty()) name = b.str("name");
+        const bool realTime = name.size() > 10 && name.compare(name.size() - 10, 10, "/real_time") == 0;
+        const double ns = b.num(realTime ? "real_time" : "cpu_time") * unitToNs(b.str("time_unit"));
+        const std::string key = "kernels/" + name + "/" + rule->field;
+        if (b.str("run_type") == "aggregate") {
+            if (b.str("aggregate_name") == "median") medians[key] = ns;
+        } else {
+            addResult(iterations, key, *rule, ns);
+        }
+    }
+    for (auto& it : iterations) {
+        auto median = medians.find(it.first);
+        if (median != medians.end()) it.second.value = median->second;
+        addResult(out, it.first, *rule, it.second.value);
+    }
+}
+
+bool collect(const char* path, Metrics& out) {
+    Json doc;
+    if (!readJson(path, &doc)) return false;
+    const Json* list = doc.get("benchmarks");
+    if (list && list->type == Json::ARRAY) {
+        collectGoogleBenchmark(doc, out);
+        return true;
+    }
+    const std::string bench = doc.str("bench");
+    if (bench == "loopback" || bench == "decode") {
+        collectOmtBench(doc, bench, out);
+        return true;
+    }
+    LOGW("%s: no tracked benchmark (\"%s\"); skipped", path, bench.c_str());
+    return true;
+}
+
+// ---- Machine identity ----
+
+struct Machine {
+    std::string host;
+    std::string cpu;
+    int cpus = 0;
+
+    bool operator==(const Machine& o) const { return host == o.host && cpu == o.cpu && cpus == o.cpus; }
+};
+
+Machine thisMachine() {
+    Machine m;
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) == 0) m.host = host;
+    if (FILE* f = std::fopen("/proc/cpuinfo", "r")) {
+        char line[512];
+        std::string implementer, part;
+        while (std::fgets(line, sizeof(line), f)) {
+            char* colon = std::strchr(line, ':');
+            if (!colon) continue;
+            std::string key(line, colon), value(colon + 1);
+            auto trim = [](std::string& s) {
+                while (!s.empty() && std::isspace((unsigned char)s.back())) s.pop_back();
+                s.erase(0, std::min(s.size(), s.find_first_not_of(" \t")));
+            };
+            trim(key);
+            trim(value);
+            // x86 names the model; arm64 only gives implementer and part numbers
+            if (key == "model name" && m.cpu.empty()) m.cpu = value;
+            else if (key == "CPU implementer" && implementer.empty()) implementer = value;
+            else if (key == "CPU part" && part.empty()) part = value;
+        }
+        std::fclose(f);
+        if (m.cpu.empty() && !part.empty()) m.cpu = "arm " + implementer + "/" + part;
+    }
+    m.cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return m;
+}
+
+// ---- Baseline file ----
+
+struct Baseline {
+    Machine machine;
+    std::string updated;
+    Metrics metrics;
+};
+
+bool readBaseline(const char* path, Baseline* out) {
+    Json doc;
+    if (!readJson(path, &doc)) return false;
+    if (const Json* m = doc.get("machine")) {
+        out->machine.host = m->str("host");
+        out->machine.cpu = m->str("cpu");
+        out->machine.cpus = (int)m->num("cpus");
+    }
+    out->updated = doc.str("updated");
+    const Json* metrics = doc.get("metrics");
+    if (!metrics || metrics->type != Json::OBJECT) {
+        LOGE("%s: no \"metrics\" object", path);
+        return false;
+    }
+    for (const auto& entry : metrics->members) {
+        Metric m;
+        m.value = entry.second.num("value");
+        m.better = entry.second.str("better") == "higher" ? HIGHER : LOWER;
+        m.tolerancePct = entry.second.num("tolerance_pct");
+        m.slack = entry.second.num("slack");
+        out->metrics[entry.first] = m;
+    }
+    return true;
+}
+
+bool writeBaseline(const char* path, const Baseline& b) {
+    const std::string tmp = std::string(path) + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "w");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"machine\": {\"host\": %s, \"cpu\": %s, \"cpus\": %d},\n  \"updated\": %s,\n  \"metrics\": {\n",
+                 quoted(b.machine.host).c_str(), quoted(b.machine.cpu).c_str(), b.machine.cpus,
+                 quoted(b.updated).c_str());
+    size_t i = 0;
+    for (const auto& it : b.metrics) {
+        const Metric& m = it.second;
+        std::fprintf(f, "    %s: {\"value\": %.17g, \"better\": \"%s\", \"tolerance_pct\": %g, \"slack\": %g}%s\n",
+                     quoted(it.first).c_str(), m.value, m.better == LOWER ? "lower" : "higher", m.tolerancePct,
+                     m.slack, ++i < b.metrics.size() ? "," : "");
+    }
+    std::fprintf(f, "  }\n}\n");
+    if (std::fclose(f) != 0) return false;
+    return std::rename(tmp.c_str(), path) == 0;
+}
+
+std::string utcNow() {
+    char buf[32];
+    const time_t t = std::time(nullptr);
+    tm utc;
+    gmtime_r(&t, &utc);
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buf;
+}
+
+// ---- Comparison ----
+
+enum Verdict { SAME, FASTER, SLOWER, NEW, MISSING };
+
+/** Worse than the baseline by more than both the relative tolerance and the absolute slack. */
+Verdict judge(const Metric& base, double current, double tolerancePct) {
+    const double worse = base.better == LOWER ? current - base.value : base.value - current;
+    const double limit = std::max(std::fabs(base.value) * tolerancePct / 100, base.slack);
+    if (worse > limit) return SLOWER;
+    if (-worse > limit && -worse > 0) return FASTER;
+    return SAME;
+}
+
+const char* verdictName(Verdict v) {
+    switch (v) {
+    case SAME: return "ok";
+    case FASTER: return "better";
+    case SLOWER: return "FAIL";
+    case NEW: return "new";
+    case MISSING: return "not run";
+    }
+    return "?";
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: omt_bench_compare --baseline FILE [--update] [--tolerance PCT] [--any-machine] [--quiet]\n"
+        "                         results.json...\n"
+        "       results: omt_bench_loopback/omt_bench_decode --json, omt_bench_kernels --benchmark_out\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* baselinePath = nullptr;
+    bool update = false;
+    bool anyMachine = false;
+    bool quiet = false;
+    double tolerance = -1; // < 0: per-metric tolerances from the baseline
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--baseline") && hasValue) baselinePath = argv[++i];
+        else if (!std::strcmp(a, "--update")) update = true;
+        else if (!std::strcmp(a, "--tolerance") && hasValue) tolerance = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--any-machine")) anyMachine = true;
+        else if (!std::strcmp(a, "--quiet")) quiet = true;
+        else if (a[0] == '-') { usage(); return 2; }
+        else files.push_back(a);
+    }
+    if (!baselinePath || files.empty()) { usage(); return 2; }
+
+    Metrics current;
+    for (const char* path : files)
+        if (!collect(path, current)) return 2;
+    if (current.empty()) {
+        LOGE("no tracked metrics in the results");
+        return 2;
+    }
+
+    const Machine machine = thisMachine();
+    Baseline baseline;
+    const bool haveBaseline = access(baselinePath, F_OK) == 0;
+    if (haveBaseline && !readBaseline(baselinePath, &baseline)) return 2;
+
+    if (update) {
+        // New values; per-metric tolerances edited into the file survive.
+        for (const auto& it : current) {
+            auto old = baseline.metrics.find(it.first);
+            Metric m = it.second;
+            if (old != baseline.metrics.end()) {
+                m.tolerancePct = old->second.tolerancePct;
+                m.slack = old->second.slack;
+            }
+            baseline.metrics[it.first] = m;
+        }
+        baseline.machine = machine;
+        baseline.updated = utcNow();
+        if (!writeBaseline(baselinePath, baseline)) {
+            LOGE("cannot write %s", baselinePath);
+            return 2;
+        }
+        std::printf("[compare] baseline %s: %zu metrics recorded for %s (%s, %d CPUs)\n", baselinePath,
+                    current.size(), machine.host.c_str(), machine.cpu.c_str(), machine.cpus);
+        return 0;
+    }
+
+    if (!haveBaseline) {
+        LOGE("no baseline at %s; record one with --update", baselinePath);
+        return 2;
+    }
+    if (!(baseline.machine == machine)) {
+        LOGW("baseline is from %s (%s, %d CPUs), this is %s (%s, %d CPUs)", baseline.machine.host.c_str(),
+             baseline.machine.cpu.c_str(), baseline.machine.cpus, machine.host.c_str(), machine.cpu.c_str(),
+             machine.cpus);
+        if (!anyMachine) {
+            LOGE("baselines are per machine; record one here or pass --any-machine");
+            return 2;
+        }
+    }
+
+    int counts[MISSING + 1] = {};
+    std::printf("%-7s %-60s %12s %12s %8s %8s\n", "status", "metric", "baseline", "current", "delta", "limit");
+    auto row = [&](Verdict v, const std::string& key, const Metric* base, const double* value, double tol) {
+        counts[v]++;
+        if (quiet && (v == SAME || v == MISSING)) return;
+        char baseText[24] = "-", curText[24] = "-", delta[16] = "-", limit[16] = "-";
+        if (base) {
+            std::snprintf(baseText, sizeof(baseText), "%.6g", base->value);
+            std::snprintf(limit, sizeof(limit), "%s%.0f%%", base->better == LOWER ? "+" : "-", tol);
+        }
+        if (value) std::snprintf(curText, sizeof(curText), "%.6g", *value);
+        if (base && value && base->value != 0)
+            std::snprintf(delta, sizeof(delta), "%+.1f%%", (*value / base->value - 1) * 100);
+        std::printf("%-7s %-60s %12s %12s %8s %8s\n", verdictName(v), key.c_str(), baseText, curText, delta, limit);
+    };
+    for (const auto& it : baseline.metrics) {
+        auto cur = current.find(it.first);
+        const double tol = tolerance >= 0 ? tolerance : it.second.tolerancePct;
+        if (cur == current.end()) row(MISSING, it.first, &it.second, nullptr, tol);
+        else row(judge(it.second, cur->second.value, tol), it.first, &it.second, &cur->second.value, tol);
+    }
+    for (const auto& it : current)
+        if (!baseline.metrics.count(it.first)) row(NEW, it.first, nullptr, &it.second.value, 0);
+
+    std::printf("[compare] %d ok, %d better, %d regressed, %d new, %d not run (baseline %s)\n", counts[SAME],
+                counts[FASTER], counts[SLOWER], counts[NEW], counts[MISSING],
+                baseline.updated.empty() ? "undated" : baseline.updated.c_str());
+    if (counts[FASTER] > 0) std::printf("[compare] improvements beyond tolerance: refresh the baseline with --update\n");
+    return counts[SLOWER] > 0 ? 1 : 0;
+}
@@ -0,0 +1,477 @@
+/**
+ * Offline decode-throughput benchmark: replays captured OMT byte streams
+ * through the receiver's demux → decode → convert stages as fast as the
+ * CPU allows, so decoder-side changes can be compared on the same data.
+ *
+ * A capture is the raw byte stream a subscriber reads off the socket
+ * (headers included), recorded from vMix, the app or any OMT source:
+ *
+ *   ./omt_bench_decode --capture 192.168.1.50 --seconds 10 camera.omt
+ *   ./omt_bench_decode --synth 1280x720,1920x1080,3840x2160 --codec vmx1,nv12 synth.omt
+ *   ./omt_bench_decode camera.omt synth.omt --min-seconds 5 --json decode.json
+ *
+ * Replay reports, per codec and resolution found in the stream, frames per
+ * second and the mean / p99 time of each stage: demux (the chunked copy
+ * recv would do plus frame parsing), decode (VMX1 → BGRA; NV12 needs none)
+ * and convert (BGRA → RGBA swap, or NV12 → RGBA). VMX1 needs libvmx — the
+ * host stub unless OMT_LIBVMX points at the real library.
+ */
+#define LOG_TAG "omt_bench_decode"
+#include "omt_demux.h"
+#include "omt_histogram.h"
+#include "omt_log.h"
+#include "omt_net.h"
+#include "omt_pixel.h"
+#include "omt_protocol.h"
+#include "omt_vmx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+    std::vector<const char*> files;
+    double minSeconds = 2;
+    size_t chunk = 256u << 10; // bytes handed to the demuxer per "recv"
+    int threads = 0;           // VMX decoder threads; 0 keeps the library default
+    const char* jsonPath = nullptr;
+    // --capture
+    const char* captureHost = nullptr;
+    int capturePort = 6500;
+    double captureSeconds = 10;
+    bool captureAudio = false;
+    // --synth
+    std::vector<std::pair<int, int>> synthSizes;
+    std::vector<uint32_t> synthCodecs;
+    int synthFrames = 120;
+};
+
+const char* codecName(uint32_t codec) {
+    switch (codec) {
+        case CODEC_VMX1: return "VMX1";
+        case CODEC_NV12: return "NV12";
+        case CODEC_FPA1: return "FPA1";
+        default: return "????";
+    }
+}
+
+// ---- Replay ----
+
+struct Group {
+    uint32_t codec;
+    int width, height;
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t failed = 0;
+    uint64_t decodeNs = 0;
+    uint64_t convertNs = 0;
+    LatencyHistogram decode;
+    LatencyHistogram convert;
+    std::vector<uint8_t> rgba;
+    void* vmx = nullptr;
+};
+
+struct Replay {
+    std::map<std::tuple<uint32_t, int, int>, std::unique_ptr<Group>> groups;
+    Group* last = nullptr;
+    uint64_t totalBytes = 0;
+    uint64_t videoFrames = 0;
+    uint64_t otherFrames = 0;
+    uint64_t skipped = 0;      // video we cannot decode (unknown codec, no libvmx)
+    uint64_t demuxNs = 0;
+    uint64_t callbackNs = 0;   // time inside onFrame, subtracted from demux
+    int threads = 0;
+
+    ~Replay() {
+        for (auto& g : groups) vmxDestroy(g.second->vmx);
+    }
+
+    Group* groupFor(uint32_t codec, int w, int h) {
+        if (last && last->codec == codec && last->width == w && last->height == h) return last;
+        auto& g = groups[std::make_tuple(codec, w, h)];
+        if (!g) {
+            g = std::make_unique<Group>();
+            g->codec = codec;
+            g->width = w;
+            g->height = h;
+            g->rgba.resize((size_t)w * h * 4);
+        }
+        return last = g.get();
+    }
+
+    void onFrame(const FrameHeader& h, const uint8_t* data, size_t len) {
+        if (h.type != FRAME_VIDEO || len < (size_t)VIDEO_EXT_HEADER_SIZE) {
+            otherFrames++;
+            return;
+        }
+        int64_t start = nowNs();
+        VideoHeader vh;
+        parseVideoHeader(data, &vh);
+        const uint8_t* payload = data + VIDEO_EXT_HEADER_SIZE;
+        size_t payloadLen = len - VIDEO_EXT_HEADER_SIZE;
+        videoFrames++;
+        if (vh.width <= 0 || vh.height <= 0 || vh.width > 8192 || vh.height > 8192 ||
+            (vh.codec != CODEC_VMX1 && vh.codec != CODEC_NV12) ||
+            (vh.codec == CODEC_VMX1 && !vmxCanDecode())) {
+            skipped++;
+            callbackNs += nowNs() - start;
+            return;
+        }
+        Group* g = groupFor(vh.codec, vh.width, vh.height);
+        g->frames++;
+        g->bytes += len;
+        int64_t t0 = nowNs(), t1 = t0;
+        bool ok;
+        if (vh.codec == CODEC_VMX1) {
+            if (!g->vmx) g->vmx = vmxCreate(vh.width, vh.height, threads, "decoder");
+            ok = g->vmx && vmxDecodeBgra(g->vmx, payload, (int)payloadLen, g->rgba.data(), vh.width, vh.height);
+            t1 = nowNs();
+            if (ok) swapBgraToRgba(g->rgba.data(), (size_t)vh.width * vh.height);
+        } else {
+            size_t ySize = (size_t)vh.width * vh.height;
+            ok = payloadLen >= ySize + ySize / 2;
+            if (ok) nv12ToRgba(payload, vh.width, payload + ySize, vh.width,
+                               g->rgba.data(), vh.width * 4, vh.width, vh.height);
+        }
+        int64_t t2 = nowNs();
+        if (!ok) {
+            g->failed++;
+        } else {
+            if (vh.codec == CODEC_VMX1) {
+                g->decode.record((uint64_t)(t1 - t0));
+                g->decodeNs += (uint64_t)(t1 - t0);
+            }
+            g->convert.record((uint64_t)(t2 - t1));
+            g->convertNs += (uint64_t)(t2 - t1);
+        }
+        callbackNs += (uint64_t)(t2 - start);
+    }
+
+    /** One pass over a capture; false if the stream is corrupt. */
+    bool pass(const uint8_t* data, size_t size, size_t chunk, Demuxer& demux) {
+        demux.reset();
+        size_t offset = 0;
+        while (offset < size) {
+            int64_t t0 = nowNs();
+            uint64_t cb0 = callbackNs;
+            size_t avail;
+            uint8_t* dst = demux.writable(&avail);
+            size_t n = std::min({ avail, chunk, size - offset });
+            std::memcpy(dst, data + offset, n);
+            bool ok = demux.commit(n, [this](const FrameHeader& h, const uint8_t* p, size_t len) {
+                onFrame(h, p, len);
+            });
+            demuxNs += (uint64_t)(nowNs() - t0) - (callbackNs - cb0);
+            offset += n;
+            if (!ok) return false;
+        }
+        totalBytes += size;
+        if (demux.pending() > 0) LOGW("capture ends mid-frame (%zu bytes ignored)", demux.pending());
+        return true;
+    }
+};
+
+struct Mapped {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    bool open(const char* path) {
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        data = (const uint8_t*)p;
+        size = (size_t)st.st_size;
+        return true;
+    }
+    ~Mapped() { if (data) munmap((void*)data, size); }
+};
+
+int runReplay(const Options& opt) {
+    Replay replay;
+    replay.threads = opt.threads;
+    std::vector<std::unique_ptr<Mapped>> files;
+    for (const char* path : opt.files) {
+        auto m = std::make_unique<Mapped>();
+        if (!m->open(path)) {
+            LOGE("cannot map %s", path);
+            return 1;
+        }
+        files.push_back(std::move(m));
+    }
+    // Largest frame in any capture bounds the demux buffer; 64 MB covers 8K NV12.
+    Demuxer demux(64u << 20);
+    int64_t start = nowNs();
+    int passes = 0;
+    do {
+        for (size_t i = 0; i < files.size(); i++) {
+            if (!replay.pass(files[i]->data, files[i]->size, opt.chunk, demux)) {
+                LOGE("%s: corrupt OMT stream at frame %llu", opt.files[i],
+                     (unsigned long long)demux.framesParsed());
+                return 1;
+            }
+        }
+        passes++;
+    } while (!s_stop.load() && (nowNs() - start) < (int64_t)(opt.minSeconds * 1e9));
+    double wall = (nowNs() - start) / 1e9;
+
+    std::printf("%d pass(es), %.1f MB, %llu video frames (%llu skipped), %llu other frames in %.2f s\n",
+                passes, replay.totalBytes / 1e6, (unsigned long long)replay.videoFrames,
+                (unsigned long long)replay.skipped, (unsigned long long)replay.otherFrames, wall);
+    double demuxNsPerByte = replay.totalBytes ? (double)replay.demuxNs / replay.totalBytes : 0;
+    std::printf("demux %.0f MB/s\n\n", demuxNsPerByte > 0 ? 1e3 / demuxNsPerByte : 0.0);
+    std::printf("%-16s %8s %9s %9s %11s %11s %11s %11s %7s\n", "stream", "frames", "fps", "demux us",
+                "decode us", "decode p99", "convert us", "convert p99", "failed");
+
+    FILE* json = nullptr;
+    if (opt.jsonPath) {
+        json = std::fopen(opt.jsonPath, "w");
+        if (!json) {
+            LOGE("cannot write %s", opt.jsonPath);
+            return 1;
+        }
+        std::fprintf(json, "{\n  \"bench\": \"decode\",\n  \"results\": [\n");
+    }
+    size_t index = 0;
+    for (auto& entry : replay.groups) {
+        Group& g = *entry.second;
+        char name[48];
+        std::snprintf(name, sizeof(name), "%s %dx%d", codecName(g.codec), g.width, g.height);
+        uint64_t ok = g.frames - g.failed;
+        double demuxUs = g.frames ? demuxNsPerByte * g.bytes / g.frames / 1e3 : 0;
+        double decodeUs = ok ? g.decodeNs / 1e3 / ok : 0;
+        double convertUs = ok ? g.convertNs / 1e3 / ok : 0;
+        double perFrameUs = demuxUs + decodeUs + convertUs;
+        double fps = perFrameUs > 0 ? 1e6 / perFrameUs : 0;
+        HistogramSnapshot dec = g.decode.snapshot(), conv = g.convert.snapshot();
+        std::printf("%-16s %8llu %9.1f %9.1f %11.1f %11.1f %11.1f %11.1f %7llu\n", name,
+                    (unsigned long long)g.frames, fps, demuxUs, decodeUs, dec.p99 / 1e3, convertUs,
+                    conv.p99 / 1e3, (unsigned long long)g.failed);
+        if (json) {
+            std::fprintf(json,
+                "    {\"name\": \"%s_%dx%d\", \"codec\": \"%s\", \"width\": %d, \"height\": %d, "
+                "\"frames\": %llu, \"failed\": %llu, \"fps\": %.2f, \"demux_us\": %.2f, "
+                "\"decode_us\": %.2f, \"decode_p99_us\": %.2f, \"convert_us\": %.2f, "
+                "\"convert_p99_us\": %.2f}%s\n",
+                codecName(g.codec), g.width, g.height, codecName(g.codec), g.width, g.height,
+                (unsigned long long)g.frames, (unsigned long long)g.failed, fps, demuxUs, decodeUs,
+                dec.p99 / 1e3, convertUs, conv.p99 / 1e3, ++index < replay.groups.size() ? "," : "");
+        }
+    }
+    if (json) {
+        std::fprintf(json, "  ]\n}\n");
+        if (std::fclose(json) != 0) return 1;
+    }
+    if (replay.groups.empty()) {
+        LOGE("no decodable video in the capture(s)");
+        return 1;
+    }
+    return 0;
+}
+
+// ---- Capture ----
+
+int runCapture(const Options& opt, const char* outPath) {
+    FILE* out = std::fopen(outPath, "wb");
+    if (!out) {
+        LOGE("cannot write %s", outPath);
+        return 1;
+    }
+    int fd = tcpConnect(opt.captureHost, opt.capturePort, 3000);
+    if (fd < 0) {
+        std::fclose(out);
+        return 1;
+    }
+    static const char kSubVideo[] = "<OMTSubscribe Video=\"true\" />";
+    static const char kSubAudio[] = "<OMTSubscribe Audio=\"true\" />";
+    if (!sendMetadata(fd, kSubVideo, sizeof(kSubVideo) - 1) ||
+        (opt.captureAudio && !sendMetadata(fd, kSubAudio, sizeof(kSubAudio) - 1))) {
+        LOGE("Subscribe failed");
+        close(fd);
+        std::fclose(out);
+        return 1;
+    }
+    timeval tv{ 0, 200000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    std::vector<uint8_t> buf(1u << 20);
+    uint64_t total = 0;
+    int64_t end = nowNs() + (int64_t)(opt.captureSeconds * 1e9);
+    int rc = 0;
+    while (!s_stop.load() && nowNs() < end) {
+        ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+        if (n > 0) {
+            if (std::fwrite(buf.data(), 1, (size_t)n, out) != (size_t)n) { rc = 1; break; }
+            total += (uint64_t)n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+        LOGW("source closed the connection");
+        break;
+    }
+    close(fd);
+    if (std::fclose(out) != 0) rc = 1;
+    std::printf("captured %.1f MB to %s\n", total / 1e6, outPath);
+    return rc;
+}
+
+// ---- Synthetic capture ----
+
+int runSynth(const Options& opt, const char* outPath) {
+    FILE* out = std::fopen(outPath, "wb");
+    if (!out) {
+        LOGE("cannot write %s", outPath);
+        return 1;
+    }
+    int rc = 0;
+    uint64_t frames = 0;
+    for (auto size : opt.synthSizes) {
+        const int w = size.first, h = size.second;
+        std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2));
+        for (uint32_t codec : opt.synthCodecs) {
+            void* enc = nullptr;
+            if (codec == CODEC_VMX1 && !(enc = vmxCreate(w, h, 0, "encoder"))) {
+                LOGE("VMX encoder unavailable for %dx%d", w, h);
+                rc = 1;
+                continue;
+            }
+            size_t maxPayload = y.size() + uv.size();
+            std::vector<uint8_t> frame(HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + maxPayload);
+            for (int f = 0; f < opt.synthFrames && rc == 0; f++) {
+                // Moving diagonal ramps with a little noise, so the codec has texture to chew on.
+                uint32_t x = 0x9E3779B9u * (uint32_t)(f + 1);
+                for (int r = 0; r < h; r++)
+                    for (int c = 0; c < w; c++) {
+                        x = x * 1664525u + 1013904223u;
+                        y[(size_t)r * w + c] = (uint8_t)(16 + ((r + c + f * 4) % 220) + (x >> 30));
+                    }
+                for (int r = 0; r < h / 2; r++)
+                    for (int c = 0; c < w; c += 2) {
+                        uv[(size_t)r * w + c] = (uint8_t)(128 + ((c + f * 2) % 64) - 32);
+                        uv[(size_t)r * w + c + 1] = (uint8_t)(128 + ((r + f) % 64) - 32);
+                    }
+                uint8_t* payload = frame.data() + HEADER_SIZE + VIDEO_EXT_HEADER_SIZE;
+                int len;
+                if (codec == CODEC_VMX1) {
+                    len = vmxEncode(enc, y.data(), w, uv.data(), w, payload, (int)maxPayload);
+                    if (len <= 0) { LOGE("VMX encode failed"); rc = 1; break; }
+                } else {
+                    std::memcpy(payload, y.data(), y.size());
+                    std::memcpy(payload + y.size(), uv.data(), uv.size());
+                    len = (int)maxPayload;
+                }
+                FrameHeader fh;
+                fh.type = FRAME_VIDEO;
+                fh.timestamp = (int64_t)f * 10000000 / 60;
+                fh.dataLength = VIDEO_EXT_HEADER_SIZE + len;
+                VideoHeader vh;
+                vh.codec = codec;
+                vh.width = w;
+                vh.height = h;
+                vh.frameRateN = 60;
+                writeFrameHeader(frame.data(), fh);
+                writeVideoHeader(frame.data() + HEADER_SIZE, vh);
+                size_t total = HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + (size_t)len;
+                if (std::fwrite(frame.data(), 1, total, out) != total) rc = 1;
+                frames++;
+            }
+            vmxDestroy(enc);
+        }
+    }
+    if (std::fclose(out) != 0) rc = 1;
+    if (rc == 0) std::printf("wrote %llu synthetic frames to %s\n", (unsigned long long)frames, outPath);
+    return rc;
+}
+
+bool parseSizes(const char* s, std::vector<std::pair<int, int>>& out) {
+    for (const char* p = s; p && *p; p = std::strchr(p, ',') ? std::strchr(p, ',') + 1 : nullptr) {
+        int w, h;
+        if (std::sscanf(p, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0 || (w | h) & 1) return false;
+        out.emplace_back(w, h);
+    }
+    return !out.empty();
+}
+
+bool parseCodecs(const char* s, std::vector<uint32_t>& out) {
+    for (const char* p = s; p && *p; p = std::strchr(p, ',') ? std::strchr(p, ',') + 1 : nullptr) {
+        if (!strncasecmp(p, "vmx", 3)) out.push_back(CODEC_VMX1);
+        else if (!strncasecmp(p, "nv12", 4)) out.push_back(CODEC_NV12);
+        else return false;
+    }
+    return !out.empty();
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: omt_bench_decode [--min-seconds s] [--chunk bytes] [--threads n] [--json path] capture.omt...\n"
+        "       omt_bench_decode --capture <host> [--port p] [--seconds s] [--audio] out.omt\n"
+        "       omt_bench_decode --synth WxH[,WxH...] [--codec vmx1,nv12] [--frames n] out.omt\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--min-seconds") && hasValue) opt.minSeconds = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--chunk") && hasValue) opt.chunk = (size_t)std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(a, "--threads") && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--json") && hasValue) opt.jsonPath = argv[++i];
+        else if (!std::strcmp(a, "--capture") && hasValue) opt.captureHost = argv[++i];
+        else if (!std::strcmp(a, "--port") && hasValue) opt.capturePort = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--seconds") && hasValue) opt.captureSeconds = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--audio")) opt.captureAudio = true;
+        else if (!std::strcmp(a, "--synth") && hasValue) {
+            if (!parseSizes(argv[++i], opt.synthSizes)) { usage(); return 2; }
+        }
+        else if (!std::strcmp(a, "--codec") && hasValue) {
+            if (!parseCodecs(argv[++i], opt.synthCodecs)) { usage(); return 2; }
+        }
+        else if (!std::strcmp(a, "--frames") && hasValue) opt.synthFrames = std::atoi(argv[++i]);
+        else if (a[0] == '-') { usage(); return 2; }
+        else opt.files.push_back(a);
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    if (opt.captureHost || !opt.synthSizes.empty()) {
+        if (opt.files.size() != 1) { usage(); return 2; }
+        if (opt.captureHost) return runCapture(opt, opt.files[0]);
+        if (opt.synthCodecs.empty()) opt.synthCodecs = { CODEC_VMX1, CODEC_NV12 };
+        return runSynth(opt, opt.files[0]);
+    }
+    if (opt.files.empty()) { usage(); return 2; }
+    return runReplay(opt);
+}
@@ -0,0 +1,294 @@
+/**
+ * Google Benchmark suite for the omt_core pixel kernels.
+ * Each case runs at 540p, 1080p and 4K and reports throughput as MPix/s (the "MPix" rate counter).
+ *
+ *   ./omt_bench_kernels --benchmark_filter=Nv12ToRgba
+ */
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "omt_lz4.h"
+#include "omt_pattern.h"
+#include "omt_pixel.h"
+#include "omt_quality.h"
+#include "omt_vmx.h"
+
+namespace {
+
+struct Resolution { int width; int height; };
+
+constexpr Resolution kResolutions[] = { { 960, 540 }, { 1920, 1080 }, { 3840, 2160 } };
+
+void applyResolutions(benchmark::internal::Benchmark* b) {
+    for (const auto& r : kResolutions) b->Args({ r.width, r.height });
+    b->ArgNames({ "w", "h" });
+}
+
+void fillPattern(std::vector<uint8_t>& buf) {
+    uint32_t x = 0x12345678u;
+    for (auto& v : buf) { x = x * 1664525u + 1013904223u; v = (uint8_t)(x >> 24); }
+}
+
+void setThroughput(benchmark::State& state, int width, int height) {
+    state.counters["MPix"] = benchmark::Counter(
+        (double)state.iterations() * width * height / 1e6, benchmark::Counter::kIsRate);
+    state.SetBytesProcessed((int64_t)state.iterations() * width * height * 3 / 2);
+}
+
+void BM_Nv12ToRgba(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2)), dst((size_t)w * h * 4);
+    fillPattern(y); fillPattern(uv);
+    for (auto _ : state) {
+        omt::nv12ToRgba(y.data(), w, uv.data(), w, dst.data(), w * 4, w, h);
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, w, h);
+}
+
+void BM_SwapBgraToRgba(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    std::vector<uint8_t> buf((size_t)w * h * 4);
+    fillPattern(buf);
+    for (auto _ : state) {
+        omt::swapBgraToRgba(buf.data(), (size_t)w * h);
+        benchmark::DoNotOptimize(buf.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, w, h);
+}
+
+/** CameraX semi-planar layout: padded rows, U/V views interleaved with pixel stride 2. */
+void BM_PackNv12SemiPlanar(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    const int rowStride = (w + 63) & ~63;
+    std::vector<uint8_t> srcY((size_t)rowStride * h), srcUV((size_t)rowStride * (h / 2) + 1);
+    std::vector<uint8_t> dstY((size_t)w * h), dstUV((size_t)w * (h / 2));
+    fillPattern(srcY); fillPattern(srcUV);
+    for (auto _ : state) {
+        omt::packNv12(srcY.data(), rowStride,
+                      srcUV.data(), rowStride, 2, srcUV.data() + 1, rowStride, 2,
+                      dstY.data(), dstUV.data(), w, h);
+        benchmark::DoNotOptimize(dstUV.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, w, h);
+}
+
+/** Fully planar I420 source (pixel stride 1) that must be interleaved. */
+void BM_PackNv12Planar(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    std::vector<uint8_t> srcY((size_t)w * h), srcU((size_t)(w / 2) * (h / 2)), srcV(srcU.size());
+    std::vector<uint8_t> dstY((size_t)w * h), dstUV((size_t)w * (h / 2));
+    fillPattern(srcY); fillPattern(srcU); fillPattern(srcV);
+    for (auto _ : state) {
+        omt::packNv12(srcY.data(), w, srcU.data(), w / 2, 1, srcV.data(), w / 2, 1,
+                      dstY.data(), dstUV.data(), w, h);
+        benchmark::DoNotOptimize(dstUV.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, w, h);
+}
+
+/** Downscale to one third in each dimension (e.g. 1080p → 360p proxy). */
+void BM_ScaleNv12Third(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    const int dw = (w / 3) & ~1, dh = (h / 3) & ~1;
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2));
+    std::vector<uint8_t> dy((size_t)dw * dh), duv((size_t)dw * (dh / 2));
+    fillPattern(y); fillPattern(uv);
+    for (auto _ : state) {
+        omt::scaleNv12(y.data(), w, uv.data(), w, w, h, dy.data(), duv.data(), dw, dh);
+        benchmark::DoNotOptimize(dy.data());
+        benchmark::ClobberMemory();
+    }
+    // Throughput is counted in source pixels so resolutions compare directly
+    setThroughput(state, w, h);
+}
+
+/** Encode through whatever libvmx.so loads (the vmx_stub stand-in on Linux hosts). */
+void BM_VmxEncode(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    void* enc = omt::vmxCreate(w, h, 0);
+    if (!enc) { state.SkipWithError("libvmx not available"); return; }
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2)), out((size_t)w * h * 2);
+    fillPattern(y); fillPattern(uv);
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        int n = omt::vmxEncode(enc, y.data(), w, uv.data(), w, out.data(), (int)out.size());
+        if (n < 0) { state.SkipWithError("encode failed"); break; }
+        bytes += n;
+    }
+    omt::vmxDestroy(enc);
+    setThroughput(state, w, h);
+    state.counters["KB/frame"] = state.iterations() ? (double)bytes / state.iterations() / 1024 : 0;
+}
+
+void BM_VmxDecodeRgba(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    void* enc = omt::vmxCreate(w, h, 0);
+    void* dec = omt::vmxCanDecode() ? omt::vmxCreate(w, h, 0, "decoder") : nullptr;
+    if (!enc || !dec) {
+        omt::vmxDestroy(enc);
+        state.SkipWithError("libvmx decode not available");
+        return;
+    }
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2)), out((size_t)w * h * 2), rgba((size_t)w * h * 4);
+    fillPattern(y); fillPattern(uv);
+    int len = omt::vmxEncode(enc, y.data(), w, uv.data(), w, out.data(), (int)out.size());
+    for (auto _ : state) {
+        if (!omt::vmxDecodeRgba(dec, out.data(), len, rgba.data(), w, h)) { state.SkipWithError("decode failed"); break; }
+        benchmark::DoNotOptimize(rgba.data());
+    }
+    omt::vmxDestroy(dec);
+    omt::vmxDestroy(enc);
+    setThroughput(state, w, h);
+}
+
+/** Test-pattern render (omt_pattern) plus counter overlay into a tight NV12 frame; arg 2 is the PatternKind. */
+void BM_TestPattern(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    const auto kind = (omt::PatternKind)state.range(2);
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2));
+    omt::TestPattern pattern;
+    pattern.configure(w, h);
+    uint64_t n = 0;
+    for (auto _ : state) {
+        pattern.render(kind, n, y.data(), w, uv.data(), w);
+        pattern.drawCounter(n++, y.data(), w, uv.data(), w);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, w, h);
+    state.SetLabel(omt::patternName(kind));
+}
+
+/** PSNR + SSIM of all three planes (omt_quality) between two NV12 frames; the label names the kernels. */
+void BM_QualityNv12(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2)), y2(y.size()), uv2(uv.size());
+    fillPattern(y); fillPattern(uv);
+    for (size_t i = 0; i < y.size(); i++) y2[i] = (uint8_t)(y[i] ^ (i & 3));
+    for (size_t i = 0; i < uv.size(); i++) uv2[i] = (uint8_t)(uv[i] ^ (i & 1));
+    omt::QualityMeter meter;
+    meter.configure(w, h);
+    omt::QualityResult q;
+    for (auto _ : state) {
+        meter.measureNv12(y.data(), w, uv.data(), w, y2.data(), w, uv2.data(), w, &q);
+        benchmark::DoNotOptimize(q);
+    }
+    setThroughput(state, w, h);
+    state.SetLabel(omt::qualityKernelName());
+}
+
+/**
+ * VMX encode → decode round trip of a test pattern (arg 2 is the PatternKind) with its quality:
+ * PSNR/SSIM counters per plane next to KB/frame, for encoder tuning.
+ */
+void BM_VmxRoundTripQuality(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1);
+    const auto kind = (omt::PatternKind)state.range(2);
+    void* enc = omt::vmxCreate(w, h, 0);
+    void* dec = omt::vmxCanDecode() ? omt::vmxCreate(w, h, 0, "decoder") : nullptr;
+    if (!enc || !dec) {
+        omt::vmxDestroy(enc);
+        state.SkipWithError("libvmx decode not available");
+        return;
+    }
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2));
+    omt::TestPattern pattern;
+    pattern.configure(w, h);
+    pattern.render(kind, 0, y.data(), w, uv.data(), w);
+    omt::QualityMeter meter;
+    meter.configure(w, h);
+    omt::QualityResult q;
+    int bytes = 0;
+    for (auto _ : state) {
+        if (!meter.roundTrip(enc, dec, y.data(), w, uv.data(), w, &q, &bytes)) { state.SkipWithError("round trip failed"); break; }
+    }
+    omt::vmxDestroy(dec);
+    omt::vmxDestroy(enc);
+    setThroughput(state, w, h);
+    state.counters["PSNR"] = q.psnr;
+    state.counters["PSNR_Y"] = q.y.psnr;
+    state.counters["PSNR_Cb"] = q.cb.psnr;
+    state.counters["PSNR_Cr"] = q.cr.psnr;
+    state.counters["SSIM"] = q.ssim;
+    state.counters["KB/frame"] = bytes / 1024.0;
+    state.SetLabel(omt::patternName(kind));
+}
+
+/** Test pattern for the NVLZ cases: a PatternKind, or kNvlzNoise for incompressible planes. */
+constexpr int kNvlzNoise = 3;
+
+void renderNvlzSource(int kind, int w, int h, std::vector<uint8_t>& y, std::vector<uint8_t>& uv) {
+    if (kind == kNvlzNoise) {
+        fillPattern(y); fillPattern(uv);
+        return;
+    }
+    omt::TestPattern pattern;
+    pattern.configure(w, h);
+    pattern.render((omt::PatternKind)kind, 0, y.data(), w, uv.data(), w);
+}
+
+/** NVLZ compression (omt_lz4) of one NV12 frame; arg 2 is the pattern, "ratio" the raw / packed size. */
+void BM_NvlzPack(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1), kind = (int)state.range(2);
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2)), out(omt::nvlzBound(w, h));
+    renderNvlzSource(kind, w, h, y, uv);
+    omt::Lz4Compressor lz;
+    int bytes = 0;
+    for (auto _ : state) {
+        bytes = omt::packNvlz(lz, y.data(), uv.data(), w, h, out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    setThroughput(state, w, h);
+    state.counters["ratio"] = (double)(y.size() + uv.size()) / bytes;
+    state.SetLabel(kind == kNvlzNoise ? "noise" : omt::patternName((omt::PatternKind)kind));
+}
+
+void BM_NvlzUnpack(benchmark::State& state) {
+    const int w = (int)state.range(0), h = (int)state.range(1), kind = (int)state.range(2);
+    std::vector<uint8_t> y((size_t)w * h), uv((size_t)w * (h / 2)), packed(omt::nvlzBound(w, h));
+    renderNvlzSource(kind, w, h, y, uv);
+    omt::Lz4Compressor lz;
+    const int bytes = omt::packNvlz(lz, y.data(), uv.data(), w, h, packed.data(), packed.size());
+    for (auto _ : state) {
+        if (!omt::unpackNvlz(packed.data(), (size_t)bytes, w, h, y.data(), uv.data())) {
+            state.SkipWithError("unpack failed");
+            break;
+        }
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, w, h);
+    state.SetLabel(kind == kNvlzNoise ? "noise" : omt::patternName((omt::PatternKind)kind));
+}
+
+} // namespace
+
+BENCHMARK(BM_Nv12ToRgba)->Apply(applyResolutions)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SwapBgraToRgba)->Apply(applyResolutions)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PackNv12SemiPlanar)->Apply(applyResolutions)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PackNv12Planar)->Apply(applyResolutions)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ScaleNv12Third)->Apply(applyResolutions)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_VmxEncode)->Apply(applyResolutions)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_VmxDecodeRgba)->Apply(applyResolutions)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_TestPattern)
+    ->ArgsProduct({ { 3840 }, { 2160 }, { omt::PATTERN_BARS, omt::PATTERN_ZONE_PLATE, omt::PATTERN_RAMP } })
+    ->ArgNames({ "w", "h", "kind" })->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_QualityNv12)->Apply(applyResolutions)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_VmxRoundTripQuality)
+    ->ArgsProduct({ { 1920 }, { 1080 }, { omt::PATTERN_BARS, omt::PATTERN_ZONE_PLATE, omt::PATTERN_RAMP } })
+    ->ArgNames({ "w", "h", "kind" })->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_NvlzPack)
+    ->ArgsProduct({ { 1920 }, { 1080 }, { omt::PATTERN_BARS, omt::PATTERN_ZONE_PLATE, omt::PATTERN_RAMP, kNvlzNoise } })
+    ->ArgNames({ "w", "h", "kind" })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_NvlzUnpack)
+    ->ArgsProduct({ { 1920 }, { 1080 }, { omt::PATTERN_BARS, omt::PATTERN_ZONE_PLATE, omt::PATTERN_RAMP, kNvlzNoise } })
+    ->ArgNames({ "w", "h", "kind" })->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
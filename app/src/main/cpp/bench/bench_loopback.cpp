@@ -0,0 +1,401 @@
+/**
+ * Loopback end-to-end benchmark: the native sender core and N native
+ * receivers in one process over 127.0.0.1, fed paced synthetic frames.
+ * Exercises framing, fan-out (pooled packets, per-client queues, drop
+ * policy) and demux without a camera or a network in the way.
+ *
+ * For each resolution × frame rate × receiver count it reports sustained
+ * fps (slowest and mean receiver), process CPU per produced frame, RSS and
+ * send → demuxed latency percentiles; `--json` writes the same numbers for
+ * the regression gate. `--loop epoll,uring` runs every case on each EventLoop
+ * backend (sender and receivers alike) and adds context switches per frame
+ * and, for io_uring, io_uring_enter calls per frame to compare them by.
+ *
+ *   ./omt_bench_loopback                              # full matrix
+ *   ./omt_bench_loopback --res 1080p --fps 60 --receivers 1,4,16 --seconds 5
+ *   ./omt_bench_loopback --raw --res 720p             # uncompressed NV12 payloads
+ *   ./omt_bench_loopback --res 1080p --fps 60 --loop epoll,uring
+ */
+#define LOG_TAG "omt_bench_loopback"
+#include "omt_histogram.h"
+#include "omt_log.h"
+#include "omt_loop.h"
+#include "omt_receiver.h"
+#include "omt_sender.h"
+#include "omt_stats.h"
+#include "omt_uring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <strings.h>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Resolution { const char* name; int width; int height; };
+
+constexpr Resolution kResolutions[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "4k", 3840, 2160 } };
+
+struct Options {
+    std::vector<Resolution> resolutions;
+    std::vector<int> fps;
+    std::vector<int> receivers;
+    std::vector<LoopBackend> loops;
+    double seconds = 3;
+    double warmupSeconds = 0.5;
+    double bitsPerPixel = 2.0; // synthetic VMX-sized payloads; ignored with --raw
+    bool raw = false;
+    int queueDepth = 2;
+    const char* jsonPath = nullptr;
+};
+
+struct Result {
+    std::string name;
+    int width, height, fps, receivers;
+    LoopBackend loop;
+    size_t frameBytes;
+    double fpsMin, fpsMean, producedFps;
+    double cpuUsPerFrame, cpuPercent;
+    double switchesPerFrame, entersPerFrame;
+    double rssMb, peakRssMb;
+    HistogramSnapshot latency;
+    uint64_t drops;
+};
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+double cpuSeconds() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+uint64_t contextSwitches() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t)(ru.ru_nvcsw + ru.ru_nivcsw);
+}
+
+// io_uring_enter calls of the receivers' and the sender's loop so far (0 on epoll).
+uint64_t uringEnters(const EventLoop& rxLoop, const Sender& sender) {
+    uint64_t n = rxLoop.uring() ? rxLoop.uring()->enterCalls() : 0;
+    if (const EventLoop* tx = sender.eventLoop(); tx && tx->uring()) n += tx->uring()->enterCalls();
+    return n;
+}
+
+double rssMb() {
+    long pages = 0, resident = 0;
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(f);
+    }
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+double peakRssMb() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss / 1024.0;
+}
+
+size_t frameBytesFor(const Options& opt, const Resolution& res) {
+    return opt.raw ? (size_t)res.width * res.height * 3 / 2
+                   : (size_t)(res.width * (double)res.height * opt.bitsPerPixel / 8);
+}
+
+struct RxState {
+    std::unique_ptr<Receiver> receiver;
+    std::atomic<uint64_t> frames{0};
+};
+
+bool runCase(const Options& opt, const Resolution& res, int fps, int receivers, LoopBackend loop, Result* out) {
+    statsReset();
+    SenderConfig sc;
+    sc.loop = loop;
+    sc.port = 0;
+    sc.bindAddress = "127.0.0.1";
+    sc.queueDepth = opt.queueDepth;
+    sc.frameBytesHint = HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + frameBytesFor(opt, res);
+    Sender sender(sc);
+    if (!sender.start()) return false;
+
+    // Receivers all share one loop thread, like a multiview client would.
+    EventLoop rxLoop(loop);
+    if (rxLoop.backend() != loop) {
+        LOGE("%s backend unavailable", loopBackendName(loop));
+        sender.stop();
+        return false;
+    }
+    LatencyHistogram latency;
+    std::vector<RxState> rx(receivers);
+    for (auto& r : rx) {
+        ReceiverConfig rc;
+        rc.port = sender.port();
+        RxState* state = &r;
+        r.receiver = std::make_unique<Receiver>(rxLoop, rc,
+            [state, &latency](const FrameHeader& h, const uint8_t*, size_t) {
+                if (h.type != FRAME_VIDEO) return;
+                state->frames.fetch_add(1, std::memory_order_relaxed);
+                latency.record((uint64_t)std::max<int64_t>(0, nowNs() - h.timestamp * 100));
+            });
+        if (!r.receiver->connect()) {
+            sender.stop();
+            return false;
+        }
+    }
+    auto subscribeDeadline = Clock::now() + std::chrono::seconds(2);
+    while (sender.videoClientCount() < receivers && Clock::now() < subscribeDeadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (sender.videoClientCount() < receivers) {
+        LOGE("only %d of %d receivers subscribed", sender.videoClientCount(), receivers);
+        sender.stop();
+        return false;
+    }
+    std::thread rxThread([&rxLoop] { rxLoop.run(); });
+
+    VideoHeader vh;
+    vh.codec = opt.raw ? CODEC_NV12 : CODEC_VMX1;
+    vh.width = res.width;
+    vh.height = res.height;
+    vh.frameRateN = fps;
+    vh.frameRateD = 1;
+    size_t frameBytes = frameBytesFor(opt, res);
+    std::vector<uint8_t> payload(frameBytes);
+    uint32_t x = 0x12345678u;
+    for (auto& v : payload) { x = x * 1664525u + 1013904223u; v = (uint8_t)(x >> 24); }
+
+    const auto period = std::chrono::nanoseconds(1000000000LL / fps);
+    const auto start = Clock::now();
+    const auto measureStart = start + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double>(opt.warmupSeconds));
+    const auto end = measureStart + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(opt.seconds));
+    auto next = start;
+    bool measuring = false;
+    double cpuStart = 0;
+    uint64_t producedStart = 0, produced = 0, dropsStart = 0, switchesStart = 0, entersStart = 0;
+    std::vector<uint64_t> rxStart(receivers);
+    while (true) {
+        std::this_thread::sleep_until(next);
+        auto now = Clock::now();
+        if (now >= end) break;
+        if (!measuring && now >= measureStart) {
+            measuring = true;
+            for (int i = 0; i < receivers; i++) rxStart[i] = rx[i].frames.load(std::memory_order_relaxed);
+            latency.reset();
+            cpuStart = cpuSeconds();
+            switchesStart = contextSwitches();
+            entersStart = uringEnters(rxLoop, sender);
+            producedStart = produced;
+            dropsStart = statsDropCount(DROP_SLOW_CLIENT);
+        }
+        Packet* p = sender.beginVideo(frameBytes);
+        uint8_t* dst = p->payload() + VIDEO_EXT_HEADER_SIZE;
+        std::memcpy(dst, payload.data(), frameBytes);
+        putU64(dst, produced);
+        sender.publishVideo(p, vh, nowNs() / 100, frameBytes);
+        produced++;
+        next += period;
+        // Behind schedule (the producer was starved): resync instead of bursting.
+        if (next < now - period) next = now;
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - measureStart).count();
+    double cpu = cpuSeconds() - cpuStart;
+    const uint64_t switches = contextSwitches() - switchesStart;
+    const uint64_t enters = uringEnters(rxLoop, sender) - entersStart;
+    uint64_t producedInWindow = produced - producedStart;
+
+    double fpsMin = 1e18, fpsSum = 0;
+    for (int i = 0; i < receivers; i++) {
+        double f = (rx[i].frames.load(std::memory_order_relaxed) - rxStart[i]) / elapsed;
+        fpsMin = std::min(fpsMin, f);
+        fpsSum += f;
+    }
+
+    out->name = std::string(res.name) + "@" + std::to_string(fps) + "x" + std::to_string(receivers);
+    if (loop == LoopBackend::URING) out->name += "/uring"; // epoll keeps the names baselines know
+    out->width = res.width;
+    out->height = res.height;
+    out->fps = fps;
+    out->receivers = receivers;
+    out->loop = loop;
+    out->frameBytes = frameBytes;
+    out->fpsMin = fpsMin;
+    out->fpsMean = fpsSum / receivers;
+    out->producedFps = producedInWindow / elapsed;
+    out->cpuUsPerFrame = producedInWindow ? cpu * 1e6 / producedInWindow : 0;
+    out->cpuPercent = cpu * 100 / elapsed;
+    out->switchesPerFrame = producedInWindow ? (double)switches / producedInWindow : 0;
+    out->entersPerFrame = producedInWindow ? (double)enters / producedInWindow : 0;
+    out->rssMb = rssMb();
+    out->peakRssMb = peakRssMb();
+    out->latency = latency.snapshot();
+    out->drops = statsDropCount(DROP_SLOW_CLIENT) - dropsStart;
+
+    rxLoop.stop();
+    rxThread.join();
+    rx.clear();
+    sender.stop();
+    return true;
+}
+
+void printHeader() {
+    std::printf("%-22s %9s %8s %8s %8s %10s %6s %8s %8s %8s %9s %9s %9s %9s %7s\n",
+                "case", "frame KB", "fps tgt", "fps min", "fps avg", "cpu us/fr", "cpu %",
+                "csw/fr", "enter/fr", "rss MB", "p50 ms", "p99 ms", "p99.9 ms", "max ms", "drops");
+}
+
+void printResult(const Result& r) {
+    std::printf("%-22s %9.1f %8d %8.1f %8.1f %10.1f %6.1f %8.2f %8.2f %8.1f %9.3f %9.3f %9.3f %9.3f %7llu\n",
+                r.name.c_str(), r.frameBytes / 1024.0, r.fps, r.fpsMin, r.fpsMean, r.cpuUsPerFrame,
+                r.cpuPercent, r.switchesPerFrame, r.entersPerFrame, r.rssMb, r.latency.p50 / 1e6, r.latency.p99 / 1e6, r.latency.p999 / 1e6,
+                r.latency.max / 1e6, (unsigned long long)r.drops);
+    std::fflush(stdout);
+}
+
+bool writeJson(const char* path, const Options& opt, const std::vector<Result>& results) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"bench\": \"loopback\",\n  \"payload\": \"%s\",\n  \"results\": [\n",
+                 opt.raw ? "nv12" : "synthetic");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::fprintf(f,
+            "    {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"fps_target\": %d, \"receivers\": %d, "
+            "\"loop\": \"%s\", \"frame_bytes\": %zu, \"fps_min\": %.2f, \"fps_mean\": %.2f, \"fps_produced\": %.2f, "
+            "\"cpu_us_per_frame\": %.2f, \"cpu_percent\": %.2f, \"context_switches_per_frame\": %.2f, "
+            "\"uring_enters_per_frame\": %.2f, \"rss_mb\": %.2f, \"peak_rss_mb\": %.2f, "
+            "\"latency_p50_us\": %.1f, \"latency_p99_us\": %.1f, \"latency_p999_us\": %.1f, "
+            "\"latency_max_us\": %.1f, \"drops\": %llu}%s\n",
+            r.name.c_str(), r.width, r.height, r.fps, r.receivers, loopBackendName(r.loop), r.frameBytes, r.fpsMin,
+            r.fpsMean, r.producedFps, r.cpuUsPerFrame, r.cpuPercent, r.switchesPerFrame, r.entersPerFrame, r.rssMb, r.peakRssMb, r.latency.p50 / 1e3,
+            r.latency.p99 / 1e3, r.latency.p999 / 1e3, r.latency.max / 1e3,
+            (unsigned long long)r.drops, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+std::vector<int> parseInts(const char* s) {
+    std::vector<int> v;
+    for (const char* p = s; *p;) {
+        v.push_back(std::atoi(p));
+        p = std::strchr(p, ',');
+        if (!p) break;
+        p++;
+    }
+    return v;
+}
+
+bool parseResolutions(const char* s, std::vector<Resolution>& out) {
+    std::string list(s);
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        std::string name = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        auto it = std::find_if(std::begin(kResolutions), std::end(kResolutions),
+                               [&](const Resolution& r) { return strcasecmp(r.name, name.c_str()) == 0; });
+        if (it == std::end(kResolutions)) return false;
+        out.push_back(*it);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return true;
+}
+
+bool parseLoops(const char* s, std::vector<LoopBackend>& out) {
+    std::string list(s);
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        std::string name = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        if (strcasecmp(name.c_str(), "epoll") == 0) out.push_back(LoopBackend::EPOLL);
+        else if (strcasecmp(name.c_str(), "uring") == 0 || strcasecmp(name.c_str(), "io_uring") == 0) out.push_back(LoopBackend::URING);
+        else return false;
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return true;
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: omt_bench_loopback [--res 720p,1080p,4k] [--fps 30,60,120] [--receivers 1,4,16]\n"
+        "                          [--seconds s] [--warmup s] [--bpp bits] [--raw] [--queue n]\n"
+        "                          [--loop epoll,uring] [--json path]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--res") && hasValue) {
+            if (!parseResolutions(argv[++i], opt.resolutions)) { usage(); return 2; }
+        }
+        else if (!std::strcmp(a, "--fps") && hasValue) opt.fps = parseInts(argv[++i]);
+        else if (!std::strcmp(a, "--receivers") && hasValue) opt.receivers = parseInts(argv[++i]);
+        else if (!std::strcmp(a, "--seconds") && hasValue) opt.seconds = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--warmup") && hasValue) opt.warmupSeconds = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--bpp") && hasValue) opt.bitsPerPixel = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--queue") && hasValue) opt.queueDepth = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--json") && hasValue) opt.jsonPath = argv[++i];
+        else if (!std::strcmp(a, "--loop") && hasValue) {
+            if (!parseLoops(argv[++i], opt.loops)) { usage(); return 2; }
+        }
+        else if (!std::strcmp(a, "--raw")) opt.raw = true;
+        else { usage(); return 2; }
+    }
+    if (opt.resolutions.empty()) opt.resolutions.assign(std::begin(kResolutions), std::end(kResolutions));
+    if (opt.fps.empty()) opt.fps = { 30, 60, 120 };
+    if (opt.receivers.empty()) opt.receivers = { 1, 4, 16 };
+    if (opt.loops.empty()) opt.loops = { defaultLoopBackend() };
+    for (LoopBackend loop : opt.loops) {
+        if (loop == LoopBackend::URING && !uringSupported()) {
+            LOGE("io_uring is not available here");
+            return 1;
+        }
+    }
+    for (int f : opt.fps) if (f <= 0) { usage(); return 2; }
+    for (int n : opt.receivers) if (n < 1 || n > 64) { usage(); return 2; }
+
+    std::vector<Result> results;
+    printHeader();
+    for (const auto& res : opt.resolutions) {
+        for (int fps : opt.fps) {
+            for (int n : opt.receivers) {
+                for (LoopBackend loop : opt.loops) {
+                    Result r;
+                    if (!runCase(opt, res, fps, n, loop, &r)) {
+                        LOGE("%s@%dx%d (%s) failed", res.name, fps, n, loopBackendName(loop));
+                        return 1;
+                    }
+                    printResult(r);
+                    results.push_back(r);
+                }
+            }
+        }
+    }
+    if (opt.jsonPath && !writeJson(opt.jsonPath, opt, results)) {
+        LOGE("cannot write %s", opt.jsonPath);
+        return 1;
+    }
+    return 0;
+}
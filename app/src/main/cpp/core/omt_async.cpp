@@ -0,0 +1,175 @@
+#define LOG_TAG "OmtAsync"
+#include "omt_async.h"
+#include "omt_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace omt {
+
+namespace {
+
+detail::Detached runDetached(Task<void> task) {
+    co_await task;
+}
+
+} // namespace
+
+void spawn(Task<void> task) {
+    runDetached(std::move(task));
+}
+
+// ---- AsyncFd ----
+
+AsyncFd::AsyncFd(EventLoop& loop, int fd) : m_loop(loop), m_fd(fd) {
+    if (m_fd < 0) return;
+    const int flags = fcntl(m_fd, F_GETFL);
+    if (flags >= 0 && !(flags & O_NONBLOCK)) fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+    m_registered = m_loop.add(m_fd, 0, [this](uint32_t events) { onEvents(events); });
+    if (!m_registered) LOGW("Cannot watch fd %d", m_fd);
+}
+
+AsyncFd::~AsyncFd() {
+    close();
+}
+
+bool AsyncFd::attempt(Op& op) {
+    if (m_fd < 0) {
+        op.result = -ECANCELED;
+        return true;
+    }
+    for (;;) {
+        ssize_t n;
+        switch (op.kind) {
+        case Op::RECV:
+            n = ::recv(m_fd, op.data, op.length, MSG_DONTWAIT);
+            break;
+        case Op::SEND_ALL:
+            if (op.done == op.length) {
+                op.result = (ssize_t)op.done;
+                return true;
+            }
+            n = ::send(m_fd, op.data + op.done, op.length - op.done, MSG_DONTWAIT | MSG_NOSIGNAL);
+            break;
+        case Op::ACCEPT:
+            n = ::accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            break;
+        default:
+            op.result = -EINVAL;
+            return true;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+            // ECONNABORTED and friends only lose that one connection.
+            if (op.kind == Op::ACCEPT && (errno == ECONNABORTED || errno == EPROTO)) continue;
+            op.result = -errno;
+            return true;
+        }
+        if (op.kind != Op::SEND_ALL) {
+            op.result = n;
+            return true;
+        }
+        op.done += (size_t)n;
+    }
+}
+
+void AsyncFd::park(Op& op, std::coroutine_handle<> h) {
+    op.waiter = h;
+    if (op.kind == Op::SEND_ALL) m_writer = &op;
+    else m_reader = &op;
+    if (!m_registered) {
+        // Nothing will ever report readiness: fail it on the next turn rather than hang.
+        m_loop.post([this, &op] {
+            if ((op.kind == Op::SEND_ALL ? m_writer : m_reader) != &op) return;
+            (op.kind == Op::SEND_ALL ? m_writer : m_reader) = nullptr;
+            op.result = -EBADF;
+            op.waiter.resume();
+        });
+        return;
+    }
+    updateEvents();
+}
+
+void AsyncFd::updateEvents() {
+    const uint32_t events = (m_reader ? (uint32_t)LOOP_READ : 0u) | (m_writer ? (uint32_t)LOOP_WRITE : 0u);
+    if (events == m_events || !m_registered) return;
+    m_events = events;
+    m_loop.modify(m_fd, events);
+}
+
+void AsyncFd::onEvents(uint32_t events) {
+    const bool failed = events & (LOOP_ERROR | LOOP_HANGUP);
+    Op* done[2] = {};
+    if (m_reader && (failed || (events & LOOP_READ)) && attempt(*m_reader)) done[0] = std::exchange(m_reader, nullptr);
+    if (m_writer && (failed || (events & LOOP_WRITE)) && attempt(*m_writer)) done[1] = std::exchange(m_writer, nullptr);
+    updateEvents();
+    // The first coroutine resumed may close or free this; the second's result is already in its frame.
+    for (Op* op : done) {
+        if (op) op->waiter.resume();
+    }
+}
+
+void AsyncFd::close() {
+    if (m_fd < 0) return;
+    if (m_registered) m_loop.remove(m_fd);
+    m_registered = false;
+    ::close(m_fd);
+    m_fd = -1;
+    m_events = 0;
+    Op* reader = std::exchange(m_reader, nullptr);
+    Op* writer = std::exchange(m_writer, nullptr);
+    for (Op* op : {reader, writer}) {
+        if (!op) continue;
+        op->result = -ECANCELED;
+        op->waiter.resume();
+    }
+}
+
+// ---- LoopPool ----
+
+LoopPool::LoopPool(int threads, LoopBackend backend) {
+    for (int i = 0; i < std::max(threads, 1); i++) m_loops.push_back(std::make_unique<EventLoop>(backend));
+}
+
+LoopPool::~LoopPool() {
+    stop();
+}
+
+bool LoopPool::valid() const {
+    for (const auto& loop : m_loops) {
+        if (!loop->valid()) return false;
+    }
+    return true;
+}
+
+EventLoop& LoopPool::next() {
+    return *m_loops[m_next.fetch_add(1, std::memory_order_relaxed) % m_loops.size()];
+}
+
+void LoopPool::start() {
+    if (!m_threads.empty()) return;
+    for (size_t i = 0; i < m_loops.size(); i++) {
+        m_threads.emplace_back([this, i] {
+            char name[16];
+            std::snprintf(name, sizeof(name), "OmtLoop-%zu", i);
+            pthread_setname_np(pthread_self(), name);
+            m_loops[i]->run();
+        });
+    }
+}
+
+void LoopPool::stop() {
+    if (m_threads.empty()) return;
+    for (auto& loop : m_loops) loop->stop();
+    for (auto& t : m_threads) t.join();
+    m_threads.clear();
+}
+
+} // namespace omt
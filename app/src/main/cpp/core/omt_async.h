@@ -0,0 +1,291 @@
+/**
+ * C++20 coroutines on the EventLoop, for connection handling written as
+ * straight-line code instead of callbacks and state machines.
+ *
+ *   Task<T>    lazy coroutine; co_await runs it and resumes the caller when it
+ *              returns (symmetric transfer, so long chains do not grow the stack)
+ *   spawn()    starts a Task<void> detached; its frame frees itself at the end
+ *   AsyncFd    a non-blocking socket on one loop: co_await recv(), sendAll()
+ *              and accept() suspend until the fd is ready, then do the syscall
+ *   sleepFor() resumes after a delay, on the loop's timers
+ *   AsyncEvent single-waiter signal between coroutines on the same loop
+ *   LoopPool   a handful of loops, one thread each; schedule(loop) moves the
+ *              awaiting coroutine onto another one
+ *
+ * Everything resumes on the loop thread that owns the fd or timer, and no
+ * locking is done: a coroutine touches only its own loop's objects, and
+ * crosses to another loop with schedule(). The I/O awaitables keep their
+ * state in the awaiting coroutine's frame, so steady-state reads and writes
+ * do not allocate; creating a Task does (its frame), so per-frame work
+ * belongs in a loop inside one, not in a Task per frame.
+ *
+ * Resumption is inline: AsyncEvent::set() and AsyncFd::close() run the
+ * waiting coroutine to its next suspension before returning. A suspended
+ * coroutine must not be destroyed from outside; detached ones end by
+ * returning.
+ */
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <sys/types.h>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "omt_loop.h"
+
+namespace omt {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            return h.promise().continuation;
+        }
+        void await_resume() const noexcept { }
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+    Task<T> get_return_object() noexcept;
+    void return_value(T v) { value.emplace(std::move(v)); }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept { }
+};
+
+} // namespace detail
+
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle h) : m_handle(h) { }
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) { }
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        m_handle.promise().continuation = caller;
+        return m_handle;
+    }
+    T await_resume() {
+        if constexpr (!std::is_void_v<T>) return std::move(*m_handle.promise().value);
+    }
+
+private:
+    Handle m_handle;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace detail
+
+/** Run task on the calling (loop) thread until its first suspension; it frees itself when done. */
+void spawn(Task<void> task);
+
+/** co_await sleepFor(loop, ms): resume on loop after ms. */
+class SleepFor {
+public:
+    SleepFor(EventLoop& loop, int ms) : m_loop(loop), m_ms(ms) { }
+    bool await_ready() const noexcept { return m_ms <= 0; }
+    void await_suspend(std::coroutine_handle<> h) {
+        m_loop.addTimer(m_ms, [h] { h.resume(); });
+    }
+    void await_resume() const noexcept { }
+
+private:
+    EventLoop& m_loop;
+    int m_ms;
+};
+
+inline SleepFor sleepFor(EventLoop& loop, int ms) { return SleepFor(loop, ms); }
+
+/** co_await schedule(loop): continue on loop's thread (allocates; for hand-offs, not per frame). */
+class Schedule {
+public:
+    explicit Schedule(EventLoop& loop) : m_loop(loop) { }
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        m_loop.post([h] { h.resume(); });
+    }
+    void await_resume() const noexcept { }
+
+private:
+    EventLoop& m_loop;
+};
+
+inline Schedule schedule(EventLoop& loop) { return Schedule(loop); }
+
+/** One waiter, set by a coroutine or callback on the same loop; stays set until reset(). */
+class AsyncEvent {
+public:
+    void set() {
+        m_set = true;
+        if (auto h = std::exchange(m_waiter, {})) h.resume();
+    }
+    void reset() { m_set = false; }
+    bool isSet() const { return m_set; }
+
+    auto wait() {
+        struct Awaiter {
+            AsyncEvent& event;
+            bool await_ready() const noexcept { return event.m_set; }
+            void await_suspend(std::coroutine_handle<> h) noexcept { event.m_waiter = h; }
+            void await_resume() const noexcept { }
+        };
+        return Awaiter{*this};
+    }
+
+private:
+    bool m_set = false;
+    std::coroutine_handle<> m_waiter;
+};
+
+/**
+ * A non-blocking fd registered with one loop, owned and closed by this.
+ * At most one read-side (recv/accept) and one write-side (sendAll) operation
+ * may be pending at a time; they may be pending together.
+ */
+class AsyncFd {
+public:
+    /** Results: bytes (recv: 0 at EOF), a new fd (accept) or -errno; -ECANCELED once closed. */
+    struct Op {
+        enum Kind : uint8_t { RECV, SEND_ALL, ACCEPT } kind = RECV;
+        uint8_t* data = nullptr;
+        size_t length = 0;
+        size_t done = 0;
+        ssize_t result = 0;
+        std::coroutine_handle<> waiter;
+    };
+
+    class Awaiter {
+    public:
+        Awaiter(AsyncFd& fd, Op::Kind kind, const void* data = nullptr, size_t length = 0) : m_fd(fd) {
+            m_op.kind = kind;
+            m_op.data = (uint8_t*)const_cast<void*>(data);
+            m_op.length = length;
+        }
+        /** Tries the syscall first: an fd that is already ready never suspends. */
+        bool await_ready() { return m_fd.attempt(m_op); }
+        void await_suspend(std::coroutine_handle<> h) { m_fd.park(m_op, h); }
+        ssize_t await_resume() const noexcept { return m_op.result; }
+
+    private:
+        AsyncFd& m_fd;
+        Op m_op;
+    };
+
+    AsyncFd(EventLoop& loop, int fd);
+    ~AsyncFd();
+    AsyncFd(const AsyncFd&) = delete;
+    AsyncFd& operator=(const AsyncFd&) = delete;
+
+    bool valid() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+    EventLoop& loop() const { return m_loop; }
+
+    Awaiter recv(void* data, size_t length) { return Awaiter(*this, Op::RECV, data, length); }
+    /** Completes once all of it is written (or on error). */
+    Awaiter sendAll(const void* data, size_t length) { return Awaiter(*this, Op::SEND_ALL, data, length); }
+    /** A listening socket's next connection, non-blocking and close-on-exec. */
+    Awaiter accept() { return Awaiter(*this, Op::ACCEPT); }
+
+    /** Unregister and close; pending operations complete with -ECANCELED before this returns. */
+    void close();
+
+private:
+    bool attempt(Op& op);
+    void park(Op& op, std::coroutine_handle<> h);
+    void onEvents(uint32_t events);
+    void updateEvents();
+
+    EventLoop& m_loop;
+    int m_fd = -1;
+    bool m_registered = false;
+    uint32_t m_events = 0;
+    Op* m_reader = nullptr;
+    Op* m_writer = nullptr;
+};
+
+/** A fixed set of loops, each run by its own thread ("OmtLoop-N"). */
+class LoopPool {
+public:
+    explicit LoopPool(int threads, LoopBackend backend = defaultLoopBackend());
+    ~LoopPool();
+    LoopPool(const LoopPool&) = delete;
+    LoopPool& operator=(const LoopPool&) = delete;
+
+    bool valid() const;
+    int size() const { return (int)m_loops.size(); }
+    EventLoop& loop(int i) { return *m_loops[(size_t)i]; }
+    /** Round-robin pick for new work. Thread-safe. */
+    EventLoop& next();
+
+    void start();
+    /** Stop every loop and join its thread. */
+    void stop();
+
+private:
+    std::vector<std::unique_ptr<EventLoop>> m_loops;
+    std::vector<std::thread> m_threads;
+    std::atomic<uint32_t> m_next{0};
+};
+
+} // namespace omt
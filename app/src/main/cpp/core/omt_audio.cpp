@@ -0,0 +1,28 @@
+#include "omt_audio.h"
+
+#include <cstring>
+
+namespace omt {
+
+void interleavedToPlanar(const float* src, int samplesPerChannel, int channels, uint8_t* dst) {
+    // Both Android targets and Linux hosts are little-endian, so a float copy is the wire format.
+    for (int ch = 0; ch < channels; ch++) {
+        uint8_t* plane = dst + (size_t)ch * samplesPerChannel * 4;
+        for (int i = 0; i < samplesPerChannel; i++)
+            std::memcpy(plane + (size_t)i * 4, &src[(size_t)i * channels + ch], 4);
+    }
+}
+
+void planarToInterleaved(const uint8_t* src, size_t srcLen, int samplesPerChannel, int channels, float* dst) {
+    const size_t available = srcLen / 4;
+    for (int ch = 0; ch < channels; ch++) {
+        size_t base = (size_t)ch * samplesPerChannel;
+        for (int i = 0; i < samplesPerChannel; i++) {
+            float v = 0.f;
+            if (base + i < available) std::memcpy(&v, src + (base + i) * 4, 4);
+            dst[(size_t)i * channels + ch] = v;
+        }
+    }
+}
+
+} // namespace omt
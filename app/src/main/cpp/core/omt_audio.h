@@ -0,0 +1,24 @@
+/**
+ * Portable audio kernels for the OMT FPA1 format (32-bit float, planar).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omt {
+
+/**
+ * De-interleave [L0 R0 L1 R1 ...] floats into FPA1 planar order
+ * [L0 L1 ... Ln][R0 R1 ... Rn], written as little-endian bytes.
+ * dst must hold samplesPerChannel * channels * 4 bytes.
+ */
+void interleavedToPlanar(const float* src, int samplesPerChannel, int channels, uint8_t* dst);
+
+/**
+ * Inverse of interleavedToPlanar: FPA1 planar little-endian bytes → interleaved floats.
+ * Reads at most srcLen bytes; samples beyond the payload are written as 0.
+ */
+void planarToInterleaved(const uint8_t* src, size_t srcLen, int samplesPerChannel, int channels, float* dst);
+
+} // namespace omt
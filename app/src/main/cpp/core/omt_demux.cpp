@@ -0,0 +1,36 @@
+#include "omt_demux.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace omt {
+
+namespace {
+// Minimum free space offered to recv(); small reads cost a syscall each.
+constexpr size_t MIN_READ = 64u << 10;
+}
+
+Demuxer::Demuxer(size_t maxFrameBytes, size_t initialCapacity)
+    : m_buf(initialCapacity), m_maxFrame(maxFrameBytes) { }
+
+uint8_t* Demuxer::writable(size_t* avail) {
+    size_t want = std::max(MIN_READ, m_need > pending() ? m_need - pending() : 0);
+    if (m_buf.size() - m_end < want) {
+        if (m_start > 0) {
+            std::memmove(m_buf.data(), m_buf.data() + m_start, m_end - m_start);
+            m_end -= m_start;
+            m_start = 0;
+        }
+        if (m_buf.size() - m_end < want) m_buf.resize(m_end + want);
+    }
+    *avail = m_buf.size() - m_end;
+    return m_buf.data() + m_end;
+}
+
+void Demuxer::reset() {
+    m_start = m_end = m_need = 0;
+    m_frames = m_bytes = 0;
+    m_corrupt = false;
+}
+
+} // namespace omt
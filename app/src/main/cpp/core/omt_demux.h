@@ -0,0 +1,96 @@
+/**
+ * Incremental OMT frame demuxer for non-blocking sockets.
+ *
+ * Callers recv() straight into writable(), then commit() the byte count;
+ * every complete frame is handed to the callback as a pointer into the
+ * internal buffer (valid only during the call), so a frame is copied at
+ * most once — when a partial tail is compacted to the front. The buffer
+ * grows to the largest frame seen and is reused, so steady state does not
+ * allocate. Data that already landed elsewhere (io_uring's provided receive
+ * buffers) goes through feed(), which copies it in.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "omt_protocol.h"
+
+namespace omt {
+
+class Demuxer {
+public:
+    explicit Demuxer(size_t maxFrameBytes = 64u << 20, size_t initialCapacity = 256u << 10);
+
+    /** Free space to receive into (at least enough to finish the pending frame). */
+    uint8_t* writable(size_t* avail);
+
+    /**
+     * Account n bytes received into writable() and deliver every complete
+     * frame as onFrame(const FrameHeader&, const uint8_t* payload, size_t len).
+     * Returns false on a corrupt header or an oversized frame; the stream
+     * cannot be resynchronised after that.
+     */
+    template <typename OnFrame>
+    bool commit(size_t n, OnFrame&& onFrame) {
+        m_end += n;
+        m_bytes += n;
+        while (m_end - m_start >= (size_t)HEADER_SIZE) {
+            FrameHeader h;
+            const uint8_t* p = m_buf.data() + m_start;
+            if (!parseFrameHeader(p, &h) || h.dataLength < 0 || (size_t)h.dataLength > m_maxFrame) {
+                m_corrupt = true;
+                return false;
+            }
+            size_t total = HEADER_SIZE + (size_t)h.dataLength;
+            if (m_end - m_start < total) {
+                m_need = total;
+                break;
+            }
+            m_need = 0;
+            m_frames++;
+            onFrame(h, p + HEADER_SIZE, (size_t)h.dataLength);
+            m_start += total;
+        }
+        if (m_start == m_end) m_start = m_end = 0;
+        return true;
+    }
+
+    /** Copy n bytes received elsewhere in and deliver frames as commit() does. */
+    template <typename OnFrame>
+    bool feed(const uint8_t* data, size_t n, OnFrame&& onFrame) {
+        while (n > 0) {
+            size_t avail;
+            uint8_t* dst = writable(&avail);
+            const size_t chunk = std::min(avail, n);
+            std::memcpy(dst, data, chunk);
+            if (!commit(chunk, onFrame)) return false;
+            data += chunk;
+            n -= chunk;
+        }
+        return true;
+    }
+
+    void reset();
+
+    uint64_t framesParsed() const { return m_frames; }
+    uint64_t bytesReceived() const { return m_bytes; }
+    /** Bytes buffered towards the next frame. */
+    size_t pending() const { return m_end - m_start; }
+    bool corrupt() const { return m_corrupt; }
+
+private:
+    std::vector<uint8_t> m_buf;
+    size_t m_start = 0;
+    size_t m_end = 0;
+    size_t m_need = 0;
+    size_t m_maxFrame;
+    uint64_t m_frames = 0;
+    uint64_t m_bytes = 0;
+    bool m_corrupt = false;
+};
+
+} // namespace omt
@@ -0,0 +1,105 @@
+/**
+ * Lock-free HDR-style latency histogram.
+ *
+ * Values (nanoseconds) are bucketed log-linearly: exact below 32, then 32
+ * linear sub-buckets per power of two, i.e. ≤ ~3% relative error up to
+ * 2^36 ns (~68 s); larger values land in the last bucket. Recording is a
+ * handful of relaxed atomic adds, so it is safe on any hot path and from any
+ * thread; snapshots are taken concurrently without stopping writers.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace omt {
+
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+    uint64_t mean = 0;
+};
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int MAX_SHIFT = 31;
+    static constexpr int BUCKET_COUNT = SUB_COUNT * (MAX_SHIFT + 2);
+
+    void record(uint64_t valueNs) {
+        m_buckets[indexFor(valueNs)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(valueNs, std::memory_order_relaxed);
+        uint64_t prev = m_max.load(std::memory_order_relaxed);
+        while (valueNs > prev &&
+               !m_max.compare_exchange_weak(prev, valueNs, std::memory_order_relaxed)) { }
+    }
+
+    /** Percentiles are reported at the midpoint of their bucket. */
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot s;
+        uint64_t counts[BUCKET_COUNT];
+        uint64_t total = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        s.count = total;
+        s.max = m_max.load(std::memory_order_relaxed);
+        if (total == 0) return s;
+        // Divide by the bucket total, not a separate count: a reset or the first sample can leave that at
+        // zero while a bucket is already set, and the mean stays consistent with the percentiles.
+        s.mean = m_sum.load(std::memory_order_relaxed) / total;
+        s.p50 = percentile(counts, total, 0.50);
+        s.p99 = percentile(counts, total, 0.99);
+        s.p999 = percentile(counts, total, 0.999);
+        if (s.p50 > s.max) s.p50 = s.max;
+        if (s.p99 > s.max) s.p99 = s.max;
+        if (s.p999 > s.max) s.p999 = s.max;
+        return s;
+    }
+
+    /** Not atomic with respect to concurrent recorders; a few samples may straddle the reset. */
+    void reset() {
+        for (auto& b : m_buckets) b.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    static int indexFor(uint64_t v) {
+        if (v < (uint64_t)SUB_COUNT) return (int)v;
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - SUB_BITS;
+        if (shift > MAX_SHIFT) return BUCKET_COUNT - 1;
+        int sub = (int)(v >> shift) & (SUB_COUNT - 1);
+        return SUB_COUNT * (shift + 1) + sub;
+    }
+
+    static uint64_t midpointOf(int index) {
+        if (index < SUB_COUNT) return (uint64_t)index;
+        int shift = index / SUB_COUNT - 1;
+        uint64_t lower = (uint64_t)(SUB_COUNT + index % SUB_COUNT) << shift;
+        return lower + (((uint64_t)1 << shift) >> 1);
+    }
+
+private:
+    static uint64_t percentile(const uint64_t* counts, uint64_t total, double q) {
+        uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i];
+            if (seen >= rank) return midpointOf(i);
+        }
+        return midpointOf(BUCKET_COUNT - 1);
+    }
+
+    std::atomic<uint64_t> m_buckets[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+} // namespace omt
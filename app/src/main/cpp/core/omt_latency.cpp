@@ -0,0 +1,190 @@
+#include "omt_latency.h"
+#include "omt_protocol.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+namespace omt {
+
+namespace {
+
+constexpr int CELL_COUNT = TIMECODE_COLS * TIMECODE_ROWS;
+constexpr int SYNC_CELLS = 4;
+constexpr int VALUE_BITS = 56;
+constexpr int CRC_BITS = 8;
+constexpr uint8_t LUMA_WHITE = 235;
+constexpr uint8_t LUMA_BLACK = 16;
+constexpr int MIN_CONTRAST = 64;
+
+uint8_t crc8(uint64_t value) {
+    uint8_t crc = 0;
+    for (int i = VALUE_BITS / 8 - 1; i >= 0; i--) {
+        crc ^= (uint8_t)(value >> (i * 8));
+        for (int b = 0; b < 8; b++) crc = (uint8_t)((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+    return crc;
+}
+
+/** Cell bit layout: 1010 sync, value MSB first, CRC-8, 0101 end marker. */
+void buildBits(uint64_t value, bool bits[CELL_COUNT]) {
+    value &= TIMECODE_VALUE_MASK;
+    const uint8_t crc = crc8(value);
+    int k = 0;
+    for (int i = 0; i < SYNC_CELLS; i++) bits[k++] = (i & 1) == 0;
+    for (int i = VALUE_BITS - 1; i >= 0; i--) bits[k++] = (value >> i) & 1;
+    for (int i = CRC_BITS - 1; i >= 0; i--) bits[k++] = (crc >> i) & 1;
+    for (; k < CELL_COUNT; k++) bits[k] = (k & 1) != 0;
+}
+
+bool fits(int width, int height, int cell) {
+    return width >= (TIMECODE_COLS + 2) * cell && height >= (TIMECODE_ROWS + 2) * cell;
+}
+
+/** Average luma over the central half of every cell, then threshold against the sync cells. */
+template <typename LumaAt>
+bool readCells(int width, int height, LumaAt lumaAt, uint64_t* value) {
+    const int cell = timecodeCellSize(height);
+    if (!fits(width, height, cell)) return false;
+    const int inset = cell / 4;
+    const int span = cell / 2;
+    int levels[CELL_COUNT];
+    for (int k = 0; k < CELL_COUNT; k++) {
+        const int x = cell + (k % TIMECODE_COLS) * cell + inset;
+        const int y = cell + (k / TIMECODE_COLS) * cell + inset;
+        int sum = 0;
+        for (int dy = 0; dy < span; dy++)
+            for (int dx = 0; dx < span; dx++) sum += lumaAt(x + dx, y + dy);
+        levels[k] = sum / (span * span);
+    }
+    const int white = (levels[0] + levels[2]) / 2;
+    const int black = (levels[1] + levels[3]) / 2;
+    if (white - black < MIN_CONTRAST) return false;
+    const int threshold = (white + black) / 2;
+
+    bool bits[CELL_COUNT];
+    for (int k = 0; k < CELL_COUNT; k++) bits[k] = levels[k] > threshold;
+    uint64_t v = 0;
+    for (int i = 0; i < VALUE_BITS; i++) v = (v << 1) | (bits[SYNC_CELLS + i] ? 1 : 0);
+    bool expected[CELL_COUNT];
+    buildBits(v, expected);
+    if (std::memcmp(bits, expected, sizeof(bits)) != 0) return false;
+    *value = v;
+    return true;
+}
+
+} // namespace
+
+int timecodeCellSize(int height) {
+    int cell = (height / 68) & ~1;
+    return cell < 8 ? 8 : cell;
+}
+
+void timecodeStampNv12(uint8_t* y, int strideY, uint8_t* uv, int strideUV, int width, int height, uint64_t value) {
+    const int cell = timecodeCellSize(height);
+    if (!fits(width, height, cell)) return;
+    bool bits[CELL_COUNT];
+    buildBits(value, bits);
+    for (int k = 0; k < CELL_COUNT; k++) {
+        const int x0 = cell + (k % TIMECODE_COLS) * cell;
+        const int y0 = cell + (k / TIMECODE_COLS) * cell;
+        const uint8_t luma = bits[k] ? LUMA_WHITE : LUMA_BLACK;
+        for (int row = y0; row < y0 + cell; row++)
+            std::memset(y + (size_t)row * strideY + x0, luma, cell);
+    }
+    // Cell origin and size are even, so the code area maps exactly onto chroma rows/pairs
+    const int cx = cell, cy = cell / 2;
+    const int cw = TIMECODE_COLS * cell, ch = TIMECODE_ROWS * cell / 2;
+    for (int row = cy; row < cy + ch; row++)
+        std::memset(uv + (size_t)row * strideUV + cx, 128, cw);
+}
+
+bool timecodeReadNv12(const uint8_t* y, int strideY, int width, int height, uint64_t* value) {
+    return readCells(width, height, [&](int x, int row) {
+        return (int)y[(size_t)row * strideY + x];
+    }, value);
+}
+
+bool timecodeReadRgba(const uint8_t* rgba, int stride, int width, int height, uint64_t* value) {
+    // BT.709 luma weights; only relative levels matter since the sync cells set the threshold
+    return readCells(width, height, [&](int x, int row) {
+        const uint8_t* p = rgba + (size_t)row * stride + (size_t)x * 4;
+        return (54 * p[0] + 183 * p[1] + 19 * p[2]) >> 8;
+    }, value);
+}
+
+int formatClockRequest(char* buf, size_t len, int64_t t1) {
+    int n = std::snprintf(buf, len, "<OMTClockRequest T1=\"%lld\" />", (long long)t1);
+    return n > 0 && (size_t)n < len ? n : -1;
+}
+
+int formatClockReply(char* buf, size_t len, int64_t t1, int64_t t2, int64_t t3) {
+    int n = std::snprintf(buf, len, "<OMTClockReply T1=\"%lld\" T2=\"%lld\" T3=\"%lld\" />",
+                          (long long)t1, (long long)t2, (long long)t3);
+    return n > 0 && (size_t)n < len ? n : -1;
+}
+
+int formatLatencyStamp(char* buf, size_t len, int64_t stampUs, int64_t frame) {
+    int n = std::snprintf(buf, len, "<OMTLatencyStamp T=\"%lld\" F=\"%lld\" />",
+                          (long long)stampUs, (long long)frame);
+    return n > 0 && (size_t)n < len ? n : -1;
+}
+
+bool parseClockRequest(const char* xml, size_t len, int64_t* t1) {
+    return containsIgnoreCase(xml, len, "<OMTClockRequest") && xmlAttrInt64(xml, len, "T1", t1);
+}
+
+bool parseClockReply(const char* xml, size_t len, int64_t* t1, int64_t* t2, int64_t* t3) {
+    return containsIgnoreCase(xml, len, "<OMTClockReply") &&
+           xmlAttrInt64(xml, len, "T1", t1) && xmlAttrInt64(xml, len, "T2", t2) &&
+           xmlAttrInt64(xml, len, "T3", t3);
+}
+
+bool parseLatencyStamp(const char* xml, size_t len, int64_t* stampUs, int64_t* frame) {
+    return containsIgnoreCase(xml, len, "<OMTLatencyStamp") &&
+           xmlAttrInt64(xml, len, "T", stampUs) && xmlAttrInt64(xml, len, "F", frame);
+}
+
+void ClockSync::addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    const int64_t rtt = (t4 - t1) - (t3 - t2);
+    if (rtt < 0) return;
+    m_offsets[m_next] = ((t2 - t1) + (t3 - t4)) / 2;
+    m_rtts[m_next] = rtt;
+    m_next = (m_next + 1) % WINDOW;
+    if (m_count < WINDOW) m_count++;
+
+    int best = 0;
+    for (int i = 1; i < m_count; i++)
+        if (m_rtts[i] < m_rtts[best]) best = i;
+    m_offset.store(m_offsets[best], std::memory_order_relaxed);
+    m_rtt.store(m_rtts[best], std::memory_order_relaxed);
+    m_valid.store(true, std::memory_order_release);
+}
+
+void ClockSync::reset() {
+    m_count = 0;
+    m_next = 0;
+    m_valid.store(false, std::memory_order_release);
+}
+
+bool latencyModeEnabled() {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    return __system_property_get("debug.omt.latency", value) > 0 && value[0] == '1';
+#else
+    const char* v = std::getenv("OMT_LATENCY");
+    return v && v[0] == '1';
+#endif
+}
+
+int64_t monotonicUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace omt
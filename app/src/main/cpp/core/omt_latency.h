@@ -0,0 +1,85 @@
+/**
+ * Glass-to-glass latency measurement.
+ *
+ * The sender stamps its capture time (µs, CLOCK_MONOTONIC) into each frame
+ * twice: as a pixel timecode in the top-left corner, which survives VMX, and
+ * as an <OMTLatencyStamp> metadata frame sent just before the video frame.
+ * Receivers align clocks with an NTP-style exchange over OMT metadata:
+ *
+ *   receiver → <OMTClockRequest T1="…" />
+ *   sender   → <OMTClockReply T1="…" T2="…" T3="…" />   (T2 receipt, T3 reply time)
+ *
+ * latency = receiverNow + offset − stamp, where offset = senderClock − receiverClock.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace omt {
+
+// ---- Pixel timecode ----
+
+/** 2 rows × 36 cells: 4 sync cells, 56-bit value, CRC-8, 4 end cells. */
+constexpr int TIMECODE_COLS = 36;
+constexpr int TIMECODE_ROWS = 2;
+constexpr uint64_t TIMECODE_VALUE_MASK = (1ull << 56) - 1;
+
+/** Cell edge in pixels for a frame height (even, at least 8). */
+int timecodeCellSize(int height);
+
+/** Stamp value (low 56 bits) into the top-left corner of an NV12 frame; chroma is neutralised under it. */
+void timecodeStampNv12(uint8_t* y, int strideY, uint8_t* uv, int strideUV, int width, int height, uint64_t value);
+/** Returns false when no valid code (sync + CRC) is found. */
+bool timecodeReadNv12(const uint8_t* y, int strideY, int width, int height, uint64_t* value);
+bool timecodeReadRgba(const uint8_t* rgba, int stride, int width, int height, uint64_t* value);
+
+// ---- Metadata ----
+
+/** Each returns the XML length written into buf (NUL-terminated), or -1 if it does not fit. */
+int formatClockRequest(char* buf, size_t len, int64_t t1);
+int formatClockReply(char* buf, size_t len, int64_t t1, int64_t t2, int64_t t3);
+int formatLatencyStamp(char* buf, size_t len, int64_t stampUs, int64_t frame);
+
+bool parseClockRequest(const char* xml, size_t len, int64_t* t1);
+bool parseClockReply(const char* xml, size_t len, int64_t* t1, int64_t* t2, int64_t* t3);
+bool parseLatencyStamp(const char* xml, size_t len, int64_t* stampUs, int64_t* frame);
+
+// ---- Clock offset ----
+
+/**
+ * Keeps the last few exchanges and publishes the offset of the one with the
+ * smallest round trip (least queuing noise). Samples may be added from one
+ * thread while another reads offsetUs().
+ */
+class ClockSync {
+public:
+    static constexpr int WINDOW = 16;
+
+    void addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+    bool valid() const { return m_valid.load(std::memory_order_acquire); }
+    int64_t offsetUs() const { return m_offset.load(std::memory_order_relaxed); }
+    int64_t rttUs() const { return m_rtt.load(std::memory_order_relaxed); }
+    void reset();
+
+private:
+    int64_t m_offsets[WINDOW] = {};
+    int64_t m_rtts[WINDOW] = {};
+    int m_count = 0;
+    int m_next = 0;
+    std::atomic<bool> m_valid{false};
+    std::atomic<int64_t> m_offset{0};
+    std::atomic<int64_t> m_rtt{0};
+};
+
+/**
+ * Whether measurement mode is switched on: `adb shell setprop debug.omt.latency 1`
+ * on Android, OMT_LATENCY=1 on hosts. Read once per call; callers cache it per session.
+ */
+bool latencyModeEnabled();
+
+/** CLOCK_MONOTONIC in µs — the clock both ends stamp with (matches System.nanoTime()/1000). */
+int64_t monotonicUs();
+
+} // namespace omt
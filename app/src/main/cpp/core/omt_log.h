@@ -0,0 +1,23 @@
+/**
+ * Logging for the native core: Android logcat on device, stderr on Linux hosts.
+ * Files define LOG_TAG before including this header.
+ */
+#pragma once
+
+#ifndef LOG_TAG
+#define LOG_TAG "OmtCore"
+#endif
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define OMT_HOST_LOG(level, ...) \
+    do { std::fprintf(stderr, "%s/%s: ", level, LOG_TAG); std::fprintf(stderr, __VA_ARGS__); std::fputc('\n', stderr); } while (0)
+#define LOGI(...) OMT_HOST_LOG("I", __VA_ARGS__)
+#define LOGW(...) OMT_HOST_LOG("W", __VA_ARGS__)
+#define LOGE(...) OMT_HOST_LOG("E", __VA_ARGS__)
+#endif
@@ -0,0 +1,268 @@
+#define LOG_TAG "OmtLoop"
+#include "omt_loop.h"
+#include "omt_log.h"
+#include "omt_uring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace omt {
+
+static_assert(LOOP_READ == (uint32_t)EPOLLIN && LOOP_WRITE == (uint32_t)EPOLLOUT &&
+              LOOP_ERROR == (uint32_t)EPOLLERR && LOOP_HANGUP == (uint32_t)EPOLLHUP,
+              "LoopEvent values mirror epoll");
+
+namespace {
+constexpr int MAX_EVENTS = 64;
+constexpr unsigned URING_ENTRIES = 256;
+// epoll data.ptr for the wake eventfd; never a real Entry address
+char s_wakeTag;
+
+int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}
+
+LoopBackend defaultLoopBackend() {
+#ifdef __ANDROID__
+    return LoopBackend::EPOLL;
+#else
+    const char* value = std::getenv("OMT_LOOP");
+    return value && std::strcmp(value, "uring") == 0 ? LoopBackend::URING : LoopBackend::EPOLL;
+#endif
+}
+
+const char* loopBackendName(LoopBackend backend) {
+    return backend == LoopBackend::URING ? "io_uring" : "epoll";
+}
+
+EventLoop::EventLoop(LoopBackend backend) {
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (backend == LoopBackend::URING && m_wakeFd >= 0) {
+        m_uring = std::make_unique<Uring>();
+        if (m_uring->init(URING_ENTRIES)) {
+            armWake();
+            return;
+        }
+        LOGW("io_uring unavailable; using epoll");
+        m_uring.reset();
+    }
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0 || m_wakeFd < 0) {
+        LOGE("EventLoop init failed: %s", std::strerror(errno));
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &s_wakeTag;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+}
+
+EventLoop::~EventLoop() {
+    m_uring.reset(); // before the fds its polls watch
+    if (m_wakeFd >= 0) close(m_wakeFd);
+    if (m_epollFd >= 0) close(m_epollFd);
+}
+
+void EventLoop::armWake() {
+    m_uring->pollAdd(m_wakeFd, LOOP_READ, [this](int res, uint32_t) {
+        if (res == -ECANCELED) return;
+        uint64_t count;
+        while (read(m_wakeFd, &count, sizeof(count)) > 0) { }
+        m_woke = true;
+        armWake();
+    });
+}
+
+void EventLoop::armPoll(Entry* entry) {
+    entry->pollId = m_uring->pollAdd(entry->fd, entry->events, [this, entry](int res, uint32_t) { onPoll(entry, res); });
+}
+
+void EventLoop::onPoll(Entry* entry, int res) {
+    // Only a live entry still has its handler here: remove() and modify() detach the old poll.
+    entry->pollId = 0;
+    if (res == -ECANCELED) return;
+    if (res < 0) {
+        LOGW("poll fd %d failed: %s", entry->fd, std::strerror(-res));
+        res = LOOP_ERROR;
+    }
+    entry->handler((uint32_t)res);
+    // Re-arm unless the handler removed the fd or modify() armed a fresh poll: level-triggered, like epoll.
+    if (entry->alive && entry->pollId == 0 && entry->events) armPoll(entry);
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler handler) {
+    auto entry = std::make_unique<Entry>(Entry{fd, std::move(handler), true});
+    if (m_uring) {
+        entry->events = events;
+        if (events) {
+            armPoll(entry.get());
+            if (!entry->pollId) {
+                LOGE("io_uring poll fd %d failed", fd);
+                return false;
+            }
+        }
+        auto it = m_entries.find(fd);
+        if (it != m_entries.end()) {
+            it->second->alive = false;
+            m_uring->detach(it->second->pollId);
+            m_graveyard.push_back(std::move(it->second));
+        }
+        m_entries[fd] = std::move(entry);
+        return true;
+    }
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = entry.get();
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        LOGE("epoll add fd %d failed: %s", fd, std::strerror(errno));
+        return false;
+    }
+    auto it = m_entries.find(fd);
+    if (it != m_entries.end()) {
+        // fd number reused after a close we were not told about
+        it->second->alive = false;
+        m_graveyard.push_back(std::move(it->second));
+    }
+    m_entries[fd] = std::move(entry);
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events) {
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end()) return false;
+    if (m_uring) {
+        Entry* entry = it->second.get();
+        if (entry->pollId && entry->events == events) return true;
+        m_uring->detach(entry->pollId);
+        entry->pollId = 0;
+        entry->events = events;
+        if (events) armPoll(entry);
+        return !events || entry->pollId != 0;
+    }
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = it->second.get();
+    return epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd) {
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end()) return;
+    if (m_uring) m_uring->detach(it->second->pollId);
+    else epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    it->second->alive = false;
+    m_graveyard.push_back(std::move(it->second));
+    m_entries.erase(it);
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t n = write(m_wakeFd, &one, sizeof(one));
+    (void)n; // EAGAIN means a wake is already pending
+}
+
+void EventLoop::post(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        m_posted.push_back(std::move(fn));
+    }
+    wake();
+}
+
+uint64_t EventLoop::addTimer(int delayMs, std::function<void()> fn) {
+    const uint64_t id = m_nextTimerId++;
+    const int64_t deadline = monotonicNs() + (int64_t)std::max(delayMs, 0) * 1000000;
+    m_timers.emplace(std::make_pair(deadline, id), std::move(fn));
+    m_timerDeadlines.emplace(id, deadline);
+    return id;
+}
+
+void EventLoop::cancelTimer(uint64_t id) {
+    auto it = m_timerDeadlines.find(id);
+    if (it == m_timerDeadlines.end()) return;
+    m_timers.erase(std::make_pair(it->second, id));
+    m_timerDeadlines.erase(it);
+}
+
+int EventLoop::timerWaitMs(int timeoutMs) const {
+    if (m_timers.empty()) return timeoutMs;
+    const int64_t untilNs = m_timers.begin()->first.first - monotonicNs();
+    const int ms = untilNs <= 0 ? 0 : (int)std::min<int64_t>((untilNs + 999999) / 1000000, INT32_MAX);
+    return timeoutMs < 0 ? ms : std::min(ms, timeoutMs);
+}
+
+void EventLoop::runTimers() {
+    const int64_t now = monotonicNs();
+    // One pass over what is due now; timers a callback adds wait for the next batch.
+    while (!m_timers.empty() && m_timers.begin()->first.first <= now && !m_stopped) {
+        auto it = m_timers.begin();
+        std::function<void()> fn = std::move(it->second);
+        m_timerDeadlines.erase(it->first.second);
+        m_timers.erase(it);
+        fn();
+    }
+}
+
+bool EventLoop::runOnce(int timeoutMs) {
+    if (m_stopped) return false;
+    timeoutMs = timerWaitMs(timeoutMs);
+    bool woke = false;
+    if (m_uring) {
+        if (m_uring->run(timeoutMs) < 0) return false;
+        woke = m_woke;
+        m_woke = false;
+    } else {
+        epoll_event events[MAX_EVENTS];
+        int n = epoll_wait(m_epollFd, events, MAX_EVENTS, timeoutMs);
+        if (n < 0 && errno != EINTR) {
+            LOGE("epoll_wait failed: %s", std::strerror(errno));
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &s_wakeTag) {
+                uint64_t count;
+                while (read(m_wakeFd, &count, sizeof(count)) > 0) { }
+                woke = true;
+                continue;
+            }
+            auto* entry = (Entry*)events[i].data.ptr;
+            if (entry->alive) entry->handler(events[i].events);
+        }
+    }
+    if (woke) runPosted();
+    runTimers();
+    // Stopped: settle everything still in the ring here, on its thread, so
+    // whoever destroys the loop next finds nothing in flight.
+    if (m_stopped && m_uring) m_uring->cancelAll();
+    m_graveyard.clear();
+    return !m_stopped;
+}
+
+void EventLoop::runPosted() {
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        m_running.swap(m_posted);
+    }
+    for (auto& fn : m_running) fn();
+    m_running.clear();
+    if (m_onWake) m_onWake();
+}
+
+void EventLoop::run() {
+    while (runOnce(-1)) { }
+}
+
+void EventLoop::stop() {
+    post([this] { m_stopped = true; });
+}
+
+} // namespace omt
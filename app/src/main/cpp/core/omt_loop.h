@@ -0,0 +1,112 @@
+/**
+ * Minimal single-threaded readiness event loop (epoll) for the native sender
+ * and receiver cores. Everything except wake() and post() must be called on
+ * the loop thread (or before run() starts).
+ *
+ * Handlers may add or remove fds — including their own — while dispatching;
+ * removed entries are freed after the current batch.
+ *
+ * On Linux hosts the loop can run on io_uring instead (OMT_LOOP=uring): fds
+ * are then watched with one-shot polls re-armed after each handler, which
+ * keeps the level-triggered behaviour, and the sender and receiver submit
+ * their socket I/O to uring() directly. epoll stays the default and the
+ * fallback wherever io_uring is missing.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace omt {
+
+class Uring;
+
+enum class LoopBackend { EPOLL, URING };
+
+/** OMT_LOOP=uring|epoll on Linux hosts; always epoll on Android. */
+LoopBackend defaultLoopBackend();
+const char* loopBackendName(LoopBackend backend);
+
+enum LoopEvent : uint32_t {
+    LOOP_READ = 0x001,   // EPOLLIN
+    LOOP_WRITE = 0x004,  // EPOLLOUT
+    LOOP_ERROR = 0x008,  // EPOLLERR
+    LOOP_HANGUP = 0x010, // EPOLLHUP
+};
+
+class EventLoop {
+public:
+    using Handler = std::function<void(uint32_t events)>;
+
+    /** Falls back to epoll when the io_uring backend cannot be set up. */
+    explicit EventLoop(LoopBackend backend = defaultLoopBackend());
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool valid() const { return (m_epollFd >= 0 || m_uring) && m_wakeFd >= 0; }
+    LoopBackend backend() const { return m_uring ? LoopBackend::URING : LoopBackend::EPOLL; }
+    /** The ring behind the io_uring backend (nullptr on epoll); loop thread only. */
+    Uring* uring() const { return m_uring.get(); }
+
+    bool add(int fd, uint32_t events, Handler handler);
+    bool modify(int fd, uint32_t events);
+    void remove(int fd);
+
+    /** Called on the loop thread after every wake(); set before run(). */
+    void setWakeHandler(std::function<void()> handler) { m_onWake = std::move(handler); }
+    /** Thread-safe, allocation-free: coalesces into one wake-handler call. */
+    void wake();
+    /** Thread-safe: run fn on the loop thread (allocates; not for per-frame use). */
+    void post(std::function<void()> fn);
+
+    /** Call fn once on the loop thread after delayMs (allocates); loop thread only. Returns an id for cancelTimer(). */
+    uint64_t addTimer(int delayMs, std::function<void()> fn);
+    void cancelTimer(uint64_t id);
+
+    /** Dispatch one batch of events and due timers; timeoutMs < 0 blocks. Returns false once stopped. */
+    bool runOnce(int timeoutMs);
+    void run();
+    /** Thread-safe: make run() return after the current batch. */
+    void stop();
+    /** stop() has taken effect (loop thread). */
+    bool stopped() const { return m_stopped; }
+
+private:
+    struct Entry {
+        int fd;
+        Handler handler;
+        bool alive;
+        uint32_t events = 0;  // io_uring: what to re-arm the poll with
+        uint64_t pollId = 0;  // io_uring: the armed poll
+    };
+
+    int timerWaitMs(int timeoutMs) const;
+    void runTimers();
+    void armPoll(Entry* entry);
+    void onPoll(Entry* entry, int res);
+    void armWake();
+    void runPosted();
+
+    std::unique_ptr<Uring> m_uring;
+    bool m_woke = false;
+    int m_epollFd = -1;
+    int m_wakeFd = -1;
+    bool m_stopped = false;
+    std::unordered_map<int, std::unique_ptr<Entry>> m_entries;
+    std::vector<std::unique_ptr<Entry>> m_graveyard;
+    std::function<void()> m_onWake;
+    std::map<std::pair<int64_t, uint64_t>, std::function<void()>> m_timers; // (deadline ns, id)
+    std::unordered_map<uint64_t, int64_t> m_timerDeadlines;
+    uint64_t m_nextTimerId = 1;
+    std::mutex m_postMutex;
+    std::vector<std::function<void()>> m_posted;
+    std::vector<std::function<void()>> m_running;
+};
+
+} // namespace omt
@@ -0,0 +1,208 @@
+#include "omt_lz4.h"
+#include "omt_protocol.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace omt {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t LAST_LITERALS = 5; // the block always ends in at least this many literals
+constexpr size_t MF_LIMIT = 12;     // and no match starts closer than this to the end
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int SKIP_TRIGGER = 6;     // after 2^6 misses the search step grows by one byte
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+/** Hash of the 5 bytes at p: candidates that share 5 rather than 4 bytes give longer, fewer matches. */
+inline uint32_t hash5(const uint8_t* p, int hashLog) {
+    return (uint32_t)(((read64(p) << 24) * 889523592379ull) >> (64 - hashLog));
+}
+
+/** Bytes equal at p and ref, stopping at limit. */
+inline size_t matchLength(const uint8_t* p, const uint8_t* ref, const uint8_t* limit) {
+    const uint8_t* start = p;
+    while (p + 8 <= limit) {
+        const uint64_t diff = read64(p) ^ read64(ref);
+        if (diff) return (size_t)(p - start) + (size_t)(__builtin_ctzll(diff) >> 3); // little-endian
+        p += 8;
+        ref += 8;
+    }
+    while (p < limit && *p == *ref) {
+        p++;
+        ref++;
+    }
+    return (size_t)(p - start);
+}
+
+inline uint8_t* writeLength(uint8_t* op, size_t length) {
+    for (; length >= 255; length -= 255) *op++ = 255;
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+/** Token, length and literals of one sequence; the caller guarantees room for them plus 16 bytes. */
+inline uint8_t* writeLiterals(uint8_t* op, const uint8_t* literals, size_t count, size_t matchCode,
+                              const uint8_t* srcEnd) {
+    uint8_t* token = op++;
+    if (count >= 15) {
+        *token = (uint8_t)(15 << 4);
+        op = writeLength(op, count - 15);
+    } else {
+        *token = (uint8_t)(count << 4);
+    }
+    *token |= (uint8_t)std::min<size_t>(matchCode, 15);
+    // Short runs copy a fixed 16 bytes; what lands past the run is overwritten by the next sequence
+    if (count <= 16 && srcEnd - literals >= 16) std::memcpy(op, literals, 16);
+    else std::memcpy(op, literals, count);
+    return op + count;
+}
+
+/** Reads a length continuation (255, 255, …, n); false if it runs off the end. */
+inline bool readLength(const uint8_t*& ip, const uint8_t* end, size_t* length) {
+    uint8_t b;
+    do {
+        if (ip >= end) return false;
+        b = *ip++;
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+} // namespace
+
+int Lz4Compressor::compress(const uint8_t* src, size_t n, uint8_t* dst, size_t dstCapacity) {
+    if (n > 0x7FFFFFFF || dstCapacity < lz4CompressBound(n)) return -1;
+    const uint8_t* const end = src + n;
+    const uint8_t* anchor = src;
+    uint8_t* op = dst;
+
+    if (n >= MF_LIMIT + 1) {
+        const uint8_t* const matchLimit = end - LAST_LITERALS;
+        const uint8_t* const mfLimit = end - MF_LIMIT;
+        std::memset(m_table, 0, sizeof(m_table));
+        const uint8_t* ip = src + 1;
+        for (;;) {
+            const uint8_t* ref;
+            unsigned misses = 1u << SKIP_TRIGGER;
+            for (;;) {
+                if (ip > mfLimit) goto lastLiterals;
+                const uint32_t seq = read32(ip);
+                const uint32_t h = hash5(ip, HASH_LOG);
+                ref = src + m_table[h];
+                m_table[h] = (uint32_t)(ip - src);
+                if (ref < ip && (size_t)(ip - ref) <= MAX_OFFSET && read32(ref) == seq) break;
+                ip += misses++ >> SKIP_TRIGGER;
+            }
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const size_t extra = matchLength(ip + MIN_MATCH, ref + MIN_MATCH, matchLimit);
+            op = writeLiterals(op, anchor, (size_t)(ip - anchor), extra, end);
+            const size_t offset = (size_t)(ip - ref);
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+            if (extra >= 15) op = writeLength(op, extra - 15);
+            ip += MIN_MATCH + extra;
+            anchor = ip;
+            // Index the tail of the match so the next search can continue from it
+            if (ip - 2 > src && ip - 2 <= mfLimit)
+                m_table[hash5(ip - 2, HASH_LOG)] = (uint32_t)(ip - 2 - src);
+        }
+    }
+
+lastLiterals:
+    op = writeLiterals(op, anchor, (size_t)(end - anchor), 0, end);
+    return (int)(op - dst);
+}
+
+bool lz4Decompress(const uint8_t* src, size_t length, uint8_t* dst, size_t dstLength) {
+    const uint8_t* ip = src;
+    const uint8_t* const end = src + length;
+    uint8_t* op = dst;
+    uint8_t* const outEnd = dst + dstLength;
+    for (;;) {
+        if (ip >= end) return false;
+        const uint8_t token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(ip, end, &literals)) return false;
+        if (literals <= 16 && end - ip >= 16 && outEnd - op >= 16) {
+            std::memcpy(op, ip, 16); // fixed-size copy; the bytes past `literals` are overwritten next
+        } else {
+            if (literals > (size_t)(end - ip) || literals > (size_t)(outEnd - op)) return false;
+            std::memcpy(op, ip, literals);
+        }
+        op += literals;
+        ip += literals;
+        if (ip == end) return op == outEnd; // the last sequence has no match
+
+        if (end - ip < 2) return false;
+        const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return false;
+        size_t match = token & 15;
+        if (match == 15 && !readLength(ip, end, &match)) return false;
+        match += MIN_MATCH;
+        if (match > (size_t)(outEnd - op)) return false;
+        if (offset >= 16 && match <= 32 && outEnd - op >= 32) {
+            std::memcpy(op, op - offset, 16);
+            std::memcpy(op + 16, op + 16 - offset, 16);
+            op += match;
+            continue;
+        }
+        // Overlapping copies repeat the last `offset` bytes; every copied chunk doubles the safe distance.
+        size_t distance = offset;
+        while (match > 0) {
+            const size_t chunk = std::min(distance, match);
+            std::memcpy(op, op - distance, chunk);
+            op += chunk;
+            match -= chunk;
+            distance += chunk;
+        }
+    }
+}
+
+size_t nvlzBound(int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    const size_t ySize = (size_t)width * height, uvSize = (size_t)width * (height / 2);
+    return NVLZ_HEADER_SIZE + lz4CompressBound(ySize) + lz4CompressBound(uvSize);
+}
+
+int packNvlz(Lz4Compressor& lz, const uint8_t* y, const uint8_t* uv, int width, int height, uint8_t* dst,
+             size_t dstCapacity) {
+    const size_t bound = nvlzBound(width, height);
+    if (bound == 0 || dstCapacity < bound) return -1;
+    const size_t ySize = (size_t)width * height, uvSize = (size_t)width * (height / 2);
+    uint8_t* out = dst + NVLZ_HEADER_SIZE;
+    const int yBytes = lz.compress(y, ySize, out, lz4CompressBound(ySize));
+    if (yBytes < 0) return -1;
+    const int uvBytes = lz.compress(uv, uvSize, out + yBytes, lz4CompressBound(uvSize));
+    if (uvBytes < 0) return -1;
+    putU32(dst, (uint32_t)yBytes);
+    putU32(dst + 4, (uint32_t)uvBytes);
+    return NVLZ_HEADER_SIZE + yBytes + uvBytes;
+}
+
+bool unpackNvlz(const uint8_t* src, size_t length, int width, int height, uint8_t* y, uint8_t* uv) {
+    if (width <= 0 || height <= 0 || length < (size_t)NVLZ_HEADER_SIZE) return false;
+    const size_t yBytes = getU32(src), uvBytes = getU32(src + 4);
+    if (yBytes > length - NVLZ_HEADER_SIZE || uvBytes > length - NVLZ_HEADER_SIZE - yBytes) return false;
+    const uint8_t* blocks = src + NVLZ_HEADER_SIZE;
+    return lz4Decompress(blocks, yBytes, y, (size_t)width * height) &&
+           lz4Decompress(blocks + yBytes, uvBytes, uv, (size_t)width * (height / 2));
+}
+
+} // namespace omt
@@ -0,0 +1,57 @@
+/**
+ * LZ4 block compression (the standard block format, no frame wrapper) and
+ * the NVLZ video payload built on it: NV12 planes compressed losslessly for
+ * links that cannot carry raw NV12 and have no VMX encoder.
+ *
+ *   NVLZ payload (after the 32-byte video extended header):
+ *     [Y block bytes u32][UV block bytes u32][LZ4 block of Y][LZ4 block of UV]
+ *
+ * Planes are tightly packed (stride == width) before compression; their raw
+ * sizes follow from the header's width and height, so the decoder needs no
+ * length fields of its own and rejects any block that does not expand to
+ * exactly its plane. Senders offer NVLZ only to receivers that sent
+ * <OMTCodecs Accept="NVLZ" />; everyone else keeps getting NV12.
+ *
+ * The compressor is greedy with one hash probe per position and skips
+ * ahead faster through data that does not match, so noisy camera luma costs
+ * little time for what it fails to save. Neither side allocates.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omt {
+
+constexpr int NVLZ_HEADER_SIZE = 8;
+
+/** Worst-case compressed size of n bytes (incompressible input grows slightly). */
+constexpr size_t lz4CompressBound(size_t n) { return n + n / 255 + 16; }
+
+class Lz4Compressor {
+public:
+    /**
+     * Compress n bytes into dst as one LZ4 block. Returns the block size, or
+     * -1 if dstCapacity < lz4CompressBound(n) or n exceeds 2 GB.
+     */
+    int compress(const uint8_t* src, size_t n, uint8_t* dst, size_t dstCapacity);
+
+private:
+    static constexpr int HASH_LOG = 12; // 16 KB of state, as reference LZ4's fast mode
+    uint32_t m_table[1u << HASH_LOG]; // last position seen with each 5-byte hash
+};
+
+/** Decode one LZ4 block; true only if it is well formed and fills exactly dstLength bytes. */
+bool lz4Decompress(const uint8_t* src, size_t length, uint8_t* dst, size_t dstLength);
+
+/** Largest NVLZ payload (excluding the video extended header) for a width x height frame. */
+size_t nvlzBound(int width, int height);
+
+/** Compress tightly packed NV12 planes into an NVLZ payload; returns its size or -1. */
+int packNvlz(Lz4Compressor& lz, const uint8_t* y, const uint8_t* uv, int width, int height, uint8_t* dst,
+             size_t dstCapacity);
+
+/** Expand an NVLZ payload into tightly packed NV12 planes; false if it is corrupt or the wrong size. */
+bool unpackNvlz(const uint8_t* src, size_t length, int width, int height, uint8_t* y, uint8_t* uv);
+
+} // namespace omt
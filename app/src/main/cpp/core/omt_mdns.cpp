@@ -0,0 +1,297 @@
+#define LOG_TAG "OmtMdns"
+#include "omt_mdns.h"
+#include "omt_log.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace omt {
+
+namespace {
+
+constexpr uint16_t MDNS_PORT = 5353;
+constexpr const char* MDNS_GROUP = "224.0.0.251";
+constexpr const char* SERVICE_TYPE = "_omt._tcp.local";
+constexpr const char* SERVICES_META = "_services._dns-sd._udp.local";
+constexpr uint32_t TTL_SHARED = 4500; // PTR records (RFC 6762 §10)
+constexpr uint32_t TTL_UNIQUE = 120;  // SRV, TXT, A
+constexpr uint32_t TTL_LEGACY = 10;   // unicast answers to one-shot resolvers (§6.7)
+constexpr int MAX_PACKET = 1500;
+
+enum : uint16_t { TYPE_A = 1, TYPE_PTR = 12, TYPE_TXT = 16, TYPE_SRV = 33, TYPE_ANY = 255 };
+constexpr uint16_t CLASS_IN = 1;
+constexpr uint16_t CACHE_FLUSH = 0x8000;
+
+/** Append-only DNS message writer; every put fails once the buffer is full. */
+struct Writer {
+    uint8_t* p;
+    int cap;
+    int len = 0;
+    bool ok = true;
+
+    void bytes(const void* src, int n) {
+        if (!ok || len + n > cap) { ok = false; return; }
+        std::memcpy(p + len, src, (size_t)n);
+        len += n;
+    }
+    void u8(uint8_t v) { bytes(&v, 1); }
+    void u16(uint16_t v) { uint8_t b[2] = {(uint8_t)(v >> 8), (uint8_t)v}; bytes(b, 2); }
+    void u32(uint32_t v) { u16((uint16_t)(v >> 16)); u16((uint16_t)v); }
+
+    /** firstLabel (an instance name: spaces, parentheses, dots) is one label; rest is dotted. */
+    void name(const std::string& firstLabel, const char* rest) {
+        if (!firstLabel.empty()) label(firstLabel.data(), firstLabel.size());
+        const char* s = rest;
+        while (*s) {
+            const char* dot = std::strchr(s, '.');
+            size_t n = dot ? (size_t)(dot - s) : std::strlen(s);
+            label(s, n);
+            s += n + (dot ? 1 : 0);
+        }
+        u8(0);
+    }
+    void label(const char* s, size_t n) {
+        if (n > 63) n = 63;
+        u8((uint8_t)n);
+        bytes(s, (int)n);
+    }
+    /** Reserve a 16-bit RDLENGTH; patch it with endRdata(). */
+    int beginRdata() { int at = len; u16(0); return at; }
+    void endRdata(int at) {
+        if (!ok) return;
+        int n = len - at - 2;
+        p[at] = (uint8_t)(n >> 8);
+        p[at + 1] = (uint8_t)n;
+    }
+};
+
+/**
+ * Read a possibly compressed name at off into dotted lower-case form.
+ * Returns the offset just past the name in the original position, or -1.
+ */
+int readName(const uint8_t* msg, int len, int off, std::string& out, bool* compressed) {
+    out.clear();
+    *compressed = false;
+    int end = -1;
+    for (int jumps = 0; off < len && jumps < 16;) {
+        uint8_t n = msg[off];
+        if (n == 0) return end >= 0 ? end : off + 1;
+        if ((n & 0xC0) == 0xC0) {
+            if (off + 1 >= len) return -1;
+            if (end < 0) end = off + 2;
+            *compressed = true;
+            off = ((n & 0x3F) << 8) | msg[off + 1];
+            jumps++;
+            continue;
+        }
+        if (off + 1 + n > len) return -1;
+        if (!out.empty()) out += '.';
+        for (int i = 0; i < n; i++) {
+            char c = (char)msg[off + 1 + i];
+            out += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+        }
+        off += 1 + n;
+    }
+    return -1;
+}
+
+std::string lower(std::string s) {
+    for (char& c : s) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    return s;
+}
+
+/** IPv4 address the kernel would use to reach the LAN (no packet is sent). */
+uint32_t defaultRouteAddress() {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+    sockaddr_in probe{};
+    probe.sin_family = AF_INET;
+    probe.sin_port = htons(MDNS_PORT);
+    inet_pton(AF_INET, "192.0.2.1", &probe.sin_addr); // TEST-NET-1; routed via the default route
+    sockaddr_in local{};
+    socklen_t len = sizeof(local);
+    uint32_t addr = 0;
+    if (connect(fd, (sockaddr*)&probe, sizeof(probe)) == 0 && getsockname(fd, (sockaddr*)&local, &len) == 0)
+        addr = local.sin_addr.s_addr;
+    close(fd);
+    return addr ? addr : htonl(INADDR_LOOPBACK);
+}
+
+} // namespace
+
+MdnsAdvertiser::~MdnsAdvertiser() {
+    stop();
+}
+
+bool MdnsAdvertiser::start(const std::string& sourceName, int port, const std::string& hostAddress) {
+    if (m_running.load()) return true;
+    char hostname[64] = {};
+    if (gethostname(hostname, sizeof(hostname) - 1) != 0 || !hostname[0]) std::strcpy(hostname, "omt-host");
+    if (char* dot = std::strchr(hostname, '.')) *dot = '\0';
+    // Same instance format as OmtDiscoveryRegistration: "HOSTNAME (Source Name)"
+    bool qualified = sourceName.find('(') != std::string::npos && sourceName.find(')') != std::string::npos;
+    m_instance = qualified ? sourceName : std::string(hostname) + " (" + sourceName + ")";
+    if (m_instance.size() > 63) m_instance.resize(63);
+    m_host = std::string(hostname) + ".local";
+    m_port = port;
+    m_address = 0;
+    if (!hostAddress.empty() && inet_pton(AF_INET, hostAddress.c_str(), &m_address) != 1) {
+        LOGE("Bad IPv4 address %s", hostAddress.c_str());
+        return false;
+    }
+    if (!m_address) m_address = defaultRouteAddress();
+
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOGE("mDNS socket: %s", std::strerror(errno));
+        return false;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    sockaddr_in bindAddr{};
+    bindAddr.sin_family = AF_INET;
+    bindAddr.sin_port = htons(MDNS_PORT);
+    bindAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    ip_mreq group{};
+    inet_pton(AF_INET, MDNS_GROUP, &group.imr_multiaddr);
+    group.imr_interface.s_addr = m_address;
+    uint8_t ttl = 255, loop = 1;
+    if (bind(fd, (sockaddr*)&bindAddr, sizeof(bindAddr)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) != 0) {
+        LOGE("mDNS bind/join on %s: %s", MDNS_GROUP, std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &group.imr_interface, sizeof(group.imr_interface));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    m_fd = fd;
+
+    char addr[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &m_address, addr, sizeof(addr));
+    LOGI("Advertising \"%s\" (%s) at %s:%d", m_instance.c_str(), SERVICE_TYPE, addr, port);
+    m_running.store(true);
+    m_thread = std::thread([this] { run(); });
+    return true;
+}
+
+void MdnsAdvertiser::stop() {
+    if (!m_running.exchange(false)) return;
+    if (m_thread.joinable()) m_thread.join();
+    announce(0); // goodbye
+    close(m_fd);
+    m_fd = -1;
+}
+
+int MdnsAdvertiser::buildResponse(uint8_t* dst, int capacity, uint32_t ttl, bool legacy, uint16_t id,
+                                  const uint8_t* question, int questionLength) const {
+    Writer w{dst, capacity};
+    w.u16(id);
+    w.u16(0x8400); // response, authoritative
+    w.u16(question ? 1 : 0);
+    w.u16(5); // answers: services PTR, PTR, SRV, TXT, A
+    w.u16(0);
+    w.u16(0);
+    if (question) w.bytes(question, questionLength);
+    // Unicast replies to legacy resolvers must not set the cache-flush bit.
+    const uint16_t uniqueClass = legacy ? CLASS_IN : (uint16_t)(CLASS_IN | CACHE_FLUSH);
+
+    w.name("", SERVICES_META);
+    w.u16(TYPE_PTR); w.u16(CLASS_IN); w.u32(ttl ? TTL_SHARED : 0);
+    int at = w.beginRdata(); w.name("", SERVICE_TYPE); w.endRdata(at);
+
+    w.name("", SERVICE_TYPE);
+    w.u16(TYPE_PTR); w.u16(CLASS_IN); w.u32(ttl ? TTL_SHARED : 0);
+    at = w.beginRdata(); w.name(m_instance, SERVICE_TYPE); w.endRdata(at);
+
+    w.name(m_instance, SERVICE_TYPE);
+    w.u16(TYPE_SRV); w.u16(uniqueClass); w.u32(ttl);
+    at = w.beginRdata(); w.u16(0); w.u16(0); w.u16((uint16_t)m_port); w.name("", m_host.c_str()); w.endRdata(at);
+
+    w.name(m_instance, SERVICE_TYPE);
+    w.u16(TYPE_TXT); w.u16(uniqueClass); w.u32(ttl);
+    at = w.beginRdata(); w.u8(0); w.endRdata(at); // one empty string: no TXT keys
+
+    w.name("", m_host.c_str());
+    w.u16(TYPE_A); w.u16(uniqueClass); w.u32(ttl);
+    at = w.beginRdata(); w.bytes(&m_address, 4); w.endRdata(at);
+    return w.ok ? w.len : -1;
+}
+
+void MdnsAdvertiser::announce(uint32_t ttl) {
+    uint8_t packet[MAX_PACKET];
+    int n = buildResponse(packet, sizeof(packet), ttl, false, 0, nullptr, 0);
+    if (n <= 0 || m_fd < 0) return;
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(MDNS_PORT);
+    inet_pton(AF_INET, MDNS_GROUP, &to.sin_addr);
+    sendto(m_fd, packet, (size_t)n, 0, (sockaddr*)&to, sizeof(to));
+}
+
+void MdnsAdvertiser::run() {
+    using Clock = std::chrono::steady_clock;
+    // RFC 6762 §8.3: at least two announcements, one second apart (doubling after).
+    int announcements = 0;
+    auto nextAnnounce = Clock::now();
+    const std::string service = lower(SERVICE_TYPE);
+    const std::string services = lower(SERVICES_META);
+    const std::string instance = lower(m_instance) + "." + service;
+    const std::string host = lower(m_host);
+
+    uint8_t msg[9000];
+    std::string qname;
+    while (m_running.load()) {
+        if (announcements < 3 && Clock::now() >= nextAnnounce) {
+            announce(TTL_UNIQUE);
+            nextAnnounce = Clock::now() + std::chrono::seconds(1 << announcements);
+            announcements++;
+        }
+        pollfd p{m_fd, POLLIN, 0};
+        if (poll(&p, 1, 250) <= 0) continue;
+        sockaddr_in from{};
+        socklen_t fromLen = sizeof(from);
+        int len = (int)recvfrom(m_fd, msg, sizeof(msg), 0, (sockaddr*)&from, &fromLen);
+        if (len < 12) continue;
+        const uint16_t flags = (uint16_t)(msg[2] << 8 | msg[3]);
+        if (flags & 0x8000) continue; // a response, not a query
+        const int questions = msg[4] << 8 | msg[5];
+        int off = 12;
+        bool match = false, compressed = false;
+        int matchStart = 0, matchLength = 0;
+        for (int q = 0; q < questions && off > 0 && !match; q++) {
+            int start = off;
+            off = readName(msg, len, off, qname, &compressed);
+            if (off < 0 || off + 4 > len) break;
+            uint16_t type = (uint16_t)(msg[off] << 8 | msg[off + 1]);
+            off += 4;
+            bool ptr = type == TYPE_PTR || type == TYPE_ANY;
+            match = (ptr && (qname == service || qname == services)) ||
+                    (qname == instance && (type == TYPE_SRV || type == TYPE_TXT || type == TYPE_ANY)) ||
+                    (qname == host && (type == TYPE_A || type == TYPE_ANY));
+            matchStart = start;
+            matchLength = off - start;
+        }
+        if (!match) continue;
+
+        uint8_t reply[MAX_PACKET];
+        if (ntohs(from.sin_port) != MDNS_PORT) {
+            // Legacy unicast (RFC 6762 §6.7): echo the id and question back to the sender.
+            // A compressed question name would point into the query, so only plain ones are echoed.
+            int n = buildResponse(reply, sizeof(reply), TTL_LEGACY, true, (uint16_t)(msg[0] << 8 | msg[1]),
+                                  compressed ? nullptr : msg + matchStart, compressed ? 0 : matchLength);
+            if (n > 0) sendto(m_fd, reply, (size_t)n, 0, (sockaddr*)&from, fromLen);
+        } else {
+            announce(TTL_UNIQUE);
+        }
+    }
+}
+
+} // namespace omt
@@ -0,0 +1,53 @@
+/**
+ * Minimal DNS-SD/mDNS advertiser (RFC 6762/6763) for host tools, the Linux
+ * counterpart of OmtDiscoveryRegistration: publishes one `_omt._tcp`
+ * instance named "HOSTNAME (Source Name)" so vMix and OMT viewers list it.
+ *
+ * Only the advertising half is implemented: the records are announced on
+ * start, re-sent in answer to matching queries (multicast, or unicast to
+ * legacy resolvers querying from a port other than 5353) and withdrawn with
+ * a TTL-0 goodbye on stop. No probing or conflict resolution — pick unique
+ * source names. Shares UDP 5353 with avahi through SO_REUSEADDR/SO_REUSEPORT.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace omt {
+
+class MdnsAdvertiser {
+public:
+    MdnsAdvertiser() = default;
+    ~MdnsAdvertiser();
+    MdnsAdvertiser(const MdnsAdvertiser&) = delete;
+    MdnsAdvertiser& operator=(const MdnsAdvertiser&) = delete;
+
+    /**
+     * Start advertising port under sourceName ("HOSTNAME (sourceName)" unless it
+     * already has the parenthesised form). hostAddress is the IPv4 address put in
+     * the A record; empty picks the address of the default-route interface.
+     */
+    bool start(const std::string& sourceName, int port, const std::string& hostAddress = "");
+    void stop();
+
+    const std::string& instanceName() const { return m_instance; }
+
+private:
+    int buildResponse(uint8_t* dst, int capacity, uint32_t ttl, bool legacy, uint16_t id,
+                      const uint8_t* question, int questionLength) const;
+    void announce(uint32_t ttl);
+    void run();
+
+    int m_fd = -1;
+    int m_port = 0;
+    uint32_t m_address = 0; // network byte order
+    std::string m_instance;
+    std::string m_host; // "<hostname>.local"
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+};
+
+} // namespace omt
@@ -0,0 +1,286 @@
+#define LOG_TAG "OmtMetrics"
+#include "omt_metrics.h"
+#include "omt_log.h"
+#include "omt_stats.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+namespace omt {
+
+namespace {
+
+std::mutex s_serverMutex;
+std::thread s_thread;
+int s_listenFd = -1;
+int s_wakePipe[2] = {-1, -1};
+std::atomic<bool> s_running{false};
+
+void appendf(std::string& out, const char* fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) out.append(buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+/** Label values may come from peers and thread names: escape \, " and newlines. */
+std::string escapeLabel(const char* s) {
+    std::string out;
+    for (; *s; s++) {
+        if (*s == '\\' || *s == '"') { out += '\\'; out += *s; }
+        else if (*s == '\n') out += "\\n";
+        else out += *s;
+    }
+    return out;
+}
+
+void header(std::string& out, const char* name, const char* type, const char* help) {
+    appendf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void summary(std::string& out, const char* name, const std::string& labels, const HistogramSnapshot& s) {
+    const char* sep = labels.empty() ? "" : ",";
+    appendf(out, "%s{%s%squantile=\"0.5\"} %.9f\n", name, labels.c_str(), sep, s.p50 / 1e9);
+    appendf(out, "%s{%s%squantile=\"0.99\"} %.9f\n", name, labels.c_str(), sep, s.p99 / 1e9);
+    appendf(out, "%s{%s%squantile=\"0.999\"} %.9f\n", name, labels.c_str(), sep, s.p999 / 1e9);
+    appendf(out, "%s_sum{%s} %.9f\n", name, labels.c_str(), (double)s.mean * s.count / 1e9);
+    appendf(out, "%s_count{%s} %llu\n", name, labels.c_str(), (unsigned long long)s.count);
+}
+
+void renderThreadCpu(std::string& out) {
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return;
+    const double tick = (double)sysconf(_SC_CLK_TCK);
+    header(out, "omt_thread_cpu_seconds_total", "counter", "User+system CPU time per thread.");
+    while (dirent* e = readdir(dir)) {
+        if (e->d_name[0] < '0' || e->d_name[0] > '9') continue;
+        char path[64], stat[512];
+        std::snprintf(path, sizeof(path), "/proc/self/task/%.32s/stat", e->d_name); // tids are at most 10 digits
+        FILE* f = std::fopen(path, "r");
+        if (!f) continue;
+        size_t n = std::fread(stat, 1, sizeof(stat) - 1, f);
+        std::fclose(f);
+        stat[n] = 0;
+        // "tid (comm) state ..." — comm may contain spaces or ')', so split on the last ')'
+        char* open = std::strchr(stat, '(');
+        char* close = std::strrchr(stat, ')');
+        if (!open || !close || close < open) continue;
+        *close = 0;
+        unsigned long long utime = 0, stime = 0;
+        // Fields after comm: state(3) … utime(14) stime(15)
+        if (std::sscanf(close + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2)
+            continue;
+        appendf(out, "omt_thread_cpu_seconds_total{tid=\"%s\",thread=\"%s\"} %.2f\n",
+                e->d_name, escapeLabel(open + 1).c_str(), (utime + stime) / tick);
+    }
+    closedir(dir);
+}
+
+void renderMemory(std::string& out) {
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return;
+    unsigned long long size = 0, resident = 0;
+    int got = std::fscanf(f, "%llu %llu", &size, &resident);
+    std::fclose(f);
+    if (got != 2) return;
+    header(out, "process_resident_memory_bytes", "gauge", "Resident set size.");
+    appendf(out, "process_resident_memory_bytes %llu\n", resident * (unsigned long long)sysconf(_SC_PAGESIZE));
+}
+
+void handleScrape(int fd) {
+    timeval tv{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    char req[2048];
+    size_t got = 0;
+    while (got < sizeof(req) - 1) {
+        ssize_t n = recv(fd, req + got, sizeof(req) - 1 - got, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += (size_t)n;
+        req[got] = 0;
+        if (std::strstr(req, "\r\n\r\n")) break;
+    }
+    req[got] = 0;
+
+    std::string body;
+    const char* status = "200 OK";
+    if (std::strncmp(req, "GET /metrics", 12) == 0 && (req[12] == ' ' || req[12] == '?')) {
+        metricsRender(body);
+    } else {
+        status = "404 Not Found";
+        body = "Try /metrics\n";
+    }
+    std::string resp;
+    appendf(resp, "HTTP/1.1 %s\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                  "Content-Length: %zu\r\nConnection: close\r\n\r\n", status, body.size());
+    resp += body;
+    const char* p = resp.data();
+    size_t left = resp.size();
+    while (left > 0) {
+        ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        p += n;
+        left -= (size_t)n;
+    }
+}
+
+void serveLoop(int listenFd, int wakeFd) {
+    pthread_setname_np(pthread_self(), "OmtMetrics");
+    pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    while (s_running.load(std::memory_order_relaxed)) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOGE("poll failed: %s", std::strerror(errno));
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        handleScrape(fd);
+        close(fd);
+    }
+}
+
+} // namespace
+
+int metricsConfiguredPort() {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.omt.metrics_port", value) <= 0) return 0;
+    const char* v = value;
+#else
+    const char* v = std::getenv("OMT_METRICS_PORT");
+    if (!v) return 0;
+#endif
+    int port = std::atoi(v);
+    return port > 0 && port < 65536 ? port : 0;
+}
+
+bool metricsServerStart(int port) {
+    std::lock_guard<std::mutex> lock(s_serverMutex);
+    if (s_running.load()) return true;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0 || pipe2(s_wakePipe, O_CLOEXEC) != 0) {
+        LOGE("Metrics listen on :%d failed: %s", port, std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    s_listenFd = fd;
+    s_running.store(true);
+    s_thread = std::thread(serveLoop, s_listenFd, s_wakePipe[0]);
+    LOGI("Metrics on http://0.0.0.0:%d/metrics", port);
+    return true;
+}
+
+void metricsServerStop() {
+    std::lock_guard<std::mutex> lock(s_serverMutex);
+    if (!s_running.exchange(false)) return;
+    char b = 0;
+    if (write(s_wakePipe[1], &b, 1) < 0) LOGW("Metrics wake failed: %s", std::strerror(errno));
+    if (s_thread.joinable()) s_thread.join();
+    close(s_listenFd);
+    close(s_wakePipe[0]);
+    close(s_wakePipe[1]);
+    s_listenFd = s_wakePipe[0] = s_wakePipe[1] = -1;
+}
+
+bool metricsServerRunning() {
+    return s_running.load();
+}
+
+void metricsRender(std::string& out) {
+    out.reserve(out.size() + 16384);
+
+    header(out, "omt_frames_total", "counter", "Video frames by pipeline event.");
+    for (int c = COUNTER_FRAMES_CAPTURED; c <= COUNTER_FRAMES_PRESENTED; c++)
+        appendf(out, "omt_frames_total{event=\"%s\"} %llu\n", counterName(c), (unsigned long long)statsCounter(c));
+    appendf(out, "omt_frames_total{event=\"%s\"} %llu\n", counterName(COUNTER_FRAMES_ENCODE_FALLBACK),
+            (unsigned long long)statsCounter(COUNTER_FRAMES_ENCODE_FALLBACK));
+    header(out, "omt_bytes_total", "counter", "OMT bytes on the wire.");
+    for (int c = COUNTER_BYTES_SENT; c <= COUNTER_BYTES_RECEIVED; c++)
+        appendf(out, "omt_bytes_total{direction=\"%s\"} %llu\n", counterName(c), (unsigned long long)statsCounter(c));
+
+    header(out, "omt_fps", "gauge", "Frame rate over the last log interval.");
+    appendf(out, "omt_fps{stream=\"sent\"} %.2f\n", statsGauge(GAUGE_FPS_SENT));
+    appendf(out, "omt_fps{stream=\"presented\"} %.2f\n", statsGauge(GAUGE_FPS_PRESENTED));
+    header(out, "omt_clients", "gauge", "Connected OMT clients.");
+    appendf(out, "omt_clients %.0f\n", statsGauge(GAUGE_CLIENTS));
+    header(out, "omt_queue_depth", "gauge", "Frames waiting at a pipeline hand-off.");
+    for (int g = GAUGE_SENDER_PENDING; g <= GAUGE_VIEWER_POOL; g++)
+        appendf(out, "omt_queue_depth{queue=\"%s\"} %.0f\n", gaugeName(g), statsGauge(g));
+    header(out, "omt_encode_quality", "gauge", "Last sampled encode round trip (PSNR dB, SSIM); 0 when not sampling.");
+    for (int g = GAUGE_QUALITY_PSNR; g <= GAUGE_QUALITY_SSIM; g++)
+        appendf(out, "omt_encode_quality{metric=\"%s\"} %.4f\n", gaugeName(g), statsGauge(g));
+
+    header(out, "omt_frame_drops_total", "counter", "Dropped frames by cause.");
+    for (int c = 0; c < DROP_CAUSE_COUNT; c++)
+        appendf(out, "omt_frame_drops_total{cause=\"%s\"} %llu\n", dropCauseName(c), (unsigned long long)statsDropCount(c));
+
+    header(out, "omt_stage_latency_seconds", "summary", "Per-stage frame latency.");
+    for (int st = 0; st < STAGE_COUNT; st++) {
+        HistogramSnapshot s;
+        if (statsSnapshot(st, &s)) summary(out, "omt_stage_latency_seconds", std::string("stage=\"") + stageName(st) + "\"", s);
+    }
+
+    // Per-client series only for slots that currently hold a labelled client
+    std::string clientBytes, clientLatency, clientDrops;
+    for (int slot = 0; slot < STATS_MAX_CLIENTS; slot++) {
+        char label[48];
+        if (!statsClientLabel(slot, label, sizeof(label))) continue;
+        char base[96];
+        std::snprintf(base, sizeof(base), "client=\"%d\",peer=\"%s\"", slot, escapeLabel(label).c_str());
+        appendf(clientBytes, "omt_client_bytes_total{%s} %llu\n", base, (unsigned long long)statsClientBytes(slot));
+        HistogramSnapshot s;
+        if (statsSnapshotClient(slot, &s)) summary(clientLatency, "omt_client_write_latency_seconds", base, s);
+        for (int c = 0; c < DROP_CAUSE_COUNT; c++) {
+            uint64_t n = statsDropCountClient(slot, c);
+            if (n) appendf(clientDrops, "omt_client_frame_drops_total{%s,cause=\"%s\"} %llu\n", base, dropCauseName(c),
+                           (unsigned long long)n);
+        }
+    }
+    if (!clientBytes.empty()) {
+        header(out, "omt_client_bytes_total", "counter", "Bytes written per client.");
+        out += clientBytes;
+        header(out, "omt_client_write_latency_seconds", "summary", "Frame queued to written, per client.");
+        out += clientLatency;
+        if (!clientDrops.empty()) {
+            header(out, "omt_client_frame_drops_total", "counter", "Dropped frames charged to a client.");
+            out += clientDrops;
+        }
+    }
+
+    renderThreadCpu(out);
+    renderMemory(out);
+}
+
+} // namespace omt
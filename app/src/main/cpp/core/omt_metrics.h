@@ -0,0 +1,28 @@
+/**
+ * Optional Prometheus text-format endpoint (GET /metrics) for the stats in
+ * omt_stats plus per-thread CPU time and resident memory.
+ *
+ * The server is a single thread parked in poll() on the listening socket:
+ * nothing is computed until a scrape arrives, and the pipeline only ever
+ * touches the relaxed atomics it already updates. Off unless started; the
+ * port comes from `debug.omt.metrics_port` on Android or OMT_METRICS_PORT on
+ * hosts, or is passed explicitly.
+ */
+#pragma once
+
+#include <string>
+
+namespace omt {
+
+/** Configured port, or 0 when metrics are disabled. */
+int metricsConfiguredPort();
+
+/** Start serving on 0.0.0.0:port. Returns false if binding failed; true if already running. */
+bool metricsServerStart(int port);
+void metricsServerStop();
+bool metricsServerRunning();
+
+/** Render the current metrics in Prometheus text exposition format 0.0.4. */
+void metricsRender(std::string& out);
+
+} // namespace omt
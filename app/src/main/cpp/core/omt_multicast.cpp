@@ -0,0 +1,532 @@
+#define LOG_TAG "OmtMulticast"
+#include "omt_multicast.h"
+#include "omt_log.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+namespace omt {
+
+namespace {
+
+constexpr size_t DATAGRAM_HEADER = 24;
+constexpr uint8_t MULTICAST_VERSION = 1;
+constexpr uint8_t KIND_DATA = 0;
+constexpr uint8_t KIND_PARITY = 1;
+constexpr int BATCH = 64;            // datagrams per sendmmsg / recvmmsg
+constexpr int IOV_PER_DATAGRAM = 4;  // header + a fragment spanning up to three frame pieces
+constexpr int MAX_DATAGRAM = 9000;   // jumbo frames at most
+constexpr int MIN_DATAGRAM = 256;
+constexpr int MAX_FRAGMENTS = 65535;
+constexpr size_t MAX_FRAME_BYTES = 64u << 20; // largest frame a receiver reassembles, as the Demuxer's default
+constexpr int MAX_DATAGRAMS_PER_EVENT = 4 * BATCH;
+
+struct DatagramHeader {
+    uint8_t kind;
+    uint16_t index;
+    uint32_t sequence;
+    uint32_t sourceId;
+    uint32_t frameId;
+    uint32_t frameLength;
+    uint16_t fragmentBytes;
+    uint8_t fecGroup;
+};
+
+void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+uint16_t getU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+void writeDatagramHeader(uint8_t* p, const DatagramHeader& h) {
+    p[0] = MULTICAST_VERSION;
+    p[1] = h.kind;
+    putU16(p + 2, h.index);
+    putU32(p + 4, h.sequence);
+    putU32(p + 8, h.sourceId);
+    putU32(p + 12, h.frameId);
+    putU32(p + 16, h.frameLength);
+    putU16(p + 20, h.fragmentBytes);
+    p[22] = h.fecGroup;
+    p[23] = 0;
+}
+
+bool parseDatagramHeader(const uint8_t* p, size_t length, DatagramHeader* h) {
+    if (length < DATAGRAM_HEADER || p[0] != MULTICAST_VERSION) return false;
+    h->kind = p[1];
+    h->index = getU16(p + 2);
+    h->sequence = getU32(p + 4);
+    h->sourceId = getU32(p + 8);
+    h->frameId = getU32(p + 12);
+    h->frameLength = getU32(p + 16);
+    h->fragmentBytes = getU16(p + 20);
+    h->fecGroup = p[22];
+    // The receiver sizes its reassembly buffers from these fields, so anything no sender would emit is
+    // rejected before they are allocated.
+    if (h->fragmentBytes == 0 || h->fragmentBytes > (size_t)MAX_DATAGRAM - DATAGRAM_HEADER) return false;
+    if (h->frameLength < HEADER_SIZE || h->frameLength > MAX_FRAME_BYTES) return false;
+    const size_t fragments = ((size_t)h->frameLength + h->fragmentBytes - 1) / h->fragmentBytes;
+    return fragments <= (size_t)MAX_FRAGMENTS && (h->kind == KIND_DATA || h->kind == KIND_PARITY);
+}
+
+/** The up-to-three pieces a wire frame is handed over in, addressed as one range. */
+struct Pieces {
+    const uint8_t* ptr[3];
+    size_t len[3];
+
+    /** Call fn(ptr, n) for each contiguous run of [offset, offset + length). */
+    template <typename Fn>
+    void forRange(size_t offset, size_t length, Fn fn) const {
+        for (int i = 0; i < 3 && length > 0; i++) {
+            if (offset >= len[i]) {
+                offset -= len[i];
+                continue;
+            }
+            const size_t n = std::min(len[i] - offset, length);
+            fn(ptr[i] + offset, n);
+            offset = 0;
+            length -= n;
+        }
+    }
+};
+
+void xorInto(uint8_t* dst, const uint8_t* src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] ^= src[i];
+}
+
+/** 239.255.X.Y from the low half of the first up, non-loopback IPv4 address: distinct per device on a /16. */
+std::string defaultGroup() {
+    std::string group = "239.255.0.1";
+    ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) return group;
+    for (ifaddrs* it = list; it; it = it->ifa_next) {
+        if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET || !(it->ifa_flags & IFF_UP) ||
+            (it->ifa_flags & IFF_LOOPBACK))
+            continue;
+        const uint32_t a = ntohl(((const sockaddr_in*)it->ifa_addr)->sin_addr.s_addr);
+        char buf[INET_ADDRSTRLEN];
+        std::snprintf(buf, sizeof(buf), "239.255.%u.%u", (a >> 8) & 0xff, a & 0xff);
+        group = buf;
+        break;
+    }
+    freeifaddrs(list);
+    return group;
+}
+
+bool parseAddress(const std::string& text, in_addr* out) {
+    return inet_pton(AF_INET, text.c_str(), out) == 1;
+}
+
+} // namespace
+
+bool parseMulticastSpec(const char* spec, MulticastConfig* config) {
+    if (!spec || !*spec) return false;
+    if (!std::strcmp(spec, "1")) return true;
+    MulticastConfig c = *config;
+    const char* p = spec;
+    const size_t groupLen = std::strcspn(p, ":,");
+    if (groupLen > 0) {
+        c.group.assign(p, groupLen);
+        in_addr addr;
+        if (!parseAddress(c.group, &addr) || !IN_MULTICAST(ntohl(addr.s_addr))) return false;
+        p += groupLen;
+    }
+    char* end;
+    if (*p == ':') {
+        const long port = std::strtol(p + 1, &end, 10);
+        if (end == p + 1 || port < 1 || port > 65535) return false;
+        c.port = (int)port;
+        p = end;
+    }
+    if (*p == ',') {
+        const long fec = std::strtol(p + 1, &end, 10);
+        if (end == p + 1 || fec < 0 || fec > 255) return false;
+        c.fecGroup = (int)fec;
+        p = end;
+    }
+    if (*p) return false;
+    *config = c;
+    return true;
+}
+
+bool multicastConfigured(MulticastConfig* config) {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.omt.multicast", value) <= 0) return false;
+#else
+    const char* value = std::getenv("OMT_MULTICAST");
+    if (!value) return false;
+#endif
+    if (parseMulticastSpec(value, config)) return true;
+    LOGW("Ignoring multicast spec \"%s\" (expected [GROUP][:PORT][,FEC])", value);
+    return false;
+}
+
+int formatMulticastOffer(char* out, size_t outLen, const MulticastConfig& config) {
+    const int n = std::snprintf(out, outLen, "<OMTMulticast Address=\"%s\" Port=\"%d\" />", config.group.c_str(),
+                                config.port);
+    return n > 0 && (size_t)n < outLen ? n : -1;
+}
+
+// ---- Sender ----
+
+MulticastSender::MulticastSender(MulticastConfig config) : m_config(std::move(config)) {
+    m_config.datagramBytes = std::max(MIN_DATAGRAM, std::min(m_config.datagramBytes, MAX_DATAGRAM));
+    m_config.fecGroup = std::max(0, std::min(m_config.fecGroup, 255));
+}
+
+MulticastSender::~MulticastSender() { stop(); }
+
+bool MulticastSender::start() {
+    if (running()) return true;
+    if (m_config.group.empty()) m_config.group = defaultGroup();
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons((uint16_t)m_config.port);
+    if (!parseAddress(m_config.group, &dest.sin_addr) || !IN_MULTICAST(ntohl(dest.sin_addr.s_addr))) {
+        LOGE("Not a multicast group: %s", m_config.group.c_str());
+        return false;
+    }
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOGE("socket failed: %s", std::strerror(errno));
+        return false;
+    }
+    const unsigned char ttl = (unsigned char)std::max(1, std::min(m_config.ttl, 255));
+    const unsigned char loop = 1; // receivers on this host (tools, tests) hear it too
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &m_config.socketBufferBytes, sizeof(m_config.socketBufferBytes));
+    in_addr iface;
+    if (!m_config.interfaceAddress.empty() &&
+        (!parseAddress(m_config.interfaceAddress, &iface) ||
+         setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) != 0))
+        LOGW("Cannot send multicast from %s; using the default interface", m_config.interfaceAddress.c_str());
+    // Connected: sendmmsg needs no per-message address.
+    if (connect(fd, (sockaddr*)&dest, sizeof(dest)) != 0) {
+        LOGE("Cannot send to %s:%d: %s", m_config.group.c_str(), m_config.port, std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_headers.assign((size_t)BATCH * DATAGRAM_HEADER, 0);
+    m_iov.assign((size_t)BATCH * IOV_PER_DATAGRAM, iovec{});
+    m_msgs.assign(BATCH, mmsghdr{});
+    // Distinguishes a restarted sender (frame ids start over) and others sharing the group.
+    m_sourceId = (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count() ^ ((uint32_t)getpid() << 16);
+    m_sequence = 0;
+    m_frameId = 0;
+    m_fd = fd;
+    LOGI("Multicast to %s:%d, %d-byte datagrams, FEC 1/%d", m_config.group.c_str(), m_config.port,
+         m_config.datagramBytes, m_config.fecGroup);
+    return true;
+}
+
+void MulticastSender::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) return;
+    close(m_fd);
+    m_fd = -1;
+    LOGI("Multicast stopped: %llu frames sent, %llu dropped, %.1f MB", (unsigned long long)framesSent(),
+         (unsigned long long)framesDropped(), bytesSent() / 1e6);
+}
+
+bool MulticastSender::flush(int count) {
+    int done = 0;
+    while (done < count) {
+        const int n = sendmmsg(m_fd, m_msgs.data() + done, (unsigned)(count - done), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n > 0) {
+            for (int i = done; i < done + n; i++) m_bytesSent.fetch_add(m_msgs[i].msg_len, std::memory_order_relaxed);
+            m_datagramsSent.fetch_add((uint64_t)n, std::memory_order_relaxed);
+            done += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        // EAGAIN: the socket buffer is full — the link is slower than the stream.
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS)
+            LOGW("Multicast send failed: %s", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool MulticastSender::send(const uint8_t* head, size_t headLen, const uint8_t* body, size_t bodyLen,
+                           const uint8_t* tail, size_t tailLen) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) return false;
+    const Pieces pieces = {{head, body, tail}, {headLen, body ? bodyLen : 0, tail ? tailLen : 0}};
+    const size_t total = pieces.len[0] + pieces.len[1] + pieces.len[2];
+    const size_t fragmentBytes = (size_t)m_config.datagramBytes - DATAGRAM_HEADER;
+    const size_t fragments = (total + fragmentBytes - 1) / fragmentBytes;
+    if (total < HEADER_SIZE || total > MAX_FRAME_BYTES || fragments > MAX_FRAGMENTS) {
+        m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const int k = m_config.fecGroup;
+    const size_t groups = k > 0 ? (fragments + k - 1) / k : 0;
+    // Parity of every group stays valid until the batch holding it is sent.
+    if (m_parity.size() < groups * fragmentBytes) m_parity.resize(groups * fragmentBytes);
+    if (groups) std::memset(m_parity.data(), 0, groups * fragmentBytes);
+
+    DatagramHeader h{};
+    h.sourceId = m_sourceId;
+    h.frameId = m_frameId++;
+    h.frameLength = (uint32_t)total;
+    h.fragmentBytes = (uint16_t)fragmentBytes;
+    h.fecGroup = (uint8_t)k;
+
+    int batched = 0;
+    auto add = [&](uint8_t kind, uint16_t index, const uint8_t* parity, size_t offset, size_t length) {
+        h.kind = kind;
+        h.index = index;
+        h.sequence = m_sequence++;
+        uint8_t* header = m_headers.data() + (size_t)batched * DATAGRAM_HEADER;
+        writeDatagramHeader(header, h);
+        iovec* iov = m_iov.data() + (size_t)batched * IOV_PER_DATAGRAM;
+        int n = 0;
+        iov[n++] = {header, DATAGRAM_HEADER};
+        if (parity) iov[n++] = {(void*)parity, fragmentBytes};
+        else pieces.forRange(offset, length, [&](const uint8_t* p, size_t len) { iov[n++] = {(void*)p, len}; });
+        mmsghdr& m = m_msgs[batched++];
+        m.msg_hdr = msghdr{};
+        m.msg_hdr.msg_iov = iov;
+        m.msg_hdr.msg_iovlen = (size_t)n;
+        m.msg_len = 0;
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < fragments && ok; i++) {
+        const size_t offset = i * fragmentBytes;
+        const size_t length = std::min(fragmentBytes, total - offset);
+        add(KIND_DATA, (uint16_t)i, nullptr, offset, length);
+        if (k > 0) {
+            uint8_t* parity = m_parity.data() + (i / k) * fragmentBytes;
+            size_t at = 0;
+            pieces.forRange(offset, length, [&](const uint8_t* p, size_t len) {
+                xorInto(parity + at, p, len);
+                at += len;
+            });
+            if ((i + 1) % k == 0 || i + 1 == fragments) add(KIND_PARITY, (uint16_t)(i / k), parity, 0, 0);
+        }
+        if (batched > BATCH - 2) { // room for a data + parity pair
+            ok = flush(batched);
+            batched = 0;
+        }
+    }
+    if (ok && batched > 0) ok = flush(batched);
+    if (ok) m_framesSent.fetch_add(1, std::memory_order_relaxed);
+    else m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+    return ok;
+}
+
+// ---- Receiver ----
+
+MulticastReceiver::MulticastReceiver(EventLoop& loop, MulticastConfig config, FrameCallback onFrame)
+    : m_loop(loop), m_config(std::move(config)), m_onFrame(std::move(onFrame)) { }
+
+MulticastReceiver::~MulticastReceiver() { stop(); }
+
+bool MulticastReceiver::start() {
+    if (m_fd >= 0) return true;
+    in_addr group;
+    if (!parseAddress(m_config.group, &group) || !IN_MULTICAST(ntohl(group.s_addr))) {
+        LOGW("Not a multicast group: %s", m_config.group.c_str());
+        return false;
+    }
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    const int one = 1;
+    // Several monitors on one host share the port.
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &m_config.socketBufferBytes, sizeof(m_config.socketBufferBytes));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)m_config.port);
+    addr.sin_addr = group; // only this group's datagrams, not every group on the port
+    ip_mreq mreq{};
+    mreq.imr_multiaddr = group;
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (!m_config.interfaceAddress.empty()) parseAddress(m_config.interfaceAddress, &mreq.imr_interface);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+        LOGW("Cannot join %s:%d: %s", m_config.group.c_str(), m_config.port, std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    m_buffers.assign((size_t)BATCH * MAX_DATAGRAM, 0);
+    m_iov.assign(BATCH, iovec{});
+    m_msgs.assign(BATCH, mmsghdr{});
+    for (int i = 0; i < BATCH; i++) {
+        m_iov[i] = {m_buffers.data() + (size_t)i * MAX_DATAGRAM, (size_t)MAX_DATAGRAM};
+        m_msgs[i].msg_hdr.msg_iov = &m_iov[i];
+        m_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    if (!m_loop.add(fd, LOOP_READ, [this](uint32_t) { onReadable(); })) {
+        close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_haveSource = m_delivered = false;
+    for (Assembly& a : m_slots) a.active = false;
+    return true;
+}
+
+void MulticastReceiver::stop() {
+    if (m_fd < 0) return;
+    m_loop.remove(m_fd);
+    close(m_fd);
+    m_fd = -1;
+}
+
+void MulticastReceiver::onReadable() {
+    for (int total = 0; total < MAX_DATAGRAMS_PER_EVENT && m_fd >= 0;) {
+        const int n = recvmmsg(m_fd, m_msgs.data(), BATCH, MSG_DONTWAIT, nullptr);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        for (int i = 0; i < n && m_fd >= 0; i++)
+            onDatagram(m_buffers.data() + (size_t)i * MAX_DATAGRAM, m_msgs[i].msg_len);
+        total += n;
+        if (n < BATCH) return; // drained
+    }
+}
+
+void MulticastReceiver::onDatagram(const uint8_t* p, size_t length) {
+    DatagramHeader h;
+    if (!parseDatagramHeader(p, length, &h)) return;
+    m_datagramsReceived++;
+    if (!m_haveSource || h.sourceId != m_sourceId) {
+        // New or restarted sender: its frame ids and sequence numbers start over.
+        m_haveSource = true;
+        m_sourceId = h.sourceId;
+        m_nextSequence = h.sequence;
+        m_delivered = false;
+        for (Assembly& a : m_slots) a.active = false;
+    }
+    const int32_t gap = (int32_t)(h.sequence - m_nextSequence);
+    if (gap >= 0) {
+        m_datagramsLost += (uint64_t)gap;
+        m_nextSequence = h.sequence + 1;
+    }
+    if (m_delivered && (int32_t)(h.frameId - m_lastFrameId) <= 0) return; // late, for a frame already done
+    const size_t body = length - DATAGRAM_HEADER;
+    Assembly* a = slotFor(h.frameId, h.frameLength, h.fragmentBytes, h.fecGroup);
+    if (!a || a->frameLength != h.frameLength || a->fragmentBytes != h.fragmentBytes) return;
+    const uint8_t* payload = p + DATAGRAM_HEADER;
+    int group;
+    if (h.kind == KIND_DATA) {
+        if (h.index >= a->fragments || a->have[h.index]) return;
+        const size_t offset = (size_t)h.index * a->fragmentBytes;
+        const size_t expect = std::min(a->fragmentBytes, a->frameLength - offset);
+        if (body != expect) return;
+        std::memcpy(a->data.data() + offset, payload, body);
+        a->have[h.index] = 1;
+        a->received++;
+        group = a->fecGroup > 0 ? h.index / a->fecGroup : -1;
+    } else {
+        if (a->fecGroup == 0 || h.index >= a->haveParity.size() || a->haveParity[h.index] ||
+            body != a->fragmentBytes)
+            return;
+        std::memcpy(a->parity.data() + (size_t)h.index * a->fragmentBytes, payload, body);
+        a->haveParity[h.index] = 1;
+        group = h.index;
+    }
+    if (group >= 0 && a->received < a->fragments) recover(*a, group);
+    if (a->received == a->fragments) complete(*a);
+}
+
+MulticastReceiver::Assembly* MulticastReceiver::slotFor(uint32_t frameId, size_t frameLength, size_t fragmentBytes,
+                                                        int fecGroup) {
+    Assembly* free = nullptr;
+    Assembly* oldest = nullptr;
+    for (Assembly& a : m_slots) {
+        if (a.active && a.frameId == frameId) return &a;
+        if (!a.active) free = free ? free : &a;
+        else if (!oldest || (int32_t)(a.frameId - oldest->frameId) < 0) oldest = &a;
+    }
+    Assembly* a = free;
+    if (!a) {
+        // More frames in flight than slots: the oldest will not complete in time.
+        if ((int32_t)(frameId - oldest->frameId) < 0) return nullptr;
+        m_framesLost++;
+        a = oldest;
+    }
+    const size_t fragments = (frameLength + fragmentBytes - 1) / fragmentBytes;
+    const size_t groups = fecGroup > 0 ? (fragments + fecGroup - 1) / fecGroup : 0;
+    a->active = true;
+    a->frameId = frameId;
+    a->frameLength = frameLength;
+    a->fragmentBytes = fragmentBytes;
+    a->fragments = (int)fragments;
+    a->fecGroup = fecGroup;
+    a->received = 0;
+    // Capacity is kept across frames: steady state does not allocate.
+    if (a->data.size() < fragments * fragmentBytes) a->data.resize(fragments * fragmentBytes);
+    a->have.assign(fragments, 0);
+    if (a->parity.size() < groups * fragmentBytes) a->parity.resize(groups * fragmentBytes);
+    a->haveParity.assign(groups, 0);
+    return a;
+}
+
+void MulticastReceiver::recover(Assembly& a, int group) {
+    if (!a.haveParity[group]) return;
+    const int first = group * a.fecGroup;
+    const int last = std::min(first + a.fecGroup, a.fragments);
+    int missing = -1;
+    for (int i = first; i < last; i++) {
+        if (a.have[i]) continue;
+        if (missing >= 0) return; // two gone: XOR parity cannot tell them apart
+        missing = i;
+    }
+    if (missing < 0) return;
+    // missing = parity ^ every other fragment of the group (short ones zero-padded)
+    uint8_t* dst = a.data.data() + (size_t)missing * a.fragmentBytes;
+    const size_t length = std::min(a.fragmentBytes, a.frameLength - (size_t)missing * a.fragmentBytes);
+    std::memcpy(dst, a.parity.data() + (size_t)group * a.fragmentBytes, length);
+    for (int i = first; i < last; i++) {
+        if (i == missing) continue;
+        const size_t offset = (size_t)i * a.fragmentBytes;
+        xorInto(dst, a.data.data() + offset, std::min(length, a.frameLength - offset));
+    }
+    a.have[missing] = 1;
+    a.received++;
+    m_fragmentsRecovered++;
+}
+
+void MulticastReceiver::complete(Assembly& a) {
+    a.active = false;
+    // Frames go out one after another, so anything older still open has lost fragments for good.
+    for (Assembly& other : m_slots) {
+        if (other.active && (int32_t)(other.frameId - a.frameId) < 0) {
+            other.active = false;
+            m_framesLost++;
+        }
+    }
+    m_delivered = true;
+    m_lastFrameId = a.frameId;
+    FrameHeader h;
+    if (!parseFrameHeader(a.data.data(), &h) || h.dataLength < 0 ||
+        HEADER_SIZE + (size_t)h.dataLength != a.frameLength) {
+        m_framesLost++;
+        return;
+    }
+    m_framesReceived++;
+    m_onFrame(h, a.data.data() + HEADER_SIZE, (size_t)h.dataLength);
+}
+
+} // namespace omt
@@ -0,0 +1,175 @@
+/**
+ * UDP multicast fan-out for preview and monitoring receivers: one
+ * transmission per frame serves every receiver on the subnet, while program
+ * receivers (vMix) keep their reliable TCP connection.
+ *
+ * Negotiated over TCP metadata like the shared-memory ring:
+ *   receiver → <OMTMulticast Request="true" />
+ *   sender   → <OMTMulticast Address="239.255.x.y" Port="6501" />
+ *   receiver joins the group, then → <OMTMulticast Attached="true" />
+ * and the sender stops queuing video and audio on that client's socket.
+ *
+ * Each wire frame (16-byte header + payload, as on TCP) is cut into
+ * fragments of datagramBytes; every datagram starts with a 24-byte header:
+ *   u8 version, u8 kind (0 data, 1 parity), u16 index (fragment / FEC group),
+ *   u32 sequence (per datagram, for loss counting), u32 sourceId (random per
+ *   start), u32 frameId, u32 frameLength, u16 fragmentBytes, u8 fecGroup, u8 0
+ * all little-endian. After every fecGroup data fragments a parity datagram
+ * carries their XOR (short fragments zero-padded), so a receiver rebuilds any
+ * one lost fragment per group. Frames missing more are dropped whole: a
+ * monitor shows the next frame instead of waiting for a retransmission.
+ *
+ * Sends never block (MSG_DONTWAIT through sendmmsg); when the socket buffer
+ * is full the rest of the frame is dropped and counted, so a slow link costs
+ * multicast frames, never the live TCP path.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include "omt_loop.h"
+#include "omt_protocol.h"
+
+namespace omt {
+
+struct MulticastConfig {
+    std::string group;            // IPv4 group; empty: 239.255.X.Y from the host's own address
+    int port = 6501;
+    int ttl = 1;                  // stay on the subnet
+    std::string interfaceAddress; // local address to send from / join on; empty: the routing table's choice
+    int datagramBytes = 1400;     // UDP payload per datagram, header included (fits VPN/tunnel MTUs)
+    int fecGroup = 8;             // data fragments per parity datagram (12.5% overhead); 0 disables FEC
+    int socketBufferBytes = 4 << 20;
+};
+
+/**
+ * Parse "[GROUP][:PORT][,FEC]", e.g. "239.255.1.20:6501,8", ":6600" or
+ * ",4"; "1" keeps the defaults. Fields not given keep their current values.
+ */
+bool parseMulticastSpec(const char* spec, MulticastConfig* config);
+/** Multicast requested through debug.omt.multicast / OMT_MULTICAST (a spec as above); fills config. */
+bool multicastConfigured(MulticastConfig* config);
+/** The sender's <OMTMulticast Address=… Port=… /> answer; returns its length, or -1 if out is too small. */
+int formatMulticastOffer(char* out, size_t outLen, const MulticastConfig& config);
+
+class MulticastSender {
+public:
+    explicit MulticastSender(MulticastConfig config);
+    ~MulticastSender();
+    MulticastSender(const MulticastSender&) = delete;
+    MulticastSender& operator=(const MulticastSender&) = delete;
+
+    /** Open the socket; resolves an empty group. */
+    bool start();
+    void stop();
+    bool running() const { return m_fd >= 0; }
+    const MulticastConfig& config() const { return m_config; }
+
+    /**
+     * Fragment and send one wire frame made of up to three pieces (as
+     * Recorder::record). Thread-safe; false if any of it was dropped.
+     */
+    bool send(const uint8_t* head, size_t headLen, const uint8_t* body, size_t bodyLen,
+              const uint8_t* tail = nullptr, size_t tailLen = 0);
+
+    uint64_t framesSent() const { return m_framesSent.load(std::memory_order_relaxed); }
+    uint64_t framesDropped() const { return m_framesDropped.load(std::memory_order_relaxed); }
+    uint64_t datagramsSent() const { return m_datagramsSent.load(std::memory_order_relaxed); }
+    uint64_t bytesSent() const { return m_bytesSent.load(std::memory_order_relaxed); }
+
+private:
+    bool flush(int count);
+
+    MulticastConfig m_config;
+    int m_fd = -1;
+    std::mutex m_mutex; // video and audio threads both send
+    uint32_t m_sourceId = 0;
+    uint32_t m_sequence = 0;
+    uint32_t m_frameId = 0;
+    std::vector<uint8_t> m_headers;  // one datagram header per batch entry
+    std::vector<uint8_t> m_parity;   // one fragment per FEC group of the current frame
+    std::vector<iovec> m_iov;        // up to IOV_PER_DATAGRAM per batch entry
+    std::vector<mmsghdr> m_msgs;
+    std::atomic<uint64_t> m_framesSent{0};
+    std::atomic<uint64_t> m_framesDropped{0};
+    std::atomic<uint64_t> m_datagramsSent{0};
+    std::atomic<uint64_t> m_bytesSent{0};
+};
+
+class MulticastReceiver {
+public:
+    /** payload points past the 16-byte header and is only valid during the call. */
+    using FrameCallback = std::function<void(const FrameHeader& header, const uint8_t* payload, size_t length)>;
+
+    MulticastReceiver(EventLoop& loop, MulticastConfig config, FrameCallback onFrame);
+    ~MulticastReceiver();
+    MulticastReceiver(const MulticastReceiver&) = delete;
+    MulticastReceiver& operator=(const MulticastReceiver&) = delete;
+
+    /** Join the group and register with the loop (loop thread, or before it runs). */
+    bool start();
+    /** Safe from within the frame callback; the object itself must outlive the call. */
+    void stop();
+    bool running() const { return m_fd >= 0; }
+
+    uint64_t framesReceived() const { return m_framesReceived; }
+    /** Frames given up: more fragments missing than FEC could rebuild. */
+    uint64_t framesLost() const { return m_framesLost; }
+    uint64_t fragmentsRecovered() const { return m_fragmentsRecovered; }
+    uint64_t datagramsReceived() const { return m_datagramsReceived; }
+    /** Gaps in the sender's datagram sequence. */
+    uint64_t datagramsLost() const { return m_datagramsLost; }
+
+private:
+    static constexpr int SLOTS = 4; // frames being reassembled at once
+
+    struct Assembly {
+        bool active = false;
+        uint32_t frameId = 0;
+        size_t frameLength = 0;
+        size_t fragmentBytes = 0;
+        int fragments = 0;
+        int fecGroup = 0;
+        int received = 0;
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> have;       // per data fragment
+        std::vector<uint8_t> parity;
+        std::vector<uint8_t> haveParity; // per FEC group
+    };
+
+    void onReadable();
+    void onDatagram(const uint8_t* p, size_t length);
+    Assembly* slotFor(uint32_t frameId, size_t frameLength, size_t fragmentBytes, int fecGroup);
+    void recover(Assembly& a, int group);
+    void complete(Assembly& a);
+
+    EventLoop& m_loop;
+    MulticastConfig m_config;
+    FrameCallback m_onFrame;
+    int m_fd = -1;
+    std::vector<uint8_t> m_buffers; // one datagram per batch entry
+    std::vector<iovec> m_iov;
+    std::vector<mmsghdr> m_msgs;
+    Assembly m_slots[SLOTS];
+    bool m_haveSource = false;
+    uint32_t m_sourceId = 0;
+    uint32_t m_nextSequence = 0;
+    bool m_delivered = false;
+    uint32_t m_lastFrameId = 0;
+
+    uint64_t m_framesReceived = 0;
+    uint64_t m_framesLost = 0;
+    uint64_t m_fragmentsRecovered = 0;
+    uint64_t m_datagramsReceived = 0;
+    uint64_t m_datagramsLost = 0;
+};
+
+} // namespace omt
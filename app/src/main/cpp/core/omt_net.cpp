@@ -0,0 +1,102 @@
+#define LOG_TAG "OmtNet"
+#include "omt_net.h"
+#include "omt_log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace omt {
+
+static int connectOne(const addrinfo* ai, int timeoutMs) {
+    int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+    if (fd < 0) return -1;
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int rc = connect(fd, ai->ai_addr, ai->ai_addrlen);
+    if (rc != 0 && errno == EINPROGRESS) {
+        pollfd p{fd, POLLOUT, 0};
+        rc = poll(&p, 1, timeoutMs) == 1 ? 0 : -1;
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (rc == 0 && (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0)) {
+            errno = err;
+            rc = -1;
+        }
+        if (rc != 0 && err == 0) errno = ETIMEDOUT;
+    }
+    if (rc != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, flags);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int tcpConnect(const char* host, int port, int timeoutMs) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[16];
+    std::snprintf(service, sizeof(service), "%d", port);
+    addrinfo* list = nullptr;
+    int gai = getaddrinfo(host, service, &hints, &list);
+    if (gai != 0) {
+        LOGE("Resolve %s failed: %s", host, gai_strerror(gai));
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* ai = list; ai && fd < 0; ai = ai->ai_next) fd = connectOne(ai, timeoutMs);
+    if (fd < 0) LOGE("Connect %s:%d failed: %s", host, port, std::strerror(errno));
+    freeaddrinfo(list);
+    return fd;
+}
+
+bool readFully(int fd, void* buf, size_t len) {
+    auto* p = (uint8_t*)buf;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* buf, size_t len) {
+    auto* p = (const uint8_t*)buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+bool sendMetadata(int fd, const char* xml, size_t xmlLen, int64_t timestamp) {
+    uint8_t frame[HEADER_SIZE + 1024];
+    int n = buildMetadataFrame(frame, sizeof(frame), xml, xmlLen, timestamp);
+    return n > 0 && writeFully(fd, frame, (size_t)n);
+}
+
+bool readFrame(int fd, FrameHeader* header, std::vector<uint8_t>& payload, size_t maxPayload) {
+    uint8_t raw[HEADER_SIZE];
+    if (!readFully(fd, raw, sizeof(raw))) return false;
+    if (!parseFrameHeader(raw, header) || (size_t)header->dataLength > maxPayload) return false;
+    payload.resize((size_t)header->dataLength);
+    return header->dataLength == 0 || readFully(fd, payload.data(), payload.size());
+}
+
+} // namespace omt
@@ -0,0 +1,30 @@
+/**
+ * Blocking POSIX socket helpers for the host tools: connect, exact reads and
+ * writes, and whole-frame OMT I/O. EINTR is retried; everything else fails.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "omt_protocol.h"
+
+namespace omt {
+
+/** Connect with TCP_NODELAY set. Returns the fd, or -1 (errno-style message logged). */
+int tcpConnect(const char* host, int port, int timeoutMs);
+
+bool readFully(int fd, void* buf, size_t len);
+bool writeFully(int fd, const void* buf, size_t len);
+
+/** Send one metadata frame carrying xml. */
+bool sendMetadata(int fd, const char* xml, size_t xmlLen, int64_t timestamp = 0);
+
+/**
+ * Read one frame: header, then dataLength bytes into payload (resized).
+ * Fails on EOF, a bad header or a payload above maxPayload.
+ */
+bool readFrame(int fd, FrameHeader* header, std::vector<uint8_t>& payload, size_t maxPayload = 64u << 20);
+
+} // namespace omt
@@ -0,0 +1,190 @@
+#include "omt_pattern.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+namespace omt {
+
+namespace {
+
+// white, yellow, cyan, green, magenta, red, blue, black (Y, Cb, Cr), BT.709 limited range
+constexpr uint8_t kBars[8][3] = {
+    {180, 128, 128}, {168, 44, 136}, {145, 147, 44}, {133, 63, 52},
+    {63, 193, 204}, {51, 109, 212}, {28, 212, 120}, {16, 128, 128},
+};
+
+constexpr int RAMP_PERIOD = 220;        // luma 16..235
+constexpr int RAMP_CHROMA_PERIOD = 64;  // chroma 96..159
+constexpr uint32_t ZONE_PHASE_STEP = 4; // 1/64 cycle per frame
+
+// 5x7 digits, one byte per row, bit 4 = leftmost column
+constexpr uint8_t kDigits[10][7] = {
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},
+};
+constexpr int COUNTER_DIGITS = 8;
+
+/**
+ * Squared distance of sample i from the centre of an n-sample axis (in half
+ * pixels) × 32/width, in 16.16 phase units (256 per cycle) and wrapped to 32
+ * bits — only bits 16..23 are used, so sums may wrap freely.
+ */
+uint32_t zoneTerm(int i, int n, int width) {
+    const double d = 2.0 * i - (n - 1);
+    return (uint32_t)((uint64_t)std::llround(d * d * 32.0 * 65536.0 / width) & 0xFFFFFFFFu);
+}
+
+} // namespace
+
+bool parsePatternKind(const char* name, PatternKind* kind) {
+    if (!std::strcmp(name, "bars")) *kind = PATTERN_BARS;
+    else if (!std::strcmp(name, "zoneplate") || !std::strcmp(name, "zone")) *kind = PATTERN_ZONE_PLATE;
+    else if (!std::strcmp(name, "ramp")) *kind = PATTERN_RAMP;
+    else return false;
+    return true;
+}
+
+const char* patternName(PatternKind kind) {
+    switch (kind) {
+    case PATTERN_BARS: return "bars";
+    case PATTERN_ZONE_PLATE: return "zoneplate";
+    case PATTERN_RAMP: return "ramp";
+    }
+    return "?";
+}
+
+bool testPatternConfigured(PatternKind* kind, int* width, int* height) {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.omt.pattern", value) <= 0) return false;
+#else
+    const char* env = std::getenv("OMT_PATTERN");
+    if (!env) return false;
+    char value[64] = {};
+    std::snprintf(value, sizeof(value), "%s", env);
+#endif
+    int w = 1920, h = 1080;
+    if (char* colon = std::strchr(value, ':')) {
+        *colon = '\0';
+        if (std::sscanf(colon + 1, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0 || (w | h) & 1) return false;
+    }
+    if (!parsePatternKind(value, kind)) return false;
+    *width = w;
+    *height = h;
+    return true;
+}
+
+bool TestPattern::configure(int width, int height) {
+    if (width < 2 || height < 2 || (width | height) & 1) return false;
+    if (width == m_width && height == m_height) return true;
+    m_width = width;
+    m_height = height;
+
+    m_barsY.resize((size_t)width);
+    m_barsUV.resize((size_t)width);
+    for (int c = 0; c < width; c++) m_barsY[c] = kBars[c * 8 / width][0];
+    for (int c = 0; c < width; c += 2) {
+        m_barsUV[c] = kBars[c * 8 / width][1];
+        m_barsUV[c + 1] = kBars[c * 8 / width][2];
+    }
+
+    m_rampY.resize((size_t)width + RAMP_PERIOD);
+    for (size_t i = 0; i < m_rampY.size(); i++) m_rampY[i] = (uint8_t)(16 + i % RAMP_PERIOD);
+    m_rampU.resize((size_t)width / 2 + RAMP_CHROMA_PERIOD);
+    for (size_t i = 0; i < m_rampU.size(); i++) m_rampU[i] = (uint8_t)(96 + i % RAMP_CHROMA_PERIOD);
+
+    m_zoneX.resize((size_t)width);
+    for (int c = 0; c < width; c++) m_zoneX[c] = zoneTerm(c, width, width);
+    // Same scale on both axes keeps the rings circular.
+    m_zoneY.resize((size_t)height / 2);
+    for (int r = 0; r < height / 2; r++) m_zoneY[r] = zoneTerm(r, height, width);
+    return true;
+}
+
+void TestPattern::render(PatternKind kind, uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const {
+    switch (kind) {
+    case PATTERN_BARS: renderBars(n, y, strideY, uv, strideUV); break;
+    case PATTERN_ZONE_PLATE: renderZonePlate(n, y, strideY, uv, strideUV); break;
+    case PATTERN_RAMP: renderRamp(n, y, strideY, uv, strideUV); break;
+    }
+}
+
+void TestPattern::renderBars(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const {
+    const int w = m_width, h = m_height;
+    for (int r = 0; r < h; r++) std::memcpy(y + (size_t)r * strideY, m_barsY.data(), (size_t)w);
+    for (int r = 0; r < h / 2; r++) std::memcpy(uv + (size_t)r * strideUV, m_barsUV.data(), (size_t)w);
+    // One sweep every 4 s at 60 fps; the marker makes dropped or repeated frames visible.
+    const int markerW = std::max(2, w / 64) & ~1;
+    if (markerW >= w) return;
+    const int x = (int)(n * (uint64_t)(w - markerW) / 240 % (uint64_t)(w - markerW)) & ~1;
+    for (int r = 0; r < h; r++) std::memset(y + (size_t)r * strideY + x, 235, (size_t)markerW);
+    for (int r = 0; r < h / 2; r++) std::memset(uv + (size_t)r * strideUV + x, 128, (size_t)markerW);
+}
+
+void TestPattern::renderZonePlate(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const {
+    const int w = m_width, h = m_height;
+    const uint32_t phase = (uint32_t)(n * ZONE_PHASE_STEP) << 16;
+    const uint32_t* zx = m_zoneX.data();
+    for (int r = 0; r < h / 2; r++) {
+        const uint32_t base = m_zoneY[r] + phase;
+        uint8_t* row = y + (size_t)r * strideY;
+        // Parabolic sine: one hump per half cycle, 17..235 around 126. Branch-free so it vectorises.
+        for (int c = 0; c < w; c++) {
+            const uint16_t s = (uint16_t)(((zx[c] + base) >> 16) & 0xFF);
+            const uint16_t u = s & 127;
+            const uint16_t hump = (uint16_t)(u * (128 - u));                 // 0..4096
+            const uint16_t d = (uint16_t)(((uint32_t)hump * 1744) >> 16);     // × 109/4096
+            row[c] = (uint8_t)((s & 128) ? 126 - d : 126 + d);
+        }
+        std::memcpy(y + (size_t)(h - 1 - r) * strideY, row, (size_t)w);
+    }
+    for (int r = 0; r < h / 2; r++) std::memset(uv + (size_t)r * strideUV, 128, (size_t)w);
+}
+
+void TestPattern::renderRamp(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const {
+    const int w = m_width, h = m_height;
+    const int shift = (int)(n * 4 % RAMP_PERIOD);
+    for (int r = 0; r < h; r++)
+        std::memcpy(y + (size_t)r * strideY, m_rampY.data() + (r + shift) % RAMP_PERIOD, (size_t)w);
+    const uint8_t* u = m_rampU.data() + shift % RAMP_CHROMA_PERIOD;
+    for (int r = 0; r < h / 2; r++) {
+        uint8_t* row = uv + (size_t)r * strideUV;
+        const uint8_t v = (uint8_t)(96 + (r + shift) % RAMP_CHROMA_PERIOD);
+        for (int i = 0; i < w / 2; i++) {
+            row[2 * i] = u[i];
+            row[2 * i + 1] = v;
+        }
+    }
+}
+
+void TestPattern::drawCounter(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const {
+    const int cell = std::max(2, m_height / 135) & ~1; // 16 px at 4K, 8 at 1080p
+    const int boxW = (COUNTER_DIGITS * 6 + 1) * cell, boxH = 9 * cell;
+    const int x0 = 2 * cell, y0 = m_height - 2 * cell - boxH;
+    if (y0 < 0 || x0 + boxW > m_width) return;
+    for (int r = y0; r < y0 + boxH; r++) std::memset(y + (size_t)r * strideY + x0, 16, (size_t)boxW);
+    for (int r = y0 / 2; r < (y0 + boxH) / 2; r++) std::memset(uv + (size_t)r * strideUV + x0, 128, (size_t)boxW);
+    for (int k = COUNTER_DIGITS - 1; k >= 0; k--, n /= 10) {
+        const uint8_t* glyph = kDigits[n % 10];
+        const int gx = x0 + (1 + k * 6) * cell;
+        for (int gr = 0; gr < 7; gr++) {
+            for (int gc = 0; gc < 5; gc++) {
+                if (!(glyph[gr] & (0x10 >> gc))) continue;
+                for (int r = 0; r < cell; r++)
+                    std::memset(y + (size_t)(y0 + (1 + gr) * cell + r) * strideY + gx + gc * cell, 235, (size_t)cell);
+            }
+        }
+    }
+}
+
+} // namespace omt
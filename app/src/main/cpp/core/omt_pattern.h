@@ -0,0 +1,67 @@
+/**
+ * Synthetic NV12 test patterns for lining up a receiver and measuring the
+ * encoder without a camera: colour bars, a moving zone plate and a moving
+ * ramp, with an optional frame-counter overlay.
+ *
+ * Rendering is row-oriented so it stays far below a frame period at 4K60:
+ * static rows are built once per size and copied, the zone plate computes
+ * only the top half (rows mirror about the centre) with wrap-around integer
+ * phase arithmetic that the compiler vectorises (NEON / SSE / AVX), and
+ * nothing allocates after configure().
+ *
+ * Enabled on the camera with `adb shell setprop debug.omt.pattern zoneplate`
+ * (optionally `zoneplate:3840x2160`); OMT_PATTERN on hosts.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace omt {
+
+enum PatternKind : int {
+    PATTERN_BARS = 0,       // BT.709 75% bars with a sweeping marker
+    PATTERN_ZONE_PLATE = 1, // circular zone plate reaching Nyquist at the left/right edges, rings moving
+    PATTERN_RAMP = 2,       // diagonal luma ramp and chroma ramps, scrolling
+};
+
+/** "bars", "zoneplate" / "zone", "ramp". */
+bool parsePatternKind(const char* name, PatternKind* kind);
+const char* patternName(PatternKind kind);
+
+/**
+ * Pattern requested through debug.omt.pattern / OMT_PATTERN as KIND[:WxH].
+ * Size defaults to 1920x1080. Returns false when unset or unparsable.
+ */
+bool testPatternConfigured(PatternKind* kind, int* width, int* height);
+
+class TestPattern {
+public:
+    /** Build the per-size row caches; width and height must be even. */
+    bool configure(int width, int height);
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    /** Render frame n into NV12 planes of the configured size. */
+    void render(PatternKind kind, uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const;
+
+    /** Frame number as white digits on black in the bottom-left corner (clear of the latency timecode). */
+    void drawCounter(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const;
+
+private:
+    void renderBars(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const;
+    void renderZonePlate(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const;
+    void renderRamp(uint64_t n, uint8_t* y, int strideY, uint8_t* uv, int strideUV) const;
+
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<uint8_t> m_barsY;   // one luma row
+    std::vector<uint8_t> m_barsUV;  // one chroma row
+    std::vector<uint8_t> m_rampY;   // luma cycle repeated past width + period, sliced per row
+    std::vector<uint8_t> m_rampU;   // Cb cycle, sliced per frame
+    std::vector<uint32_t> m_zoneX;  // per-column squared distance × frequency, 16.16 phase units
+    std::vector<uint32_t> m_zoneY;  // per-row term for the top half
+};
+
+} // namespace omt
@@ -0,0 +1,157 @@
+#include "omt_pixel.h"
+
+#include <cstring>
+
+namespace omt {
+
+// Clamp helper
+static inline int clamp255(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+void nv12ToRgba(const uint8_t* y, int strideY, const uint8_t* uv, int strideUV,
+                uint8_t* dst, int dstStride, int width, int height) {
+    // BT.709 coefficients (fixed point, shift 10)
+    const int CY = 1192;  // 1.164 * 1024
+    const int CRV = 1836; // 1.793 * 1024
+    const int CGU = 218;  // 0.213 * 1024
+    const int CGV = 546;  // 0.533 * 1024
+    const int CBU = 2163; // 2.112 * 1024
+
+    for (int row = 0; row < height; row++) {
+        const uint8_t* yRow = y + (size_t)row * strideY;
+        const uint8_t* uvRow = uv + (size_t)(row >> 1) * strideUV;
+        uint8_t* out = dst + (size_t)row * dstStride;
+        for (int col = 0; col < width; col += 2) {
+            // One UV pair covers two horizontal luma samples
+            int uVal = (int)uvRow[col] - 128;
+            int vVal = (int)uvRow[col + 1] - 128;
+            int rOff = CRV * vVal;
+            int gOff = -CGU * uVal - CGV * vVal;
+            int bOff = CBU * uVal;
+            int pair = (col + 1 < width) ? 2 : 1;
+            for (int k = 0; k < pair; k++) {
+                int c = CY * ((int)yRow[col + k] - 16);
+                uint8_t* px = out + (size_t)(col + k) * 4;
+                px[0] = (uint8_t)clamp255((c + rOff) >> 10); // RGBA byte order
+                px[1] = (uint8_t)clamp255((c + gOff) >> 10);
+                px[2] = (uint8_t)clamp255((c + bOff) >> 10);
+                px[3] = 0xFF;
+            }
+        }
+    }
+}
+
+void rgbaToNv12(const uint8_t* rgba, int stride, uint8_t* dstY, int strideY, uint8_t* dstUV, int strideUV,
+                int width, int height) {
+    // BT.709 limited range (fixed point, shift 10): Y = 16 + 0.1826R + 0.6142G + 0.0620B
+    const int YR = 187, YG = 629, YB = 63;
+    const int UR = -103, UG = -346, UB = 449; // Cb = 128 - 0.1006R - 0.3386G + 0.4392B
+    const int VR = 449, VG = -408, VB = -41;  // Cr = 128 + 0.4392R - 0.3989G - 0.0403B
+
+    for (int row = 0; row < height; row += 2) {
+        const uint8_t* p0 = rgba + (size_t)row * stride;
+        const uint8_t* p1 = p0 + stride;
+        uint8_t* y0 = dstY + (size_t)row * strideY;
+        uint8_t* y1 = y0 + strideY;
+        uint8_t* uv = dstUV + (size_t)(row >> 1) * strideUV;
+        for (int col = 0; col < width; col += 2) {
+            const uint8_t* a = p0 + (size_t)col * 4;
+            const uint8_t* b = p1 + (size_t)col * 4;
+            y0[col] = (uint8_t)(16 + ((YR * a[0] + YG * a[1] + YB * a[2] + 512) >> 10));
+            y0[col + 1] = (uint8_t)(16 + ((YR * a[4] + YG * a[5] + YB * a[6] + 512) >> 10));
+            y1[col] = (uint8_t)(16 + ((YR * b[0] + YG * b[1] + YB * b[2] + 512) >> 10));
+            y1[col + 1] = (uint8_t)(16 + ((YR * b[4] + YG * b[5] + YB * b[6] + 512) >> 10));
+            const int r = a[0] + a[4] + b[0] + b[4];
+            const int g = a[1] + a[5] + b[1] + b[5];
+            const int bl = a[2] + a[6] + b[2] + b[6];
+            uv[col] = (uint8_t)clamp255(128 + ((UR * r + UG * g + UB * bl + 2048) >> 12));
+            uv[col + 1] = (uint8_t)clamp255(128 + ((VR * r + VG * g + VB * bl + 2048) >> 12));
+        }
+    }
+}
+
+void swapBgraToRgba(uint8_t* buf, size_t numPixels) {
+    for (size_t i = 0; i < numPixels; i++) {
+        uint32_t v;
+        std::memcpy(&v, buf + i * 4, 4);
+        // BGRA byte order: [B,G,R,A] → RGBA byte order: [R,G,B,A]
+        v = (v & 0xFF00FF00u) | ((v & 0xFFu) << 16) | ((v >> 16) & 0xFFu);
+        std::memcpy(buf + i * 4, &v, 4);
+    }
+}
+
+void packNv12(const uint8_t* srcY, int yRowStride,
+              const uint8_t* srcU, int uRowStride, int uPixelStride,
+              const uint8_t* srcV, int vRowStride, int vPixelStride,
+              uint8_t* dstY, uint8_t* dstUV, int width, int height) {
+    if (yRowStride == width) {
+        std::memcpy(dstY, srcY, (size_t)width * height);
+    } else {
+        for (int row = 0; row < height; row++)
+            std::memcpy(dstY + (size_t)row * width, srcY + (size_t)row * yRowStride, width);
+    }
+
+    const int uvHeight = height / 2;
+    const int uvWidth = width / 2;
+    if (uPixelStride == 2 && vPixelStride == 2 && srcV == srcU + 1) {
+        // Semi-planar NV12 layout already: U plane view starts at U0 with V0 right after it.
+        for (int row = 0; row < uvHeight; row++)
+            std::memcpy(dstUV + (size_t)row * width, srcU + (size_t)row * uRowStride, (size_t)uvWidth * 2);
+        return;
+    }
+    for (int row = 0; row < uvHeight; row++) {
+        const uint8_t* u = srcU + (size_t)row * uRowStride;
+        const uint8_t* v = srcV + (size_t)row * vRowStride;
+        uint8_t* out = dstUV + (size_t)row * width;
+        for (int col = 0; col < uvWidth; col++) {
+            out[col * 2] = u[col * uPixelStride];
+            out[col * 2 + 1] = v[col * vPixelStride];
+        }
+    }
+}
+
+/** Bilinear resample of one plane with `comps` interleaved components per sample. */
+static void scalePlane(const uint8_t* src, int srcStride, int srcW, int srcH,
+                       uint8_t* dst, int dstStride, int dstW, int dstH, int comps) {
+    // 16.16 source position of each destination sample centre
+    const int64_t stepX = ((int64_t)srcW << 16) / dstW;
+    const int64_t stepY = ((int64_t)srcH << 16) / dstH;
+    const int64_t maxX = (int64_t)(srcW - 1) << 16;
+    const int64_t maxY = (int64_t)(srcH - 1) << 16;
+    int64_t fy = stepY / 2 - 0x8000;
+    for (int dy = 0; dy < dstH; dy++, fy += stepY) {
+        int64_t cy = fy < 0 ? 0 : (fy > maxY ? maxY : fy);
+        int y0 = (int)(cy >> 16);
+        int y1 = y0 + 1 < srcH ? y0 + 1 : y0;
+        int wy = (int)((cy >> 8) & 0xFF);
+        const uint8_t* r0 = src + (size_t)y0 * srcStride;
+        const uint8_t* r1 = src + (size_t)y1 * srcStride;
+        uint8_t* out = dst + (size_t)dy * dstStride;
+        int64_t fx = stepX / 2 - 0x8000;
+        for (int dx = 0; dx < dstW; dx++, fx += stepX) {
+            int64_t cx = fx < 0 ? 0 : (fx > maxX ? maxX : fx);
+            int x0 = (int)(cx >> 16);
+            int x1 = x0 + 1 < srcW ? x0 + 1 : x0;
+            int wx = (int)((cx >> 8) & 0xFF);
+            for (int c = 0; c < comps; c++) {
+                int a = r0[x0 * comps + c], b = r0[x1 * comps + c];
+                int d = r1[x0 * comps + c], e = r1[x1 * comps + c];
+                int top = (a << 8) + (b - a) * wx;
+                int bot = (d << 8) + (e - d) * wx;
+                out[dx * comps + c] = (uint8_t)(((top << 8) + (bot - top) * wy + 0x8000) >> 16);
+            }
+        }
+    }
+}
+
+void scaleNv12(const uint8_t* srcY, int srcStrideY, const uint8_t* srcUV, int srcStrideUV,
+               int srcWidth, int srcHeight,
+               uint8_t* dstY, uint8_t* dstUV, int dstWidth, int dstHeight) {
+    if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) return;
+    scalePlane(srcY, srcStrideY, srcWidth, srcHeight, dstY, dstWidth, dstWidth, dstHeight, 1);
+    scalePlane(srcUV, srcStrideUV, srcWidth / 2, srcHeight / 2,
+               dstUV, dstWidth, dstWidth / 2, dstHeight / 2, 2);
+}
+
+} // namespace omt
@@ -0,0 +1,50 @@
+/**
+ * Portable pixel kernels shared by the JNI wrapper, host tools and benchmarks.
+ * All functions take explicit strides (in bytes) and never allocate.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omt {
+
+/**
+ * Convert NV12 (Y + interleaved UV) to RGBA using BT.709 coefficients.
+ * Outputs RGBA byte order to match Android's ARGB_8888 memory layout.
+ */
+void nv12ToRgba(const uint8_t* y, int strideY, const uint8_t* uv, int strideUV,
+                uint8_t* dst, int dstStride, int width, int height);
+
+/**
+ * Convert RGBA to NV12 (BT.709 limited range), the inverse of nv12ToRgba.
+ * Chroma is taken from the average of each 2x2 block; width and height must be even.
+ */
+void rgbaToNv12(const uint8_t* rgba, int stride, uint8_t* dstY, int strideY, uint8_t* dstUV, int strideUV,
+                int width, int height);
+
+/**
+ * Swap BGRA → RGBA in-place (R and B exchanged, G and A unchanged).
+ */
+void swapBgraToRgba(uint8_t* buf, size_t numPixels);
+
+/**
+ * Pack a YUV_420_888 image (as delivered by CameraX) into tightly packed NV12.
+ * Handles both semi-planar sources (pixel stride 2, U/V interleaved) and
+ * fully planar sources (pixel stride 1). dstY is width*height bytes,
+ * dstUV is width*(height/2) bytes.
+ */
+void packNv12(const uint8_t* srcY, int yRowStride,
+              const uint8_t* srcU, int uRowStride, int uPixelStride,
+              const uint8_t* srcV, int vRowStride, int vPixelStride,
+              uint8_t* dstY, uint8_t* dstUV, int width, int height);
+
+/**
+ * Bilinear NV12 → NV12 rescale (fixed point, 16.16). Chroma is scaled as
+ * interleaved UV pairs. Destination planes are tightly packed.
+ */
+void scaleNv12(const uint8_t* srcY, int srcStrideY, const uint8_t* srcUV, int srcStrideUV,
+               int srcWidth, int srcHeight,
+               uint8_t* dstY, uint8_t* dstUV, int dstWidth, int dstHeight);
+
+} // namespace omt
@@ -0,0 +1,137 @@
+#include "omt_protocol.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace omt {
+
+void writeFrameHeader(uint8_t* dst, const FrameHeader& h) {
+    dst[0] = h.version;
+    dst[1] = h.type;
+    putU64(dst + 2, (uint64_t)h.timestamp);
+    dst[10] = (uint8_t)h.metadataLength;
+    dst[11] = (uint8_t)(h.metadataLength >> 8);
+    putU32(dst + 12, (uint32_t)h.dataLength);
+}
+
+bool parseFrameHeader(const uint8_t* src, FrameHeader* out) {
+    out->version = src[0];
+    out->type = src[1];
+    out->timestamp = (int64_t)getU64(src + 2);
+    out->metadataLength = (uint16_t)(src[10] | (src[11] << 8));
+    out->dataLength = (int32_t)getU32(src + 12);
+    return out->version == 1 && out->dataLength >= 0;
+}
+
+void writeVideoHeader(uint8_t* dst, const VideoHeader& h) {
+    uint32_t aspect;
+    std::memcpy(&aspect, &h.aspectRatio, 4);
+    putU32(dst, h.codec);
+    putU32(dst + 4, (uint32_t)h.width);
+    putU32(dst + 8, (uint32_t)h.height);
+    putU32(dst + 12, (uint32_t)h.frameRateN);
+    putU32(dst + 16, (uint32_t)h.frameRateD);
+    putU32(dst + 20, aspect);
+    putU32(dst + 24, (uint32_t)h.flags);
+    putU32(dst + 28, (uint32_t)h.colorSpace);
+}
+
+void parseVideoHeader(const uint8_t* src, VideoHeader* out) {
+    uint32_t aspect = getU32(src + 20);
+    out->codec = getU32(src);
+    out->width = (int32_t)getU32(src + 4);
+    out->height = (int32_t)getU32(src + 8);
+    out->frameRateN = (int32_t)getU32(src + 12);
+    out->frameRateD = (int32_t)getU32(src + 16);
+    std::memcpy(&out->aspectRatio, &aspect, 4);
+    out->flags = (int32_t)getU32(src + 24);
+    out->colorSpace = (int32_t)getU32(src + 28);
+}
+
+void writeAudioHeader(uint8_t* dst, const AudioHeader& h) {
+    putU32(dst, h.codec);
+    putU32(dst + 4, (uint32_t)h.sampleRate);
+    putU32(dst + 8, (uint32_t)h.samplesPerChannel);
+    putU32(dst + 12, (uint32_t)h.channels);
+    putU32(dst + 16, (uint32_t)h.activeChannels);
+    putU32(dst + 20, (uint32_t)h.reserved);
+}
+
+void parseAudioHeader(const uint8_t* src, AudioHeader* out) {
+    out->codec = getU32(src);
+    out->sampleRate = (int32_t)getU32(src + 4);
+    out->samplesPerChannel = (int32_t)getU32(src + 8);
+    out->channels = (int32_t)getU32(src + 12);
+    out->activeChannels = (int32_t)getU32(src + 16);
+    out->reserved = (int32_t)getU32(src + 20);
+}
+
+int buildMetadataFrame(uint8_t* dst, size_t dstLen, const char* xml, size_t xmlLen, int64_t timestamp) {
+    if (dstLen < HEADER_SIZE + xmlLen) return -1;
+    FrameHeader h;
+    h.type = FRAME_METADATA;
+    h.timestamp = timestamp;
+    h.dataLength = (int32_t)xmlLen;
+    writeFrameHeader(dst, h);
+    std::memcpy(dst + HEADER_SIZE, xml, xmlLen);
+    return (int)(HEADER_SIZE + xmlLen);
+}
+
+bool containsIgnoreCase(const char* text, size_t textLen, const char* needle) {
+    size_t n = std::strlen(needle);
+    if (n == 0) return true;
+    for (size_t i = 0; i + n <= textLen; i++) {
+        size_t k = 0;
+        while (k < n && std::tolower((unsigned char)text[i + k]) == std::tolower((unsigned char)needle[k])) k++;
+        if (k == n) return true;
+    }
+    return false;
+}
+
+namespace {
+
+// Index just past the opening quote of attribute `name="…"`, or textLen if it is absent.
+size_t attrValue(const char* text, size_t textLen, const char* name) {
+    size_t n = std::strlen(name);
+    for (size_t i = 0; i + n + 2 <= textLen; i++) {
+        // Attribute names must be preceded by whitespace so "T1" does not match "XT1"
+        if (i == 0 || !std::isspace((unsigned char)text[i - 1])) continue;
+        if (std::memcmp(text + i, name, n) != 0 || text[i + n] != '=') continue;
+        size_t p = i + n + 1;
+        if (p >= textLen || (text[p] != '"' && text[p] != '\'')) continue;
+        return p + 1;
+    }
+    return textLen;
+}
+
+} // namespace
+
+bool xmlAttrInt64(const char* text, size_t textLen, const char* name, int64_t* out) {
+    size_t p = attrValue(text, textLen, name);
+    if (p >= textLen) return false;
+    bool neg = text[p] == '-';
+    if (neg) p++;
+    int64_t v = 0;
+    size_t digits = 0;
+    while (p < textLen && text[p] >= '0' && text[p] <= '9') {
+        v = v * 10 + (text[p++] - '0');
+        digits++;
+    }
+    if (digits == 0 || digits > 18) return false;
+    *out = neg ? -v : v;
+    return true;
+}
+
+bool xmlAttrText(const char* text, size_t textLen, const char* name, char* out, size_t outLen) {
+    const size_t start = attrValue(text, textLen, name);
+    if (start >= textLen) return false;
+    const char quote = text[start - 1];
+    size_t end = start;
+    while (end < textLen && text[end] != quote) end++;
+    if (end >= textLen || end - start >= outLen) return false;
+    std::memcpy(out, text + start, end - start);
+    out[end - start] = 0;
+    return true;
+}
+
+} // namespace omt
@@ -0,0 +1,107 @@
+/**
+ * OMT wire protocol: 16-byte frame header plus the video (32-byte) and
+ * audio (24-byte) extended headers, all little-endian.
+ *
+ *   Frame header: [version u8][type u8][timestamp i64][metadataLen u16][dataLen i32]
+ *   Video ext:    [codec][width][height][fpsN][fpsD][aspect f32][flags][colorSpace]
+ *   Audio ext:    [codec][sampleRate][samplesPerChannel][channels][activeChannels][reserved]
+ *
+ * Timestamps are in 100 ns units, matching CameraStreamSender.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omt {
+
+enum FrameType : uint8_t {
+    FRAME_METADATA = 1,
+    FRAME_VIDEO = 2,
+    FRAME_AUDIO = 4,
+};
+
+constexpr int HEADER_SIZE = 16;
+constexpr int VIDEO_EXT_HEADER_SIZE = 32;
+constexpr int AUDIO_EXT_HEADER_SIZE = 24;
+
+constexpr uint32_t CODEC_VMX1 = 0x31584D56;
+constexpr uint32_t CODEC_NV12 = 0x3231564E;
+constexpr uint32_t CODEC_FPA1 = 0x31415046; // "FPA1" — Float Planar Audio
+constexpr uint32_t CODEC_NVLZ = 0x5A4C564E; // "NVLZ" — LZ4-compressed NV12 planes (omt_lz4), negotiated
+
+constexpr int COLORSPACE_BT709 = 709;
+
+struct FrameHeader {
+    uint8_t version = 1;
+    uint8_t type = 0;
+    int64_t timestamp = 0;
+    uint16_t metadataLength = 0;
+    int32_t dataLength = 0;
+};
+
+struct VideoHeader {
+    uint32_t codec = CODEC_NV12;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t frameRateN = 30;
+    int32_t frameRateD = 1;
+    float aspectRatio = 16.f / 9.f;
+    int32_t flags = 0;
+    int32_t colorSpace = COLORSPACE_BT709;
+};
+
+struct AudioHeader {
+    uint32_t codec = CODEC_FPA1;
+    int32_t sampleRate = 48000;
+    int32_t samplesPerChannel = 0;
+    int32_t channels = 2;
+    int32_t activeChannels = 0x03;
+    int32_t reserved = 0;
+};
+
+// ---- Little-endian field helpers ----
+
+inline void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void putU64(uint8_t* p, uint64_t v) {
+    putU32(p, (uint32_t)v); putU32(p + 4, (uint32_t)(v >> 32));
+}
+
+inline uint64_t getU64(const uint8_t* p) {
+    return (uint64_t)getU32(p) | ((uint64_t)getU32(p + 4) << 32);
+}
+
+// ---- Header encode / decode ----
+
+void writeFrameHeader(uint8_t* dst, const FrameHeader& h);
+/** Returns false if the buffer does not hold a plausible version-1 header. */
+bool parseFrameHeader(const uint8_t* src, FrameHeader* out);
+
+void writeVideoHeader(uint8_t* dst, const VideoHeader& h);
+void parseVideoHeader(const uint8_t* src, VideoHeader* out);
+
+void writeAudioHeader(uint8_t* dst, const AudioHeader& h);
+void parseAudioHeader(const uint8_t* src, AudioHeader* out);
+
+/**
+ * Build a complete metadata frame (header + UTF-8 XML) into dst.
+ * Returns the total number of bytes written, or -1 if dstLen is too small.
+ */
+int buildMetadataFrame(uint8_t* dst, size_t dstLen, const char* xml, size_t xmlLen, int64_t timestamp = 0);
+
+/** Case-insensitive substring test used for loose OMT metadata matching. */
+bool containsIgnoreCase(const char* text, size_t textLen, const char* needle);
+
+/** Parse the integer value of attribute `name="…"` from an XML fragment. */
+bool xmlAttrInt64(const char* text, size_t textLen, const char* name, int64_t* out);
+/** Copy the value of attribute `name="…"` into out (NUL-terminated); false if absent or too long. */
+bool xmlAttrText(const char* text, size_t textLen, const char* name, char* out, size_t outLen);
+
+} // namespace omt
@@ -0,0 +1,248 @@
+#define LOG_TAG "OmtProxy"
+#include "omt_proxy.h"
+#include "omt_log.h"
+#include "omt_pixel.h"
+#include "omt_protocol.h"
+#include "omt_vmx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+namespace omt {
+
+namespace {
+
+constexpr size_t PROXY_RECORD_BUFFER = 8u << 20;
+constexpr int MIN_PROXY_SIZE = 16;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t threadCpuNs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+bool parseField(const char** p, int minValue, int maxValue, int* out) {
+    char* end;
+    const long v = std::strtol(*p, &end, 10);
+    if (end == *p || v < minValue || v > maxValue) return false;
+    *out = (int)v;
+    *p = end;
+    return true;
+}
+
+} // namespace
+
+bool parseProxySpec(const char* spec, ProxyConfig* config) {
+    if (!spec || !*spec) return false;
+    if (!std::strcmp(spec, "1")) return true;
+    ProxyConfig c = *config;
+    const char* p = spec;
+    if (!parseField(&p, MIN_PROXY_SIZE, 8192, &c.width)) return false;
+    c.height = 0;
+    if (*p == 'x' && !(++p, parseField(&p, MIN_PROXY_SIZE, 8192, &c.height))) return false;
+    if (*p == '@' && !(++p, parseField(&p, 1, 120, &c.fps))) return false;
+    if (*p == ',' && !(++p, parseField(&p, 1, 100, &c.cpuPercent))) return false;
+    if (*p == '%') p++;
+    if (*p) return false;
+    c.width &= ~1;
+    c.height &= ~1;
+    *config = c;
+    return true;
+}
+
+bool proxyConfigured(ProxyConfig* config) {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.omt.proxy", value) <= 0) return false;
+#else
+    const char* value = std::getenv("OMT_PROXY");
+    if (!value) return false;
+#endif
+    if (parseProxySpec(value, config)) return true;
+    LOGW("Ignoring proxy spec \"%s\" (expected W[xH][@FPS][,CPU%%])", value);
+    return false;
+}
+
+ProxyRecorder::ProxyRecorder(ProxyConfig config) : m_config(std::move(config)) {
+    m_config.fps = std::max(1, m_config.fps);
+    m_config.cpuPercent = std::max(1, std::min(m_config.cpuPercent, 100));
+    m_periodNs = 1000000000LL / m_config.fps;
+}
+
+ProxyRecorder::~ProxyRecorder() { stop(); }
+
+bool ProxyRecorder::start() {
+    if (m_running.load()) return true;
+    if (!vmxLoad()) {
+        LOGE("Proxy recording needs libvmx");
+        return false;
+    }
+    RecorderConfig rc;
+    rc.basePath = m_config.basePath;
+    rc.bufferBytes = PROXY_RECORD_BUFFER;
+    m_recorder = std::make_unique<Recorder>(rc);
+    if (!m_recorder->start()) {
+        m_recorder.reset();
+        return false;
+    }
+    m_stopping = false;
+    m_hasPending.store(false);
+    m_nextDueNs = 0;
+    m_budgetDueNs.store(0);
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread([this] {
+        pthread_setname_np(pthread_self(), "OmtProxy");
+        // Below the encode and I/O threads: the live path wins every contended core.
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), m_config.niceness);
+        workerLoop();
+    });
+    LOGI("Proxy %dx%s @ %d fps, %d%% CPU budget", m_config.width,
+         m_config.height ? std::to_string(m_config.height).c_str() : "auto", m_config.fps, m_config.cpuPercent);
+    return true;
+}
+
+void ProxyRecorder::stop() {
+    if (!m_running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    m_recorder->stop();
+    LOGI("Proxy stopped: %llu frames, %.1f MB, skipped %llu busy + %llu over budget, %.2f ms/frame",
+         (unsigned long long)framesEncoded(), bytesWritten() / 1e6, (unsigned long long)framesSkippedBusy(),
+         (unsigned long long)framesSkippedBudget(), meanCostNs() / 1e6);
+}
+
+uint64_t ProxyRecorder::meanCostNs() const {
+    const uint64_t n = framesEncoded();
+    return n ? m_costTotalNs.load(std::memory_order_relaxed) / n : 0;
+}
+
+void ProxyRecorder::proxySize(int srcWidth, int srcHeight, int* width, int* height) const {
+    if (m_config.width >= srcWidth) {
+        *width = srcWidth;
+        *height = srcHeight;
+        return;
+    }
+    *width = m_config.width;
+    *height = m_config.height > 0 ? m_config.height
+                                  : (int)(((int64_t)m_config.width * srcHeight / srcWidth + 1) & ~1);
+    *height = std::max(MIN_PROXY_SIZE, std::min(*height, srcHeight));
+}
+
+bool ProxyRecorder::due() const {
+    const int64_t now = nowNs();
+    return m_running.load(std::memory_order_relaxed) && now + m_periodNs / 8 >= m_nextDueNs &&
+           now >= m_budgetDueNs.load(std::memory_order_relaxed) && !m_hasPending.load(std::memory_order_acquire);
+}
+
+bool ProxyRecorder::offer(const uint8_t* y, int strideY, const uint8_t* uv, int strideUV, int width, int height,
+                          int64_t timestamp) {
+    if (!m_running.load(std::memory_order_acquire) || width < MIN_PROXY_SIZE || height < MIN_PROXY_SIZE) return false;
+    const int64_t now = nowNs();
+    // Source frames arrive with jitter; take the one closest to each proxy slot.
+    if (now + m_periodNs / 8 < m_nextDueNs) return false;
+    m_nextDueNs += m_periodNs;
+    if (m_nextDueNs <= now) m_nextDueNs = now + m_periodNs;
+    if (now < m_budgetDueNs.load(std::memory_order_relaxed)) {
+        m_skippedBudget.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (m_hasPending.load(std::memory_order_acquire)) {
+        m_skippedBusy.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const int64_t cpuStart = threadCpuNs();
+    Slot& s = m_pending;
+    proxySize(width, height, &s.width, &s.height);
+    s.y.resize((size_t)s.width * s.height);
+    s.uv.resize((size_t)s.width * (s.height / 2));
+    scaleNv12(y, strideY, uv, strideUV, width, height, s.y.data(), s.uv.data(), s.width, s.height);
+    s.timestamp = timestamp;
+    s.takenNs = now;
+    s.scaleNs = threadCpuNs() - cpuStart;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hasPending.store(true, std::memory_order_release);
+    }
+    m_cond.notify_one();
+    return true;
+}
+
+void ProxyRecorder::workerLoop() {
+    void* encoder = nullptr;
+    int encoderWidth = 0, encoderHeight = 0;
+    std::vector<uint8_t> out;
+    uint8_t head[HEADER_SIZE + VIDEO_EXT_HEADER_SIZE];
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] { return m_hasPending.load() || m_stopping; });
+            if (!m_hasPending.load()) break;
+            std::swap(m_pending, m_work);
+            m_hasPending.store(false, std::memory_order_release);
+        }
+        const Slot& s = m_work;
+        const int64_t cpuStart = threadCpuNs();
+        if (!encoder || encoderWidth != s.width || encoderHeight != s.height) {
+            vmxDestroy(encoder);
+            // One thread: the proxy must not fan out over the cores the live encoder uses.
+            encoder = vmxCreate(s.width, s.height, 1, "proxy encoder", VMX_PROFILE_OMT_LQ);
+            encoderWidth = s.width;
+            encoderHeight = s.height;
+            out.resize((size_t)s.width * s.height * 2);
+            if (!encoder) {
+                LOGE("Proxy encoder unavailable for %dx%d", s.width, s.height);
+                continue;
+            }
+        }
+        if (!encoder) continue;
+        const int len = vmxEncode(encoder, s.y.data(), s.width, s.uv.data(), s.width, out.data(), (int)out.size());
+        const int64_t cost = s.scaleNs + threadCpuNs() - cpuStart;
+        m_costTotalNs.fetch_add((uint64_t)cost, std::memory_order_relaxed);
+        // Pay the frame back before taking another: cost / interval stays within the budget.
+        m_budgetDueNs.store(s.takenNs + cost * 100 / m_config.cpuPercent, std::memory_order_relaxed);
+        if (len <= 0) {
+            LOGW("Proxy encode failed %dx%d", s.width, s.height);
+            continue;
+        }
+        FrameHeader h;
+        h.type = FRAME_VIDEO;
+        h.timestamp = s.timestamp;
+        h.dataLength = VIDEO_EXT_HEADER_SIZE + len;
+        VideoHeader vh;
+        vh.codec = CODEC_VMX1;
+        vh.width = s.width;
+        vh.height = s.height;
+        vh.frameRateN = m_config.fps;
+        vh.frameRateD = 1;
+        vh.aspectRatio = (float)s.width / s.height;
+        writeFrameHeader(head, h);
+        writeVideoHeader(head + HEADER_SIZE, vh);
+        if (m_recorder->record(head, sizeof(head), out.data(), (size_t)len))
+            m_framesEncoded.fetch_add(1, std::memory_order_relaxed);
+    }
+    vmxDestroy(encoder);
+}
+
+} // namespace omt
@@ -0,0 +1,117 @@
+/**
+ * Low-resolution proxy recording for editing after the show: every camera
+ * frame is offered, a reduced-rate subset is downscaled, VMX-encoded with its
+ * own LQ-profile encoder and written as a recording (core/omt_record), so the
+ * proxy plays in omt_replay and reads in omt_bench_decode like any stream.
+ *
+ * The live stream must never wait for it:
+ *  - offer() runs on the encode thread but returns at once unless a proxy
+ *    frame is due and the worker's single slot is free; then it only
+ *    downscales into that slot (bilinear, omt_pixel) and signals.
+ *  - One worker thread, single-threaded encoder, niced below the live path.
+ *  - A CPU budget (percent of one core, scale + encode averaged over frames):
+ *    after each frame the next one is not taken before its cost has been
+ *    paid back, so on a slow phone the proxy drops to a lower rate instead.
+ *  - Writes go through the recorder's own bounded ring and writer thread.
+ * Frames passed over because the worker was busy or the budget was spent
+ * are counted, not queued.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "omt_record.h"
+
+namespace omt {
+
+struct ProxyConfig {
+    std::string basePath;   // proxy recording: basePath-0001.omt (+ .idx)
+    int width = 640;
+    int height = 0;         // 0: follow the source aspect ratio
+    int fps = 10;
+    int cpuPercent = 10;    // of one core, scale + encode
+    int niceness = 10;      // nice value of the worker thread (the live threads run at 0)
+};
+
+/**
+ * Parse "W[xH][@FPS][,CPU%]", e.g. "640x360@10,15" or "480@5"; "1" keeps
+ * the defaults. Fields not given keep their current values.
+ */
+bool parseProxySpec(const char* spec, ProxyConfig* config);
+/** Proxy requested through debug.omt.proxy / OMT_PROXY (a spec as above); fills config. */
+bool proxyConfigured(ProxyConfig* config);
+
+class ProxyRecorder {
+public:
+    explicit ProxyRecorder(ProxyConfig config);
+    ~ProxyRecorder();
+    ProxyRecorder(const ProxyRecorder&) = delete;
+    ProxyRecorder& operator=(const ProxyRecorder&) = delete;
+
+    /** Open the recording and start the worker; false if libvmx or the file is unavailable. */
+    bool start();
+    /** Encode what is pending, close the recording and join the worker. */
+    void stop();
+
+    /** Cheap pre-check for callers that must pin buffers first (JNI). */
+    bool due() const;
+    /**
+     * Offer one live NV12 frame. Takes it (downscales into the worker's slot)
+     * only when a proxy frame is due and the worker is free; true if taken.
+     * Call from one thread.
+     */
+    bool offer(const uint8_t* y, int strideY, const uint8_t* uv, int strideUV, int width, int height,
+               int64_t timestamp);
+
+    uint64_t framesEncoded() const { return m_framesEncoded.load(std::memory_order_relaxed); }
+    /** Due frames passed over because the worker was still encoding. */
+    uint64_t framesSkippedBusy() const { return m_skippedBusy.load(std::memory_order_relaxed); }
+    /** Due frames passed over to stay within the CPU budget. */
+    uint64_t framesSkippedBudget() const { return m_skippedBudget.load(std::memory_order_relaxed); }
+    uint64_t bytesWritten() const { return m_recorder ? m_recorder->bytesWritten() : 0; }
+    /** Mean scale + encode cost per proxy frame, in ns. */
+    uint64_t meanCostNs() const;
+    const ProxyConfig& config() const { return m_config; }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> y, uv;
+        int width = 0, height = 0;
+        int64_t timestamp = 0;
+        int64_t takenNs = 0;
+        int64_t scaleNs = 0;
+    };
+
+    void workerLoop();
+    void proxySize(int srcWidth, int srcHeight, int* width, int* height) const;
+
+    ProxyConfig m_config;
+    std::unique_ptr<Recorder> m_recorder;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    // m_pending is the caller's while m_hasPending is false, the worker's after.
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    Slot m_pending, m_work;
+    std::atomic<bool> m_hasPending{false};
+    bool m_stopping = false;
+
+    int64_t m_periodNs = 0;
+    int64_t m_nextDueNs = 0;                 // caller only
+    std::atomic<int64_t> m_budgetDueNs{0};   // set by the worker after each frame
+
+    std::atomic<uint64_t> m_framesEncoded{0};
+    std::atomic<uint64_t> m_skippedBusy{0};
+    std::atomic<uint64_t> m_skippedBudget{0};
+    std::atomic<uint64_t> m_costTotalNs{0};
+};
+
+} // namespace omt
@@ -0,0 +1,341 @@
+#include "omt_quality.h"
+#include "omt_pixel.h"
+#include "omt_vmx.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OMT_QUALITY_AVX2 1
+#endif
+
+namespace omt {
+
+namespace {
+
+// ---- Scalar kernels (reference and tails) ----
+
+uint64_t sseRowScalar(const uint8_t* a, const uint8_t* b, int n) {
+    uint64_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        const int d = (int)a[i] - (int)b[i];
+        sum += (uint64_t)(d * d);
+    }
+    return sum;
+}
+
+/** s1, s2, ss (a² + b²), s12 of 4x4 blocks [first, last) in a 4-row strip. */
+void blockSumsScalar(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int first, int last,
+                     int32_t (*sums)[4]) {
+    for (int blk = first; blk < last; blk++) {
+        int32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+        for (int row = 0; row < 4; row++) {
+            const uint8_t* pa = a + (size_t)row * strideA + blk * 4;
+            const uint8_t* pb = b + (size_t)row * strideB + blk * 4;
+            for (int k = 0; k < 4; k++) {
+                const int x = pa[k], y = pb[k];
+                s1 += x;
+                s2 += y;
+                ss += x * x + y * y;
+                s12 += x * y;
+            }
+        }
+        sums[blk][0] = s1;
+        sums[blk][1] = s2;
+        sums[blk][2] = ss;
+        sums[blk][3] = s12;
+    }
+}
+
+// ---- NEON (arm64 baseline) ----
+
+#if defined(__aarch64__)
+
+uint64_t sseRowNeon(const uint8_t* a, const uint8_t* b, int n) {
+    uint32x4_t acc = vdupq_n_u32(0);
+    int i = 0;
+    // 16 bytes per step: |a-b|² fits u16, pairwise-accumulated into u32 lanes (≤ 2·65025·n/8 per lane)
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(d), vget_low_u8(d)));
+        acc = vpadalq_u16(acc, vmull_high_u8(d, d));
+    }
+    return vaddlvq_u32(acc) + sseRowScalar(a + i, b + i, n - i);
+}
+
+int blockSumsNeon(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int blocks, int32_t (*sums)[4]) {
+    int blk = 0;
+    for (; blk + 4 <= blocks; blk += 4) {
+        uint32x4_t s1 = vdupq_n_u32(0), s2 = s1, ss = s1, s12 = s1;
+        for (int row = 0; row < 4; row++) {
+            const uint8x16_t x = vld1q_u8(a + (size_t)row * strideA + blk * 4);
+            const uint8x16_t y = vld1q_u8(b + (size_t)row * strideB + blk * 4);
+            // Pairs, then pairs of pairs: one u32 lane per 4x4 block
+            s1 = vpadalq_u16(s1, vpaddlq_u8(x));
+            s2 = vpadalq_u16(s2, vpaddlq_u8(y));
+            const uint32x4_t xxLo = vpaddlq_u16(vmull_u8(vget_low_u8(x), vget_low_u8(x)));
+            const uint32x4_t xxHi = vpaddlq_u16(vmull_high_u8(x, x));
+            const uint32x4_t yyLo = vpaddlq_u16(vmull_u8(vget_low_u8(y), vget_low_u8(y)));
+            const uint32x4_t yyHi = vpaddlq_u16(vmull_high_u8(y, y));
+            const uint32x4_t xyLo = vpaddlq_u16(vmull_u8(vget_low_u8(x), vget_low_u8(y)));
+            const uint32x4_t xyHi = vpaddlq_u16(vmull_high_u8(x, y));
+            ss = vaddq_u32(ss, vaddq_u32(vpaddq_u32(xxLo, xxHi), vpaddq_u32(yyLo, yyHi)));
+            s12 = vaddq_u32(s12, vpaddq_u32(xyLo, xyHi));
+        }
+        uint32_t t1[4], t2[4], tss[4], t12[4];
+        vst1q_u32(t1, s1);
+        vst1q_u32(t2, s2);
+        vst1q_u32(tss, ss);
+        vst1q_u32(t12, s12);
+        for (int k = 0; k < 4; k++) {
+            sums[blk + k][0] = (int32_t)t1[k];
+            sums[blk + k][1] = (int32_t)t2[k];
+            sums[blk + k][2] = (int32_t)tss[k];
+            sums[blk + k][3] = (int32_t)t12[k];
+        }
+    }
+    return blk;
+}
+
+#endif
+
+// ---- AVX2 (x86, selected at run time) ----
+
+#ifdef OMT_QUALITY_AVX2
+
+__attribute__((target("avx2"))) uint64_t sseRowAvx2(const uint8_t* a, const uint8_t* b, int n) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero; // ≤ 4·65025 per lane per step: no overflow below ~260K samples a row
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        const __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        const __m256i dLo = _mm256_sub_epi16(_mm256_unpacklo_epi8(x, zero), _mm256_unpacklo_epi8(y, zero));
+        const __m256i dHi = _mm256_sub_epi16(_mm256_unpackhi_epi8(x, zero), _mm256_unpackhi_epi8(y, zero));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(dLo, dLo));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(dHi, dHi));
+    }
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256((__m256i*)lanes, acc);
+    uint64_t sum = 0;
+    for (uint32_t v : lanes) sum += v;
+    return sum + sseRowScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2"))) int blockSumsAvx2(const uint8_t* a, int strideA, const uint8_t* b, int strideB,
+                                                  int blocks, int32_t (*sums)[4]) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    int blk = 0;
+    for (; blk + 4 <= blocks; blk += 4) {
+        __m256i s1 = _mm256_setzero_si256(), s2 = s1, ss = s1, s12 = s1;
+        for (int row = 0; row < 4; row++) {
+            // 16 pixels → 16 x u16; madd leaves one i32 per pixel pair, blocks 0-1 low lane, 2-3 high
+            const __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(a + (size_t)row * strideA + blk * 4)));
+            const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(b + (size_t)row * strideB + blk * 4)));
+            s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(x, ones));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(y, ones));
+            ss = _mm256_add_epi32(ss, _mm256_add_epi32(_mm256_madd_epi16(x, x), _mm256_madd_epi16(y, y)));
+            s12 = _mm256_add_epi32(s12, _mm256_madd_epi16(x, y));
+        }
+        // Per 128-bit lane: [s1 b0, s1 b1, s2 b0, s2 b1] and [ss b0, ss b1, s12 b0, s12 b1]
+        alignas(32) int32_t t12[8], tss[8];
+        _mm256_store_si256((__m256i*)t12, _mm256_hadd_epi32(s1, s2));
+        _mm256_store_si256((__m256i*)tss, _mm256_hadd_epi32(ss, s12));
+        for (int k = 0; k < 4; k++) {
+            const int lane = (k >> 1) * 4 + (k & 1);
+            sums[blk + k][0] = t12[lane];
+            sums[blk + k][1] = t12[lane + 2];
+            sums[blk + k][2] = tss[lane];
+            sums[blk + k][3] = tss[lane + 2];
+        }
+    }
+    return blk;
+}
+
+bool hasAvx2() {
+    static const bool s_avx2 = __builtin_cpu_supports("avx2");
+    return s_avx2;
+}
+
+#endif
+
+uint64_t sseRow(const uint8_t* a, const uint8_t* b, int n) {
+#if defined(__aarch64__)
+    return sseRowNeon(a, b, n);
+#else
+#ifdef OMT_QUALITY_AVX2
+    if (hasAvx2()) return sseRowAvx2(a, b, n);
+#endif
+    return sseRowScalar(a, b, n);
+#endif
+}
+
+void blockSums(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int blocks, int32_t (*sums)[4]) {
+    int done = 0;
+#if defined(__aarch64__)
+    done = blockSumsNeon(a, strideA, b, strideB, blocks, sums);
+#elif defined(OMT_QUALITY_AVX2)
+    if (hasAvx2()) done = blockSumsAvx2(a, strideA, b, strideB, blocks, sums);
+#endif
+    blockSumsScalar(a, strideA, b, strideB, done, blocks, sums);
+}
+
+/**
+ * SSIM of one 8x8 window from its four 4x4 block sums. Constants and scaling
+ * are x264's (ssim_end1), so the numbers line up with x264/ffmpeg reports.
+ */
+double ssimWindow(const int32_t* a, const int32_t* b, const int32_t* c, const int32_t* d) {
+    const double ssimC1 = 0.01 * 0.01 * 255 * 255 * 64;
+    const double ssimC2 = 0.03 * 0.03 * 255 * 255 * 64 * 63;
+    const double s1 = a[0] + b[0] + c[0] + d[0];
+    const double s2 = a[1] + b[1] + c[1] + d[1];
+    const double ss = a[2] + b[2] + c[2] + d[2];
+    const double s12 = a[3] + b[3] + c[3] + d[3];
+    const double vars = ss * 64 - s1 * s1 - s2 * s2;
+    const double covar = s12 * 64 - s1 * s2;
+    return (2 * s1 * s2 + ssimC1) * (2 * covar + ssimC2) / ((s1 * s1 + s2 * s2 + ssimC1) * (vars + ssimC2));
+}
+
+void deinterleave(const uint8_t* uv, int strideUV, int pairs, int rows, uint8_t* cb, uint8_t* cr) {
+    for (int r = 0; r < rows; r++) {
+        const uint8_t* src = uv + (size_t)r * strideUV;
+        uint8_t* u = cb + (size_t)r * pairs;
+        uint8_t* v = cr + (size_t)r * pairs;
+        for (int i = 0; i < pairs; i++) {
+            u[i] = src[2 * i];
+            v[i] = src[2 * i + 1];
+        }
+    }
+}
+
+} // namespace
+
+bool qualitySamplingConfigured(double* periodSec) {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.omt.quality", value) <= 0) return false;
+#else
+    const char* value = std::getenv("OMT_QUALITY");
+    if (!value) return false;
+#endif
+    const double period = std::atof(value);
+    if (period <= 0) return false;
+    *periodSec = period;
+    return true;
+}
+
+const char* qualityKernelName() {
+#if defined(__aarch64__)
+    return "neon";
+#elif defined(OMT_QUALITY_AVX2)
+    return hasAvx2() ? "avx2" : "scalar";
+#else
+    return "scalar";
+#endif
+}
+
+uint64_t sumSquaredError(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int width, int height) {
+    uint64_t sum = 0;
+    for (int row = 0; row < height; row++)
+        sum += sseRow(a + (size_t)row * strideA, b + (size_t)row * strideB, width);
+    return sum;
+}
+
+double psnrFromSse(uint64_t sse, uint64_t count) {
+    if (count == 0) return 0;
+    if (sse == 0) return QUALITY_MAX_PSNR;
+    const double psnr = 10.0 * std::log10(255.0 * 255.0 * (double)count / (double)sse);
+    return psnr < QUALITY_MAX_PSNR ? psnr : QUALITY_MAX_PSNR;
+}
+
+bool QualityMeter::configure(int width, int height) {
+    if (width < 8 || height < 8 || (width | height) & 1) return false;
+    if (width == m_width && height == m_height) return true;
+    m_width = width;
+    m_height = height;
+    const size_t ySize = (size_t)width * height, uvSize = (size_t)width * (height / 2);
+    m_bitstream.resize(ySize * 2); // same bound as the senders' encode buffers
+    m_rgba.resize(ySize * 4);
+    m_refY.resize(ySize);
+    m_testY.resize(ySize);
+    m_refUV.resize(uvSize);
+    m_testUV.resize(uvSize);
+    m_chroma.resize(uvSize * 2);
+    m_blockSums.resize((size_t)(width / 4 + 1) * 2 * 4);
+    return true;
+}
+
+double QualityMeter::ssimPlane(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int width, int height) {
+    const int blocksX = width / 4, blocksY = height / 4;
+    if (blocksX < 2 || blocksY < 2 || width > m_width) return 0;
+    auto* rows = reinterpret_cast<int32_t(*)[4]>(m_blockSums.data());
+    int32_t(*prev)[4] = rows;
+    int32_t(*cur)[4] = rows + blocksX;
+    double total = 0;
+    blockSums(a, strideA, b, strideB, blocksX, prev);
+    for (int by = 1; by < blocksY; by++) {
+        blockSums(a + (size_t)by * 4 * strideA, strideA, b + (size_t)by * 4 * strideB, strideB, blocksX, cur);
+        for (int bx = 0; bx + 1 < blocksX; bx++)
+            total += ssimWindow(prev[bx], prev[bx + 1], cur[bx], cur[bx + 1]);
+        std::swap(prev, cur);
+    }
+    return total / ((double)(blocksX - 1) * (blocksY - 1));
+}
+
+void QualityMeter::measureNv12(const uint8_t* refY, int refStrideY, const uint8_t* refUV, int refStrideUV,
+                               const uint8_t* testY, int testStrideY, const uint8_t* testUV, int testStrideUV,
+                               QualityResult* out) {
+    const int w = m_width, h = m_height, cw = w / 2, ch = h / 2;
+    const size_t chromaSize = (size_t)cw * ch;
+    uint8_t* refCb = m_chroma.data();
+    uint8_t* refCr = refCb + chromaSize;
+    uint8_t* testCb = refCr + chromaSize;
+    uint8_t* testCr = testCb + chromaSize;
+    deinterleave(refUV, refStrideUV, cw, ch, refCb, refCr);
+    deinterleave(testUV, testStrideUV, cw, ch, testCb, testCr);
+
+    const uint64_t sseY = sumSquaredError(refY, refStrideY, testY, testStrideY, w, h);
+    const uint64_t sseCb = sumSquaredError(refCb, cw, testCb, cw, cw, ch);
+    const uint64_t sseCr = sumSquaredError(refCr, cw, testCr, cw, cw, ch);
+    out->y.psnr = psnrFromSse(sseY, (uint64_t)w * h);
+    out->cb.psnr = psnrFromSse(sseCb, chromaSize);
+    out->cr.psnr = psnrFromSse(sseCr, chromaSize);
+    out->y.ssim = ssimPlane(refY, refStrideY, testY, testStrideY, w, h);
+    out->cb.ssim = ssimPlane(refCb, cw, testCb, cw, cw, ch);
+    out->cr.ssim = ssimPlane(refCr, cw, testCr, cw, cw, ch);
+    // 6:1:1 weighting of the per-sample mean squared errors (luma has 4x the samples of each chroma plane)
+    const double mse = (6.0 * sseY / ((double)w * h) + (double)sseCb / chromaSize + (double)sseCr / chromaSize) / 8.0;
+    out->psnr = mse > 0 ? std::fmin(QUALITY_MAX_PSNR, 10.0 * std::log10(255.0 * 255.0 / mse)) : QUALITY_MAX_PSNR;
+    out->ssim = (6.0 * out->y.ssim + out->cb.ssim + out->cr.ssim) / 8.0;
+}
+
+bool QualityMeter::measureEncoded(void* decoder, const uint8_t* data, int length,
+                                  const uint8_t* y, int strideY, const uint8_t* uv, int strideUV, QualityResult* out) {
+    const int w = m_width, h = m_height;
+    if (!decoder || !data || length <= 0 || w == 0) return false;
+    if (!vmxDecodeRgba(decoder, data, length, m_rgba.data(), w, h)) return false;
+    rgbaToNv12(m_rgba.data(), w * 4, m_testY.data(), w, m_testUV.data(), w, w, h);
+    nv12ToRgba(y, strideY, uv, strideUV, m_rgba.data(), w * 4, w, h);
+    rgbaToNv12(m_rgba.data(), w * 4, m_refY.data(), w, m_refUV.data(), w, w, h);
+    measureNv12(m_refY.data(), w, m_refUV.data(), w, m_testY.data(), w, m_testUV.data(), w, out);
+    return true;
+}
+
+bool QualityMeter::roundTrip(void* encoder, void* decoder, const uint8_t* y, int strideY, const uint8_t* uv,
+                             int strideUV, QualityResult* out, int* encodedBytes) {
+    if (!encoder || m_width == 0) return false;
+    const int len = vmxEncode(encoder, y, strideY, uv, strideUV, m_bitstream.data(), (int)m_bitstream.size());
+    if (len <= 0) return false;
+    if (encodedBytes) *encodedBytes = len;
+    return measureEncoded(decoder, m_bitstream.data(), len, y, strideY, uv, strideUV, out);
+}
+
+} // namespace omt
@@ -0,0 +1,85 @@
+/**
+ * Objective picture quality for encoder tuning: PSNR and SSIM on Y, Cb and
+ * Cr of an NV12 frame against its encode → decode round trip.
+ *
+ * The inner loops (squared error per row, 4x4 block sums for SSIM) have
+ * NEON (arm64) and AVX2 kernels, the latter picked at run time on x86;
+ * everything else is scalar. SSIM follows x264: 8x8 windows on a 4-pixel
+ * grid built from 4x4 block sums, averaged over the plane.
+ *
+ * libvmx only decodes to BGRA, so the decoded picture is converted back to
+ * NV12 for comparison and the reference takes the same NV12 → RGB → NV12
+ * path; the conversion rounding then cancels and the numbers reflect the
+ * codec. Nothing allocates after configure().
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace omt {
+
+struct PlaneQuality {
+    double psnr = 0; // dB, capped at QUALITY_MAX_PSNR for identical planes
+    double ssim = 0; // 0..1
+};
+
+struct QualityResult {
+    PlaneQuality y, cb, cr;
+    double psnr = 0; // 6:1:1 weighted mean squared error, as PSNR
+    double ssim = 0; // 6:1:1 weighted
+};
+
+constexpr double QUALITY_MAX_PSNR = 100.0;
+
+/**
+ * Live sampling period requested through debug.omt.quality / OMT_QUALITY, in
+ * seconds ("1" = one frame a second). Returns false when unset or not positive.
+ */
+bool qualitySamplingConfigured(double* periodSec);
+
+/** "avx2", "neon" or "scalar": the kernels this process uses. */
+const char* qualityKernelName();
+
+/** Sum of squared differences between two 8-bit planes. */
+uint64_t sumSquaredError(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int width, int height);
+
+/** PSNR in dB for a sum of squared errors over count 8-bit samples. */
+double psnrFromSse(uint64_t sse, uint64_t count);
+
+class QualityMeter {
+public:
+    /** Size the scratch planes; width and height must be even. */
+    bool configure(int width, int height);
+
+    /** SSIM of one 8-bit plane of up to the configured width (in samples). */
+    double ssimPlane(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int width, int height);
+
+    /** Compare two NV12 frames of the configured size. */
+    void measureNv12(const uint8_t* refY, int refStrideY, const uint8_t* refUV, int refStrideUV,
+                     const uint8_t* testY, int testStrideY, const uint8_t* testUV, int testStrideUV,
+                     QualityResult* out);
+
+    /**
+     * Decode an already encoded VMX frame of y/uv with decoder and compare
+     * (live sampling: the sender keeps its own encode).
+     */
+    bool measureEncoded(void* decoder, const uint8_t* data, int length,
+                        const uint8_t* y, int strideY, const uint8_t* uv, int strideUV, QualityResult* out);
+
+    /** Encode y/uv with encoder, decode with decoder and compare; encodedBytes gets the frame size. */
+    bool roundTrip(void* encoder, void* decoder, const uint8_t* y, int strideY, const uint8_t* uv, int strideUV,
+                   QualityResult* out, int* encodedBytes = nullptr);
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<uint8_t> m_bitstream;
+    std::vector<uint8_t> m_rgba;
+    std::vector<uint8_t> m_refY, m_refUV, m_testY, m_testUV; // both sides after the RGB round trip
+    std::vector<uint8_t> m_chroma;                           // 4 deinterleaved chroma planes
+    std::vector<int32_t> m_blockSums;                        // two rows of 4x4 block sums (s1, s2, ss, s12)
+};
+
+} // namespace omt
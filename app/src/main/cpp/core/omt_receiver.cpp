@@ -0,0 +1,287 @@
+#define LOG_TAG "OmtReceiver"
+#include "omt_receiver.h"
+#include "omt_log.h"
+#include "omt_net.h"
+#include "omt_stats.h"
+#include "omt_uring.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace omt {
+
+namespace {
+// recv() calls per readiness event before yielding to other connections on the loop
+constexpr int MAX_READS_PER_EVENT = 16;
+// shared-memory frames per notifier wakeup, for the same reason
+constexpr int MAX_SHM_FRAMES_PER_EVENT = 16;
+// the notifier re-checks its stop flag at least this often
+constexpr int SHM_WAIT_MS = 200;
+}
+
+Receiver::Receiver(EventLoop& loop, ReceiverConfig config, FrameCallback onFrame)
+    : m_loop(loop), m_config(std::move(config)), m_onFrame(std::move(onFrame)) { }
+
+Receiver::~Receiver() {
+    close();
+}
+
+bool Receiver::connect() {
+    if (m_fd >= 0) return true;
+    int fd = tcpConnect(m_config.host.c_str(), m_config.port, m_config.connectTimeoutMs);
+    if (fd < 0) return false;
+    if (m_config.recvBufferBytes > 0)
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &m_config.recvBufferBytes, sizeof(m_config.recvBufferBytes));
+    static const char kSubVideo[] = "<OMTSubscribe Video=\"true\" />";
+    static const char kSubAudio[] = "<OMTSubscribe Audio=\"true\" />";
+    static const char kSubMeta[] = "<OMTSubscribe Metadata=\"true\" />";
+    static const char kPreview[] = "<OMTSettings Preview=\"true\" />";
+    static const char kShmRequest[] = "<OMTSharedMemory Request=\"true\" />";
+    static const char kMulticastRequest[] = "<OMTMulticast Request=\"true\" />";
+    static const char kCodecs[] = "<OMTCodecs Accept=\"NVLZ\" />";
+    bool ok = (!m_config.metadata || omt::sendMetadata(fd, kSubMeta, sizeof(kSubMeta) - 1)) &&
+              (!m_config.preview || omt::sendMetadata(fd, kPreview, sizeof(kPreview) - 1)) &&
+              (!m_config.nvlz || omt::sendMetadata(fd, kCodecs, sizeof(kCodecs) - 1)) &&
+              (!m_config.video || omt::sendMetadata(fd, kSubVideo, sizeof(kSubVideo) - 1)) &&
+              (!m_config.audio || omt::sendMetadata(fd, kSubAudio, sizeof(kSubAudio) - 1)) &&
+              (!m_config.sharedMemory || omt::sendMetadata(fd, kShmRequest, sizeof(kShmRequest) - 1)) &&
+              (!m_config.multicast || omt::sendMetadata(fd, kMulticastRequest, sizeof(kMulticastRequest) - 1));
+    if (!ok) {
+        LOGW("Subscribe to %s:%d failed", m_config.host.c_str(), m_config.port);
+        ::close(fd);
+        return false;
+    }
+    m_demux.reset();
+    m_fd = fd;
+    m_multishot = false;
+    if (m_loop.uring()) {
+        m_multishot = true;
+        if (m_reading) armRecv();
+        if (!m_reading || m_recvId) return true;
+        m_multishot = false; // no provided buffers: poll and recv() like epoll
+    }
+    if (!m_loop.add(fd, m_reading ? LOOP_READ : 0, [this](uint32_t events) { onEvent(events); })) {
+        ::close(fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void Receiver::close() {
+    if (m_fd < 0) return;
+    detachShm();
+    if (m_mcast) m_mcast->stop();
+    m_lastVideoTs = m_lastAudioTs = INT64_MIN;
+    if (m_multishot) {
+        if (m_recvId) m_loop.uring()->detach(m_recvId);
+        m_recvId = 0;
+    } else {
+        m_loop.remove(m_fd);
+    }
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+bool Receiver::sendMetadata(const char* xml, size_t length) {
+    return m_fd >= 0 && omt::sendMetadata(m_fd, xml, length);
+}
+
+void Receiver::setReading(bool reading) {
+    if (reading == m_reading) return;
+    m_reading = reading;
+    // Level-triggered: hangups are still reported while reads are paused.
+    // A multishot receive is cancelled instead; whatever it already took is
+    // still delivered, and resuming re-arms once its last completion is in.
+    if (m_multishot) {
+        if (!reading && m_recvId) m_loop.uring()->cancel(m_recvId);
+        else if (reading && !m_recvId && m_fd >= 0 && !armRecv()) fail("cannot queue a receive");
+    } else if (m_fd >= 0) {
+        m_loop.modify(m_fd, reading ? LOOP_READ : 0);
+    }
+    if (m_shmEventFd >= 0) m_loop.modify(m_shmEventFd, reading ? LOOP_READ : 0);
+}
+
+void Receiver::fail(const char* why) {
+    LOGW("%s:%d: %s", m_config.host.c_str(), m_config.port, why);
+    close();
+    if (m_onClosed) m_onClosed();
+}
+
+void Receiver::onEvent(uint32_t events) {
+    if (!(events & LOOP_READ)) {
+        if (events & (LOOP_ERROR | LOOP_HANGUP)) fail("connection closed");
+        return;
+    }
+    for (int i = 0; i < MAX_READS_PER_EVENT && m_reading && m_fd >= 0; i++) {
+        size_t avail;
+        uint8_t* dst = m_demux.writable(&avail);
+        ssize_t n = recv(m_fd, dst, avail, MSG_DONTWAIT);
+        if (n > 0) {
+            statsAddCounter(COUNTER_BYTES_RECEIVED, (uint64_t)n);
+            bool ok = m_demux.commit((size_t)n, [this](const FrameHeader& h, const uint8_t* payload, size_t len) {
+                onFrame(h, payload, len);
+            });
+            if (!ok) {
+                fail("corrupt stream");
+                return;
+            }
+            if ((size_t)n < avail) return; // drained
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        fail(n == 0 ? "connection closed" : std::strerror(errno));
+        return;
+    }
+}
+
+bool Receiver::armRecv() {
+    m_recvId = m_loop.uring()->recvMultishot(m_fd, [this](int res, uint32_t flags) { onRecv(res, flags); });
+    return m_recvId != 0;
+}
+
+void Receiver::onRecv(int res, uint32_t flags) {
+    Uring* ring = m_loop.uring();
+    if (!(flags & Uring::CQE_MORE)) m_recvId = 0;
+    if (res > 0) {
+        statsAddCounter(COUNTER_BYTES_RECEIVED, (uint64_t)res);
+        const bool ok = m_demux.feed(ring->recvBuffer(flags), (size_t)res,
+                                     [this](const FrameHeader& h, const uint8_t* payload, size_t len) {
+                                         onFrame(h, payload, len);
+                                     });
+        ring->recycleRecvBuffer(flags);
+        if (!ok) {
+            fail("corrupt stream");
+            return;
+        }
+    } else if (res == 0) {
+        fail("connection closed");
+        return;
+    } else if (res != -ENOBUFS && res != -ECANCELED) {
+        // ENOBUFS: every provided buffer was taken; the receive ends and is re-armed below.
+        fail(std::strerror(-res));
+        return;
+    }
+    // onFrame() may have closed the connection.
+    if (!m_recvId && m_reading && m_fd >= 0 && !m_loop.stopped() && !armRecv()) fail("cannot queue a receive");
+}
+
+void Receiver::onFrame(const FrameHeader& h, const uint8_t* payload, size_t length) {
+    if (m_config.sharedMemory || m_config.multicast) {
+        if (h.type == FRAME_METADATA && containsIgnoreCase((const char*)payload, length, "<OMTSharedMemory")) {
+            if (!m_shm.attached()) attachShm((const char*)payload, length);
+            return;
+        }
+        if (h.type == FRAME_METADATA && containsIgnoreCase((const char*)payload, length, "<OMTMulticast")) {
+            if (!multicastAttached()) attachMulticast((const char*)payload, length);
+            return;
+        }
+        // Both paths can carry a frame around the switch; keep each stream in order.
+        int64_t* last = h.type == FRAME_VIDEO ? &m_lastVideoTs : h.type == FRAME_AUDIO ? &m_lastAudioTs : nullptr;
+        if (last) {
+            if (h.timestamp <= *last) return;
+            *last = h.timestamp;
+        }
+    }
+    if (h.type == FRAME_VIDEO) statsAddCounter(COUNTER_FRAMES_RECEIVED);
+    m_onFrame(h, payload, length);
+}
+
+void Receiver::attachShm(const char* text, size_t length) {
+    int64_t pid, port;
+    if (!xmlAttrInt64(text, length, "Pid", &pid) || !xmlAttrInt64(text, length, "Port", &port)) return;
+    if (!m_shm.attach(shmFetch((int)pid, (int)port, m_config.connectTimeoutMs))) {
+        LOGW("%s:%d: shared memory unavailable, staying on TCP", m_config.host.c_str(), m_config.port);
+        return;
+    }
+    m_shmEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_shmEventFd < 0 ||
+        !m_loop.add(m_shmEventFd, m_reading ? LOOP_READ : 0, [this](uint32_t) { onShmEvent(); })) {
+        detachShm();
+        return;
+    }
+    m_shmStop.store(false);
+    m_shmNotifier = std::thread([this] {
+        pthread_setname_np(pthread_self(), "OmtShmNotify");
+        // Tracks the writer's commits itself: the ring position belongs to the loop thread.
+        uint64_t seen = m_shm.committed();
+        while (!m_shmStop.load(std::memory_order_relaxed)) {
+            const uint32_t seq = m_shm.wakeSeq();
+            const uint64_t committed = m_shm.committed();
+            if (committed != seen) {
+                seen = committed;
+                eventfd_write(m_shmEventFd, 1);
+                continue;
+            }
+            m_shm.waitFor(seq, SHM_WAIT_MS);
+        }
+    });
+    static const char kAttached[] = "<OMTSharedMemory Attached=\"true\" />";
+    if (!omt::sendMetadata(m_fd, kAttached, sizeof(kAttached) - 1)) {
+        detachShm();
+        return;
+    }
+    LOGI("%s:%d: media from shared memory", m_config.host.c_str(), m_config.port);
+}
+
+void Receiver::attachMulticast(const char* text, size_t length) {
+    MulticastConfig mc;
+    char group[64];
+    int64_t port;
+    if (!xmlAttrText(text, length, "Address", group, sizeof(group)) || !xmlAttrInt64(text, length, "Port", &port))
+        return;
+    mc.group = group;
+    mc.port = (int)port;
+    // Join on the interface that reaches the sender, not whatever the routing table prefers.
+    // A same-host sender's group is looped back on its outgoing interface, not on lo.
+    sockaddr_in local{};
+    socklen_t localLen = sizeof(local);
+    char address[INET_ADDRSTRLEN];
+    if (getsockname(m_fd, (sockaddr*)&local, &localLen) == 0 && local.sin_family == AF_INET &&
+        (ntohl(local.sin_addr.s_addr) >> 24) != 127 && inet_ntop(AF_INET, &local.sin_addr, address, sizeof(address)))
+        mc.interfaceAddress = address;
+    auto mcast = std::make_unique<MulticastReceiver>(
+        m_loop, mc, [this](const FrameHeader& h, const uint8_t* payload, size_t len) { onFrame(h, payload, len); });
+    static const char kAttached[] = "<OMTMulticast Attached=\"true\" />";
+    if (!mcast->start() || !sendMetadata(kAttached, sizeof(kAttached) - 1)) {
+        LOGW("%s:%d: multicast %s:%d unavailable, staying on TCP", m_config.host.c_str(), m_config.port,
+             mc.group.c_str(), mc.port);
+        return;
+    }
+    m_mcast = std::move(mcast);
+    LOGI("%s:%d: receiving media from %s:%d", m_config.host.c_str(), m_config.port, mc.group.c_str(), mc.port);
+}
+
+void Receiver::detachShm() {
+    if (m_shmNotifier.joinable()) {
+        m_shmStop.store(true);
+        m_shm.wakeAll();
+        m_shmNotifier.join();
+    }
+    if (m_shmEventFd >= 0) {
+        m_loop.remove(m_shmEventFd);
+        ::close(m_shmEventFd);
+        m_shmEventFd = -1;
+    }
+    m_shmDropped += m_shm.framesLost() + m_shm.framesTorn();
+    m_shm.detach();
+}
+
+void Receiver::onShmEvent() {
+    eventfd_t count;
+    eventfd_read(m_shmEventFd, &count);
+    m_shmFrames += (uint64_t)m_shm.poll(
+        [this](const FrameHeader& h, const uint8_t* payload, size_t len) { onFrame(h, payload, len); },
+        MAX_SHM_FRAMES_PER_EVENT);
+    // Still behind: come back after the other connections on the loop had their turn.
+    if (m_shmEventFd >= 0 && m_reading && m_shm.pending()) eventfd_write(m_shmEventFd, 1);
+}
+
+} // namespace omt
@@ -0,0 +1,127 @@
+/**
+ * Native OMT receiver core: one subscribed connection driven by an
+ * EventLoop. The socket stays blocking for the rare small metadata writes
+ * and is read with MSG_DONTWAIT, straight into a Demuxer; each complete
+ * frame is handed to the callback in place.
+ *
+ * Many receivers can share one loop (load generators, benchmarks); a read
+ * burst is capped per wakeup so one fast connection cannot starve the rest.
+ * On an io_uring loop the socket is read by one multishot receive into the
+ * loop's provided buffers instead, and the data is copied into the Demuxer.
+ *
+ * With sharedMemory set the receiver asks a same-host sender for its omt_shm
+ * ring and, once mapped, takes video and audio from there in place. A small
+ * notifier thread sleeps on the ring's futex and wakes the loop through an
+ * eventfd, so frames are still delivered on the loop thread. Around the switch
+ * either path may carry a frame; only ones newer than the last delivered of
+ * their type are passed on.
+ *
+ * With multicast set it likewise asks to join the sender's omt_multicast
+ * group; the group's socket is registered on the same loop and goes through
+ * the same de-duplication.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "omt_demux.h"
+#include "omt_loop.h"
+#include "omt_multicast.h"
+#include "omt_protocol.h"
+#include "omt_shm.h"
+
+namespace omt {
+
+struct ReceiverConfig {
+    std::string host = "127.0.0.1";
+    int port = 6500;
+    bool video = true;
+    bool audio = false;
+    bool metadata = false;
+    bool preview = false;    // <OMTSettings Preview="true" />: ask for the sender's low-resolution preview stream
+    int recvBufferBytes = 0; // SO_RCVBUF; 0 keeps the kernel default
+    bool sharedMemory = false; // read media from a same-host sender's omt_shm ring when it offers one
+    bool multicast = false;    // take media from the sender's omt_multicast group when it offers one (monitoring)
+    bool nvlz = false;         // <OMTCodecs Accept="NVLZ" />: take NV12 as NVLZ (omt_lz4) from senders that offer it
+    int connectTimeoutMs = 3000;
+};
+
+class Receiver {
+public:
+    /** payload points past the 16-byte header and is only valid during the call. */
+    using FrameCallback = std::function<void(const FrameHeader& header, const uint8_t* payload, size_t length)>;
+
+    Receiver(EventLoop& loop, ReceiverConfig config, FrameCallback onFrame);
+    ~Receiver();
+    Receiver(const Receiver&) = delete;
+    Receiver& operator=(const Receiver&) = delete;
+
+    /** Blocking connect + subscribe, then register with the loop (loop thread, or before it runs). */
+    bool connect();
+    /** Loop thread only. */
+    void close();
+    bool connected() const { return m_fd >= 0; }
+
+    /** Called on the loop thread when the peer closes or the stream breaks. */
+    void setOnClosed(std::function<void()> onClosed) { m_onClosed = std::move(onClosed); }
+
+    /** Blocking write of one metadata frame (clock requests, settings). */
+    bool sendMetadata(const char* xml, size_t length);
+
+    /** Pause or resume reading; a paused receiver lets the sender's queue back up. */
+    void setReading(bool reading);
+    bool reading() const { return m_reading; }
+
+    uint64_t bytesReceived() const { return m_demux.bytesReceived(); }
+    uint64_t framesReceived() const { return m_demux.framesParsed(); }
+
+    bool sharedMemoryAttached() const { return m_shm.attached(); }
+    /** Frames taken from the shared-memory ring, and those it lost or tore under this reader. */
+    uint64_t sharedMemoryFrames() const { return m_shmFrames; }
+    uint64_t sharedMemoryDropped() const {
+        return m_shmDropped + (m_shm.attached() ? m_shm.framesLost() + m_shm.framesTorn() : 0);
+    }
+
+    bool multicastAttached() const { return m_mcast && m_mcast->running(); }
+    /** The group's receiver once attached (frames, losses, FEC recoveries); nullptr before. */
+    const MulticastReceiver* multicast() const { return m_mcast.get(); }
+
+private:
+    void onEvent(uint32_t events);
+    bool armRecv();
+    void onRecv(int res, uint32_t flags);
+    void onFrame(const FrameHeader& h, const uint8_t* payload, size_t length);
+    void fail(const char* why);
+    void attachShm(const char* text, size_t length);
+    void detachShm();
+    void onShmEvent();
+    void attachMulticast(const char* text, size_t length);
+
+    EventLoop& m_loop;
+    ReceiverConfig m_config;
+    FrameCallback m_onFrame;
+    std::function<void()> m_onClosed;
+    Demuxer m_demux;
+    int m_fd = -1;
+    bool m_reading = true;
+    bool m_multishot = false; // io_uring loop: reads come from a multishot receive
+    uint64_t m_recvId = 0;
+
+    ShmReader m_shm;
+    int m_shmEventFd = -1;
+    std::thread m_shmNotifier;
+    std::atomic<bool> m_shmStop{false};
+    int64_t m_lastVideoTs = INT64_MIN, m_lastAudioTs = INT64_MIN;
+    uint64_t m_shmFrames = 0;
+    uint64_t m_shmDropped = 0; // lost and torn counts of rings already detached
+
+    std::unique_ptr<MulticastReceiver> m_mcast; // stopped, not freed, on close(): it may be on the stack
+};
+
+} // namespace omt
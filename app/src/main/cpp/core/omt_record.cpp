@@ -0,0 +1,380 @@
+#define LOG_TAG "OmtRecord"
+#include "omt_record.h"
+#include "omt_log.h"
+#include "omt_protocol.h"
+#include "omt_stats.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the .idx layout is written as-is");
+
+namespace omt {
+
+namespace {
+
+constexpr size_t RECORD_HEADER = 16; // [u32 length][u32 pad][i64 recordedNs] in front of each ring record
+constexpr uint32_t RING_WRAP = 0xFFFFFFFFu;
+constexpr uint32_t INDEX_VERSION = 1;
+constexpr size_t MAX_PENDING_ENTRIES = 256; // index entries buffered before a write
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+} // namespace
+
+bool recordingConfigured() {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    if (__system_property_get("debug.omt.record", value) <= 0) return false;
+#else
+    const char* value = std::getenv("OMT_RECORD");
+    if (!value) return false;
+#endif
+    return std::atoi(value) > 0;
+}
+
+Recorder::Recorder(RecorderConfig config) : m_config(std::move(config)) {
+    m_config.bufferBytes = std::max<size_t>(align8(m_config.bufferBytes), 1u << 20);
+}
+
+Recorder::~Recorder() { stop(); }
+
+std::string Recorder::segmentPath(const std::string& basePath, int n) {
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "-%04d.omt", n);
+    return basePath + suffix;
+}
+
+std::string Recorder::currentSegment() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_segmentPath;
+}
+
+bool Recorder::start() {
+    if (m_running.load()) return true;
+    m_ring.assign(m_config.bufferBytes, 0);
+    m_head = m_tail = 0;
+    m_stopping = false;
+    m_failed.store(false);
+    m_segment = 0;
+    if (!openSegment()) return false;
+    m_lastSyncNs = nowNs();
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread([this] {
+        pthread_setname_np(pthread_self(), "OmtRecorder");
+        writerLoop();
+    });
+    LOGI("Recording to %s", m_segmentPath.c_str());
+    return true;
+}
+
+void Recorder::stop() {
+    if (!m_running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    closeSegment();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<uint8_t>().swap(m_ring);
+    }
+    LOGI("Recording stopped: %llu frames, %.1f MB written, %llu dropped",
+         (unsigned long long)framesWritten(), bytesWritten() / 1e6, (unsigned long long)framesDropped());
+}
+
+bool Recorder::record(const uint8_t* head, size_t headLength, const uint8_t* body, size_t bodyLength,
+                      const uint8_t* tail, size_t tailLength) {
+    const size_t length = headLength + bodyLength + tailLength;
+    if (headLength < (size_t)HEADER_SIZE || length > UINT32_MAX - RECORD_HEADER) return false;
+    const size_t need = align8(RECORD_HEADER + length);
+    bool accepting, queued = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const size_t capacity = m_ring.size();
+        accepting = m_running.load(std::memory_order_relaxed) && !m_failed.load(std::memory_order_relaxed) &&
+                    !m_stopping;
+        if (accepting && need <= capacity) {
+            const size_t pos = (size_t)(m_head % capacity);
+            // Records never wrap: the rest of the ring becomes padding when the frame does not fit.
+            const size_t skip = pos + need > capacity ? capacity - pos : 0;
+            if (m_head + skip + need - m_tail <= capacity) {
+                if (skip) {
+                    const uint32_t wrap = RING_WRAP;
+                    std::memcpy(&m_ring[pos], &wrap, sizeof(wrap));
+                    m_head += skip;
+                }
+                uint8_t* rec = &m_ring[(size_t)(m_head % capacity)];
+                const uint32_t len32 = (uint32_t)length;
+                const int64_t at = nowNs();
+                std::memcpy(rec, &len32, sizeof(len32));
+                std::memcpy(rec + 8, &at, sizeof(at));
+                std::memcpy(rec + RECORD_HEADER, head, headLength);
+                if (bodyLength) std::memcpy(rec + RECORD_HEADER + headLength, body, bodyLength);
+                if (tailLength) std::memcpy(rec + RECORD_HEADER + headLength + bodyLength, tail, tailLength);
+                m_head += need;
+                queued = true;
+            }
+        }
+    }
+    if (queued) {
+        m_cond.notify_one();
+        return true;
+    }
+    // Only a full ring is an overflow; a failed or stopping recording refuses frames without counting them.
+    if (accepting) {
+        m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+        statsRecordDrop(DROP_RECORD_OVERFLOW);
+    }
+    return false;
+}
+
+void Recorder::writerLoop() {
+    const size_t capacity = m_ring.size();
+    for (;;) {
+        uint64_t head, tail;
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait_for(lock, std::chrono::milliseconds(std::max(m_config.syncIntervalMs, 100)),
+                            [this] { return m_head != m_tail || m_stopping; });
+            head = m_head;
+            tail = m_tail;
+            stopping = m_stopping;
+        }
+        // [tail, head) belongs to this thread until m_tail moves past it.
+        while (tail != head) {
+            const uint8_t* rec = &m_ring[(size_t)(tail % capacity)];
+            uint32_t length;
+            std::memcpy(&length, rec, sizeof(length));
+            if (length == RING_WRAP) {
+                tail += capacity - (size_t)(tail % capacity);
+                continue;
+            }
+            int64_t recordedNs;
+            std::memcpy(&recordedNs, rec + 8, sizeof(recordedNs));
+            const uint8_t* frame = rec + RECORD_HEADER;
+            tail += align8(RECORD_HEADER + length);
+            if (m_failed.load(std::memory_order_relaxed)) continue; // drain without writing
+
+            FrameHeader h;
+            parseFrameHeader(frame, &h);
+            // New segment at a video frame so each one starts with a picture (audio-only streams roll anywhere).
+            if (m_dataOffset > 0 && m_dataOffset + length > m_config.segmentBytes &&
+                (h.type == FRAME_VIDEO || m_dataOffset > m_config.segmentBytes)) {
+                closeSegment();
+                if (!openSegment()) {
+                    m_failed.store(true);
+                    continue;
+                }
+            }
+            if (!writeAll(m_dataFd, frame, length)) {
+                LOGE("Recording write failed (%s): stopped at %s", std::strerror(errno), m_segmentPath.c_str());
+                m_failed.store(true);
+                continue;
+            }
+            RecordEntry e = {};
+            e.offset = m_dataOffset;
+            e.timestamp = h.timestamp;
+            e.recordedNs = recordedNs;
+            e.length = length;
+            e.type = h.type;
+            m_pendingEntries.push_back(e);
+            m_dataOffset += length;
+            m_bytesWritten.fetch_add(length, std::memory_order_relaxed);
+            m_framesWritten.fetch_add(1, std::memory_order_relaxed);
+            if (m_pendingEntries.size() >= MAX_PENDING_ENTRIES && !flushIndex()) m_failed.store(true);
+        }
+        // Index entries go out after the data they point at.
+        if (!m_failed.load(std::memory_order_relaxed) && !flushIndex()) m_failed.store(true);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tail = tail;
+        }
+        const int64_t now = nowNs();
+        if (m_config.syncIntervalMs > 0 && now - m_lastSyncNs >= (int64_t)m_config.syncIntervalMs * 1000000) {
+            sync();
+            m_lastSyncNs = now;
+        }
+        if (stopping) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_head == m_tail) break;
+        }
+    }
+}
+
+bool Recorder::openSegment() {
+    const std::string path = segmentPath(m_config.basePath, ++m_segment);
+    const std::string indexPath = path + ".idx";
+    m_dataFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    m_indexFd = m_dataFd >= 0 ? ::open(indexPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : -1;
+    if (m_indexFd < 0) {
+        LOGE("Cannot create %s: %s", m_dataFd < 0 ? path.c_str() : indexPath.c_str(), std::strerror(errno));
+        if (m_dataFd >= 0) ::close(m_dataFd);
+        m_dataFd = -1;
+        return false;
+    }
+    uint8_t header[RECORD_INDEX_HEADER_SIZE] = {};
+    std::memcpy(header, RECORD_INDEX_MAGIC, sizeof(RECORD_INDEX_MAGIC));
+    putU32(header + 8, INDEX_VERSION);
+    putU32(header + 12, sizeof(RecordEntry));
+    const int64_t unixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    putU64(header + 16, (uint64_t)unixMs);
+    if (!writeAll(m_indexFd, header, sizeof(header))) {
+        LOGE("Cannot write %s: %s", indexPath.c_str(), std::strerror(errno));
+        closeSegment();
+        return false;
+    }
+    m_dataOffset = 0;
+    m_syncedOffset = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_segmentPath = path;
+    return true;
+}
+
+void Recorder::closeSegment() {
+    if (m_indexFd >= 0) {
+        flushIndex();
+        sync();
+        ::close(m_indexFd);
+        m_indexFd = -1;
+    }
+    if (m_dataFd >= 0) {
+        ::close(m_dataFd);
+        m_dataFd = -1;
+    }
+    m_pendingEntries.clear();
+}
+
+bool Recorder::writeAll(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        const ssize_t n = ::write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+bool Recorder::flushIndex() {
+    if (m_pendingEntries.empty() || m_indexFd < 0) return true;
+    const bool ok = writeAll(m_indexFd, reinterpret_cast<const uint8_t*>(m_pendingEntries.data()),
+                             m_pendingEntries.size() * sizeof(RecordEntry));
+    if (!ok) LOGE("Index write failed (%s): stopped at %s", std::strerror(errno), m_segmentPath.c_str());
+    m_pendingEntries.clear();
+    return ok;
+}
+
+void Recorder::sync() {
+    if (m_dataFd >= 0) {
+        fdatasync(m_dataFd);
+        // Written pages are not read back here; keep them from crowding the page cache on the phone.
+        posix_fadvise(m_dataFd, (off_t)m_syncedOffset, (off_t)(m_dataOffset - m_syncedOffset), POSIX_FADV_DONTNEED);
+        m_syncedOffset = m_dataOffset;
+    }
+    if (m_indexFd >= 0) fdatasync(m_indexFd);
+}
+
+// ---- Reader ----
+
+RecordingReader::~RecordingReader() { close(); }
+
+bool RecordingReader::open(const std::string& dataPath) {
+    close();
+    const std::string indexPath = dataPath + ".idx";
+    m_dataFd = ::open(dataPath.c_str(), O_RDONLY | O_CLOEXEC);
+    const int indexFd = ::open(indexPath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat ds = {}, is = {};
+    if (m_dataFd < 0 || indexFd < 0 || fstat(m_dataFd, &ds) != 0 || fstat(indexFd, &is) != 0) {
+        LOGE("Cannot open %s: %s", m_dataFd < 0 ? dataPath.c_str() : indexPath.c_str(), std::strerror(errno));
+        if (indexFd >= 0) ::close(indexFd);
+        close();
+        return false;
+    }
+    m_dataSize = (uint64_t)ds.st_size;
+    m_indexSize = (size_t)is.st_size;
+    if (m_indexSize >= RECORD_INDEX_HEADER_SIZE) {
+        void* p = mmap(nullptr, m_indexSize, PROT_READ, MAP_SHARED, indexFd, 0);
+        m_index = p == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(p);
+    }
+    ::close(indexFd);
+    if (!m_index || std::memcmp(m_index, RECORD_INDEX_MAGIC, sizeof(RECORD_INDEX_MAGIC)) != 0 ||
+        getU32(m_index + 8) != INDEX_VERSION || getU32(m_index + 12) != sizeof(RecordEntry)) {
+        LOGE("%s is not a recording index", indexPath.c_str());
+        close();
+        return false;
+    }
+    m_createdUnixMs = (int64_t)getU64(m_index + 16);
+    m_entries = reinterpret_cast<const RecordEntry*>(m_index + RECORD_INDEX_HEADER_SIZE);
+    // Callers index the data mapping with these entries and seek() bisects them, so the index is used up
+    // to its first entry that lies outside the data, is shorter than a frame header or goes back in time.
+    // After a crash only the trailing entries fail (their data was never written).
+    const size_t listed = (m_indexSize - RECORD_INDEX_HEADER_SIZE) / sizeof(RecordEntry);
+    int64_t lastRecordedNs = INT64_MIN;
+    for (m_count = 0; m_count < listed; m_count++) {
+        const RecordEntry& e = m_entries[m_count];
+        if (e.offset > m_dataSize || e.length > m_dataSize - e.offset || e.length < HEADER_SIZE ||
+            e.recordedNs < lastRecordedNs)
+            break;
+        lastRecordedNs = e.recordedNs;
+    }
+    if (m_count < listed && m_entries[m_count].offset < m_dataSize)
+        LOGW("%s: index entry %zu is invalid; using the %zu before it", indexPath.c_str(), m_count, m_count);
+    if (m_dataSize > 0) {
+        void* p = mmap(nullptr, (size_t)m_dataSize, PROT_READ, MAP_SHARED, m_dataFd, 0);
+        if (p == MAP_FAILED) {
+            LOGE("Cannot map %s: %s", dataPath.c_str(), std::strerror(errno));
+            close();
+            return false;
+        }
+        m_data = static_cast<const uint8_t*>(p);
+        madvise(const_cast<uint8_t*>(m_data), (size_t)m_dataSize, MADV_SEQUENTIAL);
+    }
+    return true;
+}
+
+void RecordingReader::close() {
+    if (m_data) munmap(const_cast<uint8_t*>(m_data), (size_t)m_dataSize);
+    if (m_index) munmap(const_cast<uint8_t*>(m_index), m_indexSize);
+    if (m_dataFd >= 0) ::close(m_dataFd);
+    m_data = nullptr;
+    m_index = nullptr;
+    m_entries = nullptr;
+    m_dataFd = -1;
+    m_dataSize = 0;
+    m_indexSize = 0;
+    m_count = 0;
+}
+
+size_t RecordingReader::seek(int64_t recordedNs) const {
+    const RecordEntry* end = m_entries + m_count;
+    return (size_t)(std::lower_bound(m_entries, end, recordedNs,
+                                     [](const RecordEntry& e, int64_t t) { return e.recordedNs < t; }) -
+                    m_entries);
+}
+
+} // namespace omt
@@ -0,0 +1,165 @@
+/**
+ * Recording of outgoing OMT frames (the VMX1/NV12 video and FPA1 audio a
+ * sender writes) to indexed segment files, e.g. as a backup ISO on the phone.
+ *
+ * A segment is two files:
+ *   BASE-0001.omt      the wire frames back to back, exactly as a subscriber
+ *                      reads them (omt_bench_decode and omt_receive --stream
+ *                      format), so any OMT stream tool can read it
+ *   BASE-0001.omt.idx  a 32-byte header ("OMTRIDX1") and one 32-byte
+ *                      RecordEntry per frame: offset, length, type, the
+ *                      frame's OMT timestamp and when it was recorded
+ *
+ * Recorder::record() copies a frame into a bounded in-memory ring and
+ * returns; a writer thread appends the ring to the current segment, writes
+ * index entries only after their data, and syncs periodically. When storage
+ * falls behind and the ring is full, frames are dropped from the recording
+ * (DROP_RECORD_OVERFLOW) rather than stalling the caller. A write error
+ * stops the recording; the stream is never affected.
+ *
+ * RecordingReader maps both files read-only. The index is used up to its
+ * first entry that is out of bounds, shorter than a frame header or out of
+ * recording order; after a crash between the two writes, that drops exactly
+ * the entries whose data never reached the file.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace omt {
+
+/** One index entry, stored as-is (little-endian, 32 bytes) in the .idx file. */
+struct RecordEntry {
+    uint64_t offset;    // of the frame header in the .omt file
+    int64_t timestamp;  // the frame's OMT timestamp (100 ns units)
+    int64_t recordedNs; // monotonic clock when record() accepted the frame; non-decreasing
+    uint32_t length;    // header + payload bytes
+    uint8_t type;       // FRAME_VIDEO / FRAME_AUDIO / FRAME_METADATA
+    uint8_t reserved[3];
+};
+static_assert(sizeof(RecordEntry) == 32, "RecordEntry is an on-disk layout");
+
+constexpr char RECORD_INDEX_MAGIC[8] = {'O', 'M', 'T', 'R', 'I', 'D', 'X', '1'};
+constexpr size_t RECORD_INDEX_HEADER_SIZE = 32; // magic, version u32, entry size u32, created unix ms i64, reserved
+
+struct RecorderConfig {
+    std::string basePath;                 // segments are basePath-0001.omt (+ .idx), -0002, ...
+    size_t bufferBytes = 64u << 20;       // ring between record() and the writer; ~1 s of 4K VMX
+    uint64_t segmentBytes = 2ull << 30;   // start a new segment (at a video frame) past this size
+    int syncIntervalMs = 1000;            // fdatasync + drop written pages from the cache (0: never)
+};
+
+/** Recording requested through debug.omt.record / OMT_RECORD ("1"). */
+bool recordingConfigured();
+
+class Recorder {
+public:
+    explicit Recorder(RecorderConfig config);
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    /** Open the first segment and start the writer thread. */
+    bool start();
+    /** Write out what is queued, close the segment and join the writer. */
+    void stop();
+    bool running() const { return m_running.load(std::memory_order_acquire); }
+
+    /**
+     * Queue one wire frame given in pieces: the 16-byte frame header plus
+     * extended header (head), then the payload as body and an optional tail
+     * (NV12 passes its Y and UV planes). Copies and returns without touching
+     * storage; false if the frame was dropped (ring full, not running or
+     * failed). Thread-safe.
+     */
+    bool record(const uint8_t* head, size_t headLength, const uint8_t* body, size_t bodyLength,
+                const uint8_t* tail = nullptr, size_t tailLength = 0);
+
+    /** A write error stopped the recording. */
+    bool failed() const { return m_failed.load(std::memory_order_relaxed); }
+    uint64_t framesWritten() const { return m_framesWritten.load(std::memory_order_relaxed); }
+    /** Frames left out because the ring was full (DROP_RECORD_OVERFLOW). */
+    uint64_t framesDropped() const { return m_framesDropped.load(std::memory_order_relaxed); }
+    uint64_t bytesWritten() const { return m_bytesWritten.load(std::memory_order_relaxed); }
+    /** Path of the segment being written (empty before start()). */
+    std::string currentSegment() const;
+
+    /** BASE-NNNN.omt for segment n (1-based). */
+    static std::string segmentPath(const std::string& basePath, int n);
+
+private:
+    void writerLoop();
+    bool openSegment();
+    void closeSegment();
+    bool writeAll(int fd, const uint8_t* data, size_t length);
+    bool flushIndex();
+    void sync();
+
+    RecorderConfig m_config;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_failed{false};
+    std::atomic<uint64_t> m_framesWritten{0};
+    std::atomic<uint64_t> m_framesDropped{0};
+    std::atomic<uint64_t> m_bytesWritten{0};
+
+    // Ring of [u32 length][u32 pad][i64 recordedNs][frame], 8-byte aligned; head/tail count bytes.
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<uint8_t> m_ring;
+    uint64_t m_head = 0; // producers, under m_mutex
+    uint64_t m_tail = 0; // advanced by the writer under m_mutex once records are on disk
+    bool m_stopping = false;
+    std::thread m_thread;
+
+    // Writer thread only
+    int m_dataFd = -1;
+    int m_indexFd = -1;
+    int m_segment = 0;
+    std::string m_segmentPath;
+    uint64_t m_dataOffset = 0;
+    uint64_t m_syncedOffset = 0;
+    std::vector<RecordEntry> m_pendingEntries;
+    int64_t m_lastSyncNs = 0;
+};
+
+class RecordingReader {
+public:
+    RecordingReader() = default;
+    ~RecordingReader();
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    /** Map dataPath and dataPath + ".idx". */
+    bool open(const std::string& dataPath);
+    void close();
+
+    size_t frameCount() const { return m_count; }
+    const RecordEntry& entry(size_t i) const { return m_entries[i]; }
+    /** The whole wire frame (header + payload) of entry i, from the mapping. */
+    const uint8_t* frame(size_t i) const { return m_data + m_entries[i].offset; }
+    /** Data file descriptor, for sendfile()/splice() straight from the page cache. */
+    int dataFd() const { return m_dataFd; }
+    uint64_t dataBytes() const { return m_dataSize; }
+    int64_t createdUnixMs() const { return m_createdUnixMs; }
+    /** First entry recorded at or after recordedNs (entries are in recording order). */
+    size_t seek(int64_t recordedNs) const;
+
+private:
+    int m_dataFd = -1;
+    const uint8_t* m_data = nullptr;
+    uint64_t m_dataSize = 0;
+    const uint8_t* m_index = nullptr;
+    size_t m_indexSize = 0;
+    const RecordEntry* m_entries = nullptr;
+    size_t m_count = 0;
+    int64_t m_createdUnixMs = 0;
+};
+
+} // namespace omt
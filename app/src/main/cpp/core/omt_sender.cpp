@@ -0,0 +1,754 @@
+#define LOG_TAG "OmtSender"
+#include "omt_sender.h"
+#include "omt_latency.h"
+#include "omt_log.h"
+#include "omt_stats.h"
+#include "omt_uring.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace omt {
+
+namespace {
+
+constexpr const char* TALLY_XML = "<OMTTally Preview=\"false\" Program=\"false\" />";
+constexpr size_t MAX_CLIENT_FRAME = 1024 * 1024; // matches the app's metadata read limit
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+Sender::Sender(SenderConfig config) : m_config(std::move(config)) {
+    m_config.queueDepth = std::max(1, std::min(m_config.queueDepth, MAX_QUEUE - 4));
+}
+
+Sender::~Sender() {
+    stop();
+    for (auto& p : m_packets) {
+        if (p->refs.load(std::memory_order_relaxed) != 0)
+            LOGW("Packet still referenced at shutdown (%d refs)", p->refs.load());
+    }
+}
+
+bool Sender::start() {
+    if (running()) return true;
+    m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0) {
+        LOGE("socket failed: %s", std::strerror(errno));
+        return false;
+    }
+    int one = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)m_config.port);
+    if (inet_pton(AF_INET, m_config.bindAddress.c_str(), &addr.sin_addr) != 1 ||
+        bind(m_listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(m_listenFd, 16) != 0) {
+        LOGE("Cannot listen on %s:%d: %s", m_config.bindAddress.c_str(), m_config.port, std::strerror(errno));
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    socklen_t addrLen = sizeof(addr);
+    getsockname(m_listenFd, (sockaddr*)&addr, &addrLen);
+    m_boundPort = ntohs(addr.sin_port);
+
+    if (m_config.frameBytesHint > 0 && m_packets.empty()) {
+        // Enough for every client to hold a frame in flight while the producer packs
+        // the next and the queues fill; more than that and frames are being dropped.
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        for (int i = 0; i < m_config.queueDepth + 3; i++) {
+            m_packets.push_back(std::make_unique<Packet>());
+            m_packets.back()->data.resize(m_config.frameBytesHint);
+            m_free.push_back(m_packets.back().get());
+        }
+        m_free.reserve(m_packets.size() * 2);
+    }
+
+    m_loop = std::make_unique<EventLoop>(m_config.loop);
+    if (!m_loop->valid() || !m_loop->add(m_listenFd, LOOP_READ, [this](uint32_t) { onAccept(); })) {
+        m_loop.reset();
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    if (m_config.sharedMemoryBytes > 0) {
+        m_shmListenFd = m_shm.create(m_config.sharedMemoryBytes) ? shmListen((int)getpid(), m_boundPort) : -1;
+        if (m_shmListenFd < 0 ||
+            !m_loop->add(m_shmListenFd, LOOP_READ, [this](uint32_t) { shmServePending(m_shmListenFd, m_shm.fd()); })) {
+            LOGW("Shared-memory transport unavailable; local receivers stay on TCP");
+            if (m_shmListenFd >= 0) close(m_shmListenFd);
+            m_shmListenFd = -1;
+            m_shm.destroy();
+        }
+    }
+    if (!m_config.multicast.empty()) {
+        MulticastConfig mc;
+        if (!parseMulticastSpec(m_config.multicast.c_str(), &mc)) {
+            LOGW("Ignoring multicast spec \"%s\"", m_config.multicast.c_str());
+        } else {
+            m_mcast = std::make_unique<MulticastSender>(mc);
+            if (!m_mcast->start()) {
+                LOGW("Multicast unavailable; monitoring receivers stay on TCP");
+                m_mcast.reset();
+            }
+        }
+    }
+    m_loop->setWakeHandler([this] { flushAll(); });
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread([this] {
+        pthread_setname_np(pthread_self(), "OmtSenderIO");
+        m_loop->run();
+    });
+    LOGI("Listening on %s:%d", m_config.bindAddress.c_str(), m_boundPort);
+    return true;
+}
+
+void Sender::stop() {
+    if (!m_running.exchange(false)) return;
+    m_loop->stop();
+    if (m_thread.joinable()) m_thread.join();
+    while (!m_clients.empty()) closeClient(m_clients.back().get());
+    // The loop settled its ring when it stopped; anything still listed as in flight never completed.
+    for (auto& c : m_closed) {
+        for (int i = c->sendDone; i < c->sendCount; i++) release(c->sending[i]);
+        c->sendCount = c->sendDone = 0;
+    }
+    m_closed.clear();
+    m_loop->remove(m_listenFd);
+    close(m_listenFd);
+    m_listenFd = -1;
+    if (m_shmListenFd >= 0) {
+        m_loop->remove(m_shmListenFd);
+        close(m_shmListenFd);
+        m_shmListenFd = -1;
+    }
+    m_shm.destroy();
+    m_mcast.reset();
+    m_loop.reset();
+}
+
+// ---- Packet pool ----
+
+Packet* Sender::acquire(size_t frameBytes) {
+    Packet* p = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        // Prefer a free packet that is already big enough; frames are similar sizes.
+        for (size_t i = m_free.size(); i-- > 0;) {
+            if (m_free[i]->data.size() >= frameBytes) {
+                p = m_free[i];
+                m_free[i] = m_free.back();
+                m_free.pop_back();
+                break;
+            }
+        }
+        if (!p && !m_free.empty()) {
+            p = m_free.back();
+            m_free.pop_back();
+        }
+        if (!p) {
+            m_packets.push_back(std::make_unique<Packet>());
+            p = m_packets.back().get();
+            m_free.reserve(m_packets.size());
+        }
+    }
+    if (p->data.size() < frameBytes) p->data.resize(frameBytes);
+    p->refs.store(1, std::memory_order_relaxed);
+    p->fileFd = -1;
+    p->fileLength = 0;
+    return p;
+}
+
+void Sender::release(Packet* packet) {
+    if (packet->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    m_free.push_back(packet);
+}
+
+// ---- Producer side ----
+
+Packet* Sender::beginVideo(size_t payloadCapacity) {
+    return acquire(HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + payloadCapacity);
+}
+
+void Sender::discard(Packet* packet) { release(packet); }
+
+int Sender::publishVideo(Packet* packet, const VideoHeader& vh, int64_t timestamp, size_t payloadLength) {
+    FrameHeader h;
+    h.type = FRAME_VIDEO;
+    h.timestamp = timestamp;
+    h.dataLength = (int32_t)(VIDEO_EXT_HEADER_SIZE + payloadLength);
+    writeFrameHeader(packet->data.data(), h);
+    writeVideoHeader(packet->payload(), vh);
+    packet->length = HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + payloadLength;
+    packet->type = FRAME_VIDEO;
+    const bool tightNv12 = vh.codec == CODEC_NV12 && vh.width > 0 && vh.height > 0 &&
+                           payloadLength == (size_t)vh.width * vh.height + (size_t)vh.width * (vh.height / 2);
+    if (!m_config.nvlz || !tightNv12 || m_nvlzClients.load(std::memory_order_relaxed) == 0) {
+        int n = publish(packet, true, false);
+        if (n > 0) statsAddCounter(COUNTER_FRAMES_SENT);
+        return n;
+    }
+    // Everyone else is queued before the compression runs; the extra reference keeps the planes readable.
+    packet->refs.fetch_add(1, std::memory_order_relaxed);
+    int n = publish(packet, true, false, Audience::NOT_NVLZ);
+    Packet* packed = packNvlz(*packet, vh, timestamp);
+    if (packed) {
+        release(packet);
+        n += publish(packed, true, false, Audience::NVLZ);
+    } else {
+        n += publish(packet, true, false, Audience::NVLZ);
+    }
+    if (n > 0) statsAddCounter(COUNTER_FRAMES_SENT);
+    return n;
+}
+
+Packet* Sender::packNvlz(const Packet& nv12, const VideoHeader& vh, int64_t timestamp) {
+    if (!m_lz) m_lz = std::make_unique<Lz4Compressor>();
+    Packet* p = beginVideo(nvlzBound(vh.width, vh.height));
+    const uint8_t* y = nv12.data.data() + HEADER_SIZE + VIDEO_EXT_HEADER_SIZE;
+    const size_t capacity = p->data.size() - HEADER_SIZE - VIDEO_EXT_HEADER_SIZE;
+    const int length = omt::packNvlz(*m_lz, y, y + (size_t)vh.width * vh.height, vh.width, vh.height,
+                                     p->payload() + VIDEO_EXT_HEADER_SIZE, capacity);
+    if (length < 0) {
+        discard(p);
+        return nullptr;
+    }
+    VideoHeader packed = vh;
+    packed.codec = CODEC_NVLZ;
+    FrameHeader h;
+    h.type = FRAME_VIDEO;
+    h.timestamp = timestamp;
+    h.dataLength = VIDEO_EXT_HEADER_SIZE + length;
+    writeFrameHeader(p->data.data(), h);
+    writeVideoHeader(p->payload(), packed);
+    p->length = HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + (size_t)length;
+    p->type = FRAME_VIDEO;
+    return p;
+}
+
+int Sender::sendVideo(const VideoHeader& vh, int64_t timestamp, const uint8_t* payload, size_t length) {
+    if (videoClientCount() == 0) return 0;
+    Packet* p = beginVideo(length);
+    std::memcpy(p->payload() + VIDEO_EXT_HEADER_SIZE, payload, length);
+    return publishVideo(p, vh, timestamp, length);
+}
+
+int Sender::sendAudio(const AudioHeader& ah, int64_t timestamp, const uint8_t* payload, size_t length) {
+    if (audioClientCount() == 0) return 0;
+    Packet* p = acquire(HEADER_SIZE + AUDIO_EXT_HEADER_SIZE + length);
+    FrameHeader h;
+    h.type = FRAME_AUDIO;
+    h.timestamp = timestamp;
+    h.dataLength = (int32_t)(AUDIO_EXT_HEADER_SIZE + length);
+    writeFrameHeader(p->data.data(), h);
+    writeAudioHeader(p->payload(), ah);
+    std::memcpy(p->payload() + AUDIO_EXT_HEADER_SIZE, payload, length);
+    p->length = HEADER_SIZE + AUDIO_EXT_HEADER_SIZE + length;
+    p->type = FRAME_AUDIO;
+    return publish(p, false, true);
+}
+
+int Sender::broadcastMetadata(const char* xml, size_t length, int64_t timestamp) {
+    Packet* p = acquire(HEADER_SIZE + length);
+    p->length = (size_t)buildMetadataFrame(p->data.data(), p->data.size(), xml, length, timestamp);
+    p->type = FRAME_METADATA;
+    return publish(p, false, false);
+}
+
+int Sender::sendFromFile(const FrameHeader& h, int fd, uint64_t dataOffset) {
+    const bool video = h.type == FRAME_VIDEO, audio = h.type == FRAME_AUDIO;
+    if (h.dataLength < 0 || (video && videoClientCount() == 0) || (audio && audioClientCount() == 0)) return 0;
+    Packet* p = acquire(HEADER_SIZE);
+    writeFrameHeader(p->data.data(), h);
+    p->fileFd = fd;
+    p->fileOffset = dataOffset;
+    p->fileLength = (size_t)h.dataLength;
+    p->length = HEADER_SIZE + p->fileLength;
+    p->type = h.type;
+    int n = publish(p, video, audio);
+    if (video && n > 0) statsAddCounter(COUNTER_FRAMES_SENT);
+    return n;
+}
+
+int Sender::publish(Packet* packet, bool video, bool audio, Audience audience) {
+    packet->queuedNs = nowNs();
+    // Same-host readers share the one copy in the ring; a frame that does not
+    // fit there goes to them over TCP like to everyone else. NVLZ never goes there.
+    const bool media = (video || audio) && audience != Audience::NVLZ;
+    const bool inRing = media && m_shmClients.load(std::memory_order_relaxed) > 0 && writeShm(*packet);
+    // Likewise one multicast transmission for every monitor; a frame the group
+    // dropped (full socket buffer) reaches them over TCP instead.
+    const bool inGroup = media && m_mcastClients.load(std::memory_order_relaxed) > 0 &&
+                         sendMulticast(*packet);
+    int queued = 0, ringReaders = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& c : m_clients) {
+            if ((video && !c->video) || (audio && !c->audio)) continue;
+            if (audience != Audience::ALL && (audience == Audience::NVLZ) != (c->nvlz && !c->shm && !c->multicast))
+                continue;
+            if ((inRing && c->shm) || (inGroup && c->multicast)) {
+                statsAddClientBytes(c->slot, packet->length);
+                ringReaders++;
+                continue;
+            }
+            packet->refs.fetch_add(1, std::memory_order_relaxed);
+            if (enqueueLocked(*c, packet)) queued++;
+            else packet->refs.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    if (queued > 0 && m_loop) m_loop->wake();
+    release(packet); // the producer's reference
+    return queued + ringReaders;
+}
+
+bool Sender::writeShm(const Packet& packet) {
+    std::lock_guard<std::mutex> lock(m_shmMutex);
+    uint8_t* dst = m_shm.reserve(packet.length);
+    if (!dst) return false;
+    const size_t inMemory = packet.length - packet.fileLength;
+    std::memcpy(dst, packet.data.data(), inMemory);
+    for (size_t done = 0; done < packet.fileLength;) {
+        ssize_t n = pread(packet.fileFd, dst + inMemory + done, packet.fileLength - done,
+                          (off_t)(packet.fileOffset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false; // not committed: the next reserve() reuses the room
+        done += (size_t)n;
+    }
+    m_shm.commit();
+    return true;
+}
+
+bool Sender::sendMulticast(const Packet& packet) {
+    // Recordings stay on TCP: sendfile() has no multicast counterpart worth a pread per frame.
+    if (!m_mcast || packet.fileFd >= 0) return false;
+    return m_mcast->send(packet.data.data(), packet.length, nullptr, 0);
+}
+
+bool Sender::enqueueLocked(Client& c, Packet* packet) {
+    bool media = packet->type != FRAME_METADATA;
+    if (media) {
+        // Video and audio are budgeted separately so a video backlog never costs audio.
+        int queuedSame = 0;
+        int oldest = -1;
+        for (int i = 0; i < c.count; i++) {
+            if (c.queue[i]->type != packet->type) continue;
+            if (oldest < 0) oldest = i;
+            queuedSame++;
+        }
+        if (queuedSame >= m_config.queueDepth) {
+            Packet* old = c.queue[oldest];
+            std::memmove(c.queue + oldest, c.queue + oldest + 1, sizeof(Packet*) * (c.count - oldest - 1));
+            c.count--;
+            release(old);
+            statsRecordDrop(DROP_SLOW_CLIENT, c.slot);
+        }
+    }
+    if (c.count == MAX_QUEUE) {
+        if (media) statsRecordDrop(DROP_SLOW_CLIENT, c.slot);
+        else LOGW("Client %s: control queue full, metadata dropped", c.peer.c_str());
+        return false;
+    }
+    c.queue[c.count++] = packet;
+    return true;
+}
+
+// ---- I/O thread ----
+
+int Sender::acquireSlot() {
+    for (int i = 0; i < STATS_MAX_CLIENTS; i++) {
+        if (!(m_slotsInUse & (1u << i))) {
+            m_slotsInUse |= 1u << i;
+            statsResetClient(i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Sender::onAccept() {
+    reapClosed();
+    for (;;) {
+        sockaddr_in addr{};
+        socklen_t addrLen = sizeof(addr);
+        int fd = accept4(m_listenFd, (sockaddr*)&addr, &addrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) LOGW("accept failed: %s", std::strerror(errno));
+            return;
+        }
+        char host[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+        if (!m_config.acceptLoopback && (ntohl(addr.sin_addr.s_addr) >> 24) == 127) {
+            close(fd);
+            continue;
+        }
+        sockaddr_in local{};
+        socklen_t localLen = sizeof(local);
+        const bool sameHost = (ntohl(addr.sin_addr.s_addr) >> 24) == 127 ||
+                              (getsockname(fd, (sockaddr*)&local, &localLen) == 0 &&
+                               local.sin_addr.s_addr == addr.sin_addr.s_addr);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &m_config.sendBufferBytes, sizeof(m_config.sendBufferBytes));
+
+        auto client = std::make_unique<Client>();
+        Client* c = client.get();
+        c->fd = fd;
+        c->local = sameHost;
+        c->peer = std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+        c->demux = std::make_unique<Demuxer>(MAX_CLIENT_FRAME, 4096);
+        int clients;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            c->slot = acquireSlot();
+            m_clients.push_back(std::move(client));
+            clients = (int)m_clients.size();
+        }
+        if (c->slot >= 0) statsSetClientLabel(c->slot, host);
+        if (!m_loop->add(fd, LOOP_READ, [this, c](uint32_t events) { onClientEvent(c, events); })) {
+            closeClient(c);
+            continue;
+        }
+        LOGI("Client %s connected (clients=%d)", c->peer.c_str(), clients);
+        // Initial metadata, as the app sends it (mimics vMix server behaviour)
+        queueControl(*c, m_config.infoXml.data(), m_config.infoXml.size());
+        queueControl(*c, TALLY_XML, std::strlen(TALLY_XML));
+        updateCounts();
+        flushClient(*c);
+    }
+}
+
+void Sender::onClientEvent(Client* c, uint32_t events) {
+    reapClosed();
+    bool dead = false;
+    if (events & LOOP_READ) {
+        for (;;) {
+            size_t avail;
+            uint8_t* dst = c->demux->writable(&avail);
+            ssize_t n = recv(c->fd, dst, avail, 0);
+            if (n > 0) {
+                int64_t receivedUs = monotonicUs();
+                bool ok = c->demux->commit((size_t)n, [&](const FrameHeader& h, const uint8_t* data, size_t len) {
+                    if (h.type == FRAME_METADATA) onClientMetadata(*c, data, len, receivedUs);
+                });
+                if (!ok) {
+                    LOGW("Client %s: corrupt stream", c->peer.c_str());
+                    dead = true;
+                    break;
+                }
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            dead = true; // EOF or error
+            break;
+        }
+    } else if (events & (LOOP_ERROR | LOOP_HANGUP)) {
+        dead = true;
+    }
+    if (dead) {
+        closeClient(c);
+        return;
+    }
+    flushClient(*c);
+}
+
+void Sender::onClientMetadata(Client& c, const uint8_t* data, size_t length, int64_t receivedUs) {
+    const char* text = (const char*)data;
+    length = strnlen(text, length);
+    if (containsIgnoreCase(text, length, "OMTClockRequest")) {
+        int64_t t1;
+        if (parseClockRequest(text, length, &t1)) {
+            c.latencyPeer = true;
+            char reply[160];
+            int n = formatClockReply(reply, sizeof(reply), t1, receivedUs, monotonicUs());
+            if (n > 0) queueControl(c, reply, (size_t)n);
+        }
+        return;
+    }
+    if (containsIgnoreCase(text, length, "OMTSharedMemory")) {
+        onSharedMemory(c, text, length);
+        return;
+    }
+    if (containsIgnoreCase(text, length, "OMTMulticast")) {
+        onMulticast(c, text, length);
+        return;
+    }
+    if (containsIgnoreCase(text, length, "OMTCodecs")) {
+        onCodecs(c, text, length);
+        return;
+    }
+    if (!containsIgnoreCase(text, length, "Subscribe")) return;
+    bool video = containsIgnoreCase(text, length, "Video");
+    bool audio = containsIgnoreCase(text, length, "Audio");
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // vMix often subscribes to video only; send audio to video clients too
+        if (video) c.video = c.audio = true;
+        if (audio) c.audio = true;
+    }
+    // Respond immediately to prevent vMix from resetting an idle audio channel
+    if (audio) queueControl(c, TALLY_XML, std::strlen(TALLY_XML));
+    updateCounts();
+}
+
+void Sender::onSharedMemory(Client& c, const char* text, size_t length) {
+    if (containsIgnoreCase(text, length, "Attached")) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (c.shm) return;
+            c.shm = true;
+        }
+        m_shmClients.fetch_add(1, std::memory_order_relaxed);
+        LOGI("Client %s reading media from shared memory", c.peer.c_str());
+        updateCounts();
+        return;
+    }
+    // Only a same-host peer can map the ring; anyone else gets no answer and stays on TCP.
+    if (m_shmListenFd < 0 || !c.local) return;
+    char reply[128];
+    int n = std::snprintf(reply, sizeof(reply), "<OMTSharedMemory Pid=\"%d\" Port=\"%d\" Bytes=\"%zu\" />",
+                          (int)getpid(), m_boundPort, m_shm.capacity());
+    if (n > 0 && (size_t)n < sizeof(reply)) queueControl(c, reply, (size_t)n);
+}
+
+void Sender::onMulticast(Client& c, const char* text, size_t length) {
+    if (containsIgnoreCase(text, length, "Attached")) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (c.multicast || !m_mcast) return;
+            c.multicast = true;
+        }
+        m_mcastClients.fetch_add(1, std::memory_order_relaxed);
+        LOGI("Client %s receiving media from %s", c.peer.c_str(), m_mcast->config().group.c_str());
+        updateCounts();
+        return;
+    }
+    // Without a group there is no answer and the receiver stays on TCP.
+    if (!m_mcast) return;
+    char reply[128];
+    int n = formatMulticastOffer(reply, sizeof(reply), m_mcast->config());
+    if (n > 0) queueControl(c, reply, (size_t)n);
+}
+
+void Sender::onCodecs(Client& c, const char* text, size_t length) {
+    if (!m_config.nvlz || !containsIgnoreCase(text, length, "NVLZ")) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (c.nvlz) return;
+        c.nvlz = true;
+    }
+    LOGI("Client %s accepts NVLZ", c.peer.c_str());
+    updateCounts();
+}
+
+void Sender::queueControl(Client& c, const char* xml, size_t length) {
+    Packet* p = acquire(HEADER_SIZE + length);
+    p->length = (size_t)buildMetadataFrame(p->data.data(), p->data.size(), xml, length);
+    p->type = FRAME_METADATA;
+    p->queuedNs = nowNs();
+    bool queued;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        queued = enqueueLocked(c, p);
+    }
+    if (!queued) release(p);
+}
+
+void Sender::flushClient(Client& c) {
+    for (;;) {
+        if (!c.current) {
+            if (m_loop->uring() && submitClient(c)) return;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (c.count > 0) {
+                    c.current = c.queue[0];
+                    std::memmove(c.queue, c.queue + 1, sizeof(Packet*) * (c.count - 1));
+                    c.count--;
+                }
+            }
+            if (!c.current) {
+                if (c.writeArmed) {
+                    m_loop->modify(c.fd, LOOP_READ);
+                    c.writeArmed = false;
+                }
+                return;
+            }
+            c.offset = 0;
+        }
+        Packet* p = c.current;
+        const size_t inMemory = p->length - p->fileLength;
+        ssize_t n;
+        if (c.offset < inMemory) {
+            // MSG_MORE holds a file-backed frame's header back until sendfile() follows it.
+            n = send(c.fd, p->data.data() + c.offset, inMemory - c.offset,
+                     MSG_NOSIGNAL | MSG_DONTWAIT | (p->fileLength ? MSG_MORE : 0));
+        } else {
+            off_t offset = (off_t)(p->fileOffset + (c.offset - inMemory));
+            n = sendfile(c.fd, p->fileFd, &offset, p->length - c.offset);
+            if (n == 0) {
+                LOGW("Client %s: frame source file truncated", c.peer.c_str());
+                closeClient(&c);
+                return;
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!c.writeArmed) {
+                    m_loop->modify(c.fd, LOOP_READ | LOOP_WRITE);
+                    c.writeArmed = true;
+                }
+                return;
+            }
+            LOGW("Client %s: send failed: %s", c.peer.c_str(), std::strerror(errno));
+            closeClient(&c);
+            return;
+        }
+        c.offset += (size_t)n;
+        if (c.offset < p->length) continue;
+        c.current = nullptr;
+        sent(c, p);
+    }
+}
+
+bool Sender::submitClient(Client& c) {
+    if (c.sendCount > 0) return true; // its completion submits the next chain
+    if (c.current) return false;      // a file-backed packet is part-way through
+    Uring* ring = m_loop->uring();
+    if (!ring->reserve(MAX_QUEUE)) return false; // room for the longest chain, so it goes in whole
+    int n = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (n < c.count && c.queue[n]->fileLength == 0) n++;
+        // Nothing queued, or a file-backed packet first: the readiness path deals with it.
+        if (n == 0) return false;
+        std::memcpy(c.sending, c.queue, sizeof(Packet*) * n);
+        std::memmove(c.queue, c.queue + n, sizeof(Packet*) * (c.count - n));
+        c.count -= n;
+    }
+    if (c.writeArmed) {
+        m_loop->modify(c.fd, LOOP_READ);
+        c.writeArmed = false;
+    }
+    // Linked, so the kernel sends them in order, each only after the previous
+    // one went out whole; a failure cancels the rest of the chain.
+    Client* client = &c;
+    for (int i = 0; i < n; i++) {
+        Packet* p = c.sending[i];
+        ring->send(c.fd, p->data.data(), p->length, i + 1 < n, [this, client](int res, uint32_t) { onSent(client, res); });
+    }
+    c.sendCount = n;
+    c.sendDone = 0;
+    c.sendFailed = false;
+    return true;
+}
+
+void Sender::onSent(Client* c, int res) {
+    Packet* p = c->sending[c->sendDone++];
+    if (res == (int)p->length && !c->closed) {
+        sent(*c, p);
+    } else {
+        if (!c->sendFailed && !c->closed && res != -ECANCELED)
+            LOGW("Client %s: send failed: %s", c->peer.c_str(), std::strerror(res < 0 ? -res : EPIPE));
+        c->sendFailed = true;
+        release(p);
+    }
+    if (c->sendDone < c->sendCount) return;
+    c->sendCount = c->sendDone = 0;
+    if (c->closed || m_loop->stopped()) return;
+    if (c->sendFailed) closeClient(c);
+    else flushClient(*c);
+}
+
+void Sender::sent(Client& c, Packet* p) {
+    // One STAGE_QUEUED_TO_WRITTEN sample per client write, through the client's slot
+    if (p->type != FRAME_METADATA) statsRecordClientWrite(c.slot, (uint64_t)(nowNs() - p->queuedNs));
+    statsAddClientBytes(c.slot, p->length); // also counts COUNTER_BYTES_SENT
+    release(p);
+}
+
+void Sender::flushAll() {
+    reapClosed();
+    // Clients can only be added or removed on this thread, so indexing is safe;
+    // flushClient may close (and unlink) the one at i.
+    for (size_t i = 0; i < m_clients.size();) {
+        Client* c = m_clients[i].get();
+        if (!c->writeArmed) flushClient(*c);
+        if (i < m_clients.size() && m_clients[i].get() == c) i++;
+    }
+}
+
+void Sender::closeClient(Client* c) {
+    if (m_loop) m_loop->remove(c->fd);
+    // A chain still in flight ends with the socket: the kernel holds its own
+    // reference, so shut it down first; the packets come back as it completes.
+    if (c->sendCount > 0) shutdown(c->fd, SHUT_RDWR);
+    close(c->fd);
+    c->closed = true;
+    if (c->current) {
+        release(c->current);
+        c->current = nullptr;
+    }
+    int clients;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < c->count; i++) release(c->queue[i]);
+        c->count = 0;
+        if (c->shm) m_shmClients.fetch_sub(1, std::memory_order_relaxed);
+        if (c->multicast) m_mcastClients.fetch_sub(1, std::memory_order_relaxed);
+        if (c->slot >= 0) m_slotsInUse &= ~(1u << c->slot);
+        auto it = std::find_if(m_clients.begin(), m_clients.end(), [c](auto& p) { return p.get() == c; });
+        if (it != m_clients.end()) {
+            m_closed.push_back(std::move(*it));
+            m_clients.erase(it);
+        }
+        clients = (int)m_clients.size();
+    }
+    if (c->slot >= 0) statsSetClientLabel(c->slot, nullptr);
+    LOGI("Client %s disconnected (clients=%d)", c->peer.c_str(), clients);
+    updateCounts();
+}
+
+void Sender::reapClosed() {
+    m_closed.erase(std::remove_if(m_closed.begin(), m_closed.end(), [](auto& c) { return c->sendCount == 0; }),
+                   m_closed.end());
+}
+
+void Sender::updateCounts() {
+    int total, video = 0, audio = 0, nvlz = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        total = (int)m_clients.size();
+        for (auto& c : m_clients) {
+            if (c->video) video++;
+            if (c->audio) audio++;
+            if (c->video && c->nvlz && !c->shm && !c->multicast) nvlz++;
+        }
+    }
+    m_clientCount.store(total, std::memory_order_relaxed);
+    m_videoClients.store(video, std::memory_order_relaxed);
+    m_audioClients.store(audio, std::memory_order_relaxed);
+    m_nvlzClients.store(nvlz, std::memory_order_relaxed);
+    statsSetGauge(GAUGE_CLIENTS, total);
+}
+
+} // namespace omt
@@ -0,0 +1,235 @@
+/**
+ * Native OMT sender core: listens for receivers, tracks their subscriptions
+ * and fans frames out to them, framing exactly like CameraStreamSender.
+ *
+ * Each frame is packed once (header + extended header + payload) into a
+ * pooled, refcounted Packet and queued by pointer on every subscribed
+ * client. One I/O thread runs an EventLoop that drains the per-client
+ * queues with non-blocking sends, so a slow receiver only ever delays
+ * itself: when its queue already holds `queueDepth` frames of the same type
+ * the oldest one is dropped (DROP_SLOW_CLIENT) instead of stalling the
+ * producer. Metadata is never dropped. send*() must not race with stop().
+ *
+ * Per-client bytes and queued → written latency go to omt_stats under the
+ * client's slot; clock requests are answered like the app sender does.
+ *
+ * Frames that already exist on disk in wire format (recordings) can be sent
+ * with sendFromFile(): only the 16-byte frame header is packed, the rest goes
+ * from the page cache to each socket with sendfile().
+ *
+ * With sharedMemoryBytes set, receivers on the same host can ask for the
+ * omt_shm ring: each media frame is then copied into it once, and those
+ * clients stop being queued video and audio on their sockets.
+ *
+ * With a multicast spec set, monitoring receivers can ask to join an
+ * omt_multicast group instead: each media frame is sent to it once, and those
+ * clients too stop being queued media. Program receivers that never ask keep
+ * plain TCP.
+ *
+ * Receivers that sent <OMTCodecs Accept="NVLZ" /> get NV12 frames as NVLZ
+ * (omt_lz4) instead: each frame is queued raw for everyone else first, then
+ * compressed once on the producer's thread for them. Ring and group readers
+ * keep NV12.
+ *
+ * On an io_uring loop (OMT_LOOP=uring) a client's queued in-memory packets
+ * are submitted together as one chain of linked sends and the next chain
+ * goes once that one has completed, so a backlog costs one submission instead
+ * of a send() per frame. File-backed packets keep the sendfile() path.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "omt_demux.h"
+#include "omt_loop.h"
+#include "omt_lz4.h"
+#include "omt_multicast.h"
+#include "omt_protocol.h"
+#include "omt_shm.h"
+
+namespace omt {
+
+struct SenderConfig {
+    int port = 6500;                   // 0 picks an ephemeral port (see Sender::port())
+    std::string bindAddress = "0.0.0.0";
+    int queueDepth = 2;                // video (and, separately, audio) frames queued per client
+    int sendBufferBytes = 512 * 1024;  // SO_SNDBUF, as in CameraStreamSender
+    bool acceptLoopback = true;        // the app rejects loopback peers; tools need them
+    size_t frameBytesHint = 0;         // preallocate the packet pool for frames this big (0: grow on demand)
+    size_t sharedMemoryBytes = 0;      // omt_shm ring offered to same-host receivers; 0 disables
+    std::string multicast;             // parseMulticastSpec() group offered to monitoring receivers; empty disables
+    bool nvlz = true;                  // NV12 frames also go out as NVLZ to receivers that accept it
+    LoopBackend loop = defaultLoopBackend(); // the I/O thread's EventLoop
+    std::string infoXml = "<OMTInfo ProductName=\"OMT Camera\" Manufacturer=\"OMT\" />";
+};
+
+/** One packed wire frame shared by every client it is queued on. */
+struct Packet {
+    std::vector<uint8_t> data;
+    size_t length = 0;
+    uint8_t type = 0;
+    int64_t queuedNs = 0;  // steady clock, for STAGE_QUEUED_TO_WRITTEN
+    std::atomic<int> refs{0};
+    // File-backed frames: data holds the first length - fileLength bytes, the
+    // rest is sent from fileFd at fileOffset.
+    int fileFd = -1;
+    uint64_t fileOffset = 0;
+    size_t fileLength = 0;
+
+    uint8_t* payload() { return data.data() + HEADER_SIZE; }
+};
+
+class Sender {
+public:
+    explicit Sender(SenderConfig config);
+    ~Sender();
+    Sender(const Sender&) = delete;
+    Sender& operator=(const Sender&) = delete;
+
+    /** Bind, listen and start the I/O thread. */
+    bool start();
+    void stop();
+    bool running() const { return m_running.load(std::memory_order_acquire); }
+    /** Bound port (useful with port 0). */
+    int port() const { return m_boundPort; }
+
+    int clientCount() const { return m_clientCount.load(std::memory_order_relaxed); }
+    int videoClientCount() const { return m_videoClients.load(std::memory_order_relaxed); }
+    int audioClientCount() const { return m_audioClients.load(std::memory_order_relaxed); }
+    /** Clients reading media from the shared-memory ring instead of their socket. */
+    int sharedMemoryClientCount() const { return m_shmClients.load(std::memory_order_relaxed); }
+    /** Clients receiving media from the multicast group instead of their socket. */
+    int multicastClientCount() const { return m_mcastClients.load(std::memory_order_relaxed); }
+    /** Clients sent NV12 video as NVLZ. */
+    int nvlzClientCount() const { return m_nvlzClients.load(std::memory_order_relaxed); }
+    /** The group's sender, or nullptr when multicast is off (for its counters). */
+    const MulticastSender* multicast() const { return m_mcast.get(); }
+
+    /**
+     * Zero-copy path: reserve a video packet with room for payloadCapacity
+     * bytes after the extended header, fill packet->payload() +
+     * VIDEO_EXT_HEADER_SIZE (e.g. encode straight into it), then publish.
+     */
+    Packet* beginVideo(size_t payloadCapacity);
+    /**
+     * Returns the number of clients the frame was queued on; consumes the packet.
+     * Video producer thread only (NV12 is compressed here for NVLZ clients).
+     */
+    int publishVideo(Packet* packet, const VideoHeader& vh, int64_t timestamp, size_t payloadLength);
+    /** Abandon a packet from beginVideo() without sending it. */
+    void discard(Packet* packet);
+
+    /** Copying convenience wrappers. */
+    int sendVideo(const VideoHeader& vh, int64_t timestamp, const uint8_t* payload, size_t length);
+    int sendAudio(const AudioHeader& ah, int64_t timestamp, const uint8_t* payload, size_t length);
+    int broadcastMetadata(const char* xml, size_t length, int64_t timestamp = 0);
+
+    /**
+     * Zero-copy from a file: send header h (as given, so the timestamp can be
+     * rewritten) followed by h.dataLength bytes of fd from dataOffset on. fd
+     * must stay open, and the bytes unchanged, until stop(). Video and audio go
+     * to their subscribers, metadata to every client; returns clients queued on.
+     */
+    int sendFromFile(const FrameHeader& h, int fd, uint64_t dataOffset);
+
+    /** The I/O thread's loop while started (backend, io_uring counters); nullptr otherwise. */
+    const EventLoop* eventLoop() const { return m_loop.get(); }
+
+private:
+    static constexpr int MAX_QUEUE = 16;
+
+    struct Client {
+        int fd = -1;
+        int slot = -1;
+        bool video = false;
+        bool audio = false;
+        bool writeArmed = false;
+        bool latencyPeer = false;
+        bool local = false;       // same host: may be offered the shared-memory ring
+        bool shm = false;         // media goes through the ring; guarded by m_mutex
+        bool multicast = false;   // media goes through the group; guarded by m_mutex
+        bool nvlz = false;        // accepts NVLZ video; guarded by m_mutex
+        std::string peer;
+        // Queued packets, oldest first; guarded by m_mutex.
+        Packet* queue[MAX_QUEUE] = {};
+        int count = 0;
+        // Owned by the I/O thread.
+        Packet* current = nullptr;
+        size_t offset = 0;
+        std::unique_ptr<Demuxer> demux;
+        // io_uring: the chain in flight, oldest first, and how much of it has completed.
+        Packet* sending[MAX_QUEUE] = {};
+        int sendCount = 0;
+        int sendDone = 0;
+        bool sendFailed = false;
+        bool closed = false;
+    };
+
+    /** Which clients a video packet goes to while NV12 is also being sent as NVLZ. */
+    enum class Audience : uint8_t { ALL, NVLZ, NOT_NVLZ };
+
+    Packet* acquire(size_t frameBytes);
+    void release(Packet* packet);
+    int publish(Packet* packet, bool video, bool audio, Audience audience = Audience::ALL);
+    Packet* packNvlz(const Packet& nv12, const VideoHeader& vh, int64_t timestamp);
+    bool enqueueLocked(Client& c, Packet* packet);
+    bool writeShm(const Packet& packet);
+    bool sendMulticast(const Packet& packet);
+
+    void onAccept();
+    void onClientEvent(Client* c, uint32_t events);
+    void onClientMetadata(Client& c, const uint8_t* data, size_t length, int64_t receivedUs);
+    void onSharedMemory(Client& c, const char* text, size_t length);
+    void onMulticast(Client& c, const char* text, size_t length);
+    void onCodecs(Client& c, const char* text, size_t length);
+    void queueControl(Client& c, const char* xml, size_t length);
+    void flushClient(Client& c);
+    bool submitClient(Client& c);
+    void onSent(Client* c, int res);
+    void sent(Client& c, Packet* p);
+    void flushAll();
+    void closeClient(Client* c);
+    void reapClosed();
+    void updateCounts();
+    int acquireSlot();
+
+    SenderConfig m_config;
+    int m_listenFd = -1;
+    int m_boundPort = 0;
+    std::atomic<bool> m_running{false};
+    std::atomic<int> m_clientCount{0};
+    std::atomic<int> m_videoClients{0};
+    std::atomic<int> m_audioClients{0};
+    std::atomic<int> m_nvlzClients{0};
+
+    std::unique_ptr<EventLoop> m_loop;
+    std::thread m_thread;
+
+    std::mutex m_mutex; // the client list, their queues and subscription flags
+    std::vector<std::unique_ptr<Client>> m_clients;
+    std::vector<std::unique_ptr<Client>> m_closed; // freed once no handler is on their stack and no send in flight
+    uint32_t m_slotsInUse = 0;
+
+    std::mutex m_shmMutex; // producers may be on different threads (video, audio)
+    ShmWriter m_shm;
+    int m_shmListenFd = -1;
+    std::atomic<int> m_shmClients{0};
+
+    std::unique_ptr<MulticastSender> m_mcast;
+    std::atomic<int> m_mcastClients{0};
+
+    std::unique_ptr<Lz4Compressor> m_lz; // video producer thread only
+
+    std::mutex m_poolMutex;
+    std::vector<std::unique_ptr<Packet>> m_packets;
+    std::vector<Packet*> m_free;
+};
+
+} // namespace omt
@@ -0,0 +1,351 @@
+#define LOG_TAG "OmtShm"
+#include "omt_shm.h"
+#include "omt_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace omt {
+
+struct ShmHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;      // offset of the ring; a whole number of pages
+    uint64_t capacity;         // ring bytes
+    alignas(64) std::atomic<uint64_t> writePos;   // end of the last committed record
+    std::atomic<uint64_t> latestPos;              // start of the last committed record
+    std::atomic<uint64_t> reclaimPos;             // ring bytes before this may be overwritten
+    alignas(64) std::atomic<uint32_t> wakeSeq;    // futex word, bumped on every commit
+    std::atomic<uint32_t> waiters;
+};
+
+namespace {
+
+constexpr char SHM_MAGIC[8] = {'O', 'M', 'T', 'S', 'H', 'M', '0', '1'};
+constexpr uint32_t SHM_VERSION = 1;
+constexpr size_t RECORD_HEADER = 16;     // u32 length, u32 flags, u64 index
+constexpr uint32_t WRAP_MARKER = 0xFFFFFFFFu;
+
+static_assert(sizeof(ShmHeader) <= 4096, "header must fit one page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring positions must be lock-free across processes");
+
+size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+size_t headerBytes() {
+    return std::max<size_t>(4096, (size_t)sysconf(_SC_PAGESIZE));
+}
+
+// Shared (not FUTEX_PRIVATE): the word lives in a mapping other processes wait on.
+long futex(std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+socklen_t socketAddress(int pid, int port, sockaddr_un* addr) {
+    const std::string name = shmSocketName(pid, port);
+    std::memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    // Abstract namespace: nothing to clean up on the filesystem when the sender dies.
+    const size_t n = std::min(name.size(), sizeof(addr->sun_path) - 1);
+    std::memcpy(addr->sun_path + 1, name.data(), n);
+    return (socklen_t)(offsetof(sockaddr_un, sun_path) + 1 + n);
+}
+
+} // namespace
+
+std::string shmSocketName(int pid, int port) {
+    return "omt-shm-" + std::to_string(pid) + "-" + std::to_string(port);
+}
+
+// ---- Writer ----
+
+ShmWriter::~ShmWriter() { destroy(); }
+
+bool ShmWriter::create(size_t bytes) {
+    destroy();
+    const size_t page = headerBytes();
+    const size_t capacity = (std::max<size_t>(bytes, 1u << 20) + page - 1) / page * page;
+    const int fd = (int)syscall(SYS_memfd_create, "omt-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        LOGW("memfd_create failed: %s", std::strerror(errno));
+        return false;
+    }
+    const size_t mapBytes = page + capacity;
+    if (ftruncate(fd, (off_t)mapBytes) != 0) {
+        LOGW("Cannot size shared-memory ring to %zu bytes: %s", mapBytes, std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    // Readers get the fd too; they must not be able to shrink it under the writer (SIGBUS).
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+    void* map = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOGW("Cannot map shared-memory ring: %s", std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    m_header = new (map) ShmHeader();
+    std::memcpy(m_header->magic, SHM_MAGIC, sizeof(SHM_MAGIC));
+    m_header->version = SHM_VERSION;
+    m_header->headerBytes = (uint32_t)page;
+    m_header->capacity = capacity;
+    m_data = static_cast<uint8_t*>(map) + page;
+    m_capacity = capacity;
+    m_mapBytes = mapBytes;
+    m_fd = fd;
+    m_pos = m_pending = m_pendingEnd = 0;
+    m_index = 0;
+    LOGI("Shared-memory ring: %.1f MB", capacity / 1e6);
+    return true;
+}
+
+void ShmWriter::destroy() {
+    if (!m_header) return;
+    munmap(m_header, m_mapBytes);
+    close(m_fd);
+    m_header = nullptr;
+    m_data = nullptr;
+    m_fd = -1;
+}
+
+uint8_t* ShmWriter::reserve(size_t length) {
+    const size_t recordBytes = align8(RECORD_HEADER + length);
+    if (!m_header || recordBytes > m_capacity / 2) return nullptr;
+    uint64_t start = m_pos;
+    const size_t offset = (size_t)(start % m_capacity);
+    const bool wrap = offset + recordBytes > m_capacity;
+    if (wrap) start += m_capacity - offset;
+    const uint64_t end = start + recordBytes;
+    // Readers re-check reclaimPos after reading, so it must move before the bytes do.
+    if (end > m_capacity) m_header->reclaimPos.store(end - m_capacity, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (wrap) std::memcpy(m_data + offset, &WRAP_MARKER, sizeof(WRAP_MARKER));
+    m_pending = start;
+    m_pendingEnd = end;
+    uint8_t* record = m_data + (size_t)(start % m_capacity);
+    putU32(record, (uint32_t)length);
+    return record + RECORD_HEADER;
+}
+
+void ShmWriter::commit() {
+    if (m_pendingEnd <= m_pos) return;
+    uint8_t* record = m_data + (size_t)(m_pending % m_capacity);
+    putU32(record + 4, 0);
+    putU64(record + 8, m_index++);
+    m_header->latestPos.store(m_pending, std::memory_order_relaxed);
+    m_header->writePos.store(m_pendingEnd, std::memory_order_release);
+    m_pos = m_pendingEnd;
+    m_header->wakeSeq.fetch_add(1);
+    if (m_header->waiters.load() > 0) futex(&m_header->wakeSeq, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+// ---- Reader ----
+
+ShmReader::~ShmReader() { detach(); }
+
+bool ShmReader::attach(int fd) {
+    detach();
+    if (fd < 0) return false;
+    const off_t size = lseek(fd, 0, SEEK_END);
+    const size_t page = headerBytes();
+    void* map = size > (off_t)page ? mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        LOGW("Cannot map shared-memory ring (%lld bytes)", (long long)size);
+        close(fd);
+        return false;
+    }
+    auto* header = static_cast<ShmHeader*>(map);
+    if (std::memcmp(header->magic, SHM_MAGIC, sizeof(SHM_MAGIC)) != 0 || header->version != SHM_VERSION ||
+        header->headerBytes % page != 0 || header->capacity % 8 != 0 ||
+        (uint64_t)header->headerBytes + header->capacity != (uint64_t)size ||
+        // Only the header is written by readers (waiters); the ring stays read-only.
+        mprotect(map, header->headerBytes, PROT_READ | PROT_WRITE) != 0) {
+        LOGW("Not an OMT shared-memory ring");
+        munmap(map, (size_t)size);
+        close(fd);
+        return false;
+    }
+    m_header = header;
+    m_data = static_cast<const uint8_t*>(map) + header->headerBytes;
+    m_capacity = (size_t)header->capacity;
+    m_mapBytes = (size_t)size;
+    m_fd = fd;
+    m_pos = header->writePos.load(std::memory_order_acquire);
+    m_nextIndex = 0;
+    m_framesRead = m_framesLost = m_framesTorn = 0;
+    return true;
+}
+
+void ShmReader::detach() {
+    if (!m_header) return;
+    munmap(m_header, m_mapBytes);
+    close(m_fd);
+    m_header = nullptr;
+    m_data = nullptr;
+    m_fd = -1;
+}
+
+bool ShmReader::pending() const {
+    return m_header && m_pos < m_header->writePos.load(std::memory_order_acquire);
+}
+
+uint64_t ShmReader::committed() const {
+    return m_header ? m_header->writePos.load(std::memory_order_acquire) : 0;
+}
+
+int ShmReader::poll(const FrameCallback& onFrame, int maxFrames) {
+    if (!m_header) return 0;
+    int delivered = 0;
+    const uint64_t end = m_header->writePos.load(std::memory_order_acquire);
+    while (delivered < maxFrames && m_pos < end) {
+        const uint64_t reclaim = m_header->reclaimPos.load(std::memory_order_acquire);
+        if (reclaim > m_pos) {
+            // Lapped: whatever was between here and the newest frame is gone.
+            const uint64_t latest = m_header->latestPos.load(std::memory_order_acquire);
+            m_pos = latest >= reclaim ? latest : end;
+            if (m_pos < reclaim) break; // the writer is mid-frame over it; back on its commit
+            continue;
+        }
+        const size_t offset = (size_t)(m_pos % m_capacity);
+        const uint8_t* record = m_data + offset;
+        const uint32_t length = getU32(record);
+        if (length == WRAP_MARKER) {
+            m_pos += m_capacity - offset;
+            continue;
+        }
+        FrameHeader h;
+        const bool sane = length >= HEADER_SIZE && offset + RECORD_HEADER + length <= m_capacity &&
+                          parseFrameHeader(record + RECORD_HEADER, &h) && h.dataLength >= 0 &&
+                          (size_t)h.dataLength <= length - HEADER_SIZE;
+        const uint64_t index = sane ? getU64(record + 8) : 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->reclaimPos.load(std::memory_order_relaxed) > m_pos) continue; // lapped while reading
+        if (!sane) {
+            LOGW("Corrupt shared-memory record at %llu; skipping to the newest frame", (unsigned long long)m_pos);
+            m_pos = end;
+            break;
+        }
+        if (index > m_nextIndex && m_framesRead > 0) m_framesLost += index - m_nextIndex;
+        m_nextIndex = index + 1;
+        onFrame(h, record + RECORD_HEADER + HEADER_SIZE, (size_t)h.dataLength);
+        if (!m_header) return delivered + 1; // detached from the callback
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->reclaimPos.load(std::memory_order_relaxed) > m_pos) m_framesTorn++;
+        m_framesRead++;
+        delivered++;
+        m_pos += align8(RECORD_HEADER + length);
+    }
+    return delivered;
+}
+
+uint32_t ShmReader::wakeSeq() const {
+    return m_header ? m_header->wakeSeq.load() : 0;
+}
+
+void ShmReader::waitFor(uint32_t seen, int timeoutMs) {
+    if (!m_header) return;
+    const timespec timeout = {timeoutMs / 1000, (long)(timeoutMs % 1000) * 1000000L};
+    m_header->waiters.fetch_add(1);
+    if (m_header->wakeSeq.load() == seen) futex(&m_header->wakeSeq, FUTEX_WAIT, seen, &timeout);
+    m_header->waiters.fetch_sub(1);
+}
+
+void ShmReader::wakeAll() {
+    if (m_header) futex(&m_header->wakeSeq, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+// ---- Handing out the memfd ----
+
+int shmListen(int pid, int port) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    sockaddr_un addr;
+    const socklen_t len = socketAddress(pid, port, &addr);
+    if (bind(fd, (sockaddr*)&addr, len) != 0 || listen(fd, 8) != 0) {
+        LOGW("Cannot listen on @%s: %s", shmSocketName(pid, port).c_str(), std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void shmServePending(int listenFd, int memfd) {
+    for (;;) {
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        // Same user only: the TCP stream is open to anyone, but the mapping is writable.
+        ucred cred{};
+        socklen_t credLen = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) != 0 || cred.uid != getuid()) {
+            LOGW("Shared-memory request from uid %d refused", (int)cred.uid);
+            close(fd);
+            continue;
+        }
+        char byte = 'M';
+        iovec iov = {&byte, 1};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+        if (sendmsg(fd, &msg, MSG_NOSIGNAL) != 1) LOGW("Cannot pass shared-memory fd: %s", std::strerror(errno));
+        close(fd);
+    }
+}
+
+int shmFetch(int pid, int port, int timeoutMs) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    const timeval tv = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    sockaddr_un addr;
+    const socklen_t len = socketAddress(pid, port, &addr);
+    if (connect(fd, (sockaddr*)&addr, len) != 0) {
+        LOGW("Cannot reach @%s: %s", shmSocketName(pid, port).c_str(), std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    char byte;
+    iovec iov = {&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    close(fd);
+    cmsghdr* cmsg = n == 1 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        LOGW("No shared-memory fd from @%s", shmSocketName(pid, port).c_str());
+        return -1;
+    }
+    int memfd;
+    std::memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+    return memfd;
+}
+
+} // namespace omt
@@ -0,0 +1,134 @@
+/**
+ * Same-host transport: a memfd-backed ring the sender writes every media frame
+ * into once, in wire format, and any number of local receivers read in place.
+ *
+ * Negotiated over the normal TCP connection's metadata:
+ *   receiver → <OMTSharedMemory Request="true" />
+ *   sender   → <OMTSharedMemory Pid="…" Port="…" Bytes="…" />   (same-host peers only)
+ *   receiver connects to the abstract Unix socket "omt-shm-PID-PORT", gets the
+ *            memfd over SCM_RIGHTS and maps it, then
+ *   receiver → <OMTSharedMemory Attached="true" />
+ * after which the sender stops queuing video and audio on that client's
+ * socket; metadata keeps flowing over TCP. Remote clients never see any of it.
+ *
+ * Layout: one header page, then a byte ring of variable-size records
+ * (8-aligned: u32 length, u32 flags, u64 index, then the frame). One writer,
+ * no reader state in the segment: readers keep their own position and can
+ * neither block nor slow the writer. Before reusing bytes the writer advances
+ * reclaimPos; a reader that finds its position below it has been lapped and
+ * jumps to the newest frame. Frames are handed to the callback in place and
+ * re-checked afterwards: one the writer reached while the callback still held
+ * it (a consumer a whole ring behind) is counted as torn.
+ *
+ * Wakeups use a futex on the header's wakeSeq, bumped on every commit; the
+ * writer only pays for FUTEX_WAKE while some reader is waiting.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "omt_protocol.h"
+
+namespace omt {
+
+constexpr size_t SHM_DEFAULT_BYTES = 64u << 20;
+
+struct ShmHeader;
+
+/** Abstract-namespace socket name ("omt-shm-PID-PORT", without the leading NUL). */
+std::string shmSocketName(int pid, int port);
+
+class ShmWriter {
+public:
+    ShmWriter() = default;
+    ~ShmWriter();
+    ShmWriter(const ShmWriter&) = delete;
+    ShmWriter& operator=(const ShmWriter&) = delete;
+
+    /** Create and map a sealed memfd with a ring of `bytes` (rounded up to pages). */
+    bool create(size_t bytes);
+    void destroy();
+    int fd() const { return m_fd; }
+    size_t capacity() const { return m_capacity; }
+
+    /**
+     * Reserve room for a frame of `length` bytes and return where to write it;
+     * nullptr if it can never fit (over half the ring). Finish with commit();
+     * reserving again without committing abandons the frame.
+     */
+    uint8_t* reserve(size_t length);
+    void commit();
+
+    uint64_t framesWritten() const { return m_index; }
+
+private:
+    ShmHeader* m_header = nullptr;
+    uint8_t* m_data = nullptr;
+    size_t m_capacity = 0;
+    size_t m_mapBytes = 0;
+    int m_fd = -1;
+    uint64_t m_pos = 0;        // next record, in ring bytes since creation
+    uint64_t m_pending = 0;    // start of the reserved record
+    uint64_t m_pendingEnd = 0;
+    uint64_t m_index = 0;
+};
+
+class ShmReader {
+public:
+    /** payload points past the 16-byte header, into the shared mapping; only valid during the call. */
+    using FrameCallback = std::function<void(const FrameHeader& header, const uint8_t* payload, size_t length)>;
+
+    ShmReader() = default;
+    ~ShmReader();
+    ShmReader(const ShmReader&) = delete;
+    ShmReader& operator=(const ShmReader&) = delete;
+
+    /** Map a ring received from the sender (takes ownership of fd); reading starts at the next frame. */
+    bool attach(int fd);
+    void detach();
+    bool attached() const { return m_header != nullptr; }
+
+    /** Deliver up to maxFrames committed frames in place; returns frames delivered. */
+    int poll(const FrameCallback& onFrame, int maxFrames);
+    bool pending() const;
+    /** End of the committed frames; safe to sample from another thread than poll()'s. */
+    uint64_t committed() const;
+
+    /** Futex word for waitFor(); sample it before checking committed(). */
+    uint32_t wakeSeq() const;
+    /** Sleep until wakeSeq moves past seen or timeoutMs elapses. */
+    void waitFor(uint32_t seen, int timeoutMs);
+    /** Wake every waiter on this ring (used to stop a notifier thread). */
+    void wakeAll();
+
+    uint64_t framesRead() const { return m_framesRead; }
+    /** Frames the writer lapped before this reader got to them. */
+    uint64_t framesLost() const { return m_framesLost; }
+    /** Frames overwritten while the callback was still using them. */
+    uint64_t framesTorn() const { return m_framesTorn; }
+
+private:
+    ShmHeader* m_header = nullptr;
+    const uint8_t* m_data = nullptr;
+    size_t m_capacity = 0;
+    size_t m_mapBytes = 0;
+    int m_fd = -1;
+    uint64_t m_pos = 0;
+    uint64_t m_nextIndex = 0;
+    uint64_t m_framesRead = 0;
+    uint64_t m_framesLost = 0;
+    uint64_t m_framesTorn = 0;
+};
+
+/** Listening abstract Unix socket for handing out the ring; -1 on failure. */
+int shmListen(int pid, int port);
+/** Accept every pending connection on listenFd and pass memfd to the same-user ones. */
+void shmServePending(int listenFd, int memfd);
+/** Connect to the sender's socket and receive its memfd; -1 on failure. */
+int shmFetch(int pid, int port, int timeoutMs);
+
+} // namespace omt
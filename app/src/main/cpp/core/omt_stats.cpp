@@ -0,0 +1,203 @@
+#include "omt_stats.h"
+
+#include <cstring>
+#include <mutex>
+
+namespace omt {
+
+static LatencyHistogram s_stages[STAGE_COUNT];
+static LatencyHistogram s_clients[STATS_MAX_CLIENTS];
+static std::atomic<uint64_t> s_drops[DROP_CAUSE_COUNT];
+static std::atomic<uint64_t> s_clientDrops[STATS_MAX_CLIENTS][DROP_CAUSE_COUNT];
+static std::atomic<uint64_t> s_counters[COUNTER_COUNT];
+static std::atomic<double> s_gauges[GAUGE_COUNT];
+static std::atomic<uint64_t> s_clientBytes[STATS_MAX_CLIENTS];
+
+// Which side owns each stat, for statsResetSides()
+static constexpr int s_stageSides[STAGE_COUNT] = {
+    STATS_SENDER, STATS_SENDER, STATS_SENDER, STATS_SENDER, STATS_RECEIVER, STATS_RECEIVER,
+};
+static constexpr int s_dropSides[DROP_CAUSE_COUNT] = {
+    STATS_SENDER, STATS_SENDER, STATS_SENDER, STATS_SENDER, STATS_RECEIVER, STATS_SENDER,
+};
+static constexpr int s_counterSides[COUNTER_COUNT] = {
+    STATS_SENDER, STATS_SENDER, STATS_SENDER, STATS_RECEIVER, STATS_RECEIVER, STATS_SENDER, STATS_RECEIVER, STATS_SENDER,
+};
+static constexpr int s_gaugeSides[GAUGE_COUNT] = {
+    STATS_SENDER, STATS_RECEIVER, STATS_SENDER, STATS_SENDER, STATS_RECEIVER, STATS_RECEIVER, STATS_SENDER, STATS_SENDER,
+};
+
+// Labels change only on connect/disconnect, so a plain mutex is fine
+static std::mutex s_labelMutex;
+static char s_clientLabels[STATS_MAX_CLIENTS][48];
+
+const char* stageName(int stage) {
+    switch (stage) {
+        case STAGE_CAPTURE_TO_PACKED: return "capture_to_packed";
+        case STAGE_PACKED_TO_ENCODE: return "packed_to_encode";
+        case STAGE_ENCODE: return "encode";
+        case STAGE_QUEUED_TO_WRITTEN: return "queued_to_written";
+        case STAGE_RECEIVE_TO_DECODED: return "receive_to_decoded";
+        case STAGE_DECODED_TO_PRESENT: return "decoded_to_present";
+        default: return "unknown";
+    }
+}
+
+const char* dropCauseName(int cause) {
+    switch (cause) {
+        case DROP_CAMERA_BACKPRESSURE: return "camera_backpressure";
+        case DROP_PENDING_OVERWRITE: return "pending_overwrite";
+        case DROP_ENCODE_FAILED: return "encode_failed";
+        case DROP_SLOW_CLIENT: return "slow_client";
+        case DROP_RECEIVER_REPLACED: return "receiver_replaced";
+        case DROP_RECORD_OVERFLOW: return "record_overflow";
+        default: return "unknown";
+    }
+}
+
+const char* counterName(int counter) {
+    switch (counter) {
+        case COUNTER_FRAMES_CAPTURED: return "captured";
+        case COUNTER_FRAMES_ENCODED: return "encoded";
+        case COUNTER_FRAMES_SENT: return "sent";
+        case COUNTER_FRAMES_RECEIVED: return "received";
+        case COUNTER_FRAMES_PRESENTED: return "presented";
+        case COUNTER_BYTES_SENT: return "sent";
+        case COUNTER_BYTES_RECEIVED: return "received";
+        case COUNTER_FRAMES_ENCODE_FALLBACK: return "encode_fallback";
+        default: return "unknown";
+    }
+}
+
+const char* gaugeName(int gauge) {
+    switch (gauge) {
+        case GAUGE_FPS_SENT: return "sent";
+        case GAUGE_FPS_PRESENTED: return "presented";
+        case GAUGE_CLIENTS: return "clients";
+        case GAUGE_SENDER_PENDING: return "sender_pending";
+        case GAUGE_VIEWER_PENDING: return "viewer_pending";
+        case GAUGE_VIEWER_POOL: return "viewer_pool";
+        case GAUGE_QUALITY_PSNR: return "psnr";
+        case GAUGE_QUALITY_SSIM: return "ssim";
+        default: return "unknown";
+    }
+}
+
+void statsRecord(int stage, uint64_t nanos) {
+    if (stage < 0 || stage >= STAGE_COUNT) return;
+    s_stages[stage].record(nanos);
+}
+
+void statsRecordClientWrite(int clientSlot, uint64_t nanos) {
+    s_stages[STAGE_QUEUED_TO_WRITTEN].record(nanos);
+    if (clientSlot >= 0 && clientSlot < STATS_MAX_CLIENTS) s_clients[clientSlot].record(nanos);
+}
+
+bool statsSnapshot(int stage, HistogramSnapshot* out) {
+    if (stage < 0 || stage >= STAGE_COUNT || !out) return false;
+    *out = s_stages[stage].snapshot();
+    return true;
+}
+
+bool statsSnapshotClient(int clientSlot, HistogramSnapshot* out) {
+    if (clientSlot < 0 || clientSlot >= STATS_MAX_CLIENTS || !out) return false;
+    *out = s_clients[clientSlot].snapshot();
+    return true;
+}
+
+void statsRecordDrop(int cause, int clientSlot, uint64_t frames) {
+    if (cause < 0 || cause >= DROP_CAUSE_COUNT || frames == 0) return;
+    s_drops[cause].fetch_add(frames, std::memory_order_relaxed);
+    if (clientSlot >= 0 && clientSlot < STATS_MAX_CLIENTS)
+        s_clientDrops[clientSlot][cause].fetch_add(frames, std::memory_order_relaxed);
+}
+
+uint64_t statsDropCount(int cause) {
+    if (cause < 0 || cause >= DROP_CAUSE_COUNT) return 0;
+    return s_drops[cause].load(std::memory_order_relaxed);
+}
+
+uint64_t statsDropCountClient(int clientSlot, int cause) {
+    if (clientSlot < 0 || clientSlot >= STATS_MAX_CLIENTS || cause < 0 || cause >= DROP_CAUSE_COUNT) return 0;
+    return s_clientDrops[clientSlot][cause].load(std::memory_order_relaxed);
+}
+
+void statsAddCounter(int counter, uint64_t delta) {
+    if (counter >= 0 && counter < COUNTER_COUNT) s_counters[counter].fetch_add(delta, std::memory_order_relaxed);
+}
+
+uint64_t statsCounter(int counter) {
+    if (counter < 0 || counter >= COUNTER_COUNT) return 0;
+    return s_counters[counter].load(std::memory_order_relaxed);
+}
+
+void statsSetGauge(int gauge, double value) {
+    if (gauge >= 0 && gauge < GAUGE_COUNT) s_gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+double statsGauge(int gauge) {
+    if (gauge < 0 || gauge >= GAUGE_COUNT) return 0;
+    return s_gauges[gauge].load(std::memory_order_relaxed);
+}
+
+void statsAddClientBytes(int clientSlot, uint64_t bytes) {
+    s_counters[COUNTER_BYTES_SENT].fetch_add(bytes, std::memory_order_relaxed);
+    if (clientSlot >= 0 && clientSlot < STATS_MAX_CLIENTS)
+        s_clientBytes[clientSlot].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+uint64_t statsClientBytes(int clientSlot) {
+    if (clientSlot < 0 || clientSlot >= STATS_MAX_CLIENTS) return 0;
+    return s_clientBytes[clientSlot].load(std::memory_order_relaxed);
+}
+
+void statsSetClientLabel(int clientSlot, const char* label) {
+    if (clientSlot < 0 || clientSlot >= STATS_MAX_CLIENTS) return;
+    std::lock_guard<std::mutex> lock(s_labelMutex);
+    std::strncpy(s_clientLabels[clientSlot], label ? label : "", sizeof(s_clientLabels[0]) - 1);
+}
+
+bool statsClientLabel(int clientSlot, char* out, size_t outLen) {
+    if (clientSlot < 0 || clientSlot >= STATS_MAX_CLIENTS || outLen == 0) return false;
+    std::lock_guard<std::mutex> lock(s_labelMutex);
+    std::strncpy(out, s_clientLabels[clientSlot], outLen - 1);
+    out[outLen - 1] = 0;
+    return out[0] != 0;
+}
+
+void statsResetClient(int clientSlot) {
+    if (clientSlot < 0 || clientSlot >= STATS_MAX_CLIENTS) return;
+    s_clients[clientSlot].reset();
+    for (auto& d : s_clientDrops[clientSlot]) d.store(0, std::memory_order_relaxed);
+    s_clientBytes[clientSlot].store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(s_labelMutex);
+    s_clientLabels[clientSlot][0] = 0;
+}
+
+void statsResetSides(int sides) {
+    for (int i = 0; i < STAGE_COUNT; i++)
+        if (s_stageSides[i] & sides) s_stages[i].reset();
+    for (int i = 0; i < DROP_CAUSE_COUNT; i++)
+        if (s_dropSides[i] & sides) s_drops[i].store(0, std::memory_order_relaxed);
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        if (s_counterSides[i] & sides) s_counters[i].store(0, std::memory_order_relaxed);
+    for (int i = 0; i < GAUGE_COUNT; i++)
+        if (s_gaugeSides[i] & sides) s_gauges[i].store(0, std::memory_order_relaxed);
+    if (sides & STATS_SENDER)
+        for (int slot = 0; slot < STATS_MAX_CLIENTS; slot++) statsResetClient(slot);
+}
+
+void statsReset() {
+    for (auto& h : s_stages) h.reset();
+    for (auto& h : s_clients) h.reset();
+    for (auto& d : s_drops) d.store(0, std::memory_order_relaxed);
+    for (auto& c : s_clientDrops)
+        for (auto& d : c) d.store(0, std::memory_order_relaxed);
+    for (auto& c : s_counters) c.store(0, std::memory_order_relaxed);
+    for (auto& g : s_gauges) g.store(0, std::memory_order_relaxed);
+    for (auto& b : s_clientBytes) b.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(s_labelMutex);
+    for (auto& l : s_clientLabels) l[0] = 0;
+}
+
+} // namespace omt
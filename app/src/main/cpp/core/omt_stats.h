@@ -0,0 +1,107 @@
+/**
+ * Process-wide per-stage latency statistics and frame-drop counters for the frame pipeline.
+ * Kotlin records through OmtStats (stats_jni.cpp); host tools call these directly.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "omt_histogram.h"
+
+namespace omt {
+
+enum Stage : int {
+    // Sender
+    STAGE_CAPTURE_TO_PACKED = 0, // camera callback → NV12 packed
+    STAGE_PACKED_TO_ENCODE = 1,  // packed → encode start (hand-off wait)
+    STAGE_ENCODE = 2,            // encode + save
+    STAGE_QUEUED_TO_WRITTEN = 3, // frame ready → written, all clients
+    // Receiver
+    STAGE_RECEIVE_TO_DECODED = 4, // payload received → decoded
+    STAGE_DECODED_TO_PRESENT = 5, // decoded → drawn
+    STAGE_COUNT = 6,
+};
+
+/** Where a frame was lost. Sender causes first; counters are plain totals since the last reset. */
+enum DropCause : int {
+    DROP_CAMERA_BACKPRESSURE = 0, // sensor frames skipped by ImageAnalysis KEEP_ONLY_LATEST
+    DROP_PENDING_OVERWRITE = 1,   // packed frame replaced before the encoder took it
+    DROP_ENCODE_FAILED = 2,       // encoder returned an error and the frame was not sent
+    DROP_SLOW_CLIENT = 3,         // frame intervals one client's write held the encoder past its budget
+    DROP_RECEIVER_REPLACED = 4,   // decoded frame replaced before the render thread drew it
+    DROP_RECORD_OVERFLOW = 5,     // frame left out of a recording: storage behind and the recorder's buffer full
+    DROP_CAUSE_COUNT = 6,
+};
+
+/** Monotonic event counters (exported as Prometheus counters). */
+enum Counter : int {
+    COUNTER_FRAMES_CAPTURED = 0,  // sender: analyzer frames handed to the sender
+    COUNTER_FRAMES_ENCODED = 1,
+    COUNTER_FRAMES_SENT = 2,      // sender: frames written to at least the client loop
+    COUNTER_FRAMES_RECEIVED = 3,  // receiver: video frames read off the socket
+    COUNTER_FRAMES_PRESENTED = 4,
+    COUNTER_BYTES_SENT = 5,       // all clients; per-client totals via statsAddClientBytes
+    COUNTER_BYTES_RECEIVED = 6,
+    COUNTER_FRAMES_ENCODE_FALLBACK = 7, // sender: encode failed, frame sent as raw NV12 (not a drop)
+    COUNTER_COUNT = 8,
+};
+
+/** Last-value gauges set by the pipeline. */
+enum Gauge : int {
+    GAUGE_FPS_SENT = 0,
+    GAUGE_FPS_PRESENTED = 1,
+    GAUGE_CLIENTS = 2,
+    GAUGE_SENDER_PENDING = 3,   // packed frames waiting for the encoder (0/1)
+    GAUGE_VIEWER_PENDING = 4,   // decoded frames waiting for the render thread (0/1)
+    GAUGE_VIEWER_POOL = 5,      // free bitmaps in the viewer pool
+    GAUGE_QUALITY_PSNR = 6,     // dB, last sampled encode (debug.omt.quality)
+    GAUGE_QUALITY_SSIM = 7,
+    GAUGE_COUNT = 8,
+};
+
+/** Client slots for per-connection write latency; slot indices are owned by the caller. */
+constexpr int STATS_MAX_CLIENTS = 16;
+
+const char* stageName(int stage);
+const char* dropCauseName(int cause);
+const char* counterName(int counter);
+const char* gaugeName(int gauge);
+
+void statsRecord(int stage, uint64_t nanos);
+/** Records queued → written for one client slot and into STAGE_QUEUED_TO_WRITTEN. */
+void statsRecordClientWrite(int clientSlot, uint64_t nanos);
+
+bool statsSnapshot(int stage, HistogramSnapshot* out);
+bool statsSnapshotClient(int clientSlot, HistogramSnapshot* out);
+/** Count dropped frames; a valid clientSlot also charges that client's breakdown. */
+void statsRecordDrop(int cause, int clientSlot = -1, uint64_t frames = 1);
+uint64_t statsDropCount(int cause);
+uint64_t statsDropCountClient(int clientSlot, int cause);
+
+void statsAddCounter(int counter, uint64_t delta = 1);
+uint64_t statsCounter(int counter);
+void statsSetGauge(int gauge, double value);
+double statsGauge(int gauge);
+
+/** Adds to the client's byte total and COUNTER_BYTES_SENT. */
+void statsAddClientBytes(int clientSlot, uint64_t bytes);
+uint64_t statsClientBytes(int clientSlot);
+/** Peer label for exported per-client series (e.g. its address); truncated to 47 bytes. */
+void statsSetClientLabel(int clientSlot, const char* label);
+/** Copies the label into out; returns false for unused slots (no label set). */
+bool statsClientLabel(int clientSlot, char* out, size_t outLen);
+
+/** Clears the slot's write histogram, drop counters, bytes and label. */
+void statsResetClient(int clientSlot);
+void statsReset();
+
+/** Halves of the pipeline, so a sender and a viewer in one process each reset only their own stats. */
+enum StatsSide : int {
+    STATS_SENDER = 1,   // sender stages, drop causes, counters and gauges, plus every client slot
+    STATS_RECEIVER = 2, // receiver stages, drop causes, counters and gauges
+};
+/** statsReset() restricted to sides (a mask of StatsSide). */
+void statsResetSides(int sides);
+
+} // namespace omt
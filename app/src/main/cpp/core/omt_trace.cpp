@@ -0,0 +1,206 @@
+#include "omt_trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+namespace omt {
+
+namespace {
+
+struct ThreadBuffer {
+    TraceEvent events[TRACE_EVENTS_PER_THREAD];
+    std::atomic<uint64_t> head{0};   // total events ever written
+    std::atomic<uint64_t> clearedAt{0}; // events below this index were dropped by traceClear()
+    std::atomic<bool> inUse{false};
+    int tid = 0;
+    char threadName[32] = {};
+};
+
+bool initialEnabled() {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    return __system_property_get("debug.omt.trace", value) > 0 && value[0] == '1';
+#else
+    const char* v = std::getenv("OMT_TRACE");
+    return v && v[0] == '1';
+#endif
+}
+
+std::atomic<bool> s_enabled{initialEnabled()};
+
+std::mutex s_registryMutex;
+ThreadBuffer* s_buffers[TRACE_MAX_THREADS] = {};
+std::atomic<int> s_bufferCount{0};
+
+const char* s_names[TRACE_MAX_NAMES] = {
+    "sendFrame", "encode", "clientWrite", "receive", "decode", "present",
+};
+std::atomic<uint32_t> s_nameCount{TRACE_BUILTIN_COUNT};
+
+uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void readThreadName(int tid, char* out, size_t outLen) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    out[0] = 0;
+    if (FILE* f = std::fopen(path, "r")) {
+        if (std::fgets(out, (int)outLen, f)) out[std::strcspn(out, "\n")] = 0;
+        std::fclose(f);
+    }
+    if (!out[0]) std::snprintf(out, outLen, "thread-%d", tid);
+}
+
+/** Marks the thread's ring reusable when the thread exits; its events stay dumpable until then. */
+struct ThreadSlot {
+    ThreadBuffer* buf = nullptr;
+    bool tried = false;
+    ~ThreadSlot() { if (buf) buf->inUse.store(false, std::memory_order_release); }
+};
+
+thread_local ThreadSlot t_slot;
+
+ThreadBuffer* acquireBuffer() {
+    t_slot.tried = true;
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    ThreadBuffer* b = nullptr;
+    int count = s_bufferCount.load(std::memory_order_relaxed);
+    if (count < TRACE_MAX_THREADS) {
+        b = new ThreadBuffer();
+        s_buffers[count] = b;
+        s_bufferCount.store(count + 1, std::memory_order_release);
+    } else {
+        // Registry full: recycle the ring of a thread that has exited
+        for (int i = 0; i < count && !b; i++)
+            if (!s_buffers[i]->inUse.load(std::memory_order_acquire)) b = s_buffers[i];
+        if (!b) return nullptr;
+        b->clearedAt.store(b->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    b->inUse.store(true, std::memory_order_release);
+    b->tid = (int)syscall(SYS_gettid);
+    readThreadName(b->tid, b->threadName, sizeof(b->threadName));
+    t_slot.buf = b;
+    return b;
+}
+
+inline void emit(char phase, uint32_t nameId, int64_t arg) {
+    if (!s_enabled.load(std::memory_order_relaxed)) return;
+    ThreadBuffer* b = t_slot.buf;
+    if (!b) {
+        if (t_slot.tried) return;
+        b = acquireBuffer();
+        if (!b) return;
+    }
+    uint64_t h = b->head.load(std::memory_order_relaxed);
+    TraceEvent& e = b->events[h % TRACE_EVENTS_PER_THREAD];
+    e.tsNs = nowNs();
+    e.arg = arg;
+    e.nameId = nameId;
+    e.phase = phase;
+    b->head.store(h + 1, std::memory_order_release);
+}
+
+void writeJsonString(FILE* f, const char* s) {
+    std::fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') std::fprintf(f, "\\%c", c);
+        else if (c < 0x20) std::fprintf(f, "\\u%04x", c);
+        else std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+} // namespace
+
+bool traceEnabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void traceSetEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint32_t traceRegisterName(const char* name) {
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    uint32_t count = s_nameCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++)
+        if (std::strcmp(s_names[i], name) == 0) return i;
+    if (count >= TRACE_MAX_NAMES) return count - 1;
+    s_names[count] = strdup(name);
+    s_nameCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void traceBegin(uint32_t nameId, int64_t arg) { emit('B', nameId, arg); }
+void traceEnd(uint32_t nameId) { emit('E', nameId, -1); }
+void traceInstant(uint32_t nameId, int64_t arg) { emit('i', nameId, arg); }
+
+bool traceDumpChromeJson(const char* path) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    const int pid = (int)getpid();
+    const uint32_t nameCount = s_nameCount.load(std::memory_order_acquire);
+    std::vector<TraceEvent> copy(TRACE_EVENTS_PER_THREAD);
+    bool first = true;
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    const int count = s_bufferCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        ThreadBuffer* b = s_buffers[i];
+        uint64_t h1 = b->head.load(std::memory_order_acquire);
+        uint64_t start = h1 > (uint64_t)TRACE_EVENTS_PER_THREAD ? h1 - TRACE_EVENTS_PER_THREAD : 0;
+        for (uint64_t k = start; k < h1; k++)
+            copy[k - start] = b->events[k % TRACE_EVENTS_PER_THREAD];
+        // Events the writer lapped while we copied (and the slot it may be writing) are discarded
+        uint64_t h2 = b->head.load(std::memory_order_acquire);
+        uint64_t firstValid = h2 >= (uint64_t)TRACE_EVENTS_PER_THREAD ? h2 - TRACE_EVENTS_PER_THREAD + 1 : 0;
+        if (firstValid < start) firstValid = start;
+        uint64_t cleared = b->clearedAt.load(std::memory_order_acquire);
+        if (firstValid < cleared) firstValid = cleared;
+
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                     first ? "" : ",", pid, b->tid);
+        writeJsonString(f, b->threadName);
+        std::fputs("}}", f);
+        first = false;
+
+        for (uint64_t k = firstValid; k < h1; k++) {
+            const TraceEvent& e = copy[k - start];
+            const char* name = e.nameId < nameCount ? s_names[e.nameId] : "?";
+            std::fprintf(f, ",\n{\"name\":");
+            writeJsonString(f, name);
+            std::fprintf(f, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+                         e.phase, e.tsNs / 1000.0, pid, b->tid);
+            if (e.phase == 'i') std::fputs(",\"s\":\"t\"", f);
+            if (e.arg >= 0) std::fprintf(f, ",\"args\":{\"v\":%lld}", (long long)e.arg);
+            std::fputc('}', f);
+        }
+    }
+    std::fputs("]}\n", f);
+    bool ok = !std::ferror(f);
+    return std::fclose(f) == 0 && ok;
+}
+
+void traceClear() {
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    const int count = s_bufferCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+        s_buffers[i]->clearedAt.store(s_buffers[i]->head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+} // namespace omt
@@ -0,0 +1,66 @@
+/**
+ * Low-overhead span tracing for the frame pipeline, exportable as Chrome
+ * trace JSON (chrome://tracing, ui.perfetto.dev).
+ *
+ * Each thread writes fixed-size events into its own ring (no locks, no
+ * allocation after the thread's first event); old events are overwritten.
+ * Tracing is off by default: set OMT_TRACE=1 on hosts, or
+ * `adb shell setprop debug.omt.trace 1` on Android, or call traceSetEnabled().
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace omt {
+
+/** Built-in span names; ids past TRACE_BUILTIN_COUNT come from traceRegisterName(). */
+enum TraceName : uint32_t {
+    TRACE_SEND_FRAME = 0,
+    TRACE_ENCODE = 1,
+    TRACE_CLIENT_WRITE = 2,
+    TRACE_RECEIVE = 3,
+    TRACE_DECODE = 4,
+    TRACE_PRESENT = 5,
+    TRACE_BUILTIN_COUNT = 6,
+};
+
+constexpr int TRACE_EVENTS_PER_THREAD = 16384;
+constexpr int TRACE_MAX_THREADS = 32;
+constexpr int TRACE_MAX_NAMES = 64;
+
+struct TraceEvent {
+    uint64_t tsNs;    // CLOCK_MONOTONIC
+    int64_t arg;      // exported as args.v when non-negative
+    uint32_t nameId;
+    char phase;       // 'B', 'E' or 'i'
+    uint8_t pad[3];
+};
+static_assert(sizeof(TraceEvent) == 24, "TraceEvent must stay fixed-size");
+
+bool traceEnabled();
+void traceSetEnabled(bool enabled);
+
+/** Register a span name (not for hot paths). Once the table is full the last id is returned. */
+uint32_t traceRegisterName(const char* name);
+
+void traceBegin(uint32_t nameId, int64_t arg = -1);
+void traceEnd(uint32_t nameId);
+void traceInstant(uint32_t nameId, int64_t arg = -1);
+
+/** Write every thread's retained events as Chrome trace JSON. Returns false on I/O error. */
+bool traceDumpChromeJson(const char* path);
+/** Drop all events recorded so far (rings stay registered to their threads). */
+void traceClear();
+
+/** RAII span for native callers. */
+class TraceSpan {
+public:
+    explicit TraceSpan(uint32_t nameId, int64_t arg = -1) : m_name(nameId) { traceBegin(nameId, arg); }
+    ~TraceSpan() { traceEnd(m_name); }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+private:
+    uint32_t m_name;
+};
+
+} // namespace omt
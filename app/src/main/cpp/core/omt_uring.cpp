@@ -0,0 +1,418 @@
+#define LOG_TAG "OmtUring"
+#include "omt_uring.h"
+#include "omt_log.h"
+
+#if defined(__linux__) && !defined(__ANDROID__) && __has_include(<linux/io_uring.h>)
+#define OMT_HAVE_URING 1
+#endif
+
+#ifdef OMT_HAVE_URING
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace omt {
+
+#ifdef OMT_HAVE_URING
+
+namespace {
+
+constexpr unsigned CQ_FACTOR = 16;        // CQ entries per SQ entry: multishot receives post many
+constexpr unsigned RECV_BUFFERS = 128;    // power of two: the provided ring's size
+constexpr unsigned RECV_BUFFER_BYTES = 128u << 10;
+constexpr uint16_t RECV_GROUP = 0;
+constexpr int DRAIN_MS = 200;             // destructor: wait this long for cancelled ops
+
+int sysSetup(unsigned entries, io_uring_params* p) { return (int)syscall(__NR_io_uring_setup, entries, p); }
+
+int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+int sysRegister(int fd, unsigned opcode, const void* arg, unsigned nrArgs) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs);
+}
+
+template <typename T>
+T loadAcquire(const T* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+
+template <typename T>
+void storeRelease(T* p, T v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+static_assert(Uring::CQE_MORE == IORING_CQE_F_MORE, "CQE_MORE mirrors io_uring");
+
+uint64_t selfThread() { return (uint64_t)pthread_self(); }
+
+uint64_t makeId(uint32_t index, uint32_t generation) { return ((uint64_t)generation << 32) | (index + 1); }
+
+} // namespace
+
+bool uringSupported() {
+    static const bool supported = [] {
+        io_uring_params p{};
+        const int fd = sysSetup(2, &p);
+        if (fd < 0) return false;
+        close(fd);
+        // Multishot receive and EXT_ARG waits need 6.0-era kernels.
+        return (p.features & IORING_FEAT_EXT_ARG) && (p.features & IORING_FEAT_NODROP);
+    }();
+    return supported;
+}
+
+Uring::~Uring() {
+    if (m_fd < 0) return;
+    // Handlers may point at objects already gone: drop them, then give the
+    // kernel a moment to finish with buffers it could still write into.
+    for (auto& op : m_ops) op->fn = nullptr;
+    cancelAll();
+    teardown();
+}
+
+void Uring::cancelAll() {
+    if (!m_enabled || m_owner != selfThread() || m_live == 0) return;
+    if (io_uring_sqe* sqe = nextSqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = 0;
+    }
+    for (int waited = 0; m_live > 0 && waited < DRAIN_MS; waited += 10) run(10);
+}
+
+void Uring::teardown() {
+    const bool drained = m_live == 0;
+    if (m_fd >= 0) close(m_fd);
+    m_fd = -1;
+    if (m_sqes) munmap(m_sqes, m_sqesBytes);
+    if (m_cqMap && m_cqMap != m_sqMap) munmap(m_cqMap, m_cqMapBytes);
+    if (m_sqMap) munmap(m_sqMap, m_sqMapBytes);
+    // A receive the kernel has not let go of could still land in these; keep them mapped then.
+    if (m_bufMemory && drained) munmap(m_bufMemory, m_bufMemoryBytes);
+    m_sqes = nullptr;
+    m_sqMap = m_cqMap = nullptr;
+    m_bufMemory = nullptr;
+}
+
+bool Uring::init(unsigned entries) {
+    if (m_fd >= 0) return true;
+    if (!uringSupported()) return false;
+    io_uring_params p{};
+    // Best first: loop thread as single issuer with deferred task work; then
+    // cooperative task work; then whatever the kernel takes.
+    const unsigned base = IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED;
+    const unsigned variants[] = {base | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN,
+                                 base | IORING_SETUP_COOP_TASKRUN, base};
+    int fd = -1;
+    for (unsigned flags : variants) {
+        std::memset(&p, 0, sizeof(p));
+        p.flags = flags;
+        p.cq_entries = entries * CQ_FACTOR;
+        fd = sysSetup(entries, &p);
+        if (fd >= 0) {
+            m_deferTaskRun = flags & IORING_SETUP_DEFER_TASKRUN;
+            break;
+        }
+    }
+    if (fd < 0) {
+        LOGW("io_uring_setup failed: %s", std::strerror(errno));
+        return false;
+    }
+    m_fd = fd;
+    m_sqMapBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cqMapBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) m_sqMapBytes = m_cqMapBytes = std::max(m_sqMapBytes, m_cqMapBytes);
+    m_sqMap = mmap(nullptr, m_sqMapBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (m_sqMap == MAP_FAILED) m_sqMap = nullptr;
+    if (m_sqMap && (p.features & IORING_FEAT_SINGLE_MMAP)) {
+        m_cqMap = m_sqMap;
+    } else if (m_sqMap) {
+        m_cqMap = mmap(nullptr, m_cqMapBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (m_cqMap == MAP_FAILED) m_cqMap = nullptr;
+    }
+    m_sqesBytes = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes != MAP_FAILED) m_sqes = (io_uring_sqe*)sqes;
+    if (!m_sqMap || !m_cqMap || !m_sqes) {
+        LOGW("io_uring mmap failed: %s", std::strerror(errno));
+        teardown();
+        return false;
+    }
+    auto* sq = (uint8_t*)m_sqMap;
+    auto* cq = (uint8_t*)m_cqMap;
+    m_sqHead = (unsigned*)(sq + p.sq_off.head);
+    m_sqTail = (unsigned*)(sq + p.sq_off.tail);
+    m_sqArray = (unsigned*)(sq + p.sq_off.array);
+    m_sqMask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    m_sqEntries = p.sq_entries;
+    m_sqLocalTail = *m_sqTail;
+    for (unsigned i = 0; i < m_sqEntries; i++) m_sqArray[i] = i; // SQE i always sits in slot i
+    m_cqHead = (unsigned*)(cq + p.cq_off.head);
+    m_cqTail = (unsigned*)(cq + p.cq_off.tail);
+    m_cqMask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    m_cqes = cq + p.cq_off.cqes;
+    m_ops.reserve(entries);
+    m_freeOps.reserve(entries);
+    return true;
+}
+
+bool Uring::enable() {
+    if (m_enabled) return true;
+    // The thread that enables the ring becomes its single issuer.
+    if (sysRegister(m_fd, IORING_REGISTER_ENABLE_RINGS, nullptr, 0) != 0) {
+        LOGE("io_uring enable failed: %s", std::strerror(errno));
+        return false;
+    }
+    m_enabled = true;
+    m_owner = selfThread();
+    return true;
+}
+
+unsigned Uring::flushSq() {
+    const unsigned pending = m_sqLocalTail - *m_sqTail;
+    if (pending) storeRelease(m_sqTail, m_sqLocalTail);
+    return pending;
+}
+
+int Uring::enter(unsigned toSubmit, unsigned minComplete, int timeoutMs) {
+    io_uring_getevents_arg arg{};
+    __kernel_timespec ts{};
+    if (timeoutMs >= 0 && minComplete > 0) {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (long long)(timeoutMs % 1000) * 1000000;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+    }
+    m_enterCalls.store(m_enterCalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); // loop thread only
+    return sysEnter(m_fd, toSubmit, minComplete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+bool Uring::reserve(unsigned n) {
+    if (m_fd < 0 || n > m_sqEntries) return false;
+    if (m_sqEntries - (m_sqLocalTail - loadAcquire(m_sqHead)) >= n) return true;
+    // Full: hand what is queued to the kernel, if this is the thread allowed to.
+    if (!m_enabled || m_owner != selfThread()) return false;
+    const unsigned pending = flushSq();
+    if (enter(pending, 0, 0) < 0 && errno != EINTR && errno != EBUSY) return false;
+    return m_sqEntries - (m_sqLocalTail - loadAcquire(m_sqHead)) >= n;
+}
+
+io_uring_sqe* Uring::nextSqe() {
+    if (!reserve(1)) return nullptr;
+    io_uring_sqe* sqe = &m_sqes[m_sqLocalTail & m_sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    m_sqLocalTail++;
+    return sqe;
+}
+
+io_uring_sqe* Uring::prepare(Completion fn, uint64_t* id) {
+    if (m_fd < 0) return nullptr;
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return nullptr;
+    uint32_t index;
+    if (!m_freeOps.empty()) {
+        index = m_freeOps.back();
+        m_freeOps.pop_back();
+    } else {
+        index = (uint32_t)m_ops.size();
+        m_ops.push_back(std::make_unique<Op>());
+    }
+    Op& op = *m_ops[index];
+    op.fn = std::move(fn);
+    op.generation++;
+    op.live = true;
+    op.running = false;
+    op.detached = false;
+    m_live++;
+    sqe->user_data = makeId(index, op.generation);
+    if (id) *id = sqe->user_data;
+    return sqe;
+}
+
+Uring::Op* Uring::lookup(uint64_t id) {
+    const uint32_t index = (uint32_t)id - 1;
+    if (id == 0 || index >= m_ops.size()) return nullptr;
+    Op* op = m_ops[index].get();
+    return op->live && op->generation == (uint32_t)(id >> 32) ? op : nullptr;
+}
+
+void Uring::release(uint32_t index) {
+    Op& op = *m_ops[index];
+    op.live = false;
+    op.fn = nullptr;
+    m_freeOps.push_back(index);
+    m_live--;
+}
+
+uint64_t Uring::pollAdd(int fd, uint32_t events, Completion fn) {
+    uint64_t id;
+    io_uring_sqe* sqe = prepare(std::move(fn), &id);
+    if (!sqe) return 0;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events; // LOOP_* are the poll bits
+    return id;
+}
+
+uint64_t Uring::recvMultishot(int fd, Completion fn) {
+    if (!m_bufMemory && !setupRecvBuffers()) return 0;
+    if (m_bufFailed) return 0;
+    uint64_t id;
+    io_uring_sqe* sqe = prepare(std::move(fn), &id);
+    if (!sqe) return 0;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = RECV_GROUP;
+    return id;
+}
+
+uint64_t Uring::send(int fd, const void* data, size_t length, bool link, Completion fn) {
+    uint64_t id;
+    io_uring_sqe* sqe = prepare(std::move(fn), &id);
+    if (!sqe) return 0;
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = (uint32_t)length;
+    // WAITALL: the kernel retries partial sends itself, so a link only breaks on a real error.
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    if (link) sqe->flags = IOSQE_IO_LINK;
+    return id;
+}
+
+void Uring::cancel(uint64_t id) {
+    if (!lookup(id)) return;
+    if (io_uring_sqe* sqe = nextSqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = id;
+        sqe->user_data = 0; // its own completion is not interesting
+    }
+}
+
+void Uring::detach(uint64_t id) {
+    Op* op = lookup(id);
+    if (!op) return;
+    op->detached = true;
+    if (!op->running) op->fn = nullptr;
+    cancel(id);
+}
+
+bool Uring::setupRecvBuffers() {
+    if (m_bufFailed || m_fd < 0) return false;
+    m_bufMemoryBytes = (size_t)RECV_BUFFERS * RECV_BUFFER_BYTES;
+    void* memory = mmap(nullptr, m_bufMemoryBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        LOGW("Cannot map receive buffers: %s", std::strerror(errno));
+        m_bufFailed = true;
+        return false;
+    }
+    m_bufMemory = (uint8_t*)memory;
+    m_bufCount = RECV_BUFFERS;
+    m_bufSize = RECV_BUFFER_BYTES;
+    // Handed over in one go; a receive queued behind this finds them there.
+    io_uring_sqe* sqe = prepare([this](int res, uint32_t) {
+        if (res >= 0) return;
+        LOGW("Cannot provide receive buffers: %s", std::strerror(-res));
+        m_bufFailed = true;
+    }, nullptr);
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = (int)m_bufCount;
+    sqe->addr = (uint64_t)(uintptr_t)m_bufMemory;
+    sqe->len = m_bufSize;
+    sqe->off = 0;
+    sqe->buf_group = RECV_GROUP;
+    return true;
+}
+
+const uint8_t* Uring::recvBuffer(uint32_t flags) const {
+    if (!(flags & IORING_CQE_F_BUFFER) || !m_bufMemory) return nullptr;
+    const unsigned bid = flags >> IORING_CQE_BUFFER_SHIFT;
+    return bid < m_bufCount ? m_bufMemory + (size_t)bid * m_bufSize : nullptr;
+}
+
+void Uring::recycleRecvBuffer(uint32_t flags) {
+    if (!(flags & IORING_CQE_F_BUFFER) || !m_bufMemory) return;
+    const unsigned bid = flags >> IORING_CQE_BUFFER_SHIFT;
+    if (bid >= m_bufCount) return;
+    // Goes in with the next submission, ahead of anything queued after it.
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = (uint64_t)(uintptr_t)(m_bufMemory + (size_t)bid * m_bufSize);
+    sqe->len = m_bufSize;
+    sqe->off = bid;
+    sqe->buf_group = RECV_GROUP;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = 0;
+}
+
+void Uring::dispatch() {
+    unsigned head = *m_cqHead;
+    for (;;) {
+        const unsigned tail = loadAcquire(m_cqTail);
+        if (head == tail) break;
+        const io_uring_cqe cqe = ((const io_uring_cqe*)m_cqes)[head & m_cqMask];
+        storeRelease(m_cqHead, ++head); // the slot is copied out: the kernel may reuse it
+        if (cqe.user_data == 0) continue;
+        const uint32_t index = (uint32_t)cqe.user_data - 1;
+        Op* op = lookup(cqe.user_data);
+        if (!op) continue;
+        if (op->fn) {
+            op->running = true;
+            op->fn(cqe.res, cqe.flags);
+            op->running = false;
+            if (op->detached) op->fn = nullptr;
+        } else {
+            recycleRecvBuffer(cqe.flags); // a detached receive's data has nowhere to go
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) release(index);
+        head = *m_cqHead;
+    }
+}
+
+int Uring::run(int timeoutMs) {
+    if (m_fd < 0 || (!m_enabled && !enable())) return -1;
+    const unsigned toSubmit = flushSq();
+    const bool ready = loadAcquire(m_cqTail) != *m_cqHead;
+    // Even with nothing to wait for, entering runs deferred task work into the CQ.
+    if (toSubmit || !ready || m_deferTaskRun) {
+        const int r = enter(toSubmit, ready || timeoutMs == 0 ? 0 : 1, timeoutMs);
+        if (r < 0 && errno != EINTR && errno != ETIME && errno != EBUSY && errno != EAGAIN) {
+            LOGE("io_uring_enter failed: %s", std::strerror(errno));
+            return -1;
+        }
+    }
+    const unsigned before = *m_cqHead;
+    dispatch();
+    return (int)(*m_cqHead - before);
+}
+
+#else // !OMT_HAVE_URING
+
+bool uringSupported() { return false; }
+
+Uring::~Uring() { }
+bool Uring::init(unsigned) { return false; }
+int Uring::run(int) { return -1; }
+uint64_t Uring::pollAdd(int, uint32_t, Completion) { return 0; }
+uint64_t Uring::recvMultishot(int, Completion) { return 0; }
+uint64_t Uring::send(int, const void*, size_t, bool, Completion) { return 0; }
+bool Uring::reserve(unsigned) { return false; }
+void Uring::cancel(uint64_t) { }
+void Uring::cancelAll() { }
+void Uring::detach(uint64_t) { }
+const uint8_t* Uring::recvBuffer(uint32_t) const { return nullptr; }
+void Uring::recycleRecvBuffer(uint32_t) { }
+
+#endif
+
+} // namespace omt
@@ -0,0 +1,145 @@
+/**
+ * Thin io_uring wrapper (raw syscalls, no liburing) behind EventLoop's
+ * io_uring backend on Linux hosts.
+ *
+ * Every submission is an op with a completion handler that runs on the loop
+ * thread for each of its CQEs, until one arrives without IORING_CQE_F_MORE.
+ * Ops are pooled and handlers are std::functions small enough to be stored
+ * inline, so steady-state submission does not allocate.
+ *
+ * The ring is created disabled and enabled by the first run(), so it can be
+ * set up on one thread and driven by another; where the kernel allows it the
+ * loop thread becomes its single issuer and completion work is deferred to
+ * run() (IORING_SETUP_DEFER_TASKRUN), so completions cost no extra wakeups.
+ * Only run() enters the kernel: everything prepared in between goes in that
+ * one call.
+ *
+ * Multishot receives draw from one group of provided buffers, mapped once
+ * and shared by every connection on the loop; a handler must recycle each
+ * buffer it is given, which hands it back to the kernel with the next
+ * submission. (The ring-mapped IORING_REGISTER_PBUF_RING variant registers,
+ * but its receives fail with ENOBUFS on some 6.x kernels, so the classic
+ * IORING_OP_PROVIDE_BUFFERS group is used.)
+ *
+ * Android apps may not use io_uring (their seccomp policy kills the process),
+ * so there uringSupported() is false and nothing here touches the kernel.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct io_uring_sqe;
+
+namespace omt {
+
+/** io_uring can be used in this process (probed once). */
+bool uringSupported();
+
+class Uring {
+public:
+    /** res: bytes, poll mask or -errno; flags: IORING_CQE_F_*. */
+    using Completion = std::function<void(int res, uint32_t flags)>;
+    /** IORING_CQE_F_MORE: the op has more completions coming. */
+    static constexpr uint32_t CQE_MORE = 1u << 1;
+
+    Uring() = default;
+    ~Uring();
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    bool init(unsigned entries);
+    bool valid() const { return m_fd >= 0; }
+    /** Set up with IORING_SETUP_DEFER_TASKRUN (single issuer). */
+    bool deferredTaskRun() const { return m_deferTaskRun; }
+
+    /** Submit what is prepared, wait up to timeoutMs (< 0: forever) for a completion and dispatch all there are; -1 on failure. */
+    int run(int timeoutMs);
+    /** Ops still waiting for their last completion. */
+    size_t inFlight() const { return m_live; }
+    /** io_uring_enter calls so far (for the benchmarks; readable from any thread). */
+    uint64_t enterCalls() const { return m_enterCalls.load(std::memory_order_relaxed); }
+
+    /** Make room for n submissions, so a linked chain cannot be split across two. */
+    bool reserve(unsigned n);
+
+    // Each returns the op's id, or 0 if it could not be queued.
+    /** One-shot poll for LOOP_* events; the result is the ready mask. */
+    uint64_t pollAdd(int fd, uint32_t events, Completion fn);
+    /** Multishot receive into the provided buffers (set up on first use). */
+    uint64_t recvMultishot(int fd, Completion fn);
+    /** send(MSG_WAITALL): completes once all of it is sent or on error. link: the next op waits for this one. */
+    uint64_t send(int fd, const void* data, size_t length, bool link, Completion fn);
+
+    /** Cancel an op; its handler still sees the remaining completions (ending with -ECANCELED). */
+    void cancel(uint64_t id);
+    /** Cancel an op and drop its handler; safe from inside that handler. */
+    void detach(uint64_t id);
+    /** Cancel everything and dispatch the completions (briefly waiting for them); loop thread only. */
+    void cancelAll();
+
+    /** The provided buffer a receive completion carries (IORING_CQE_F_BUFFER), and handing it back. */
+    const uint8_t* recvBuffer(uint32_t flags) const;
+    void recycleRecvBuffer(uint32_t flags);
+
+private:
+    struct Op {
+        Completion fn;
+        uint32_t generation = 0;
+        bool live = false;
+        bool running = false;
+        bool detached = false;
+    };
+
+    io_uring_sqe* nextSqe();
+    io_uring_sqe* prepare(Completion fn, uint64_t* id);
+    Op* lookup(uint64_t id);
+    void release(uint32_t index);
+    bool enable();
+    void teardown();
+    int enter(unsigned toSubmit, unsigned minComplete, int timeoutMs);
+    unsigned flushSq();
+    bool setupRecvBuffers();
+    void dispatch();
+
+    int m_fd = -1;
+    bool m_enabled = false;
+    bool m_deferTaskRun = false;
+    uint64_t m_owner = 0; // pthread of the single issuer, once enabled
+    std::atomic<uint64_t> m_enterCalls{0};
+
+    // Mappings
+    void* m_sqMap = nullptr;
+    size_t m_sqMapBytes = 0;
+    void* m_cqMap = nullptr;
+    size_t m_cqMapBytes = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesBytes = 0;
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned m_sqLocalTail = 0; // prepared, not yet published to the kernel
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    void* m_cqes = nullptr;
+
+    std::vector<std::unique_ptr<Op>> m_ops;
+    std::vector<uint32_t> m_freeOps;
+    size_t m_live = 0;
+
+    // Provided receive buffers (group 0)
+    uint8_t* m_bufMemory = nullptr;
+    size_t m_bufMemoryBytes = 0;
+    unsigned m_bufCount = 0;
+    unsigned m_bufSize = 0;
+    bool m_bufFailed = false;
+};
+
+} // namespace omt
@@ -0,0 +1,114 @@
+#define LOG_TAG "VmxJni"
+#include "omt_vmx.h"
+
+#include <dlfcn.h>
+#include <cstdlib>
+
+#include "omt_log.h"
+#include "omt_pixel.h"
+
+namespace omt {
+
+typedef struct { int width; int height; } VMX_SIZE;
+typedef unsigned char BYTE;
+enum { VMX_COLORSPACE_BT709 = 709 };
+enum VMX_ERR { VMX_ERR_OK = 0 };
+
+// Encode functions
+typedef void* (*VMX_Create_t)(VMX_SIZE, int profile, int colorSpace);
+typedef void (*VMX_Destroy_t)(void*);
+typedef int (*VMX_EncodeNV12_t)(void*, BYTE* srcY, int srcStrideY, BYTE* srcUV, int srcStrideUV, int interlaced);
+typedef int (*VMX_SaveTo_t)(void*, BYTE* dst, int maxLen);
+typedef int (*VMX_GetThreads_t)(void*);
+typedef void (*VMX_SetThreads_t)(void*, int numThreads);
+
+// Decode functions
+typedef int (*VMX_LoadFrom_t)(void*, BYTE* data, int dataLen);
+typedef int (*VMX_DecodeBGRA_t)(void*, BYTE* dst, int stride);
+
+static void* s_libvmx = nullptr;
+static VMX_Create_t fp_VMX_Create = nullptr;
+static VMX_Destroy_t fp_VMX_Destroy = nullptr;
+static VMX_EncodeNV12_t fp_VMX_EncodeNV12 = nullptr;
+static VMX_SaveTo_t fp_VMX_SaveTo = nullptr;
+static VMX_GetThreads_t fp_VMX_GetThreads = nullptr;
+static VMX_SetThreads_t fp_VMX_SetThreads = nullptr;
+static VMX_LoadFrom_t fp_VMX_LoadFrom = nullptr;
+static VMX_DecodeBGRA_t fp_VMX_DecodeBGRA = nullptr;
+
+bool vmxLoad() {
+    if (s_libvmx) return true;
+    const char* path = "libvmx.so";
+#ifndef __ANDROID__
+    if (const char* env = std::getenv("OMT_LIBVMX")) path = env;
+#endif
+    s_libvmx = dlopen(path, RTLD_NOW);
+    if (!s_libvmx) {
+        LOGE("dlopen %s failed: %s", path, dlerror());
+        return false;
+    }
+    fp_VMX_Create = (VMX_Create_t)dlsym(s_libvmx, "VMX_Create");
+    fp_VMX_Destroy = (VMX_Destroy_t)dlsym(s_libvmx, "VMX_Destroy");
+    fp_VMX_EncodeNV12 = (VMX_EncodeNV12_t)dlsym(s_libvmx, "VMX_EncodeNV12");
+    fp_VMX_SaveTo = (VMX_SaveTo_t)dlsym(s_libvmx, "VMX_SaveTo");
+    fp_VMX_GetThreads = (VMX_GetThreads_t)dlsym(s_libvmx, "VMX_GetThreads");
+    fp_VMX_SetThreads = (VMX_SetThreads_t)dlsym(s_libvmx, "VMX_SetThreads");
+    fp_VMX_LoadFrom = (VMX_LoadFrom_t)dlsym(s_libvmx, "VMX_LoadFrom");
+    fp_VMX_DecodeBGRA = (VMX_DecodeBGRA_t)dlsym(s_libvmx, "VMX_DecodeBGRA");
+    if (!fp_VMX_Create || !fp_VMX_Destroy || !fp_VMX_EncodeNV12 || !fp_VMX_SaveTo) {
+        LOGE("dlsym VMX encode functions failed");
+        dlclose(s_libvmx);
+        s_libvmx = nullptr;
+        return false;
+    }
+    LOGI("libvmx loaded (threads: %s, decode: %s)",
+         fp_VMX_SetThreads ? "yes" : "no",
+         fp_VMX_LoadFrom ? "yes" : "no");
+    return true;
+}
+
+bool vmxCanDecode() {
+    return vmxLoad() && fp_VMX_LoadFrom && fp_VMX_DecodeBGRA;
+}
+
+void* vmxCreate(int width, int height, int numThreads, const char* role, int profile) {
+    if (!vmxLoad()) return nullptr;
+    VMX_SIZE size = { width, height };
+    void* inst = fp_VMX_Create(size, profile, VMX_COLORSPACE_BT709);
+    if (inst && fp_VMX_SetThreads && numThreads > 0) {
+        int before = fp_VMX_GetThreads ? fp_VMX_GetThreads(inst) : -1;
+        fp_VMX_SetThreads(inst, numThreads);
+        int after = fp_VMX_GetThreads ? fp_VMX_GetThreads(inst) : -1;
+        LOGI("VMX %s %dx%d threads: %d -> %d (requested %d)", role, width, height, before, after, numThreads);
+    }
+    return inst;
+}
+
+void vmxDestroy(void* inst) {
+    if (inst && fp_VMX_Destroy) fp_VMX_Destroy(inst);
+}
+
+int vmxEncode(void* inst, const uint8_t* y, int strideY, const uint8_t* uv, int strideUV,
+              uint8_t* out, int maxOutLen) {
+    if (!inst || !fp_VMX_EncodeNV12 || !fp_VMX_SaveTo || !out || maxOutLen <= 0) return -1;
+    int err = fp_VMX_EncodeNV12(inst, const_cast<BYTE*>(y), strideY, const_cast<BYTE*>(uv), strideUV, 0);
+    if (err != VMX_ERR_OK) return -1;
+    int written = fp_VMX_SaveTo(inst, out, maxOutLen);
+    if (written <= 0 || written > maxOutLen) return -1;
+    return written;
+}
+
+bool vmxDecodeBgra(void* inst, const uint8_t* data, int dataLen, uint8_t* dstBgra, int width, int height) {
+    (void)height;
+    if (!inst || !fp_VMX_LoadFrom || !fp_VMX_DecodeBGRA || !data || !dstBgra) return false;
+    if (fp_VMX_LoadFrom(inst, const_cast<BYTE*>(data), dataLen) != VMX_ERR_OK) return false;
+    return fp_VMX_DecodeBGRA(inst, dstBgra, width * 4) == VMX_ERR_OK;
+}
+
+bool vmxDecodeRgba(void* inst, const uint8_t* data, int dataLen, uint8_t* dstRgba, int width, int height) {
+    if (!vmxDecodeBgra(inst, data, dataLen, dstRgba, width, height)) return false;
+    swapBgraToRgba(dstRgba, (size_t)width * height);
+    return true;
+}
+
+} // namespace omt
@@ -0,0 +1,42 @@
+/**
+ * Loader and thin wrapper around libvmx (VMX codec). Uses dlopen/dlsym so
+ * libvmx.so is optional. Shared by the JNI library and the host tools, which
+ * load the stand-in from vmx_stub/ when the proprietary library is absent.
+ *
+ * On hosts the OMT_LIBVMX environment variable overrides the library path.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace omt {
+
+/** Load libvmx and resolve its symbols. Safe to call repeatedly. */
+bool vmxLoad();
+/** True when the loaded libvmx also exports the decode entry points. */
+bool vmxCanDecode();
+
+/** libvmx encode profiles used by OMT (LQ/SQ/HQ trade size for quality). */
+enum VmxProfile { VMX_PROFILE_OMT_LQ = 133, VMX_PROFILE_OMT_SQ = 166, VMX_PROFILE_OMT_HQ = 199 };
+
+/** Create a codec instance (BT.709; the live stream uses SQ). numThreads <= 0 keeps the library default. */
+void* vmxCreate(int width, int height, int numThreads, const char* role = "encoder",
+                int profile = VMX_PROFILE_OMT_SQ);
+void vmxDestroy(void* inst);
+
+/**
+ * Encode one NV12 frame and save the bitstream into out.
+ * Returns the number of bytes written, or -1 on error.
+ */
+int vmxEncode(void* inst, const uint8_t* y, int strideY, const uint8_t* uv, int strideUV,
+              uint8_t* out, int maxOutLen);
+
+/** Load a VMX frame and decode it to libvmx's native BGRA (stride width*4). */
+bool vmxDecodeBgra(void* inst, const uint8_t* data, int dataLen, uint8_t* dstBgra, int width, int height);
+/**
+ * Load a VMX frame and decode it to RGBA (libvmx outputs BGRA; the channels are
+ * swapped so Android's ARGB_8888 renders correctly). dstRgba must hold width*height*4 bytes.
+ */
+bool vmxDecodeRgba(void* inst, const uint8_t* data, int dataLen, uint8_t* dstRgba, int width, int height);
+
+} // namespace omt
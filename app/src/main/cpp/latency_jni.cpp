@@ -0,0 +1,143 @@
+/**
+ * JNI bindings for glass-to-glass latency measurement (core/omt_latency).
+ * One clock estimate and one latency histogram per process: the viewer
+ * measures a single source at a time.
+ */
+#include <jni.h>
+#include <climits>
+#include <cstdint>
+
+#include "omt_histogram.h"
+#include "omt_latency.h"
+
+static omt::ClockSync s_clock;
+static omt::LatencyHistogram s_latency;
+
+static jstring toJString(JNIEnv* env, const char* xml, int len) {
+    return len > 0 ? env->NewStringUTF(xml) : nullptr;
+}
+
+/** Parses with the UTF-8 bytes of a Java string; false if the string could not be read. */
+template <typename Fn>
+static bool withUtf(JNIEnv* env, jstring jXml, Fn fn) {
+    if (!jXml) return false;
+    const char* xml = env->GetStringUTFChars(jXml, nullptr);
+    if (!xml) return false;
+    jsize len = env->GetStringUTFLength(jXml);
+    bool ok = fn(xml, (size_t)len);
+    env->ReleaseStringUTFChars(jXml, xml);
+    return ok;
+}
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtLatency_nativeModeEnabled(JNIEnv* env, jclass) {
+    return omt::latencyModeEnabled() ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtLatency_nativeStampNv12(JNIEnv* env, jclass, jbyteArray yArr, jbyteArray uvArr,
+                                              jint width, jint height, jlong value) {
+    if (!yArr || !uvArr) return;
+    if (env->GetArrayLength(yArr) < width * height || env->GetArrayLength(uvArr) < width * height / 2) return;
+    auto* y = (uint8_t*)env->GetPrimitiveArrayCritical(yArr, nullptr);
+    auto* uv = (uint8_t*)env->GetPrimitiveArrayCritical(uvArr, nullptr);
+    if (y && uv) omt::timecodeStampNv12(y, width, uv, width, width, height, (uint64_t)value);
+    if (uv) env->ReleasePrimitiveArrayCritical(uvArr, uv, 0);
+    if (y) env->ReleasePrimitiveArrayCritical(yArr, y, 0);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtLatency_nativeReadRgba(JNIEnv* env, jclass, jbyteArray rgbaArr, jint width, jint height) {
+    if (!rgbaArr || env->GetArrayLength(rgbaArr) < width * height * 4) return -1;
+    auto* rgba = (const uint8_t*)env->GetPrimitiveArrayCritical(rgbaArr, nullptr);
+    if (!rgba) return -1;
+    uint64_t value = 0;
+    bool ok = omt::timecodeReadRgba(rgba, width * 4, width, height, &value);
+    env->ReleasePrimitiveArrayCritical(rgbaArr, (void*)rgba, JNI_ABORT);
+    return ok ? (jlong)value : -1;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_omt_camera_OmtLatency_nativeClockRequestXml(JNIEnv* env, jclass, jlong t1) {
+    char xml[128];
+    return toJString(env, xml, omt::formatClockRequest(xml, sizeof(xml), t1));
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_omt_camera_OmtLatency_nativeClockReplyXml(JNIEnv* env, jclass, jlong t1, jlong t2, jlong t3) {
+    char xml[160];
+    return toJString(env, xml, omt::formatClockReply(xml, sizeof(xml), t1, t2, t3));
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_omt_camera_OmtLatency_nativeStampXml(JNIEnv* env, jclass, jlong stampUs, jlong frame) {
+    char xml[128];
+    return toJString(env, xml, omt::formatLatencyStamp(xml, sizeof(xml), stampUs, frame));
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtLatency_nativeParseClockRequest(JNIEnv* env, jclass, jstring jXml) {
+    int64_t t1 = 0;
+    bool ok = withUtf(env, jXml, [&](const char* xml, size_t len) {
+        return omt::parseClockRequest(xml, len, &t1);
+    });
+    return ok ? (jlong)t1 : LLONG_MIN;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtLatency_nativeOnClockReply(JNIEnv* env, jclass, jstring jXml, jlong t4) {
+    int64_t t1 = 0, t2 = 0, t3 = 0;
+    bool ok = withUtf(env, jXml, [&](const char* xml, size_t len) {
+        return omt::parseClockReply(xml, len, &t1, &t2, &t3);
+    });
+    if (ok) s_clock.addSample(t1, t2, t3, t4);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtLatency_nativeParseStamp(JNIEnv* env, jclass, jstring jXml) {
+    int64_t stamp = 0, frame = 0;
+    bool ok = withUtf(env, jXml, [&](const char* xml, size_t len) {
+        return omt::parseLatencyStamp(xml, len, &stamp, &frame);
+    });
+    return ok ? (jlong)stamp : -1;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtLatency_nativeClockValid(JNIEnv* env, jclass) {
+    return s_clock.valid() ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtLatency_nativeClockOffsetUs(JNIEnv* env, jclass) {
+    return s_clock.offsetUs();
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtLatency_nativeClockRttUs(JNIEnv* env, jclass) {
+    return s_clock.rttUs();
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtLatency_nativeRecord(JNIEnv* env, jclass, jlong latencyUs) {
+    if (latencyUs >= 0) s_latency.record((uint64_t)latencyUs * 1000);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_omt_camera_OmtLatency_nativeSnapshot(JNIEnv* env, jclass) {
+    omt::HistogramSnapshot s = s_latency.snapshot();
+    jlong values[6] = { (jlong)s.count, (jlong)s.p50, (jlong)s.p99, (jlong)s.p999, (jlong)s.max, (jlong)s.mean };
+    jlongArray arr = env->NewLongArray(6);
+    if (arr) env->SetLongArrayRegion(arr, 0, 6, values);
+    return arr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtLatency_nativeReset(JNIEnv* env, jclass) {
+    s_clock.reset();
+    s_latency.reset();
+}
+
+} // extern "C"
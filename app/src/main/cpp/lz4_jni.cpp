@@ -0,0 +1,66 @@
+/**
+ * JNI bindings for NVLZ (core/omt_lz4): the sender compresses NV12 frames
+ * for receivers that accept them when there is no VMX encoder, and the
+ * viewer expands them back to NV12 planes.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_lz4.h"
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtLz4_nativeCreate(JNIEnv* env, jclass) {
+    return (jlong)(uintptr_t)new omt::Lz4Compressor();
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtLz4_nativeDestroy(JNIEnv* env, jclass, jlong handle) {
+    delete (omt::Lz4Compressor*)(uintptr_t)handle;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_omt_camera_OmtLz4_nativeBound(JNIEnv* env, jclass, jint width, jint height) {
+    const size_t bound = omt::nvlzBound(width, height);
+    return bound > 0x7FFFFFFF ? -1 : (jint)bound;
+}
+
+/** Compress tightly packed NV12 planes into out; returns the payload size or -1. */
+JNIEXPORT jint JNICALL
+Java_com_omt_camera_OmtLz4_nativePack(JNIEnv* env, jclass, jlong handle, jbyteArray yArr, jbyteArray uvArr,
+                                      jint width, jint height, jbyteArray outArr) {
+    auto* lz = (omt::Lz4Compressor*)(uintptr_t)handle;
+    if (!lz || !yArr || !uvArr || !outArr || width <= 0 || height <= 0) return -1;
+    if (env->GetArrayLength(yArr) < width * height || env->GetArrayLength(uvArr) < width * (height / 2)) return -1;
+    const jsize capacity = env->GetArrayLength(outArr);
+    auto* y = (uint8_t*)env->GetPrimitiveArrayCritical(yArr, nullptr);
+    auto* uv = y ? (uint8_t*)env->GetPrimitiveArrayCritical(uvArr, nullptr) : nullptr;
+    auto* out = uv ? (uint8_t*)env->GetPrimitiveArrayCritical(outArr, nullptr) : nullptr;
+    int length = -1;
+    if (out) length = omt::packNvlz(*lz, y, uv, width, height, out, (size_t)capacity);
+    if (out) env->ReleasePrimitiveArrayCritical(outArr, out, length > 0 ? 0 : JNI_ABORT);
+    if (uv) env->ReleasePrimitiveArrayCritical(uvArr, uv, JNI_ABORT);
+    if (y) env->ReleasePrimitiveArrayCritical(yArr, y, JNI_ABORT);
+    return length;
+}
+
+/** Expand the NVLZ payload at src[offset, offset + length) into tightly packed planes. */
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtLz4_nativeUnpack(JNIEnv* env, jclass, jbyteArray srcArr, jint offset, jint length,
+                                        jint width, jint height, jbyteArray yArr, jbyteArray uvArr) {
+    if (!srcArr || !yArr || !uvArr || offset < 0 || length < 0 || width <= 0 || height <= 0) return JNI_FALSE;
+    if ((int64_t)offset + length > env->GetArrayLength(srcArr) || env->GetArrayLength(yArr) < width * height ||
+        env->GetArrayLength(uvArr) < width * (height / 2))
+        return JNI_FALSE;
+    auto* src = (uint8_t*)env->GetPrimitiveArrayCritical(srcArr, nullptr);
+    auto* y = src ? (uint8_t*)env->GetPrimitiveArrayCritical(yArr, nullptr) : nullptr;
+    auto* uv = y ? (uint8_t*)env->GetPrimitiveArrayCritical(uvArr, nullptr) : nullptr;
+    const bool ok = uv && omt::unpackNvlz(src + offset, (size_t)length, width, height, y, uv);
+    if (uv) env->ReleasePrimitiveArrayCritical(uvArr, uv, 0);
+    if (y) env->ReleasePrimitiveArrayCritical(yArr, y, 0);
+    if (src) env->ReleasePrimitiveArrayCritical(srcArr, src, JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+} // extern "C"
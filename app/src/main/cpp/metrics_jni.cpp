@@ -0,0 +1,25 @@
+/**
+ * JNI bindings for the optional Prometheus endpoint in core/omt_metrics.
+ */
+#include <jni.h>
+
+#include "omt_metrics.h"
+
+extern "C" {
+
+JNIEXPORT jint JNICALL
+Java_com_omt_camera_OmtMetrics_nativeConfiguredPort(JNIEnv* env, jclass) {
+    return omt::metricsConfiguredPort();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtMetrics_nativeStart(JNIEnv* env, jclass, jint port) {
+    return omt::metricsServerStart(port) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtMetrics_nativeStop(JNIEnv* env, jclass) {
+    omt::metricsServerStop();
+}
+
+} // extern "C"
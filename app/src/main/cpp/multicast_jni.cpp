@@ -0,0 +1,90 @@
+/**
+ * JNI bindings for the multicast fan-out (core/omt_multicast): the sender
+ * offers the group to receivers that ask for it and sends each wire frame to
+ * it once for all of them.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_multicast.h"
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtMulticast_nativeConfigured(JNIEnv* env, jclass) {
+    omt::MulticastConfig cfg;
+    return omt::multicastConfigured(&cfg) ? JNI_TRUE : JNI_FALSE;
+}
+
+/** Open the group from the debug.omt.multicast spec; 0 if off or unavailable. */
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtMulticast_nativeStart(JNIEnv* env, jclass) {
+    omt::MulticastConfig cfg;
+    if (!omt::multicastConfigured(&cfg)) return 0;
+    auto* mcast = new omt::MulticastSender(cfg);
+    if (!mcast->start()) {
+        delete mcast;
+        return 0;
+    }
+    return (jlong)(uintptr_t)mcast;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtMulticast_nativeStop(JNIEnv* env, jclass, jlong handle) {
+    delete (omt::MulticastSender*)(uintptr_t)handle;
+}
+
+/** The <OMTMulticast Address=… Port=… /> answer to a receiver's request. */
+JNIEXPORT jstring JNICALL
+Java_com_omt_camera_OmtMulticast_nativeOfferXml(JNIEnv* env, jclass, jlong handle) {
+    auto* mcast = (omt::MulticastSender*)(uintptr_t)handle;
+    char xml[128];
+    if (!mcast || omt::formatMulticastOffer(xml, sizeof(xml), mcast->config()) < 0) return nullptr;
+    return env->NewStringUTF(xml);
+}
+
+namespace {
+
+bool validPiece(JNIEnv* env, jbyteArray arr, jint len) {
+    return len == 0 || (len > 0 && arr && env->GetArrayLength(arr) >= len);
+}
+
+} // namespace
+
+/**
+ * Send head[0, headLen) + body[0, bodyLen) + tail[0, tailLen) as one frame;
+ * false if any of it was dropped.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtMulticast_nativeSend(JNIEnv* env, jclass, jlong handle, jbyteArray headArr, jint headLen,
+                                            jbyteArray bodyArr, jint bodyLen, jbyteArray tailArr, jint tailLen) {
+    auto* mcast = (omt::MulticastSender*)(uintptr_t)handle;
+    if (!mcast || headLen <= 0 || !validPiece(env, headArr, headLen) || !validPiece(env, bodyArr, bodyLen) ||
+        !validPiece(env, tailArr, tailLen))
+        return JNI_FALSE;
+    // Datagrams are gathered straight from the arrays; the sends never block, so
+    // critical access lasts as long as the kernel takes to copy the frame once.
+    auto* head = (const uint8_t*)env->GetPrimitiveArrayCritical(headArr, nullptr);
+    auto* body = bodyLen > 0 ? (const uint8_t*)env->GetPrimitiveArrayCritical(bodyArr, nullptr) : nullptr;
+    auto* tail = tailLen > 0 ? (const uint8_t*)env->GetPrimitiveArrayCritical(tailArr, nullptr) : nullptr;
+    bool ok = head && (bodyLen == 0 || body) && (tailLen == 0 || tail) &&
+              mcast->send(head, headLen, body, bodyLen, tail, tailLen);
+    if (tail) env->ReleasePrimitiveArrayCritical(tailArr, (void*)tail, JNI_ABORT);
+    if (body) env->ReleasePrimitiveArrayCritical(bodyArr, (void*)body, JNI_ABORT);
+    if (head) env->ReleasePrimitiveArrayCritical(headArr, (void*)head, JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/** {framesSent, framesDropped, datagramsSent, bytesSent} */
+JNIEXPORT jlongArray JNICALL
+Java_com_omt_camera_OmtMulticast_nativeCounters(JNIEnv* env, jclass, jlong handle) {
+    auto* mcast = (omt::MulticastSender*)(uintptr_t)handle;
+    if (!mcast) return nullptr;
+    const jlong values[4] = {(jlong)mcast->framesSent(), (jlong)mcast->framesDropped(),
+                             (jlong)mcast->datagramsSent(), (jlong)mcast->bytesSent()};
+    jlongArray arr = env->NewLongArray(4);
+    if (arr) env->SetLongArrayRegion(arr, 0, 4, values);
+    return arr;
+}
+
+} // extern "C"
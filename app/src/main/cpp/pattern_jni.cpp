@@ -0,0 +1,59 @@
+/**
+ * JNI bindings for the synthetic test patterns (core/omt_pattern): the sender
+ * renders them into its NV12 frame buffers in place of camera frames.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_pattern.h"
+
+extern "C" {
+
+/** {kind, width, height} from debug.omt.pattern, or null when pattern mode is off. */
+JNIEXPORT jintArray JNICALL
+Java_com_omt_camera_OmtTestPattern_nativeConfigured(JNIEnv* env, jclass) {
+    omt::PatternKind kind;
+    int width, height;
+    if (!omt::testPatternConfigured(&kind, &width, &height)) return nullptr;
+    jintArray out = env->NewIntArray(3);
+    if (!out) return nullptr;
+    const jint values[3] = {(jint)kind, width, height};
+    env->SetIntArrayRegion(out, 0, 3, values);
+    return out;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtTestPattern_nativeCreate(JNIEnv* env, jclass, jint width, jint height) {
+    auto* pattern = new omt::TestPattern();
+    if (!pattern->configure(width, height)) {
+        delete pattern;
+        return 0;
+    }
+    return (jlong)(uintptr_t)pattern;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtTestPattern_nativeDestroy(JNIEnv* env, jclass, jlong handle) {
+    delete (omt::TestPattern*)(uintptr_t)handle;
+}
+
+/** Render frame n (tight strides) with the frame-counter overlay; false on bad arguments. */
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtTestPattern_nativeRender(JNIEnv* env, jclass, jlong handle, jint kind, jlong n,
+                                                jbyteArray yArr, jbyteArray uvArr) {
+    auto* pattern = (omt::TestPattern*)(uintptr_t)handle;
+    if (!pattern || !yArr || !uvArr || kind < omt::PATTERN_BARS || kind > omt::PATTERN_RAMP) return JNI_FALSE;
+    const int w = pattern->width(), h = pattern->height();
+    if (env->GetArrayLength(yArr) < w * h || env->GetArrayLength(uvArr) < w * (h / 2)) return JNI_FALSE;
+    auto* y = (uint8_t*)env->GetPrimitiveArrayCritical(yArr, nullptr);
+    auto* uv = y ? (uint8_t*)env->GetPrimitiveArrayCritical(uvArr, nullptr) : nullptr;
+    if (y && uv) {
+        pattern->render((omt::PatternKind)kind, (uint64_t)n, y, w, uv, w);
+        pattern->drawCounter((uint64_t)n, y, w, uv, w);
+    }
+    if (uv) env->ReleasePrimitiveArrayCritical(uvArr, uv, 0);
+    if (y) env->ReleasePrimitiveArrayCritical(yArr, y, 0);
+    return y && uv ? JNI_TRUE : JNI_FALSE;
+}
+
+} // extern "C"
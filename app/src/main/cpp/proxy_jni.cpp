@@ -0,0 +1,72 @@
+/**
+ * JNI bindings for the low-resolution proxy recording (core/omt_proxy): the
+ * sender offers each camera frame after sending it; the proxy takes one now
+ * and then, downscales it and encodes it on its own low-priority thread.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_proxy.h"
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtProxy_nativeConfigured(JNIEnv* env, jclass) {
+    omt::ProxyConfig cfg;
+    return omt::proxyConfigured(&cfg) ? JNI_TRUE : JNI_FALSE;
+}
+
+/** Start a proxy recording to basePath-0001.omt with the debug.omt.proxy spec; 0 if off or unavailable. */
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtProxy_nativeStart(JNIEnv* env, jclass, jstring basePath) {
+    omt::ProxyConfig cfg;
+    if (!basePath || !omt::proxyConfigured(&cfg)) return 0;
+    const char* path = env->GetStringUTFChars(basePath, nullptr);
+    if (!path) return 0;
+    cfg.basePath = path;
+    env->ReleaseStringUTFChars(basePath, path);
+    auto* proxy = new omt::ProxyRecorder(cfg);
+    if (!proxy->start()) {
+        delete proxy;
+        return 0;
+    }
+    return (jlong)(uintptr_t)proxy;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtProxy_nativeStop(JNIEnv* env, jclass, jlong handle) {
+    delete (omt::ProxyRecorder*)(uintptr_t)handle;
+}
+
+/** Offer tight NV12 y/uv at width x height; true if the proxy took the frame. */
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtProxy_nativeOffer(JNIEnv* env, jclass, jlong handle, jbyteArray yArr, jbyteArray uvArr,
+                                         jint width, jint height, jlong timestamp) {
+    auto* proxy = (omt::ProxyRecorder*)(uintptr_t)handle;
+    // Most frames are not due: answer before pinning anything.
+    if (!proxy || !proxy->due() || !yArr || !uvArr) return JNI_FALSE;
+    if (env->GetArrayLength(yArr) < width * height || env->GetArrayLength(uvArr) < width * (height / 2))
+        return JNI_FALSE;
+    // Critical access only spans the downscale (a fraction of a millisecond at 640 wide).
+    auto* y = (const uint8_t*)env->GetPrimitiveArrayCritical(yArr, nullptr);
+    auto* uv = (const uint8_t*)env->GetPrimitiveArrayCritical(uvArr, nullptr);
+    bool taken = y && uv && proxy->offer(y, width, uv, width, width, height, timestamp);
+    if (uv) env->ReleasePrimitiveArrayCritical(uvArr, (void*)uv, JNI_ABORT);
+    if (y) env->ReleasePrimitiveArrayCritical(yArr, (void*)y, JNI_ABORT);
+    return taken ? JNI_TRUE : JNI_FALSE;
+}
+
+/** {framesEncoded, skippedBusy, skippedBudget, bytesWritten, meanCostNs} */
+JNIEXPORT jlongArray JNICALL
+Java_com_omt_camera_OmtProxy_nativeCounters(JNIEnv* env, jclass, jlong handle) {
+    auto* proxy = (omt::ProxyRecorder*)(uintptr_t)handle;
+    if (!proxy) return nullptr;
+    const jlong values[5] = {(jlong)proxy->framesEncoded(), (jlong)proxy->framesSkippedBusy(),
+                             (jlong)proxy->framesSkippedBudget(), (jlong)proxy->bytesWritten(),
+                             (jlong)proxy->meanCostNs()};
+    jlongArray arr = env->NewLongArray(5);
+    if (arr) env->SetLongArrayRegion(arr, 0, 5, values);
+    return arr;
+}
+
+} // extern "C"
@@ -0,0 +1,92 @@
+/**
+ * JNI bindings for live encode-quality sampling (core/omt_quality): the
+ * sender decodes an occasional VMX frame it has just sent and compares it
+ * with the NV12 it encoded. Results also land in the quality gauges.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_quality.h"
+#include "omt_stats.h"
+#include "omt_vmx.h"
+
+namespace {
+
+struct QualitySampler {
+    omt::QualityMeter meter;
+    void* decoder = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+} // namespace
+
+extern "C" {
+
+/** Sampling period in seconds from debug.omt.quality, or 0 when sampling is off. */
+JNIEXPORT jdouble JNICALL
+Java_com_omt_camera_OmtQuality_nativePeriodSec(JNIEnv* env, jclass) {
+    double period;
+    return omt::qualitySamplingConfigured(&period) ? period : 0.0;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_omt_camera_OmtQuality_nativeKernelName(JNIEnv* env, jclass) {
+    return env->NewStringUTF(omt::qualityKernelName());
+}
+
+/** Meter plus its own VMX decoder for width x height; 0 when libvmx cannot decode. */
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtQuality_nativeCreate(JNIEnv* env, jclass, jint width, jint height) {
+    if (!omt::vmxCanDecode()) return 0;
+    auto* sampler = new QualitySampler();
+    sampler->width = width;
+    sampler->height = height;
+    if (!sampler->meter.configure(width, height) || !(sampler->decoder = omt::vmxCreate(width, height, 0, "decoder"))) {
+        delete sampler;
+        return 0;
+    }
+    return (jlong)(uintptr_t)sampler;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtQuality_nativeDestroy(JNIEnv* env, jclass, jlong handle) {
+    auto* sampler = (QualitySampler*)(uintptr_t)handle;
+    if (!sampler) return;
+    omt::vmxDestroy(sampler->decoder);
+    delete sampler;
+}
+
+/**
+ * Decode data[0, len) and compare with tight NV12 y/uv. out receives
+ * {psnr, ssim, psnrY, psnrCb, psnrCr, ssimY, ssimCb, ssimCr}.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtQuality_nativeMeasure(JNIEnv* env, jclass, jlong handle, jbyteArray dataArr, jint len,
+                                             jbyteArray yArr, jbyteArray uvArr, jdoubleArray outArr) {
+    auto* sampler = (QualitySampler*)(uintptr_t)handle;
+    if (!sampler || !dataArr || !yArr || !uvArr || !outArr || len <= 0) return JNI_FALSE;
+    const int w = sampler->width, h = sampler->height;
+    if (env->GetArrayLength(dataArr) < len || env->GetArrayLength(yArr) < w * h ||
+        env->GetArrayLength(uvArr) < w * (h / 2) || env->GetArrayLength(outArr) < 8)
+        return JNI_FALSE;
+    // Not critical sections: the decode takes milliseconds and may block on its own threads.
+    auto* data = env->GetByteArrayElements(dataArr, nullptr);
+    auto* y = env->GetByteArrayElements(yArr, nullptr);
+    auto* uv = env->GetByteArrayElements(uvArr, nullptr);
+    omt::QualityResult q;
+    bool ok = data && y && uv &&
+              sampler->meter.measureEncoded(sampler->decoder, (const uint8_t*)data, len, (const uint8_t*)y, w,
+                                            (const uint8_t*)uv, w, &q);
+    if (uv) env->ReleaseByteArrayElements(uvArr, uv, JNI_ABORT);
+    if (y) env->ReleaseByteArrayElements(yArr, y, JNI_ABORT);
+    if (data) env->ReleaseByteArrayElements(dataArr, data, JNI_ABORT);
+    if (!ok) return JNI_FALSE;
+    omt::statsSetGauge(omt::GAUGE_QUALITY_PSNR, q.psnr);
+    omt::statsSetGauge(omt::GAUGE_QUALITY_SSIM, q.ssim);
+    const jdouble values[8] = {q.psnr, q.ssim, q.y.psnr, q.cb.psnr, q.cr.psnr, q.y.ssim, q.cb.ssim, q.cr.ssim};
+    env->SetDoubleArrayRegion(outArr, 0, 8, values);
+    return JNI_TRUE;
+}
+
+} // extern "C"
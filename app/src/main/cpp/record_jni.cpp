@@ -0,0 +1,84 @@
+/**
+ * JNI bindings for the local recording (core/omt_record): the sender hands
+ * each wire frame it builds to the recorder, which copies it and writes it
+ * to indexed segment files on its own thread.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_record.h"
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtRecorder_nativeConfigured(JNIEnv* env, jclass) {
+    return omt::recordingConfigured() ? JNI_TRUE : JNI_FALSE;
+}
+
+/** Start recording to basePath-0001.omt (+ .idx); 0 when the first segment cannot be created. */
+JNIEXPORT jlong JNICALL
+Java_com_omt_camera_OmtRecorder_nativeStart(JNIEnv* env, jclass, jstring basePath) {
+    if (!basePath) return 0;
+    const char* path = env->GetStringUTFChars(basePath, nullptr);
+    if (!path) return 0;
+    omt::RecorderConfig cfg;
+    cfg.basePath = path;
+    env->ReleaseStringUTFChars(basePath, path);
+    auto* recorder = new omt::Recorder(cfg);
+    if (!recorder->start()) {
+        delete recorder;
+        return 0;
+    }
+    return (jlong)(uintptr_t)recorder;
+}
+
+/** Write out what is queued and close the segment. */
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtRecorder_nativeStop(JNIEnv* env, jclass, jlong handle) {
+    delete (omt::Recorder*)(uintptr_t)handle;
+}
+
+namespace {
+
+bool validPiece(JNIEnv* env, jbyteArray arr, jint len) {
+    return len == 0 || (len > 0 && arr && env->GetArrayLength(arr) >= len);
+}
+
+} // namespace
+
+/**
+ * Queue head[0, headLen) + body[0, bodyLen) + tail[0, tailLen) as one frame;
+ * false if it was dropped.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtRecorder_nativeRecord(JNIEnv* env, jclass, jlong handle, jbyteArray headArr, jint headLen,
+                                             jbyteArray bodyArr, jint bodyLen, jbyteArray tailArr, jint tailLen) {
+    auto* recorder = (omt::Recorder*)(uintptr_t)handle;
+    if (!recorder || headLen <= 0 || !validPiece(env, headArr, headLen) || !validPiece(env, bodyArr, bodyLen) ||
+        !validPiece(env, tailArr, tailLen))
+        return JNI_FALSE;
+    // record() only memcpys into the ring, so critical access stays short.
+    auto* head = (const uint8_t*)env->GetPrimitiveArrayCritical(headArr, nullptr);
+    auto* body = bodyLen > 0 ? (const uint8_t*)env->GetPrimitiveArrayCritical(bodyArr, nullptr) : nullptr;
+    auto* tail = tailLen > 0 ? (const uint8_t*)env->GetPrimitiveArrayCritical(tailArr, nullptr) : nullptr;
+    bool ok = head && (bodyLen == 0 || body) && (tailLen == 0 || tail) &&
+              recorder->record(head, headLen, body, bodyLen, tail, tailLen);
+    if (tail) env->ReleasePrimitiveArrayCritical(tailArr, (void*)tail, JNI_ABORT);
+    if (body) env->ReleasePrimitiveArrayCritical(bodyArr, (void*)body, JNI_ABORT);
+    if (head) env->ReleasePrimitiveArrayCritical(headArr, (void*)head, JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/** {framesWritten, framesDropped, bytesWritten, failed} */
+JNIEXPORT jlongArray JNICALL
+Java_com_omt_camera_OmtRecorder_nativeCounters(JNIEnv* env, jclass, jlong handle) {
+    auto* recorder = (omt::Recorder*)(uintptr_t)handle;
+    if (!recorder) return nullptr;
+    const jlong values[4] = {(jlong)recorder->framesWritten(), (jlong)recorder->framesDropped(),
+                             (jlong)recorder->bytesWritten(), recorder->failed() ? 1 : 0};
+    jlongArray arr = env->NewLongArray(4);
+    if (arr) env->SetLongArrayRegion(arr, 0, 4, values);
+    return arr;
+}
+
+} // extern "C"
@@ -0,0 +1,91 @@
+/**
+ * JNI bindings for the latency histograms, drop counters, counters and gauges in core/omt_stats.
+ * Recording is lock-free; snapshots return [count, p50, p99, p99.9, max, mean] in ns.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_stats.h"
+
+static jlongArray toLongArray(JNIEnv* env, const omt::HistogramSnapshot& s) {
+    jlong values[6] = { (jlong)s.count, (jlong)s.p50, (jlong)s.p99, (jlong)s.p999, (jlong)s.max, (jlong)s.mean };
+    jlongArray arr = env->NewLongArray(6);
+    if (arr) env->SetLongArrayRegion(arr, 0, 6, values);
+    return arr;
+}
+
+extern "C" {
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeRecord(JNIEnv* env, jclass, jint stage, jlong nanos) {
+    if (nanos >= 0) omt::statsRecord(stage, (uint64_t)nanos);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeRecordClientWrite(JNIEnv* env, jclass, jint slot, jlong nanos) {
+    if (nanos >= 0) omt::statsRecordClientWrite(slot, (uint64_t)nanos);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_omt_camera_OmtStats_nativeSnapshot(JNIEnv* env, jclass, jint stage) {
+    omt::HistogramSnapshot s;
+    if (!omt::statsSnapshot(stage, &s)) return nullptr;
+    return toLongArray(env, s);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_omt_camera_OmtStats_nativeSnapshotClient(JNIEnv* env, jclass, jint slot) {
+    omt::HistogramSnapshot s;
+    if (!omt::statsSnapshotClient(slot, &s)) return nullptr;
+    return toLongArray(env, s);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeRecordDrop(JNIEnv* env, jclass, jint cause, jint slot, jlong frames) {
+    if (frames > 0) omt::statsRecordDrop(cause, slot, (uint64_t)frames);
+}
+
+/** Drop totals indexed by cause; slot < 0 returns the process-wide counters. */
+JNIEXPORT jlongArray JNICALL
+Java_com_omt_camera_OmtStats_nativeDrops(JNIEnv* env, jclass, jint slot) {
+    jlong values[omt::DROP_CAUSE_COUNT];
+    for (int c = 0; c < omt::DROP_CAUSE_COUNT; c++)
+        values[c] = (jlong)(slot < 0 ? omt::statsDropCount(c) : omt::statsDropCountClient(slot, c));
+    jlongArray arr = env->NewLongArray(omt::DROP_CAUSE_COUNT);
+    if (arr) env->SetLongArrayRegion(arr, 0, omt::DROP_CAUSE_COUNT, values);
+    return arr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeAddCounter(JNIEnv* env, jclass, jint counter, jlong delta) {
+    if (delta > 0) omt::statsAddCounter(counter, (uint64_t)delta);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeSetGauge(JNIEnv* env, jclass, jint gauge, jdouble value) {
+    omt::statsSetGauge(gauge, value);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeAddClientBytes(JNIEnv* env, jclass, jint slot, jlong bytes) {
+    if (bytes > 0) omt::statsAddClientBytes(slot, (uint64_t)bytes);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeSetClientLabel(JNIEnv* env, jclass, jint slot, jstring jLabel) {
+    const char* label = jLabel ? env->GetStringUTFChars(jLabel, nullptr) : nullptr;
+    omt::statsSetClientLabel(slot, label);
+    if (label) env->ReleaseStringUTFChars(jLabel, label);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeResetClient(JNIEnv* env, jclass, jint slot) {
+    omt::statsResetClient(slot);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtStats_nativeReset(JNIEnv* env, jclass, jint sides) {
+    omt::statsResetSides(sides);
+}
+
+} // extern "C"
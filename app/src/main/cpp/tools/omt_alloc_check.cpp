@@ -0,0 +1,457 @@
+/**
+ * omt_alloc_check — allocation-counting harness for the native hot paths.
+ *
+ * malloc/calloc/realloc/memalign and every global operator new are
+ * interposed in this executable (glibc only), so allocations from omt_core,
+ * libstdc++ and the loaded libvmx are all counted, from every thread. Each
+ * scenario drives one hot-path entry point: it warms up (first-use buffers,
+ * pools and demux capacity may allocate), then counts allocations over the
+ * steady-state frames and prints them with the glibc arena statistics.
+ *
+ *   omt_alloc_check                 # report
+ *   omt_alloc_check --check         # exit 1 if any steady-state frame allocated
+ *   omt_alloc_check --only sender --frames 500 --trace
+ *
+ * With --trace the first steady-state allocation of each scenario is
+ * reported with a backtrace.
+ */
+#define LOG_TAG "omt_alloc_check"
+#include "omt_audio.h"
+#include "omt_demux.h"
+#include "omt_latency.h"
+#include "omt_log.h"
+#include "omt_loop.h"
+#include "omt_pixel.h"
+#include "omt_protocol.h"
+#include "omt_receiver.h"
+#include "omt_sender.h"
+#include "omt_stats.h"
+#include "omt_trace.h"
+#include "omt_vmx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <execinfo.h>
+#include <functional>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#ifndef __GLIBC__
+#error "omt_alloc_check interposes glibc's allocator entry points"
+#endif
+
+// ---- Interposed allocator ----
+
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void __libc_free(void*);
+}
+
+namespace {
+
+struct AllocCounters {
+    std::atomic<uint64_t> mallocs{0};   // malloc/calloc/realloc/memalign family
+    std::atomic<uint64_t> news{0};      // operator new / new[]
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> frees{0};
+};
+
+AllocCounters s_counters;
+std::atomic<bool> s_traceArmed{false};
+thread_local bool t_inHook = false;
+
+constexpr int MAX_FRAMES = 24;
+void* s_firstStack[MAX_FRAMES];
+int s_firstDepth = 0;
+size_t s_firstSize = 0;
+
+inline void countAlloc(size_t n, bool isNew) {
+    (isNew ? s_counters.news : s_counters.mallocs).fetch_add(1, std::memory_order_relaxed);
+    s_counters.bytes.fetch_add(n, std::memory_order_relaxed);
+    if (s_traceArmed.load(std::memory_order_relaxed) && !t_inHook &&
+        s_traceArmed.exchange(false, std::memory_order_relaxed)) {
+        t_inHook = true;
+        s_firstSize = n;
+        s_firstDepth = backtrace(s_firstStack, MAX_FRAMES);
+        t_inHook = false;
+    }
+}
+
+void* alignedNew(size_t n, size_t align) {
+    countAlloc(n, true);
+    void* p = __libc_memalign(align, n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* plainNew(size_t n) {
+    countAlloc(n, true);
+    void* p = __libc_malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+inline void countFree(void* p) {
+    if (p) s_counters.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+extern "C" {
+
+void* malloc(size_t n) {
+    countAlloc(n, false);
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t count, size_t n) {
+    countAlloc(count * n, false);
+    return __libc_calloc(count, n);
+}
+
+void* realloc(void* p, size_t n) {
+    if (n) countAlloc(n, false);
+    return __libc_realloc(p, n);
+}
+
+void* memalign(size_t align, size_t n) {
+    countAlloc(n, false);
+    return __libc_memalign(align, n);
+}
+
+void* aligned_alloc(size_t align, size_t n) {
+    countAlloc(n, false);
+    return __libc_memalign(align, n);
+}
+
+int posix_memalign(void** out, size_t align, size_t n) {
+    countAlloc(n, false);
+    void* p = __libc_memalign(align, n);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+void free(void* p) {
+    countFree(p);
+    __libc_free(p);
+}
+
+} // extern "C"
+
+void* operator new(size_t n) { return plainNew(n); }
+void* operator new[](size_t n) { return plainNew(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+    countAlloc(n, true);
+    return __libc_malloc(n ? n : 1);
+}
+void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+    countAlloc(n, true);
+    return __libc_malloc(n ? n : 1);
+}
+void* operator new(size_t n, std::align_val_t a) { return alignedNew(n, (size_t)a); }
+void* operator new[](size_t n, std::align_val_t a) { return alignedNew(n, (size_t)a); }
+void operator delete(void* p) noexcept { countFree(p); __libc_free(p); }
+void operator delete[](void* p) noexcept { countFree(p); __libc_free(p); }
+void operator delete(void* p, size_t) noexcept { countFree(p); __libc_free(p); }
+void operator delete[](void* p, size_t) noexcept { countFree(p); __libc_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { countFree(p); __libc_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { countFree(p); __libc_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { countFree(p); __libc_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { countFree(p); __libc_free(p); }
+
+// ---- Scenarios ----
+
+using namespace omt;
+
+namespace {
+
+struct Snapshot {
+    uint64_t mallocs, news, bytes, frees;
+    struct mallinfo2 arena;
+
+    static Snapshot take() {
+        Snapshot s;
+        s.mallocs = s_counters.mallocs.load();
+        s.news = s_counters.news.load();
+        s.bytes = s_counters.bytes.load();
+        s.frees = s_counters.frees.load();
+        s.arena = mallinfo2();
+        return s;
+    }
+};
+
+/** One hot-path entry point; step(i) processes frame i. */
+struct Scenario {
+    const char* name;
+    std::function<bool()> setUp;       // may allocate; false skips the scenario
+    std::function<bool(int)> step;     // false aborts the scenario
+    std::function<void()> tearDown;
+};
+
+constexpr int W = 1920;
+constexpr int H = 1080;
+
+void fill(std::vector<uint8_t>& v, uint32_t seed) {
+    for (auto& b : v) { seed = seed * 1664525u + 1013904223u; b = (uint8_t)(seed >> 24); }
+}
+
+/** Buffers shared by the pixel / codec scenarios, allocated once up front. */
+struct Frames {
+    std::vector<uint8_t> srcY, srcUV, y, uv, rgba, smallY, smallUV, vmx;
+    std::vector<float> pcm;
+    std::vector<uint8_t> planar;
+
+    Frames()
+        : srcY((size_t)(W + 64) * H), srcUV((size_t)(W + 64) * H / 2 + 1),
+          y((size_t)W * H), uv((size_t)W * H / 2), rgba((size_t)W * H * 4),
+          smallY((size_t)W / 2 * H / 2), smallUV((size_t)W / 2 * H / 4), vmx((size_t)W * H * 2),
+          pcm(960 * 2), planar(960 * 2 * 4) {
+        fill(srcY, 1); fill(srcUV, 2); fill(y, 3); fill(uv, 4);
+        for (size_t i = 0; i < pcm.size(); i++) pcm[i] = (float)((int)(i % 200) - 100) / 100.f;
+    }
+};
+
+std::vector<Scenario> buildScenarios(Frames& f) {
+    std::vector<Scenario> list;
+    list.push_back({ "pixel.packNv12", [] { return true; }, [&f](int) {
+        packNv12(f.srcY.data(), W + 64, f.srcUV.data(), W + 64, 2, f.srcUV.data() + 1, W + 64, 2,
+                 f.y.data(), f.uv.data(), W, H);
+        return true;
+    }, nullptr });
+    list.push_back({ "pixel.nv12ToRgba", [] { return true; }, [&f](int) {
+        nv12ToRgba(f.y.data(), W, f.uv.data(), W, f.rgba.data(), W * 4, W, H);
+        return true;
+    }, nullptr });
+    list.push_back({ "pixel.scaleNv12", [] { return true; }, [&f](int) {
+        scaleNv12(f.y.data(), W, f.uv.data(), W, W, H, f.smallY.data(), f.smallUV.data(), W / 2, H / 2);
+        return true;
+    }, nullptr });
+    list.push_back({ "audio.planar", [] { return true; }, [&f](int) {
+        interleavedToPlanar(f.pcm.data(), 960, 2, f.planar.data());
+        planarToInterleaved(f.planar.data(), f.planar.size(), 960, 2, f.pcm.data());
+        return true;
+    }, nullptr });
+    list.push_back({ "latency.timecode", [] { return true; }, [&f](int i) {
+        timecodeStampNv12(f.y.data(), W, f.uv.data(), W, W, H, (uint64_t)i * 16667);
+        uint64_t v;
+        char xml[160];
+        int n = formatLatencyStamp(xml, sizeof(xml), i * 16667, i);
+        int64_t stamp, frame;
+        return timecodeReadNv12(f.y.data(), W, W, H, &v) && n > 0 &&
+               parseLatencyStamp(xml, (size_t)n, &stamp, &frame);
+    }, nullptr });
+    list.push_back({ "stats.trace", [] { traceSetEnabled(true); return true; }, [](int i) {
+        static const uint32_t name = traceRegisterName("alloc_check");
+        TraceSpan span(name, i);
+        statsRecord(STAGE_ENCODE, 1000 + i);
+        statsRecordClientWrite(0, 2000 + i);
+        statsRecordDrop(DROP_SLOW_CLIENT, 0);
+        statsAddCounter(COUNTER_FRAMES_SENT);
+        statsSetGauge(GAUGE_FPS_SENT, 60.0);
+        return true;
+    }, [] { traceSetEnabled(false); traceClear(); } });
+
+    // VMX through whatever libvmx is loaded (the host stub by default).
+    struct Codec { void* enc = nullptr; void* dec = nullptr; int len = 0; };
+    auto codec = std::make_shared<Codec>();
+    list.push_back({ "vmx.encode", [codec] {
+        if (!vmxLoad()) return false;
+        codec->enc = vmxCreate(W, H, 0, "encoder");
+        return codec->enc != nullptr;
+    }, [&f, codec](int) {
+        codec->len = vmxEncode(codec->enc, f.y.data(), W, f.uv.data(), W, f.vmx.data(), (int)f.vmx.size());
+        return codec->len > 0;
+    }, nullptr });
+    list.push_back({ "vmx.decode", [codec] {
+        if (!vmxCanDecode() || codec->len <= 0) return false;
+        codec->dec = vmxCreate(W, H, 0, "decoder");
+        return codec->dec != nullptr;
+    }, [&f, codec](int) {
+        return vmxDecodeRgba(codec->dec, f.vmx.data(), codec->len, f.rgba.data(), W, H);
+    }, [codec] {
+        vmxDestroy(codec->enc);
+        vmxDestroy(codec->dec);
+        codec->enc = codec->dec = nullptr;
+    } });
+
+    // Demux of a recv-sized chunk stream (metadata + video + audio frames).
+    struct DemuxState { std::vector<uint8_t> stream; Demuxer demux{64u << 20}; uint64_t frames = 0; };
+    auto dm = std::make_shared<DemuxState>();
+    list.push_back({ "demux", [dm] {
+        const char xml[] = "<OMTTally Preview=\"false\" Program=\"false\" />";
+        dm->stream.resize(HEADER_SIZE + sizeof(xml) - 1 + HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + 400000 +
+                          HEADER_SIZE + AUDIO_EXT_HEADER_SIZE + 7680);
+        uint8_t* p = dm->stream.data();
+        p += buildMetadataFrame(p, dm->stream.size(), xml, sizeof(xml) - 1);
+        FrameHeader h;
+        h.type = FRAME_VIDEO;
+        h.dataLength = VIDEO_EXT_HEADER_SIZE + 400000;
+        writeFrameHeader(p, h);
+        writeVideoHeader(p + HEADER_SIZE, VideoHeader{});
+        p += HEADER_SIZE + h.dataLength;
+        h.type = FRAME_AUDIO;
+        h.dataLength = AUDIO_EXT_HEADER_SIZE + 7680;
+        writeFrameHeader(p, h);
+        writeAudioHeader(p + HEADER_SIZE, AudioHeader{});
+        return true;
+    }, [dm](int) {
+        for (size_t off = 0; off < dm->stream.size();) {
+            size_t avail;
+            uint8_t* dst = dm->demux.writable(&avail);
+            size_t n = std::min({ avail, (size_t)65536, dm->stream.size() - off });
+            std::memcpy(dst, dm->stream.data() + off, n);
+            if (!dm->demux.commit(n, [dm](const FrameHeader&, const uint8_t*, size_t) { dm->frames++; }))
+                return false;
+            off += n;
+        }
+        return true;
+    }, nullptr });
+
+    // Sender fan-out to four loopback receivers: pack, queue, flush, demux.
+    struct FanOut {
+        std::unique_ptr<Sender> sender;
+        std::unique_ptr<EventLoop> loop;
+        std::vector<std::unique_ptr<Receiver>> receivers;
+        std::atomic<uint64_t> received{0};
+        std::thread thread;
+    };
+    auto fo = std::make_shared<FanOut>();
+    constexpr int RECEIVERS = 4;
+    constexpr size_t PAYLOAD = 500000;
+    list.push_back({ "sender.fanout", [fo] {
+        SenderConfig sc;
+        sc.port = 0;
+        sc.bindAddress = "127.0.0.1";
+        sc.queueDepth = 4;
+        sc.frameBytesHint = HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + PAYLOAD;
+        fo->sender = std::make_unique<Sender>(sc);
+        if (!fo->sender->start()) return false;
+        fo->loop = std::make_unique<EventLoop>();
+        for (int i = 0; i < RECEIVERS; i++) {
+            ReceiverConfig rc;
+            rc.port = fo->sender->port();
+            fo->receivers.push_back(std::make_unique<Receiver>(*fo->loop, rc,
+                [fo](const FrameHeader& h, const uint8_t*, size_t) {
+                    if (h.type == FRAME_VIDEO) fo->received.fetch_add(1, std::memory_order_release);
+                }));
+            if (!fo->receivers.back()->connect()) return false;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (fo->sender->videoClientCount() < RECEIVERS && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        fo->thread = std::thread([fo] { fo->loop->run(); });
+        return fo->sender->videoClientCount() == RECEIVERS;
+    }, [&f, fo](int i) {
+        VideoHeader vh;
+        vh.codec = CODEC_VMX1;
+        vh.width = W;
+        vh.height = H;
+        uint64_t target = fo->received.load() + RECEIVERS;
+        Packet* p = fo->sender->beginVideo(PAYLOAD);
+        std::memcpy(p->payload() + VIDEO_EXT_HEADER_SIZE, f.vmx.data(), PAYLOAD);
+        if (fo->sender->publishVideo(p, vh, i, PAYLOAD) != RECEIVERS) return false;
+        // Lock-step so no frame is dropped and every frame's full path is inside the window.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (fo->received.load(std::memory_order_acquire) < target) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }, [fo] {
+        if (fo->thread.joinable()) {
+            fo->loop->stop();
+            fo->thread.join();
+        }
+        fo->receivers.clear();
+        fo->loop.reset();
+        if (fo->sender) fo->sender->stop();
+        fo->sender.reset();
+    } });
+    return list;
+}
+
+void printStack() {
+    if (s_firstDepth <= 0) return;
+    std::fprintf(stderr, "  first steady-state allocation (%zu bytes):\n", s_firstSize);
+    backtrace_symbols_fd(s_firstStack, s_firstDepth, STDERR_FILENO);
+    s_firstDepth = 0;
+}
+
+void usage() {
+    std::fprintf(stderr, "usage: omt_alloc_check [--check] [--frames n] [--warmup n] [--only substr] [--trace]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool check = false, trace = false;
+    int frames = 300, warmup = 30;
+    const char* only = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--check")) check = true;
+        else if (!std::strcmp(argv[i], "--trace")) trace = true;
+        else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) frames = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--warmup") && i + 1 < argc) warmup = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--only") && i + 1 < argc) only = argv[++i];
+        else { usage(); return 2; }
+    }
+    if (frames <= 0 || warmup < 1) { usage(); return 2; }
+
+    // backtrace() loads libgcc on first use; do it before anything is armed.
+    void* prime[2];
+    backtrace(prime, 2);
+
+    Frames f;
+    std::vector<Scenario> scenarios = buildScenarios(f);
+    std::printf("%-18s %7s %9s %9s %12s %10s %12s %12s\n", "scenario", "frames", "mallocs", "news",
+                "bytes", "allocs/fr", "arena KB", "in-use KB");
+    int failures = 0;
+    for (auto& s : scenarios) {
+        if (only && !std::strstr(s.name, only)) continue;
+        if (!s.setUp()) {
+            std::printf("%-18s %7s\n", s.name, "skipped");
+            continue;
+        }
+        bool ok = true;
+        for (int i = 0; i < warmup && ok; i++) ok = s.step(i);
+        Snapshot before = Snapshot::take();
+        if (trace) s_traceArmed.store(true);
+        for (int i = 0; i < frames && ok; i++) ok = s.step(warmup + i);
+        Snapshot after = Snapshot::take();
+        s_traceArmed.store(false);
+        if (s.tearDown) s.tearDown();
+
+        uint64_t mallocs = after.mallocs - before.mallocs;
+        uint64_t news = after.news - before.news;
+        double perFrame = (double)(mallocs + news) / frames;
+        std::printf("%-18s %7d %9llu %9llu %12llu %10.2f %12.1f %+12.1f%s\n", s.name, frames,
+                    (unsigned long long)mallocs, (unsigned long long)news,
+                    (unsigned long long)(after.bytes - before.bytes), perFrame,
+                    (after.arena.arena + after.arena.hblkhd) / 1024.0,
+                    ((double)after.arena.uordblks + after.arena.hblkhd -
+                     before.arena.uordblks - before.arena.hblkhd) / 1024.0,
+                    ok ? "" : "  (aborted)");
+        std::fflush(stdout);
+        if (trace) printStack();
+        if (!ok || (check && mallocs + news > 0)) failures++;
+    }
+    if (check) {
+        if (failures) std::printf("FAIL: %d scenario(s) allocated in steady state or failed\n", failures);
+        else std::printf("OK: no steady-state allocations\n");
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * omt_latency — glass-to-glass latency probe for an OMT source running in
+ * measurement mode (debug.omt.latency=1 on the camera).
+ *
+ * Subscribes to video, aligns clocks with <OMTClockRequest> exchanges, reads
+ * the pixel timecode from each frame (falling back to the <OMTLatencyStamp>
+ * metadata) and reports capture→arrival and capture→decoded distributions.
+ *
+ *   omt_latency <host> [port] [--duration sec] [--interval sec]
+ */
+#define LOG_TAG "omt_latency"
+#include "omt_histogram.h"
+#include "omt_latency.h"
+#include "omt_log.h"
+#include "omt_net.h"
+#include "omt_protocol.h"
+#include "omt_vmx.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+constexpr int64_t CLOCK_REQUEST_FAST_US = 100000;  // first WINDOW exchanges
+constexpr int64_t CLOCK_REQUEST_US = 1000000;
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+struct Counters {
+    uint64_t frames = 0;
+    uint64_t fromPixels = 0;
+    uint64_t fromMetadata = 0;
+    uint64_t unstamped = 0;
+};
+
+void printHist(const char* label, const LatencyHistogram& h) {
+    HistogramSnapshot s = h.snapshot();
+    std::printf(" %s p50=%.2f p99=%.2f p99.9=%.2f max=%.2fms", label,
+                s.p50 / 1e6, s.p99 / 1e6, s.p999 / 1e6, s.max / 1e6);
+}
+
+void report(const char* prefix, const Counters& c, const ClockSync& clock,
+            const LatencyHistogram& arrival, const LatencyHistogram& decoded) {
+    std::printf("%s frames=%llu pixel=%llu meta=%llu none=%llu offset=%lldus rtt=%lldus",
+                prefix, (unsigned long long)c.frames, (unsigned long long)c.fromPixels,
+                (unsigned long long)c.fromMetadata, (unsigned long long)c.unstamped,
+                (long long)clock.offsetUs(), (long long)clock.rttUs());
+    printHist("arrival", arrival);
+    printHist("decoded", decoded);
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+void usage() {
+    std::fprintf(stderr, "usage: omt_latency <host> [port] [--duration sec] [--interval sec]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* host = nullptr;
+    int port = 6500;
+    double durationSec = 0;
+    double intervalSec = 2;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--duration") && i + 1 < argc) durationSec = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--interval") && i + 1 < argc) intervalSec = std::atof(argv[++i]);
+        else if (argv[i][0] == '-') { usage(); return 2; }
+        else if (!host) host = argv[i];
+        else port = std::atoi(argv[i]);
+    }
+    if (!host || port <= 0) { usage(); return 2; }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    int fd = tcpConnect(host, port, 3000);
+    if (fd < 0) return 1;
+    static const char kSubMeta[] = "<OMTSubscribe Metadata=\"true\" />";
+    static const char kSubVideo[] = "<OMTSubscribe Video=\"true\" />";
+    if (!sendMetadata(fd, kSubMeta, sizeof(kSubMeta) - 1) || !sendMetadata(fd, kSubVideo, sizeof(kSubVideo) - 1)) {
+        LOGE("Subscribe failed");
+        close(fd);
+        return 1;
+    }
+    LOGI("Connected to %s:%d", host, port);
+
+    ClockSync clock;
+    LatencyHistogram arrival, decoded;
+    Counters counters;
+    int clockSamples = 0;
+    int64_t nextClockRequest = 0;
+    int64_t pendingMetaStamp = -1;
+    const int64_t startUs = monotonicUs();
+    int64_t nextReport = startUs + (int64_t)(intervalSec * 1e6);
+
+    FrameHeader header;
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> rgba;
+    void* decoder = nullptr;
+    int decW = 0, decH = 0;
+    bool vmxWarned = false;
+
+    while (!s_stop.load()) {
+        int64_t now = monotonicUs();
+        if (now >= nextClockRequest) {
+            char xml[128];
+            int n = formatClockRequest(xml, sizeof(xml), now);
+            if (n > 0 && !sendMetadata(fd, xml, (size_t)n)) break;
+            nextClockRequest = now + (clockSamples < ClockSync::WINDOW ? CLOCK_REQUEST_FAST_US : CLOCK_REQUEST_US);
+        }
+        if (!readFrame(fd, &header, payload)) {
+            LOGW("Stream ended");
+            break;
+        }
+        const int64_t receivedAt = monotonicUs();
+
+        if (header.type == FRAME_METADATA) {
+            const char* xml = (const char*)payload.data();
+            int64_t t1, t2, t3, stamp, frame;
+            if (parseClockReply(xml, payload.size(), &t1, &t2, &t3)) {
+                clock.addSample(t1, t2, t3, receivedAt);
+                clockSamples++;
+            } else if (parseLatencyStamp(xml, payload.size(), &stamp, &frame)) {
+                pendingMetaStamp = stamp;
+            }
+        } else if (header.type == FRAME_VIDEO && payload.size() >= (size_t)VIDEO_EXT_HEADER_SIZE) {
+            counters.frames++;
+            VideoHeader vh;
+            parseVideoHeader(payload.data(), &vh);
+            const uint8_t* data = payload.data() + VIDEO_EXT_HEADER_SIZE;
+            const int dataLen = (int)payload.size() - VIDEO_EXT_HEADER_SIZE;
+            uint64_t code = 0;
+            bool haveCode = false;
+
+            if (vh.codec == CODEC_NV12 && dataLen >= vh.width * vh.height * 3 / 2) {
+                haveCode = timecodeReadNv12(data, vh.width, vh.width, vh.height, &code);
+            } else if (vh.codec == CODEC_VMX1 && vh.width > 0 && vh.height > 0) {
+                if (!decoder || decW != vh.width || decH != vh.height) {
+                    if (decoder) vmxDestroy(decoder);
+                    decoder = vmxLoad() && vmxCanDecode() ? vmxCreate(vh.width, vh.height, 0, "decoder") : nullptr;
+                    decW = vh.width;
+                    decH = vh.height;
+                    rgba.resize((size_t)decW * decH * 4);
+                    if (!decoder && !vmxWarned) {
+                        LOGW("VMX decoder unavailable — using metadata stamps only");
+                        vmxWarned = true;
+                    }
+                }
+                if (decoder && vmxDecodeRgba(decoder, data, dataLen, rgba.data(), decW, decH))
+                    haveCode = timecodeReadRgba(rgba.data(), decW * 4, decW, decH, &code);
+            }
+            const int64_t decodedAt = monotonicUs();
+
+            int64_t stamp = -1;
+            if (haveCode) {
+                stamp = (int64_t)code;
+                counters.fromPixels++;
+            } else if (pendingMetaStamp >= 0) {
+                stamp = pendingMetaStamp;
+                counters.fromMetadata++;
+            } else {
+                counters.unstamped++;
+            }
+            pendingMetaStamp = -1;
+
+            if (stamp >= 0 && clock.valid()) {
+                const int64_t offset = clock.offsetUs();
+                const int64_t arrivalUs = receivedAt + offset - stamp;
+                const int64_t decodedUs = decodedAt + offset - stamp;
+                if (arrivalUs >= 0) arrival.record((uint64_t)arrivalUs * 1000);
+                if (decodedUs >= 0) decoded.record((uint64_t)decodedUs * 1000);
+            }
+        }
+
+        now = monotonicUs();
+        if (now >= nextReport) {
+            report("[latency]", counters, clock, arrival, decoded);
+            nextReport = now + (int64_t)(intervalSec * 1e6);
+        }
+        if (durationSec > 0 && now - startUs >= (int64_t)(durationSec * 1e6)) break;
+    }
+
+    if (decoder) vmxDestroy(decoder);
+    close(fd);
+    report("[summary]", counters, clock, arrival, decoded);
+    if (counters.frames > 0 && counters.fromPixels + counters.fromMetadata == 0)
+        LOGW("No stamped frames — is measurement mode enabled on the source (debug.omt.latency=1)?");
+    return arrival.snapshot().count > 0 ? 0 : 1;
+}
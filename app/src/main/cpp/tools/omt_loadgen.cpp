@@ -0,0 +1,420 @@
+/**
+ * omt_loadgen — opens N simulated receivers against one OMT sender to stress
+ * its fan-out and slow-client handling.
+ *
+ * Connections are described in groups, COUNT:MODE[:SUBS]:
+ *
+ *   MODE  full            read as fast as frames arrive
+ *         throttle=MBPS   read at most MBPS Mbit/s (a receiver on a slow link)
+ *         stall           subscribe, then never read (the sender's queue must drop)
+ *         stall=MS/PERIOD stop reading for MS out of every PERIOD milliseconds
+ *   SUBS  video, audio, preview, metadata joined with '+' (default video+audio)
+ *
+ *   omt_loadgen 127.0.0.1 6500 --group 45:full --group 4:throttle=20 --group 1:stall
+ *
+ * All connections share one EventLoop; reading is paused and resumed per
+ * connection to apply its mode. A separate unsubscribed connection keeps the
+ * clock aligned with <OMTClockRequest> so per-frame latency (arrival minus
+ * the sender's timestamp, which the app and omt_source take from the
+ * monotonic clock) is meaningful across hosts. Gaps in a connection's video
+ * timestamps longer than 1.5 frame periods count as dropped frames.
+ *
+ * Every interval prints aggregate fps, drops and latency; the end prints a
+ * per-connection table (and --json).
+ */
+#define LOG_TAG "omt_loadgen"
+#include "omt_histogram.h"
+#include "omt_latency.h"
+#include "omt_log.h"
+#include "omt_loop.h"
+#include "omt_protocol.h"
+#include "omt_receiver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+constexpr int MAX_CONNECTIONS = 50;
+constexpr int64_t CLOCK_REQUEST_FAST_US = 100000; // first WINDOW exchanges
+constexpr int64_t CLOCK_REQUEST_US = 1000000;
+constexpr int64_t MAX_PLAUSIBLE_LATENCY_US = 60000000; // beyond this the timestamps are not our clock
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+int64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+enum class ReadMode { Full, Throttle, Stall, StallPeriodic };
+
+struct Group {
+    std::string spec;
+    int count = 1;
+    ReadMode mode = ReadMode::Full;
+    double mbps = 0;
+    int stallMs = 0;
+    int periodMs = 0;
+    bool video = true;
+    bool audio = true;
+    bool preview = false;
+    bool metadata = false;
+};
+
+struct Connection {
+    int id = 0;
+    const Group* group = nullptr;
+    std::unique_ptr<Receiver> rx;
+    bool open = false;
+    int64_t startNs = 0;
+    int64_t closedNs = 0;
+
+    uint64_t videoFrames = 0;
+    uint64_t audioFrames = 0;
+    uint64_t dropped = 0;
+    uint64_t intervalFrames = 0;
+    int64_t lastVideoTs = -1; // 100 ns units
+    LatencyHistogram latency;
+};
+
+struct Totals {
+    uint64_t dropped = 0;
+    LatencyHistogram latency;
+};
+
+bool parseGroup(const char* text, Group* g) {
+    g->spec = text;
+    std::string s(text);
+    std::vector<std::string> parts;
+    for (size_t pos = 0;;) {
+        size_t colon = s.find(':', pos);
+        parts.push_back(s.substr(pos, colon == std::string::npos ? std::string::npos : colon - pos));
+        if (colon == std::string::npos) break;
+        pos = colon + 1;
+    }
+    if (parts.size() < 2 || parts.size() > 3) return false;
+    g->count = std::atoi(parts[0].c_str());
+    if (g->count <= 0) return false;
+
+    const std::string& mode = parts[1];
+    if (mode == "full") {
+        g->mode = ReadMode::Full;
+    } else if (mode.compare(0, 9, "throttle=") == 0) {
+        g->mode = ReadMode::Throttle;
+        g->mbps = std::atof(mode.c_str() + 9);
+        if (g->mbps <= 0) return false;
+    } else if (mode == "stall") {
+        g->mode = ReadMode::Stall;
+    } else if (mode.compare(0, 6, "stall=") == 0) {
+        g->mode = ReadMode::StallPeriodic;
+        if (std::sscanf(mode.c_str() + 6, "%d/%d", &g->stallMs, &g->periodMs) != 2 || g->stallMs <= 0 ||
+            g->periodMs <= g->stallMs)
+            return false;
+    } else {
+        return false;
+    }
+
+    if (parts.size() == 3) {
+        g->video = g->audio = g->preview = g->metadata = false;
+        const std::string& subs = parts[2];
+        for (size_t pos = 0; pos <= subs.size();) {
+            size_t plus = subs.find('+', pos);
+            std::string sub = subs.substr(pos, plus == std::string::npos ? std::string::npos : plus - pos);
+            if (sub == "video") g->video = true;
+            else if (sub == "audio") g->audio = true;
+            else if (sub == "preview") g->preview = true;
+            else if (sub == "metadata") g->metadata = true;
+            else return false;
+            if (plus == std::string::npos) break;
+            pos = plus + 1;
+        }
+    }
+    return true;
+}
+
+const char* modeName(const Group& g, char* buf, size_t len) {
+    switch (g.mode) {
+    case ReadMode::Full: return "full";
+    case ReadMode::Throttle: std::snprintf(buf, len, "%gMbps", g.mbps); return buf;
+    case ReadMode::Stall: return "stall";
+    case ReadMode::StallPeriodic: std::snprintf(buf, len, "stall %d/%d", g.stallMs, g.periodMs); return buf;
+    }
+    return "?";
+}
+
+std::string subsName(const Group& g) {
+    std::string s;
+    for (auto [on, name] : {std::pair<bool, const char*>{g.video, "video"}, {g.audio, "audio"},
+                            {g.preview, "preview"}, {g.metadata, "metadata"}}) {
+        if (!on) continue;
+        if (!s.empty()) s += '+';
+        s += name;
+    }
+    return s.empty() ? "none" : s;
+}
+
+/** Pause or resume reading according to the connection's mode. */
+void applyMode(Connection& c, int64_t now) {
+    if (!c.open) return;
+    const Group& g = *c.group;
+    switch (g.mode) {
+    case ReadMode::Full:
+        break;
+    case ReadMode::Stall:
+        c.rx->setReading(false);
+        break;
+    case ReadMode::Throttle: {
+        const double allowed = g.mbps * 1e6 / 8 * (now - c.startNs) / 1e9;
+        c.rx->setReading((double)c.rx->bytesReceived() < allowed);
+        break;
+    }
+    case ReadMode::StallPeriodic: {
+        const int64_t phaseMs = (now - c.startNs) / 1000000 % g.periodMs;
+        c.rx->setReading(phaseMs >= g.stallMs);
+        break;
+    }
+    }
+}
+
+void onVideo(Connection& c, Totals& totals, const ClockSync& clock, const FrameHeader& h,
+             const uint8_t* payload, size_t len) {
+    if (len < (size_t)VIDEO_EXT_HEADER_SIZE) return;
+    const int64_t arrivalUs = monotonicUs();
+    c.videoFrames++;
+    c.intervalFrames++;
+    VideoHeader vh;
+    parseVideoHeader(payload, &vh);
+    if (c.lastVideoTs >= 0 && vh.frameRateN > 0 && vh.frameRateD > 0) {
+        const double periodTicks = 1e7 * vh.frameRateD / vh.frameRateN;
+        const double delta = (double)(h.timestamp - c.lastVideoTs);
+        if (delta > 1.5 * periodTicks) {
+            uint64_t missed = (uint64_t)std::llround(delta / periodTicks) - 1;
+            c.dropped += missed;
+            totals.dropped += missed;
+        }
+    }
+    c.lastVideoTs = h.timestamp;
+    if (clock.valid()) {
+        const int64_t latencyUs = arrivalUs + clock.offsetUs() - h.timestamp / 10;
+        if (latencyUs >= 0 && latencyUs < MAX_PLAUSIBLE_LATENCY_US) {
+            c.latency.record((uint64_t)latencyUs * 1000);
+            totals.latency.record((uint64_t)latencyUs * 1000);
+        }
+    }
+}
+
+void printTable(const std::vector<std::unique_ptr<Connection>>& conns, int64_t endNs) {
+    std::printf("%4s %-14s %-20s %8s %8s %8s %8s %9s %9s %9s %s\n", "id", "mode", "subscribe", "frames",
+                "fps", "MB", "dropped", "p50 ms", "p99 ms", "max ms", "state");
+    for (const auto& c : conns) {
+        char buf[32];
+        const double seconds = ((c->closedNs ? c->closedNs : endNs) - c->startNs) / 1e9;
+        HistogramSnapshot s = c->latency.snapshot();
+        std::printf("%4d %-14s %-20s %8llu %8.2f %8.1f %8llu %9.3f %9.3f %9.3f %s\n", c->id,
+                    modeName(*c->group, buf, sizeof(buf)), subsName(*c->group).c_str(),
+                    (unsigned long long)c->videoFrames, seconds > 0 ? c->videoFrames / seconds : 0.0,
+                    c->rx->bytesReceived() / 1e6, (unsigned long long)c->dropped, s.p50 / 1e6, s.p99 / 1e6,
+                    s.max / 1e6, c->open ? "open" : "closed");
+    }
+    std::fflush(stdout);
+}
+
+bool writeJson(const char* path, const std::vector<std::unique_ptr<Connection>>& conns, int64_t endNs) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"bench\": \"loadgen\",\n  \"connections\": [\n");
+    for (size_t i = 0; i < conns.size(); i++) {
+        const Connection& c = *conns[i];
+        char buf[32];
+        const double seconds = ((c.closedNs ? c.closedNs : endNs) - c.startNs) / 1e9;
+        HistogramSnapshot s = c.latency.snapshot();
+        std::fprintf(f,
+            "    {\"id\": %d, \"group\": \"%s\", \"mode\": \"%s\", \"subscribe\": \"%s\", \"video_frames\": %llu, "
+            "\"audio_frames\": %llu, \"fps\": %.2f, \"bytes\": %llu, \"dropped\": %llu, "
+            "\"latency_p50_us\": %.1f, \"latency_p99_us\": %.1f, \"latency_p999_us\": %.1f, "
+            "\"latency_max_us\": %.1f, \"closed\": %s}%s\n",
+            c.id, c.group->spec.c_str(), modeName(*c.group, buf, sizeof(buf)), subsName(*c.group).c_str(),
+            (unsigned long long)c.videoFrames, (unsigned long long)c.audioFrames,
+            seconds > 0 ? c.videoFrames / seconds : 0.0, (unsigned long long)c.rx->bytesReceived(),
+            (unsigned long long)c.dropped, s.p50 / 1e3, s.p99 / 1e3, s.p999 / 1e3, s.max / 1e3,
+            c.open ? "false" : "true", i + 1 < conns.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: omt_loadgen <host> [port] [--group COUNT:MODE[:SUBS]]... [--rcvbuf bytes]\n"
+        "                   [--duration sec] [--interval sec] [--json path]\n"
+        "       MODE: full | throttle=MBPS | stall | stall=MS/PERIOD_MS\n"
+        "       SUBS: video+audio+preview+metadata (default video+audio)\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* host = nullptr;
+    int port = 6500;
+    std::vector<Group> groups;
+    int rcvbuf = 0;
+    double durationSec = 10;
+    double intervalSec = 1;
+    const char* jsonPath = nullptr;
+    groups.reserve((size_t)argc);
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--group") && hasValue) {
+            Group g;
+            if (!parseGroup(argv[++i], &g)) { usage(); return 2; }
+            groups.push_back(g);
+        } else if (!std::strcmp(a, "--rcvbuf") && hasValue) rcvbuf = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--duration") && hasValue) durationSec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--interval") && hasValue) intervalSec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--json") && hasValue) jsonPath = argv[++i];
+        else if (a[0] == '-') { usage(); return 2; }
+        else if (!host) host = a;
+        else port = std::atoi(a);
+    }
+    if (!host || port <= 0 || intervalSec <= 0) { usage(); return 2; }
+    if (groups.empty()) {
+        groups.emplace_back();
+        parseGroup("1:full", &groups.back());
+    }
+    int total = 0;
+    for (const Group& g : groups) total += g.count;
+    if (total > MAX_CONNECTIONS) {
+        LOGE("%d connections requested; at most %d", total, MAX_CONNECTIONS);
+        return 2;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    if (!loop.valid()) return 1;
+    ClockSync clock;
+    Totals totals;
+    std::vector<std::unique_ptr<Connection>> conns;
+    bool paced = false;
+
+    // Unsubscribed control connection: clock exchanges never queue behind frames.
+    ReceiverConfig controlConfig;
+    controlConfig.host = host;
+    controlConfig.port = port;
+    controlConfig.video = false;
+    Receiver control(loop, controlConfig, [&](const FrameHeader& h, const uint8_t* payload, size_t len) {
+        int64_t t1, t2, t3;
+        if (h.type == FRAME_METADATA && parseClockReply((const char*)payload, len, &t1, &t2, &t3))
+            clock.addSample(t1, t2, t3, monotonicUs());
+    });
+    if (!control.connect()) return 1;
+
+    for (const Group& g : groups) {
+        paced |= g.mode == ReadMode::Throttle || g.mode == ReadMode::StallPeriodic;
+        for (int i = 0; i < g.count; i++) {
+            auto c = std::make_unique<Connection>();
+            Connection* conn = c.get();
+            conn->id = (int)conns.size();
+            conn->group = &g;
+            ReceiverConfig cfg;
+            cfg.host = host;
+            cfg.port = port;
+            cfg.video = g.video;
+            cfg.audio = g.audio;
+            cfg.preview = g.preview;
+            cfg.metadata = g.metadata;
+            cfg.recvBufferBytes = rcvbuf;
+            conn->rx = std::make_unique<Receiver>(loop, cfg,
+                [conn, &totals, &clock](const FrameHeader& h, const uint8_t* payload, size_t len) {
+                    if (h.type == FRAME_VIDEO) onVideo(*conn, totals, clock, h, payload, len);
+                    else if (h.type == FRAME_AUDIO) conn->audioFrames++;
+                });
+            conn->rx->setOnClosed([conn] {
+                conn->open = false;
+                conn->closedNs = nowNs();
+                LOGW("connection %d closed by the sender", conn->id);
+            });
+            if (!conn->rx->connect()) {
+                LOGE("connection %d failed", conn->id);
+                return 1;
+            }
+            conn->open = true;
+            conn->startNs = nowNs();
+            applyMode(*conn, conn->startNs);
+            conns.push_back(std::move(c));
+        }
+    }
+    LOGI("%d receivers connected to %s:%d", total, host, port);
+
+    const int64_t startNs = nowNs();
+    int64_t intervalStart = startNs;
+    int64_t nextClockRequestUs = 0;
+    int clockSamples = 0;
+    uint64_t droppedAtInterval = 0;
+    LatencyHistogram intervalLatency;
+    while (!s_stop.load() && nowNs() - startNs < (int64_t)(durationSec * 1e9)) {
+        loop.runOnce(paced ? 1 : 50);
+        const int64_t now = nowNs();
+        for (auto& c : conns) applyMode(*c, now);
+
+        const int64_t nowUs = now / 1000;
+        if (control.connected() && nowUs >= nextClockRequestUs) {
+            char xml[128];
+            int n = formatClockRequest(xml, sizeof(xml), monotonicUs());
+            if (n > 0) control.sendMetadata(xml, (size_t)n);
+            nextClockRequestUs = nowUs + (clockSamples++ < ClockSync::WINDOW ? CLOCK_REQUEST_FAST_US : CLOCK_REQUEST_US);
+        }
+
+        if (now - intervalStart >= (int64_t)(intervalSec * 1e9)) {
+            const double seconds = (now - intervalStart) / 1e9;
+            double fpsMin = 1e9, fpsSum = 0;
+            int open = 0, videoConns = 0;
+            for (auto& c : conns) {
+                open += c->open;
+                if (!c->group->video) continue;
+                const double fps = c->intervalFrames / seconds;
+                fpsMin = std::min(fpsMin, fps);
+                fpsSum += fps;
+                videoConns++;
+                c->intervalFrames = 0;
+            }
+            HistogramSnapshot s = totals.latency.snapshot();
+            std::printf("[load] %5.1fs open %d/%d | fps min %.2f avg %.2f | dropped %llu | latency p50=%.2f "
+                        "p99=%.2f max=%.2fms | clock rtt %lldus\n",
+                        (now - startNs) / 1e9, open, total, videoConns ? fpsMin : 0.0,
+                        videoConns ? fpsSum / videoConns : 0.0,
+                        (unsigned long long)(totals.dropped - droppedAtInterval), s.p50 / 1e6, s.p99 / 1e6,
+                        s.max / 1e6, (long long)clock.rttUs());
+            std::fflush(stdout);
+            droppedAtInterval = totals.dropped;
+            totals.latency.reset();
+            intervalStart = now;
+        }
+    }
+
+    const int64_t endNs = nowNs();
+    printTable(conns, endNs);
+    if (!clock.valid()) LOGW("No clock replies from the sender; latency not measured");
+    if (jsonPath && !writeJson(jsonPath, conns, endNs)) LOGE("Cannot write %s", jsonPath);
+    for (auto& c : conns) c->rx->close();
+    control.close();
+    return 0;
+}
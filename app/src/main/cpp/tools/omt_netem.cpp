@@ -0,0 +1,581 @@
+/**
+ * omt_netem — TCP impairment proxy for reproducing congested Wi-Fi between an
+ * OMT sender and its receivers on one workstation.
+ *
+ *   omt_netem <sender-host> [sender-port] [--listen port] [--rate MBPS]
+ *             [--step SEC:MBPS]... [--burst bytes] [--delay ms] [--jitter ms]
+ *             [--stall MS/PERIOD_MS] [--stall-random MS/MEAN_GAP_MS] [--queue bytes]
+ *             [--sndbuf bytes] [--seed n] [--log file.csv] [--duration sec] [--interval sec]
+ *
+ * Every accepted client gets its own upstream connection to the sender. The
+ * sender → receiver direction is shaped like one shared link:
+ *
+ *   --rate     token bucket shared by all connections (Mbit/s, 0 = unlimited);
+ *              --step changes it at a given second, e.g. --step 10:8 --step 20:40
+ *   --delay    one-way latency; --jitter adds a seeded uniform ±ms, never reordering
+ *   --stall    link blackouts: MS out of every PERIOD_MS, or --stall-random with
+ *              exponentially distributed gaps
+ *   --queue    bytes the proxy holds per connection before it stops reading from
+ *              the sender — past this point backpressure reaches the sender's
+ *              socket and its slow-client drop logic
+ *
+ * The receiver → sender direction (subscriptions, clock requests, tally) only
+ * gets --delay, so clock exchanges see a symmetric RTT. Jitter and random
+ * stalls come from one seeded generator; the same flags give the same
+ * impairment schedule on every run.
+ *
+ * The shaped stream is tracked frame by frame; --log writes one CSV row per
+ * frame with the time its last byte came in from the sender, the time it was
+ * fully passed on, and the proxy queue depth on arrival. Every interval prints
+ * per-connection throughput, frame delay through the proxy and time the
+ * sender was held back.
+ */
+#define LOG_TAG "omt_netem"
+#include "omt_histogram.h"
+#include "omt_log.h"
+#include "omt_loop.h"
+#include "omt_net.h"
+#include "omt_protocol.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+constexpr size_t DEFAULT_QUEUE_BYTES = 4u << 20;
+constexpr size_t UPSTREAM_QUEUE_BYTES = 256u << 10;
+constexpr size_t MIN_BURST_BYTES = 16u << 10;
+constexpr size_t MAX_IO_BYTES = 256u << 10; // per recv/send call, so one connection cannot hog a tick
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+int64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct Options {
+    const char* host = nullptr;
+    int port = 6500;
+    int listenPort = 6600;
+    double mbps = 0;
+    std::vector<std::pair<double, double>> steps; // (second, Mbit/s)
+    size_t burst = 0;
+    double delayMs = 0;
+    double jitterMs = 0;
+    int stallMs = 0;
+    int stallPeriodMs = 0;
+    int randomStallMs = 0;
+    int randomStallGapMs = 0;
+    size_t queueBytes = DEFAULT_QUEUE_BYTES;
+    int sndbuf = 0;
+    unsigned seed = 1;
+    const char* logPath = nullptr;
+    double durationSec = 0;
+    double intervalSec = 1;
+};
+
+/** Shared link state: token bucket, blackout schedule and the seeded generator. */
+class Link {
+public:
+    explicit Link(const Options& o) : m_opt(o), m_rng(o.seed), m_bytesPerNs(o.mbps * 1e6 / 8 / 1e9) { }
+
+    void start(int64_t now) {
+        m_startNs = m_lastRefillNs = now;
+        m_tokens = (double)burst();
+        if (m_opt.stallPeriodMs > 0) {
+            m_nextStallNs = now + (int64_t)(m_opt.stallPeriodMs - m_opt.stallMs) * 1000000;
+        } else if (m_opt.randomStallMs > 0) {
+            m_nextStallNs = now + randomGapNs();
+        }
+    }
+
+    /** Advance the clock: apply --step changes, stall windows and refill tokens. */
+    void tick(int64_t now) {
+        while (m_step < m_opt.steps.size() && now - m_startNs >= (int64_t)(m_opt.steps[m_step].first * 1e9)) {
+            m_bytesPerNs = m_opt.steps[m_step].second * 1e6 / 8 / 1e9;
+            LOGI("rate -> %.1f Mbit/s", m_opt.steps[m_step].second);
+            m_step++;
+        }
+        if (m_nextStallNs > 0 && now >= m_nextStallNs) {
+            const int stallMs = m_opt.stallPeriodMs > 0 ? m_opt.stallMs : m_opt.randomStallMs;
+            m_stallEndNs = m_nextStallNs + (int64_t)stallMs * 1000000;
+            m_nextStallNs = m_opt.stallPeriodMs > 0 ? m_nextStallNs + (int64_t)m_opt.stallPeriodMs * 1000000
+                                                    : m_stallEndNs + randomGapNs();
+            m_stalls++;
+        }
+        if (stalled(now)) {
+            m_tokens = 0; // nothing accumulates while the link is down
+        } else if (m_bytesPerNs > 0) {
+            m_tokens = std::min((double)burst(), m_tokens + (now - m_lastRefillNs) * m_bytesPerNs);
+        }
+        m_lastRefillNs = now;
+    }
+
+    bool stalled(int64_t now) const { return now < m_stallEndNs; }
+    bool unlimited() const { return m_bytesPerNs <= 0; }
+    size_t tokens() const { return unlimited() ? SIZE_MAX : (size_t)m_tokens; }
+    void spend(size_t n) {
+        if (!unlimited()) m_tokens -= (double)n;
+    }
+
+    /** Release time for bytes arriving now: delay ± jitter, kept in order per connection. */
+    int64_t releaseNs(int64_t now, int64_t previousRelease, bool withJitter) {
+        double ms = m_opt.delayMs;
+        if (withJitter && m_opt.jitterMs > 0) ms += std::uniform_real_distribution<double>(-m_opt.jitterMs, m_opt.jitterMs)(m_rng);
+        return std::max(previousRelease, now + (int64_t)(std::max(0.0, ms) * 1e6));
+    }
+
+    uint64_t stalls() const { return m_stalls; }
+    double mbps() const { return m_bytesPerNs * 8 * 1e9 / 1e6; }
+
+private:
+    size_t burst() const {
+        if (m_opt.burst > 0) return m_opt.burst;
+        return std::max(MIN_BURST_BYTES, (size_t)(m_bytesPerNs * 2e6)); // ~2 ms of line rate
+    }
+    int64_t randomGapNs() {
+        return (int64_t)(std::exponential_distribution<double>(1.0 / m_opt.randomStallGapMs)(m_rng) * 1e6);
+    }
+
+    const Options& m_opt;
+    std::mt19937 m_rng;
+    double m_bytesPerNs;
+    double m_tokens = 0;
+    size_t m_step = 0;
+    int64_t m_startNs = 0;
+    int64_t m_lastRefillNs = 0;
+    int64_t m_nextStallNs = 0;
+    int64_t m_stallEndNs = 0;
+    uint64_t m_stalls = 0;
+};
+
+/**
+ * One direction of a proxied connection: a byte ring filled from src and
+ * drained into dst once each chunk's release time has passed.
+ */
+struct Pipe {
+    int src = -1;
+    int dst = -1;
+    bool shaped = false;
+    std::vector<uint8_t> ring;
+    uint64_t in = 0;  // total bytes read from src
+    uint64_t out = 0; // total bytes written to dst
+    struct Mark {
+        uint64_t end;
+        int64_t releaseNs;
+    };
+    std::deque<Mark> marks;
+    bool srcEof = false;
+    bool dstShut = false;
+
+    // Held-back accounting: time the queue was full and src left unread.
+    bool full = false;
+    int64_t fullSinceNs = 0;
+
+    size_t queued() const { return (size_t)(in - out); }
+    size_t space() const { return ring.size() - queued(); }
+
+    /** Bytes releasable at now, up to the last mark that has come due. */
+    size_t releasable(int64_t now) {
+        while (!marks.empty() && marks.front().end <= out) marks.pop_front();
+        uint64_t until = out;
+        for (const Mark& m : marks) {
+            if (m.releaseNs > now) break;
+            until = m.end;
+        }
+        return (size_t)(until - out);
+    }
+
+    /** Copy n bytes starting at stream offset pos out of the ring (for header peeks). */
+    void peek(uint64_t pos, uint8_t* dst, size_t n) const {
+        for (size_t i = 0; i < n; i++) dst[i] = ring[(pos + i) % ring.size()];
+    }
+};
+
+/** Frames seen on the shaped direction, matched on the way out by byte offset. */
+struct FrameRecord {
+    uint64_t seq;
+    int type;
+    int64_t timestamp;
+    size_t bytes;
+    uint64_t end;
+    int64_t inNs;
+    size_t queuedOnArrival;
+};
+
+struct Session {
+    int id = 0;
+    int client = -1;
+    int upstream = -1;
+    Pipe down; // sender -> receiver, shaped
+    Pipe up;   // receiver -> sender, delay only
+    bool closed = false;
+
+    uint64_t nextFrameStart = 0;
+    uint64_t frameSeq = 0;
+    std::deque<FrameRecord> inFlight;
+    LatencyHistogram frameDelay;
+    uint64_t intervalBytes = 0;
+    uint64_t intervalFrames = 0;
+    int64_t intervalHeldNs = 0;
+};
+
+class Proxy {
+public:
+    Proxy(EventLoop& loop, const Options& o, FILE* log) : m_loop(loop), m_opt(o), m_link(o), m_log(log) { }
+
+    bool listen() {
+        m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_listenFd < 0) return false;
+        int one = 1;
+        setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)m_opt.listenPort);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(m_listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(m_listenFd, 64) != 0) {
+            LOGE("Cannot listen on :%d: %s", m_opt.listenPort, std::strerror(errno));
+            return false;
+        }
+        m_startNs = nowNs();
+        m_link.start(m_startNs);
+        return m_loop.add(m_listenFd, LOOP_READ, [this](uint32_t) { accept(); });
+    }
+
+    /** Move due bytes and refresh read interest; called every loop iteration. */
+    void pump(int64_t now) {
+        m_link.tick(now);
+        const size_t n = m_sessions.size();
+        // Rotate the starting connection so the shared bucket is split fairly.
+        for (size_t k = 0; k < n; k++) {
+            Session& s = *m_sessions[(m_rotate + k) % n];
+            if (s.closed) continue;
+            drain(s, s.down, now);
+            if (!s.closed) drain(s, s.up, now);
+            if (!s.closed) updateInterest(s, now);
+        }
+        if (n) m_rotate = (m_rotate + 1) % n;
+        m_sessions.erase(std::remove_if(m_sessions.begin(), m_sessions.end(),
+                                        [](const std::unique_ptr<Session>& s) { return s->closed; }),
+                         m_sessions.end());
+    }
+
+    void report(int64_t now, double seconds) {
+        std::printf("[netem] %5.1fs link %s%.1f Mbit/s, stalls %llu | %zu connection(s)\n", (now - m_startNs) / 1e9,
+                    m_link.unlimited() ? "unlimited " : "", m_link.unlimited() ? 0.0 : m_link.mbps(),
+                    (unsigned long long)m_link.stalls(), m_sessions.size());
+        for (auto& sp : m_sessions) {
+            Session& s = *sp;
+            int64_t held = s.intervalHeldNs + (s.down.full ? now - s.down.fullSinceNs : 0);
+            HistogramSnapshot d = s.frameDelay.snapshot();
+            std::printf("  #%d %7.2f Mbit/s %6.1f frames/s | queue %7zu B | delay p50=%.1f p99=%.1f max=%.1fms | "
+                        "sender held %.0f%%\n",
+                        s.id, s.intervalBytes * 8 / seconds / 1e6, s.intervalFrames / seconds, s.down.queued(),
+                        d.p50 / 1e6, d.p99 / 1e6, d.max / 1e6, 100.0 * held / (seconds * 1e9));
+            s.intervalBytes = s.intervalFrames = 0;
+            // A hold still in progress was counted up to now; the rest lands in the next interval.
+            s.intervalHeldNs = s.down.full ? -(now - s.down.fullSinceNs) : 0;
+            s.frameDelay.reset();
+        }
+        std::fflush(stdout);
+    }
+
+    void closeAll() {
+        for (auto& s : m_sessions) close(*s, nullptr);
+        m_sessions.clear();
+        if (m_listenFd >= 0) {
+            m_loop.remove(m_listenFd);
+            ::close(m_listenFd);
+            m_listenFd = -1;
+        }
+    }
+
+    /** Whether any bytes wait on a timer rather than on socket readiness. */
+    bool pending() const {
+        for (const auto& s : m_sessions)
+            if (s->down.queued() || s->up.queued()) return true;
+        return false;
+    }
+
+private:
+    void accept() {
+        for (;;) {
+            sockaddr_in peer{};
+            socklen_t len = sizeof(peer);
+            int fd = accept4(m_listenFd, (sockaddr*)&peer, &len, SOCK_CLOEXEC);
+            if (fd < 0) return;
+            int upstream = tcpConnect(m_opt.host, m_opt.port, 3000);
+            if (upstream < 0) {
+                LOGW("Upstream %s:%d unreachable; dropping client", m_opt.host, m_opt.port);
+                ::close(fd);
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (m_opt.sndbuf > 0) setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &m_opt.sndbuf, sizeof(m_opt.sndbuf));
+
+            auto s = std::make_unique<Session>();
+            s->id = m_nextId++;
+            s->client = fd;
+            s->upstream = upstream;
+            s->down.src = upstream;
+            s->down.dst = fd;
+            s->down.shaped = true;
+            s->down.ring.resize(m_opt.queueBytes);
+            s->up.src = fd;
+            s->up.dst = upstream;
+            s->up.ring.resize(UPSTREAM_QUEUE_BYTES);
+            Session* raw = s.get();
+            m_loop.add(fd, LOOP_READ, [this, raw](uint32_t ev) { onEvent(*raw, raw->up, ev); });
+            m_loop.add(upstream, LOOP_READ, [this, raw](uint32_t ev) { onEvent(*raw, raw->down, ev); });
+            LOGI("#%d %s:%d <-> %s:%d", s->id, inet_ntoa(peer.sin_addr), ntohs(peer.sin_port), m_opt.host, m_opt.port);
+            m_sessions.push_back(std::move(s));
+        }
+    }
+
+    void onEvent(Session& s, Pipe& p, uint32_t events) {
+        if (s.closed) return;
+        if (events & LOOP_READ) {
+            fill(s, p, nowNs());
+        } else if (events & (LOOP_ERROR | LOOP_HANGUP)) {
+            close(s, "hangup");
+        }
+    }
+
+    void fill(Session& s, Pipe& p, int64_t now) {
+        size_t space = std::min(p.space(), MAX_IO_BYTES);
+        if (space == 0) return;
+        const size_t at = (size_t)(p.in % p.ring.size());
+        const size_t contiguous = std::min(space, p.ring.size() - at);
+        ssize_t n = recv(p.src, p.ring.data() + at, contiguous, MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        if (n <= 0) {
+            p.srcEof = true;
+            m_loop.modify(p.src, 0);
+            if (n < 0 || p.queued() == 0) close(s, n < 0 ? std::strerror(errno) : "closed");
+            return;
+        }
+        const int64_t previous = p.marks.empty() ? 0 : p.marks.back().releaseNs;
+        p.in += (uint64_t)n;
+        p.marks.push_back({p.in, m_link.releaseNs(now, previous, p.shaped)});
+        if (p.shaped) trackArrivals(s, now);
+    }
+
+    /** Record every frame whose last byte has now arrived from the sender. */
+    void trackArrivals(Session& s, int64_t now) {
+        Pipe& p = s.down;
+        for (;;) {
+            if (p.in < s.nextFrameStart + HEADER_SIZE) return;
+            uint8_t raw[HEADER_SIZE];
+            p.peek(s.nextFrameStart, raw, sizeof(raw));
+            FrameHeader h;
+            if (!parseFrameHeader(raw, &h) || h.dataLength < 0) {
+                LOGW("#%d: not an OMT stream; frame tracking off", s.id);
+                s.nextFrameStart = UINT64_MAX / 2;
+                return;
+            }
+            const uint64_t end = s.nextFrameStart + HEADER_SIZE + (uint64_t)h.dataLength;
+            if (p.in < end) return;
+            s.inFlight.push_back({s.frameSeq++, h.type, h.timestamp, HEADER_SIZE + (size_t)h.dataLength, end, now, (size_t)(p.in - s.nextFrameStart)});
+            s.nextFrameStart = end;
+        }
+    }
+
+    void drain(Session& s, Pipe& p, int64_t now) {
+        size_t due = p.releasable(now);
+        if (p.shaped) {
+            if (m_link.stalled(now)) return;
+            due = std::min(due, m_link.tokens());
+        }
+        due = std::min(due, MAX_IO_BYTES);
+        while (due > 0) {
+            const size_t at = (size_t)(p.out % p.ring.size());
+            const size_t contiguous = std::min(due, p.ring.size() - at);
+            ssize_t n = send(p.dst, p.ring.data() + at, contiguous, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) break;
+            if (n <= 0) {
+                close(s, std::strerror(errno));
+                return;
+            }
+            p.out += (uint64_t)n;
+            due -= (size_t)n;
+            if (p.shaped) {
+                m_link.spend((size_t)n);
+                s.intervalBytes += (uint64_t)n;
+                trackDepartures(s, now);
+            }
+            if ((size_t)n < contiguous) break;
+        }
+        if (p.srcEof && p.queued() == 0 && !p.dstShut) {
+            shutdown(p.dst, SHUT_WR);
+            p.dstShut = true;
+            if (s.down.dstShut && s.up.dstShut) close(s, nullptr);
+        }
+    }
+
+    void trackDepartures(Session& s, int64_t now) {
+        while (!s.inFlight.empty() && s.inFlight.front().end <= s.down.out) {
+            const FrameRecord& f = s.inFlight.front();
+            s.frameDelay.record((uint64_t)(now - f.inNs));
+            s.intervalFrames++;
+            if (m_log) {
+                std::fprintf(m_log, "%d,%llu,%d,%lld,%zu,%.3f,%.3f,%.3f,%zu\n", s.id, (unsigned long long)f.seq,
+                             f.type, (long long)f.timestamp, f.bytes,
+                             (f.inNs - m_startNs) / 1e6, (now - m_startNs) / 1e6, (now - f.inNs) / 1e6,
+                             f.queuedOnArrival);
+            }
+            s.inFlight.pop_front();
+        }
+    }
+
+    /** Stop reading a source whose ring is full: from there the sender's own socket backs up. */
+    void updateInterest(Session& s, int64_t now) {
+        for (Pipe* p : {&s.down, &s.up}) {
+            if (p->srcEof) continue;
+            const bool full = p->space() == 0;
+            if (full == p->full) continue;
+            p->full = full;
+            m_loop.modify(p->src, full ? 0 : LOOP_READ);
+            if (p != &s.down) continue;
+            if (full) {
+                p->fullSinceNs = now;
+            } else {
+                s.intervalHeldNs += now - p->fullSinceNs;
+            }
+        }
+    }
+
+    void close(Session& s, const char* why) {
+        if (s.closed) return;
+        s.closed = true;
+        if (why) LOGI("#%d closed: %s", s.id, why);
+        for (int fd : {s.client, s.upstream}) {
+            m_loop.remove(fd);
+            ::close(fd);
+        }
+    }
+
+    EventLoop& m_loop;
+    const Options& m_opt;
+    Link m_link;
+    FILE* m_log;
+    int m_listenFd = -1;
+    int m_nextId = 0;
+    size_t m_rotate = 0;
+    int64_t m_startNs = 0;
+    std::vector<std::unique_ptr<Session>> m_sessions;
+};
+
+bool parsePair(const char* text, int* a, int* b) {
+    return std::sscanf(text, "%d/%d", a, b) == 2 && *a > 0 && *b > 0;
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: omt_netem <sender-host> [sender-port] [--listen port] [--rate MBPS] [--step SEC:MBPS]...\n"
+        "                 [--burst bytes] [--delay ms] [--jitter ms] [--stall MS/PERIOD_MS]\n"
+        "                 [--stall-random MS/MEAN_GAP_MS] [--queue bytes] [--sndbuf bytes] [--seed n]\n"
+        "                 [--log file.csv] [--duration sec] [--interval sec]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--listen") && hasValue) o.listenPort = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--rate") && hasValue) o.mbps = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--step") && hasValue) {
+            double sec, mbps;
+            if (std::sscanf(argv[++i], "%lf:%lf", &sec, &mbps) != 2 || sec < 0 || mbps < 0) { usage(); return 2; }
+            o.steps.emplace_back(sec, mbps);
+        }
+        else if (!std::strcmp(a, "--burst") && hasValue) o.burst = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(a, "--delay") && hasValue) o.delayMs = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--jitter") && hasValue) o.jitterMs = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--stall") && hasValue) {
+            if (!parsePair(argv[++i], &o.stallMs, &o.stallPeriodMs) || o.stallPeriodMs <= o.stallMs) { usage(); return 2; }
+        }
+        else if (!std::strcmp(a, "--stall-random") && hasValue) {
+            if (!parsePair(argv[++i], &o.randomStallMs, &o.randomStallGapMs)) { usage(); return 2; }
+        }
+        else if (!std::strcmp(a, "--queue") && hasValue) o.queueBytes = (size_t)std::atol(argv[++i]);
+        else if (!std::strcmp(a, "--sndbuf") && hasValue) o.sndbuf = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--seed") && hasValue) o.seed = (unsigned)std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--log") && hasValue) o.logPath = argv[++i];
+        else if (!std::strcmp(a, "--duration") && hasValue) o.durationSec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--interval") && hasValue) o.intervalSec = std::atof(argv[++i]);
+        else if (a[0] == '-') { usage(); return 2; }
+        else if (!o.host) o.host = a;
+        else o.port = std::atoi(argv[i]);
+    }
+    if (!o.host || o.port <= 0 || o.listenPort <= 0 || o.queueBytes < (size_t)HEADER_SIZE || o.intervalSec <= 0) {
+        usage();
+        return 2;
+    }
+    if (o.stallPeriodMs > 0 && o.randomStallMs > 0) {
+        LOGE("--stall and --stall-random are exclusive");
+        return 2;
+    }
+    std::sort(o.steps.begin(), o.steps.end());
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    FILE* log = nullptr;
+    if (o.logPath) {
+        log = std::fopen(o.logPath, "w");
+        if (!log) {
+            LOGE("Cannot open %s: %s", o.logPath, std::strerror(errno));
+            return 1;
+        }
+        std::fprintf(log, "conn,frame,type,timestamp,bytes,in_ms,out_ms,delay_ms,queued_bytes\n");
+    }
+
+    EventLoop loop;
+    if (!loop.valid()) return 1;
+    Proxy proxy(loop, o, log);
+    if (!proxy.listen()) return 1;
+    LOGI("Proxying :%d -> %s:%d", o.listenPort, o.host, o.port);
+
+    const int64_t startNs = nowNs();
+    int64_t intervalStart = startNs;
+    while (!s_stop.load() && (o.durationSec <= 0 || nowNs() - startNs < (int64_t)(o.durationSec * 1e9))) {
+        // Shaping runs on a 1 ms tick while anything is queued; idle, only sockets wake us.
+        loop.runOnce(proxy.pending() ? 1 : 50);
+        const int64_t now = nowNs();
+        proxy.pump(now);
+        if (now - intervalStart >= (int64_t)(o.intervalSec * 1e9)) {
+            proxy.report(now, (now - intervalStart) / 1e9);
+            intervalStart = now;
+        }
+    }
+    proxy.closeAll();
+    if (log) std::fclose(log);
+    return 0;
+}
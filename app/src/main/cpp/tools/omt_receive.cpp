@@ -0,0 +1,439 @@
+/**
+ * omt_receive — command-line OMT receiver for Linux hosts.
+ *
+ * Subscribes to video and audio on an OMT source (the app, vMix, or
+ * omt_bench_* senders), optionally dumps the elementary streams, and reports
+ * throughput and arrival jitter every interval:
+ *
+ *   --video FILE   video payloads back to back (NV12 plays with ffplay -f rawvideo;
+ *                  VMX1 frames are not self-delimiting, use --stream to keep them)
+ *   --audio FILE   FPA1 payloads (planar float32 per frame, or interleaved f32le
+ *                  with --interleave)
+ *   --stream FILE  the OMT byte stream as read off the socket (omt_bench_decode input)
+ *   --record BASE  video and audio frames to indexed segments BASE-0001.omt(.idx)
+ *                  through the async recorder (core/omt_record), as the app does
+ *
+ * FILE may be "-" for stdout, in which case reports go to stderr.
+ *
+ * --shm asks a sender on the same host for its shared-memory ring (omt_shm):
+ * video and audio are then read in place from the mapping, with no socket
+ * copies, while metadata stays on TCP. Other senders ignore the request.
+ * --multicast likewise asks to join the sender's omt_multicast group (omt_source
+ * --multicast) and reports the frames it carried, lost and FEC-repaired.
+ * --nvlz accepts NV12 as NVLZ (omt_lz4) from senders that offer it; --video
+ * still gets NV12, expanded on arrival.
+ *
+ * Jitter is measured against the sender's own timestamps: for consecutive
+ * frames of a stream, |Δarrival − Δtimestamp| is the delay variation the
+ * network and the sender's write path added. Gaps in the video timestamps
+ * longer than 1.5 frame periods are counted as missed frames.
+ *
+ *   omt_receive <host> [port] [--video FILE] [--audio FILE] [--stream FILE]
+ *               [--record BASE] [--interleave] [--no-audio] [--shm] [--multicast]
+ *               [--nvlz] [--duration sec] [--interval sec]
+ */
+#define LOG_TAG "omt_receive"
+#include "omt_histogram.h"
+#include "omt_log.h"
+#include "omt_loop.h"
+#include "omt_lz4.h"
+#include "omt_protocol.h"
+#include "omt_receiver.h"
+#include "omt_record.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+constexpr size_t FILE_BUFFER_BYTES = 4u << 20;
+constexpr int RECV_BUFFER_BYTES = 4 << 20;
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+int64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+const char* codecName(uint32_t codec) {
+    switch (codec) {
+    case CODEC_VMX1: return "VMX1";
+    case CODEC_NV12: return "NV12";
+    case CODEC_NVLZ: return "NVLZ";
+    case CODEC_FPA1: return "FPA1";
+    default: return "????";
+    }
+}
+
+/** Delay variation of one stream relative to the sender's timestamps. */
+struct JitterTracker {
+    int64_t lastArrivalNs = -1;
+    int64_t lastTimestamp = 0; // 100 ns units
+    double smoothedNs = 0;     // RFC 3550 interarrival jitter estimate
+    uint64_t lastDeviationNs = 0;
+    LatencyHistogram deviation;
+
+    /** Returns the sender timestamp delta in ns, or -1 for the first frame. */
+    int64_t add(int64_t arrivalNs, int64_t timestamp) {
+        int64_t tsDeltaNs = -1;
+        if (lastArrivalNs >= 0) {
+            tsDeltaNs = (timestamp - lastTimestamp) * 100;
+            int64_t d = (arrivalNs - lastArrivalNs) - tsDeltaNs;
+            lastDeviationNs = (uint64_t)(d < 0 ? -d : d);
+            deviation.record(lastDeviationNs);
+            smoothedNs += ((double)lastDeviationNs - smoothedNs) / 16.0;
+        }
+        lastArrivalNs = arrivalNs;
+        lastTimestamp = timestamp;
+        return tsDeltaNs;
+    }
+};
+
+struct StreamCounters {
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+};
+
+struct State {
+    FILE* videoOut = nullptr;
+    FILE* audioOut = nullptr;
+    FILE* streamOut = nullptr;
+    FILE* report = stdout;
+    bool interleave = false;
+    bool writeFailed = false;
+
+    VideoHeader lastVideo;
+    AudioHeader lastAudio;
+    bool haveVideo = false;
+    bool haveAudio = false;
+    bool vmxNoted = false;
+    bool nvlzFailed = false;
+
+    StreamCounters video, audio, metadata;
+    StreamCounters intervalVideo, intervalAudio;
+    uint64_t missedFrames = 0;
+    uint64_t intervalMissed = 0;
+    JitterTracker videoJitter, audioJitter;
+    LatencyHistogram intervalVideoDeviation;
+
+    std::vector<float> interleaved;
+    std::vector<uint8_t> nv12; // NVLZ frames expanded for --video
+};
+
+bool writeOut(State& st, FILE* f, const void* data, size_t len) {
+    if (!f || len == 0) return true;
+    if (std::fwrite(data, 1, len, f) == len) return true;
+    if (!st.writeFailed) LOGE("Write failed: %s", std::strerror(errno));
+    st.writeFailed = true;
+    return false;
+}
+
+void writeStreamFrame(State& st, const FrameHeader& h, const uint8_t* payload, size_t len) {
+    if (!st.streamOut) return;
+    uint8_t header[HEADER_SIZE];
+    writeFrameHeader(header, h);
+    if (writeOut(st, st.streamOut, header, sizeof(header)))
+        writeOut(st, st.streamOut, payload, len);
+}
+
+void onVideo(State& st, const FrameHeader& h, const uint8_t* payload, size_t len, int64_t arrivalNs) {
+    if (len < (size_t)VIDEO_EXT_HEADER_SIZE) return;
+    VideoHeader vh;
+    parseVideoHeader(payload, &vh);
+    if (!st.haveVideo || vh.codec != st.lastVideo.codec || vh.width != st.lastVideo.width ||
+        vh.height != st.lastVideo.height) {
+        LOGI("Video %s %dx%d @ %d/%d", codecName(vh.codec), vh.width, vh.height, vh.frameRateN, vh.frameRateD);
+        st.haveVideo = true;
+    }
+    st.lastVideo = vh;
+    st.video.frames++;
+    st.video.bytes += HEADER_SIZE + len;
+    st.intervalVideo.frames++;
+    st.intervalVideo.bytes += HEADER_SIZE + len;
+
+    int64_t tsDeltaNs = st.videoJitter.add(arrivalNs, h.timestamp);
+    if (tsDeltaNs >= 0) {
+        st.intervalVideoDeviation.record(st.videoJitter.lastDeviationNs);
+        if (vh.frameRateN > 0 && vh.frameRateD > 0) {
+            double periodNs = 1e9 * vh.frameRateD / vh.frameRateN;
+            if ((double)tsDeltaNs > 1.5 * periodNs) {
+                uint64_t missed = (uint64_t)std::llround((double)tsDeltaNs / periodNs) - 1;
+                st.missedFrames += missed;
+                st.intervalMissed += missed;
+            }
+        }
+    }
+
+    if (st.videoOut) {
+        if (vh.codec == CODEC_VMX1 && !st.vmxNoted) {
+            LOGW("VMX1 frames are written back to back without framing; use --stream to replay them");
+            st.vmxNoted = true;
+        }
+        if (vh.codec == CODEC_NVLZ) {
+            const size_t ySize = (size_t)vh.width * vh.height;
+            st.nv12.resize(ySize + (size_t)vh.width * (vh.height / 2));
+            if (unpackNvlz(payload + VIDEO_EXT_HEADER_SIZE, len - VIDEO_EXT_HEADER_SIZE, vh.width, vh.height,
+                           st.nv12.data(), st.nv12.data() + ySize)) {
+                writeOut(st, st.videoOut, st.nv12.data(), st.nv12.size());
+            } else if (!st.nvlzFailed) {
+                LOGW("Corrupt NVLZ frame %dx%d (%zu bytes); not written", vh.width, vh.height, len);
+                st.nvlzFailed = true;
+            }
+            return;
+        }
+        writeOut(st, st.videoOut, payload + VIDEO_EXT_HEADER_SIZE, len - VIDEO_EXT_HEADER_SIZE);
+    }
+}
+
+void onAudio(State& st, const FrameHeader& h, const uint8_t* payload, size_t len, int64_t arrivalNs) {
+    if (len < (size_t)AUDIO_EXT_HEADER_SIZE) return;
+    AudioHeader ah;
+    parseAudioHeader(payload, &ah);
+    if (!st.haveAudio || ah.sampleRate != st.lastAudio.sampleRate || ah.channels != st.lastAudio.channels) {
+        LOGI("Audio %s %d Hz %d ch, %d samples/frame", codecName(ah.codec), ah.sampleRate, ah.channels,
+             ah.samplesPerChannel);
+        st.haveAudio = true;
+    }
+    st.lastAudio = ah;
+    st.audio.frames++;
+    st.audio.bytes += HEADER_SIZE + len;
+    st.intervalAudio.frames++;
+    st.intervalAudio.bytes += HEADER_SIZE + len;
+    st.audioJitter.add(arrivalNs, h.timestamp);
+
+    if (!st.audioOut) return;
+    const uint8_t* samples = payload + AUDIO_EXT_HEADER_SIZE;
+    const size_t sampleBytes = len - AUDIO_EXT_HEADER_SIZE;
+    const int channels = ah.channels;
+    const int perChannel = ah.samplesPerChannel;
+    if (!st.interleave || ah.codec != CODEC_FPA1 || channels <= 1 || perChannel <= 0 ||
+        (size_t)perChannel * channels * 4 > sampleBytes) {
+        writeOut(st, st.audioOut, samples, sampleBytes);
+        return;
+    }
+    // Planar [ch0 s0..sN][ch1 s0..sN] → interleaved f32le for ffplay/sox
+    st.interleaved.resize((size_t)perChannel * channels);
+    for (int c = 0; c < channels; c++) {
+        const uint8_t* plane = samples + (size_t)c * perChannel * 4;
+        for (int i = 0; i < perChannel; i++) {
+            uint32_t bits = getU32(plane + (size_t)i * 4);
+            std::memcpy(&st.interleaved[(size_t)i * channels + c], &bits, 4);
+        }
+    }
+    writeOut(st, st.audioOut, st.interleaved.data(), st.interleaved.size() * 4);
+}
+
+void onMetadata(State& st, const uint8_t* payload, size_t len) {
+    st.metadata.frames++;
+    st.metadata.bytes += HEADER_SIZE + len;
+    if (st.metadata.frames <= 8) {
+        size_t n = strnlen((const char*)payload, len);
+        LOGI("Metadata: %.*s", (int)std::min<size_t>(n, 160), (const char*)payload);
+    }
+}
+
+void printJitter(FILE* out, const char* label, const HistogramSnapshot& s, double smoothedNs) {
+    std::fprintf(out, " %s jitter=%.2fms p50=%.2f p99=%.2f max=%.2fms", label, smoothedNs / 1e6,
+                 s.p50 / 1e6, s.p99 / 1e6, s.max / 1e6);
+}
+
+void report(State& st, double seconds) {
+    FILE* out = st.report;
+    const double videoFps = st.intervalVideo.frames / seconds;
+    const double mbps = (st.intervalVideo.bytes + st.intervalAudio.bytes) * 8 / seconds / 1e6;
+    std::fprintf(out, "[rx] video %6.2f fps", videoFps);
+    if (st.haveVideo)
+        std::fprintf(out, " %s %dx%d", codecName(st.lastVideo.codec), st.lastVideo.width, st.lastVideo.height);
+    std::fprintf(out, " | audio %5.1f fps | %8.2f Mbit/s | missed %llu", st.intervalAudio.frames / seconds,
+                 mbps, (unsigned long long)st.intervalMissed);
+    printJitter(out, "|", st.intervalVideoDeviation.snapshot(), st.videoJitter.smoothedNs);
+    std::fprintf(out, "\n");
+    std::fflush(out);
+    st.intervalVideo = {};
+    st.intervalAudio = {};
+    st.intervalMissed = 0;
+    st.intervalVideoDeviation.reset();
+}
+
+void summary(State& st, double seconds, uint64_t socketBytes) {
+    FILE* out = st.report;
+    std::fprintf(out, "[summary] %.1fs  %.2f Mbit/s on the wire\n", seconds, socketBytes * 8 / seconds / 1e6);
+    std::fprintf(out, "  video: %llu frames (%.2f fps), %.1f MB, missed %llu",
+                 (unsigned long long)st.video.frames, st.video.frames / seconds, st.video.bytes / 1e6,
+                 (unsigned long long)st.missedFrames);
+    printJitter(out, "", st.videoJitter.deviation.snapshot(), st.videoJitter.smoothedNs);
+    std::fprintf(out, "\n  audio: %llu frames (%.2f fps), %.1f MB", (unsigned long long)st.audio.frames,
+                 st.audio.frames / seconds, st.audio.bytes / 1e6);
+    printJitter(out, "", st.audioJitter.deviation.snapshot(), st.audioJitter.smoothedNs);
+    std::fprintf(out, "\n  metadata: %llu frames\n", (unsigned long long)st.metadata.frames);
+    std::fflush(out);
+}
+
+FILE* openOut(const char* path) {
+    if (!path) return nullptr;
+    FILE* f = !std::strcmp(path, "-") ? stdout : std::fopen(path, "wb");
+    if (!f) {
+        LOGE("Cannot open %s: %s", path, std::strerror(errno));
+        return nullptr;
+    }
+    std::setvbuf(f, nullptr, _IOFBF, FILE_BUFFER_BYTES);
+    return f;
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: omt_receive <host> [port] [--video FILE] [--audio FILE] [--stream FILE]\n"
+                 "                   [--record BASE] [--interleave] [--no-audio] [--shm] [--multicast]\n"
+                 "                   [--nvlz] [--duration sec] [--interval sec]\n"
+                 "       FILE may be - for stdout\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* host = nullptr;
+    int port = 6500;
+    const char* videoPath = nullptr;
+    const char* audioPath = nullptr;
+    const char* streamPath = nullptr;
+    const char* recordBase = nullptr;
+    bool audio = true;
+    bool interleave = false;
+    bool shm = false;
+    bool multicast = false;
+    bool nvlz = false;
+    double durationSec = 0;
+    double intervalSec = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--video") && i + 1 < argc) videoPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--audio") && i + 1 < argc) audioPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--stream") && i + 1 < argc) streamPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--record") && i + 1 < argc) recordBase = argv[++i];
+        else if (!std::strcmp(argv[i], "--interleave")) interleave = true;
+        else if (!std::strcmp(argv[i], "--no-audio")) audio = false;
+        else if (!std::strcmp(argv[i], "--shm")) shm = true;
+        else if (!std::strcmp(argv[i], "--multicast")) multicast = true;
+        else if (!std::strcmp(argv[i], "--nvlz")) nvlz = true;
+        else if (!std::strcmp(argv[i], "--duration") && i + 1 < argc) durationSec = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--interval") && i + 1 < argc) intervalSec = std::atof(argv[++i]);
+        else if (argv[i][0] == '-' && argv[i][1] != '\0') { usage(); return 2; }
+        else if (!host) host = argv[i];
+        else port = std::atoi(argv[i]);
+    }
+    if (!host || port <= 0 || intervalSec <= 0) { usage(); return 2; }
+    int toStdout = 0;
+    for (const char* p : {videoPath, audioPath, streamPath}) toStdout += p && !std::strcmp(p, "-");
+    if (toStdout > 1) {
+        LOGE("Only one of --video, --audio and --stream can go to stdout");
+        return 2;
+    }
+
+    State st;
+    st.interleave = interleave;
+    if (toStdout) st.report = stderr;
+    if ((videoPath && !(st.videoOut = openOut(videoPath))) || (audioPath && !(st.audioOut = openOut(audioPath))) ||
+        (streamPath && !(st.streamOut = openOut(streamPath))))
+        return 1;
+    RecorderConfig recordCfg;
+    if (recordBase) recordCfg.basePath = recordBase;
+    Recorder recorder(recordCfg);
+    if (recordBase && !recorder.start()) return 1;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    if (!loop.valid()) return 1;
+    ReceiverConfig cfg;
+    cfg.host = host;
+    cfg.port = port;
+    cfg.video = true;
+    cfg.audio = audio;
+    cfg.metadata = true;
+    cfg.recvBufferBytes = RECV_BUFFER_BYTES;
+    cfg.sharedMemory = shm;
+    cfg.multicast = multicast;
+    cfg.nvlz = nvlz;
+
+    bool closed = false;
+    Receiver rx(loop, cfg, [&](const FrameHeader& h, const uint8_t* payload, size_t len) {
+        const int64_t arrivalNs = nowNs();
+        writeStreamFrame(st, h, payload, len);
+        if (recordBase && h.type != FRAME_METADATA) {
+            uint8_t header[HEADER_SIZE];
+            writeFrameHeader(header, h);
+            recorder.record(header, sizeof(header), payload, len);
+        }
+        switch (h.type) {
+        case FRAME_VIDEO: onVideo(st, h, payload, len, arrivalNs); break;
+        case FRAME_AUDIO: onAudio(st, h, payload, len, arrivalNs); break;
+        case FRAME_METADATA: onMetadata(st, payload, len); break;
+        default: break;
+        }
+    });
+    rx.setOnClosed([&] { closed = true; });
+    if (!rx.connect()) {
+        LOGE("Cannot connect to %s:%d", host, port);
+        return 1;
+    }
+    LOGI("Connected to %s:%d, subscribed to video%s", host, port, audio ? " + audio" : "");
+
+    const int64_t startNs = nowNs();
+    int64_t intervalStart = startNs;
+    while (!s_stop.load() && !closed && !st.writeFailed) {
+        loop.runOnce(50);
+        const int64_t now = nowNs();
+        if (now - intervalStart >= (int64_t)(intervalSec * 1e9)) {
+            report(st, (now - intervalStart) / 1e9);
+            intervalStart = now;
+        }
+        if (durationSec > 0 && now - startNs >= (int64_t)(durationSec * 1e9)) break;
+    }
+    const double elapsed = (nowNs() - startNs) / 1e9;
+    const uint64_t socketBytes = rx.bytesReceived();
+    const uint64_t shmFrames = rx.sharedMemoryFrames(), shmDropped = rx.sharedMemoryDropped();
+    rx.close();
+
+    for (FILE* f : {st.videoOut, st.audioOut, st.streamOut}) {
+        if (!f) continue;
+        if (f == stdout) std::fflush(f);
+        else std::fclose(f);
+    }
+    summary(st, elapsed, socketBytes);
+    if (shm)
+        std::fprintf(st.report, "  shared memory: %llu frames%s, dropped %llu\n", (unsigned long long)shmFrames,
+                     shmFrames ? "" : " (none through the ring; all on TCP)", (unsigned long long)shmDropped);
+    if (multicast) {
+        const MulticastReceiver* m = rx.multicast();
+        if (m)
+            std::fprintf(st.report, "  multicast: %llu frames, lost %llu, %llu fragments rebuilt by FEC, "
+                                    "%llu of %llu datagrams missing\n",
+                         (unsigned long long)m->framesReceived(), (unsigned long long)m->framesLost(),
+                         (unsigned long long)m->fragmentsRecovered(), (unsigned long long)m->datagramsLost(),
+                         (unsigned long long)(m->datagramsReceived() + m->datagramsLost()));
+        else
+            std::fprintf(st.report, "  multicast: not offered (all on TCP)\n");
+    }
+    if (recordBase) {
+        recorder.stop();
+        std::fprintf(st.report, "  recorded: %llu frames, %.1f MB, dropped %llu%s\n",
+                     (unsigned long long)recorder.framesWritten(), recorder.bytesWritten() / 1e6,
+                     (unsigned long long)recorder.framesDropped(), recorder.failed() ? " (write failed)" : "");
+    }
+    return st.video.frames + st.audio.frames > 0 && !st.writeFailed ? 0 : 1;
+}
@@ -0,0 +1,494 @@
+/**
+ * omt_relay — re-serves one OMT source to many receivers from a handful of
+ * threads, written on the coroutine layer (core/omt_async).
+ *
+ *   omt_relay <host> [port] [--listen port] [--threads n] [--queue frames]
+ *             [--duration sec] [--interval sec]
+ *
+ * One upstream connection subscribes to video, audio and metadata and hands
+ * every frame, packed once in wire format, to each worker loop. Receivers
+ * connect to --listen and are spread over --threads worker loops; each one
+ * is a coroutine that sends its queue with co_await and a second coroutine
+ * that reads its subscriptions. A receiver that falls behind loses its
+ * oldest queued video (and, separately, audio) beyond --queue frames, like
+ * the native sender's slow-client policy; metadata is never dropped.
+ *
+ * The upstream reconnects on its own with backoff (sleepFor), and every
+ * interval prints upstream fps and Mbit/s, receivers, output Mbit/s and
+ * drops per worker.
+ */
+#define LOG_TAG "omt_relay"
+#include "omt_async.h"
+#include "omt_demux.h"
+#include "omt_log.h"
+#include "omt_net.h"
+#include "omt_protocol.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+constexpr int MAX_QUEUE = 16;          // frames per receiver, metadata included
+constexpr size_t MAX_INBOX = 64;       // frames a worker may lag behind the upstream
+constexpr size_t MAX_CLIENT_FRAME = 64u << 10; // receivers only send metadata
+constexpr int SEND_BUFFER_BYTES = 512 * 1024;
+constexpr int CONNECT_TIMEOUT_MS = 3000;
+constexpr int MAX_BACKOFF_MS = 5000;
+constexpr char INFO_XML[] = "<OMTInfo ProductName=\"OMT Relay\" Manufacturer=\"OMT\" />";
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+int64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct Options {
+    const char* host = nullptr;
+    int port = 6500;
+    int listenPort = 6600;
+    int threads = 2;
+    int queueDepth = 2;
+    double durationSec = 0;
+    double intervalSec = 1.0;
+};
+
+/** One upstream frame in wire format, shared by every receiver it is queued on. */
+struct Frame {
+    std::vector<uint8_t> bytes;
+    size_t length = 0;
+    int type = 0;
+    std::atomic<int> refs{0};
+};
+
+class FramePool {
+public:
+    Frame* acquire(size_t length) {
+        Frame* f = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free.empty()) {
+                f = m_free.back();
+                m_free.pop_back();
+            } else {
+                m_all.push_back(std::make_unique<Frame>());
+                f = m_all.back().get();
+                m_free.reserve(m_all.size());
+            }
+        }
+        if (f->bytes.size() < length) f->bytes.resize(length);
+        f->length = length;
+        return f;
+    }
+
+    void release(Frame* f) {
+        if (f->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(f);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Frame>> m_all;
+    std::vector<Frame*> m_free;
+};
+
+struct Client;
+
+/** One loop of the pool and the receivers that live on it. */
+struct Worker {
+    int index = 0;
+    EventLoop* loop = nullptr;
+    std::mutex inboxMutex; // the upstream thread pushes, the worker drains
+    std::vector<Frame*> inbox;
+    std::vector<Frame*> draining;
+    std::vector<Client*> clients; // loop thread only
+    std::atomic<int> clientCount{0};
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint64_t> drops{0};
+    std::atomic<uint64_t> inboxDrops{0};
+};
+
+struct Client {
+    Client(EventLoop& loop, int fd) : sock(loop, fd), demux(MAX_CLIENT_FRAME, 4096) { }
+
+    AsyncFd sock;
+    std::string peer;
+    Demuxer demux;
+    bool video = false;
+    bool audio = false;
+    bool closing = false;
+    Frame* queue[MAX_QUEUE] = {};
+    int count = 0;
+    AsyncEvent ready;      // the queue has something, or the client is closing
+    AsyncEvent readerDone;
+};
+
+struct Relay {
+    Options opt;
+    FramePool pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+    EventLoop* control = nullptr;
+    std::atomic<uint64_t> framesIn{0};
+    std::atomic<uint64_t> bytesIn{0};
+    bool upstreamConnected = false;
+    uint32_t nextWorker = 0;
+};
+
+// ---- Receivers (worker loops) ----
+
+bool enqueue(Relay& r, Worker& w, Client& c, Frame* f) {
+    if (f->type != FRAME_METADATA) {
+        // Video and audio are budgeted separately so a video backlog never costs audio.
+        int queuedSame = 0;
+        int oldest = -1;
+        for (int i = 0; i < c.count; i++) {
+            if (c.queue[i]->type != f->type) continue;
+            if (oldest < 0) oldest = i;
+            queuedSame++;
+        }
+        if (queuedSame >= r.opt.queueDepth) {
+            Frame* old = c.queue[oldest];
+            std::memmove(c.queue + oldest, c.queue + oldest + 1, sizeof(Frame*) * (c.count - oldest - 1));
+            c.count--;
+            r.pool.release(old);
+            w.drops.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (c.count == MAX_QUEUE) {
+        if (f->type != FRAME_METADATA) w.drops.fetch_add(1, std::memory_order_relaxed);
+        else LOGW("%s: control queue full, metadata dropped", c.peer.c_str());
+        return false;
+    }
+    f->refs.fetch_add(1, std::memory_order_relaxed);
+    c.queue[c.count++] = f;
+    return true;
+}
+
+/** Wake handler: queue what the upstream delivered on every subscribed receiver, then let them send. */
+void drainInbox(Relay& r, Worker& w) {
+    {
+        std::lock_guard<std::mutex> lock(w.inboxMutex);
+        w.draining.swap(w.inbox);
+    }
+    if (w.draining.empty()) return;
+    for (Frame* f : w.draining) {
+        for (Client* c : w.clients) {
+            const bool wanted = f->type == FRAME_METADATA || (f->type == FRAME_VIDEO && c->video) ||
+                                (f->type == FRAME_AUDIO && c->audio);
+            if (wanted && !c->closing) enqueue(r, w, *c, f);
+        }
+        r.pool.release(f); // the worker's reference
+    }
+    w.draining.clear();
+    // A resumed sender may finish and unlink itself from w.clients.
+    for (size_t i = 0; i < w.clients.size();) {
+        Client* c = w.clients[i];
+        if (c->count > 0) c->ready.set();
+        if (i < w.clients.size() && w.clients[i] == c) i++;
+    }
+}
+
+void onClientMetadata(Client& c, const uint8_t* data, size_t length) {
+    const char* text = (const char*)data;
+    length = strnlen(text, length);
+    if (!containsIgnoreCase(text, length, "Subscribe")) return;
+    // As the native sender: vMix often subscribes to video only and still expects audio.
+    if (containsIgnoreCase(text, length, "Video")) c.video = c.audio = true;
+    if (containsIgnoreCase(text, length, "Audio")) c.audio = true;
+}
+
+Task<void> readSubscriptions(Client& c) {
+    for (;;) {
+        size_t avail;
+        uint8_t* dst = c.demux.writable(&avail);
+        const ssize_t n = co_await c.sock.recv(dst, avail);
+        if (n <= 0) break;
+        const bool ok = c.demux.commit((size_t)n, [&c](const FrameHeader& h, const uint8_t* data, size_t len) {
+            if (h.type == FRAME_METADATA) onClientMetadata(c, data, len);
+        });
+        if (!ok) break;
+    }
+    c.closing = true;
+    c.ready.set();
+    c.readerDone.set();
+}
+
+Task<void> serveClient(Relay& r, Worker& w, int fd, std::string peer) {
+    co_await schedule(*w.loop); // from the accepting loop to this receiver's worker
+    Client c(*w.loop, fd);
+    c.peer = std::move(peer);
+    w.clients.push_back(&c);
+    LOGI("%s connected to worker %d (receivers=%d)", c.peer.c_str(), w.index,
+         w.clientCount.fetch_add(1, std::memory_order_relaxed) + 1);
+    spawn(readSubscriptions(c));
+
+    uint8_t info[HEADER_SIZE + sizeof(INFO_XML)];
+    const int infoLength = buildMetadataFrame(info, sizeof(info), INFO_XML, sizeof(INFO_XML) - 1);
+    bool ok = infoLength > 0 && co_await c.sock.sendAll(info, (size_t)infoLength) == infoLength;
+    while (ok && !c.closing) {
+        if (c.count == 0) {
+            c.ready.reset();
+            co_await c.ready.wait();
+            continue;
+        }
+        Frame* f = c.queue[0];
+        std::memmove(c.queue, c.queue + 1, sizeof(Frame*) * (c.count - 1));
+        c.count--;
+        const ssize_t sent = co_await c.sock.sendAll(f->bytes.data(), f->length);
+        r.pool.release(f);
+        if (sent < 0) {
+            if (sent != -ECANCELED) LOGW("%s: send failed: %s", c.peer.c_str(), std::strerror((int)-sent));
+            ok = false;
+        } else {
+            w.bytesSent.fetch_add((uint64_t)sent, std::memory_order_relaxed);
+        }
+    }
+
+    w.clients.erase(std::find(w.clients.begin(), w.clients.end(), &c));
+    c.closing = true;
+    c.sock.close(); // ends the subscription reader
+    co_await c.readerDone.wait();
+    for (int i = 0; i < c.count; i++) r.pool.release(c.queue[i]);
+    c.count = 0;
+    LOGI("%s disconnected (receivers=%d)", c.peer.c_str(), w.clientCount.fetch_sub(1, std::memory_order_relaxed) - 1);
+}
+
+/** Posted at shutdown: close every receiver so their coroutines finish. */
+void closeAll(Worker& w) {
+    while (!w.clients.empty()) {
+        Client* c = w.clients.back();
+        c->closing = true;
+        c->ready.set(); // the sender loop sees closing, unlinks and closes
+        if (!w.clients.empty() && w.clients.back() == c) c->sock.close(); // still mid-send
+    }
+}
+
+// ---- Control loop: accept and upstream ----
+
+Task<void> acceptReceivers(Relay& r, AsyncFd& listener) {
+    for (;;) {
+        const ssize_t fd = co_await listener.accept();
+        if (fd == -ECANCELED) break;
+        if (fd < 0) {
+            LOGW("accept failed: %s", std::strerror((int)-fd));
+            co_await sleepFor(*r.control, 100);
+            continue;
+        }
+        sockaddr_in addr{};
+        socklen_t addrLen = sizeof(addr);
+        getpeername((int)fd, (sockaddr*)&addr, &addrLen);
+        char host[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+        int one = 1;
+        setsockopt((int)fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt((int)fd, SOL_SOCKET, SO_SNDBUF, &SEND_BUFFER_BYTES, sizeof(SEND_BUFFER_BYTES));
+        Worker& w = *r.workers[r.nextWorker++ % r.workers.size()];
+        spawn(serveClient(r, w, (int)fd, std::string(host) + ":" + std::to_string(ntohs(addr.sin_port))));
+    }
+}
+
+void publish(Relay& r, const FrameHeader& h, const uint8_t* payload, size_t length) {
+    Frame* f = r.pool.acquire(HEADER_SIZE + length);
+    writeFrameHeader(f->bytes.data(), h);
+    std::memcpy(f->bytes.data() + HEADER_SIZE, payload, length);
+    f->type = h.type;
+    f->refs.store((int)r.workers.size(), std::memory_order_relaxed);
+    for (auto& w : r.workers) {
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(w->inboxMutex);
+            if (w->inbox.size() < MAX_INBOX) {
+                w->inbox.push_back(f);
+                queued = true;
+            }
+        }
+        if (queued) {
+            w->loop->wake();
+        } else {
+            w->inboxDrops.fetch_add(1, std::memory_order_relaxed);
+            r.pool.release(f);
+        }
+    }
+    r.framesIn.fetch_add(1, std::memory_order_relaxed);
+    r.bytesIn.fetch_add(HEADER_SIZE + length, std::memory_order_relaxed);
+}
+
+Task<void> relayUpstream(Relay& r) {
+    static const char kSubscribe[][40] = {"<OMTSubscribe Metadata=\"true\" />", "<OMTSubscribe Video=\"true\" />",
+                                          "<OMTSubscribe Audio=\"true\" />"};
+    int backoffMs = 250;
+    while (!s_stop.load()) {
+        // A blocking connect on the control loop: it holds up accepting, never the receivers.
+        int fd = tcpConnect(r.opt.host, r.opt.port, CONNECT_TIMEOUT_MS);
+        bool ok = fd >= 0;
+        for (const char* xml : kSubscribe) ok = ok && sendMetadata(fd, xml, std::strlen(xml));
+        if (!ok) {
+            if (fd >= 0) close(fd);
+            LOGW("upstream %s:%d unavailable; retrying in %d ms", r.opt.host, r.opt.port, backoffMs);
+            co_await sleepFor(*r.control, backoffMs);
+            backoffMs = std::min(backoffMs * 2, MAX_BACKOFF_MS);
+            continue;
+        }
+        LOGI("upstream %s:%d connected", r.opt.host, r.opt.port);
+        backoffMs = 250;
+        r.upstreamConnected = true;
+        AsyncFd sock(*r.control, fd);
+        Demuxer demux;
+        for (;;) {
+            size_t avail;
+            uint8_t* dst = demux.writable(&avail);
+            const ssize_t n = co_await sock.recv(dst, avail);
+            if (n <= 0) {
+                if (n < 0 && n != -ECANCELED) LOGW("upstream: %s", std::strerror((int)-n));
+                break;
+            }
+            const bool good = demux.commit((size_t)n, [&r](const FrameHeader& h, const uint8_t* payload, size_t len) {
+                publish(r, h, payload, len);
+            });
+            if (!good) {
+                LOGW("upstream: corrupt stream");
+                break;
+            }
+        }
+        r.upstreamConnected = false;
+        LOGW("upstream %s:%d lost", r.opt.host, r.opt.port);
+        co_await sleepFor(*r.control, backoffMs);
+    }
+}
+
+Task<void> report(Relay& r) {
+    const int intervalMs = (int)(r.opt.intervalSec * 1000);
+    uint64_t lastFrames = 0, lastIn = 0;
+    std::vector<uint64_t> lastOut(r.workers.size()), lastDrops(r.workers.size());
+    for (;;) {
+        co_await sleepFor(*r.control, intervalMs);
+        const uint64_t frames = r.framesIn.load(), in = r.bytesIn.load();
+        const double sec = intervalMs / 1000.0;
+        std::printf("[relay] upstream %s %6.1f fps %8.1f Mbit/s |", r.upstreamConnected ? "up  " : "down",
+                    (frames - lastFrames) / sec, (in - lastIn) * 8 / sec / 1e6);
+        for (size_t i = 0; i < r.workers.size(); i++) {
+            Worker& w = *r.workers[i];
+            const uint64_t out = w.bytesSent.load(), drops = w.drops.load() + w.inboxDrops.load();
+            std::printf(" w%zu %d rx %7.1f Mbit/s drops %llu |", i, w.clientCount.load(),
+                        (out - lastOut[i]) * 8 / sec / 1e6, (unsigned long long)(drops - lastDrops[i]));
+            lastOut[i] = out;
+            lastDrops[i] = drops;
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+        lastFrames = frames;
+        lastIn = in;
+    }
+}
+
+int listenOn(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        LOGE("Cannot listen on port %d: %s", port, std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: omt_relay <host> [port] [--listen port] [--threads n] [--queue frames]\n"
+        "                 [--duration sec] [--interval sec]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--listen") && hasValue) opt.listenPort = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--threads") && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--queue") && hasValue) opt.queueDepth = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--duration") && hasValue) opt.durationSec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--interval") && hasValue) opt.intervalSec = std::atof(argv[++i]);
+        else if (a[0] == '-') { usage(); return 2; }
+        else if (positional == 0) { opt.host = a; positional++; }
+        else if (positional == 1) { opt.port = std::atoi(a); positional++; }
+        else { usage(); return 2; }
+    }
+    if (!opt.host || opt.port <= 0 || opt.listenPort <= 0 || opt.threads < 1 || opt.threads > 64 ||
+        opt.queueDepth < 1 || opt.queueDepth > MAX_QUEUE / 2 || opt.intervalSec <= 0) {
+        usage();
+        return 2;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Relay relay;
+    relay.opt = opt;
+    EventLoop control;
+    LoopPool pool(opt.threads);
+    if (!control.valid() || !pool.valid()) return 1;
+    relay.control = &control;
+    for (int i = 0; i < pool.size(); i++) {
+        auto w = std::make_unique<Worker>();
+        w->index = i;
+        w->loop = &pool.loop(i);
+        w->inbox.reserve(MAX_INBOX);
+        w->draining.reserve(MAX_INBOX);
+        Worker* worker = w.get();
+        w->loop->setWakeHandler([&relay, worker] { drainInbox(relay, *worker); });
+        relay.workers.push_back(std::move(w));
+    }
+    const int listenFd = listenOn(opt.listenPort);
+    if (listenFd < 0) return 1;
+    AsyncFd listener(control, listenFd);
+    pool.start();
+    LOGI("Relaying %s:%d on port %d with %d worker thread(s) (%s)", opt.host, opt.port, opt.listenPort,
+         pool.size(), loopBackendName(control.backend()));
+
+    spawn(acceptReceivers(relay, listener));
+    spawn(relayUpstream(relay));
+    spawn(report(relay));
+
+    const int64_t startNs = nowNs();
+    while (!s_stop.load() && control.runOnce(100)) {
+        if (opt.durationSec > 0 && nowNs() - startNs >= (int64_t)(opt.durationSec * 1e9)) break;
+    }
+    listener.close(); // the accept coroutine ends
+    for (auto& w : relay.workers) {
+        Worker* worker = w.get();
+        w->loop->post([worker] { closeAll(*worker); });
+    }
+    pool.stop();
+    return 0;
+}
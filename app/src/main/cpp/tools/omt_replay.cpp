@@ -0,0 +1,268 @@
+/**
+ * omt_replay — serves recordings (core/omt_record: the app's debug.omt.record
+ * or omt_receive --record) as live OMT sources, at the cadence they were
+ * recorded.
+ *
+ * Each REC is one channel on its own port (--port, then +1 per channel),
+ * advertised over mDNS as "HOSTNAME (name N)". A channel named BASE-0001.omt
+ * continues through BASE-0002.omt, ... as long as they exist. Frames are not
+ * decoded or re-encoded: the pacing thread reads each frame's header from the
+ * mapped index and data, and the Sender writes the header followed by the
+ * recorded extended header and payload straight from the page cache with
+ * sendfile() (Sender::sendFromFile), so a channel costs little more than
+ * its socket writes. Timestamps are the recorded ones, advanced by the
+ * recording's length on every --loop pass so they never go backwards.
+ *
+ * Frames go out when (recorded time − first recorded time) / speed has
+ * elapsed since the start. Each interval reports per-channel video fps, Mbit/s,
+ * clients, frames sent late (more than 5 ms past their slot) and the
+ * process CPU use.
+ *
+ *   omt_replay [--port 6500] [--name "OMT Replay"] [--no-advertise] [--address ip]
+ *              [--loop] [--speed x] [--duration sec] [--interval sec] REC.omt [REC.omt ...]
+ */
+#define LOG_TAG "omt_replay"
+#include "omt_log.h"
+#include "omt_mdns.h"
+#include "omt_protocol.h"
+#include "omt_record.h"
+#include "omt_sender.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+constexpr int64_t LATE_NS = 5000000;
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+int64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void sleepUntil(int64_t deadlineNs) {
+    timespec ts{(time_t)(deadlineNs / 1000000000LL), (long)(deadlineNs % 1000000000LL)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR && !s_stop.load()) { }
+}
+
+int64_t cpuNs() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ((int64_t)ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000LL +
+           ((int64_t)ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000LL;
+}
+
+struct Options {
+    int port = 6500;
+    std::string name = "OMT Replay";
+    std::string address;
+    bool advertise = true;
+    bool loop = false;
+    double speed = 1;
+    double durationSec = 0;
+    double intervalSec = 2;
+    std::vector<const char*> recordings;
+};
+
+/** One recording served on one port by its own pacing thread. */
+struct Channel {
+    std::string name;
+    std::vector<std::unique_ptr<RecordingReader>> segments;
+    std::unique_ptr<Sender> sender;
+    MdnsAdvertiser mdns;
+    std::thread thread;
+    int64_t firstRecordedNs = 0;
+    int64_t lengthNs = 0; // one pass, including a frame's worth of gap before looping
+    uint64_t frameCount = 0;
+
+    // Written by the pacing thread, read by the report
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> videoFrames{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> late{0};
+    std::atomic<bool> finished{false};
+};
+
+/** Open REC and, when it is BASE-0001.omt, the segments that follow it. */
+bool openSegments(Channel& ch, const char* path) {
+    std::string base;
+    const std::string p = path;
+    const std::string first = "-0001.omt";
+    if (p.size() > first.size() && p.compare(p.size() - first.size(), first.size(), first) == 0)
+        base = p.substr(0, p.size() - first.size());
+    for (int n = 1;; n++) {
+        const std::string segment = base.empty() ? p : Recorder::segmentPath(base, n);
+        if (n > 1 && access(segment.c_str(), R_OK) != 0) break;
+        auto reader = std::make_unique<RecordingReader>();
+        if (!reader->open(segment)) {
+            if (n == 1) return false;
+            LOGW("%s: unreadable, stopping before it", segment.c_str());
+            break;
+        }
+        posix_fadvise(reader->dataFd(), 0, 0, POSIX_FADV_SEQUENTIAL);
+        ch.frameCount += reader->frameCount();
+        ch.segments.push_back(std::move(reader));
+        if (base.empty()) break;
+    }
+    if (ch.frameCount == 0) {
+        LOGE("%s: no frames", path);
+        return false;
+    }
+    const RecordingReader& head = *ch.segments.front();
+    const RecordingReader* tail = nullptr;
+    for (auto& s : ch.segments)
+        if (s->frameCount() > 0) tail = s.get();
+    ch.firstRecordedNs = head.entry(0).recordedNs;
+    const int64_t spanNs = tail->entry(tail->frameCount() - 1).recordedNs - ch.firstRecordedNs;
+    ch.lengthNs = spanNs + (ch.frameCount > 1 ? spanNs / (int64_t)(ch.frameCount - 1) : 33000000);
+    return true;
+}
+
+void pace(Channel& ch, const Options& opt, int64_t startNs, int64_t endNs) {
+    int64_t loopNs = 0; // recorded time already played by earlier passes
+    do {
+        for (auto& segment : ch.segments) {
+            for (size_t i = 0; i < segment->frameCount() && !s_stop.load(); i++) {
+                const RecordEntry& e = segment->entry(i);
+                const int64_t deadline =
+                    startNs + (int64_t)((loopNs + e.recordedNs - ch.firstRecordedNs) / opt.speed);
+                if (deadline >= endNs) return;
+                sleepUntil(deadline);
+                if (s_stop.load()) return;
+                FrameHeader h;
+                if (!parseFrameHeader(segment->frame(i), &h) || HEADER_SIZE + (size_t)h.dataLength != e.length) {
+                    LOGW("%s: frame %zu does not match its index entry, skipped", ch.name.c_str(), i);
+                    continue;
+                }
+                h.timestamp += loopNs / 100;
+                if (ch.sender->sendFromFile(h, segment->dataFd(), e.offset + HEADER_SIZE) > 0) {
+                    ch.frames.fetch_add(1, std::memory_order_relaxed);
+                    if (h.type == FRAME_VIDEO) ch.videoFrames.fetch_add(1, std::memory_order_relaxed);
+                    ch.bytes.fetch_add(e.length, std::memory_order_relaxed);
+                    if (nowNs() - deadline > LATE_NS) ch.late.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        loopNs += ch.lengthNs;
+    } while (opt.loop && !s_stop.load());
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: omt_replay [--port n] [--name s] [--no-advertise] [--address ip]\n"
+                 "                  [--loop] [--speed x] [--duration sec] [--interval sec] REC.omt [REC.omt ...]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--port") && hasValue) opt.port = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--name") && hasValue) opt.name = argv[++i];
+        else if (!std::strcmp(a, "--address") && hasValue) opt.address = argv[++i];
+        else if (!std::strcmp(a, "--no-advertise")) opt.advertise = false;
+        else if (!std::strcmp(a, "--loop")) opt.loop = true;
+        else if (!std::strcmp(a, "--speed") && hasValue) opt.speed = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--duration") && hasValue) opt.durationSec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--interval") && hasValue) opt.intervalSec = std::atof(argv[++i]);
+        else if (a[0] == '-' && a[1] != '\0') { usage(); return 2; }
+        else opt.recordings.push_back(a);
+    }
+    if (opt.recordings.empty() || opt.port < 0 || opt.speed <= 0 || opt.intervalSec <= 0) { usage(); return 2; }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::unique_ptr<Channel>> channels;
+    for (size_t i = 0; i < opt.recordings.size(); i++) {
+        auto ch = std::make_unique<Channel>();
+        ch->name = opt.recordings.size() > 1 ? opt.name + " " + std::to_string(i + 1) : opt.name;
+        if (!openSegments(*ch, opt.recordings[i])) return 1;
+        SenderConfig sc;
+        sc.port = opt.port > 0 ? opt.port + (int)i : 0;
+        ch->sender = std::make_unique<Sender>(sc);
+        if (!ch->sender->start()) return 1;
+        LOGI("%s: %s, %zu segment(s), %llu frames, %.1f s on port %d", ch->name.c_str(), opt.recordings[i],
+             ch->segments.size(), (unsigned long long)ch->frameCount, ch->lengthNs / 1e9, ch->sender->port());
+        if (opt.advertise && !ch->mdns.start(ch->name, ch->sender->port(), opt.address))
+            LOGW("%s not advertised; connect to port %d directly", ch->name.c_str(), ch->sender->port());
+        channels.push_back(std::move(ch));
+    }
+
+    const int64_t startNs = nowNs() + 100000000; // first frame 100 ms out
+    const int64_t endNs = opt.durationSec > 0 ? startNs + (int64_t)(opt.durationSec * 1e9) : INT64_MAX;
+    for (auto& ch : channels) {
+        Channel* c = ch.get();
+        c->thread = std::thread([c, &opt, startNs, endNs] {
+            pace(*c, opt, startNs, endNs);
+            c->finished.store(true);
+        });
+    }
+
+    std::vector<uint64_t> lastFrames(channels.size()), lastBytes(channels.size()), lastLate(channels.size());
+    int64_t intervalStart = nowNs(), intervalCpu = cpuNs();
+    const int64_t runStart = intervalStart, runCpu = intervalCpu;
+    for (;;) {
+        const bool done = std::all_of(channels.begin(), channels.end(), [](auto& c) { return c->finished.load(); });
+        if (s_stop.load() || done) break;
+        sleepUntil(std::min(intervalStart + (int64_t)(opt.intervalSec * 1e9), nowNs() + 100000000));
+        const int64_t now = nowNs();
+        if (now - intervalStart < (int64_t)(opt.intervalSec * 1e9)) continue;
+        const double seconds = (now - intervalStart) / 1e9;
+        const int64_t cpu = cpuNs();
+        std::printf("[replay]");
+        for (size_t i = 0; i < channels.size(); i++) {
+            Channel& c = *channels[i];
+            const uint64_t frames = c.videoFrames.load(), bytes = c.bytes.load(), late = c.late.load();
+            std::printf(" %s%.1f fps %.1f Mbit/s %d client(s) late %llu", i ? "| " : "",
+                        (frames - lastFrames[i]) / seconds, (bytes - lastBytes[i]) * 8 / seconds / 1e6,
+                        c.sender->clientCount(), (unsigned long long)(late - lastLate[i]));
+            lastFrames[i] = frames;
+            lastBytes[i] = bytes;
+            lastLate[i] = late;
+        }
+        std::printf(" | cpu %.1f%%\n", (cpu - intervalCpu) / 1e7 / seconds);
+        std::fflush(stdout);
+        intervalStart = now;
+        intervalCpu = cpu;
+    }
+
+    s_stop.store(true);
+    for (auto& ch : channels)
+        if (ch->thread.joinable()) ch->thread.join();
+    const double seconds = (nowNs() - runStart) / 1e9;
+    uint64_t frames = 0, bytes = 0;
+    for (auto& ch : channels) {
+        frames += ch->frames.load();
+        bytes += ch->bytes.load();
+        ch->mdns.stop();
+        ch->sender->stop();
+    }
+    std::printf("[summary] %.1fs  %zu channel(s)  %llu frames sent  %.1f MB  cpu %.1f%%\n", seconds, channels.size(),
+                (unsigned long long)frames, bytes / 1e6, (cpuNs() - runCpu) / 1e7 / seconds);
+    return 0;
+}
@@ -0,0 +1,662 @@
+/**
+ * omt_source — OMT source for Linux hosts, framing exactly like
+ * CameraStreamSender (same headers, codecs, OMTInfo/OMTTally handshake and
+ * clock replies) through the native Sender core.
+ *
+ * Frames come from a generated test pattern (omt_pattern's bars with a moving
+ * marker, moving zone plate or scrolling ramp, or noise as the encoder's
+ * worst case; --counter overlays the frame number) or a raw NV12 / Y4M
+ * (4:2:0) file, played at the chosen rate and looped. They are sent as VMX1
+ * through the native encoder path (libvmx, or the host stub) or as raw NV12.
+ * The source is advertised over mDNS as "HOSTNAME (name)" like the app, so
+ * vMix lists it; --stamp writes the capture time into the picture for
+ * omt_latency.
+ *
+ * Pacing uses absolute deadlines; each interval reports the achieved rate,
+ * send-interval error percentiles, late (past the next deadline) and
+ * skipped frames, encode time and slow-client drops. --burn N adds N
+ * busy threads to measure frame-rate accuracy under CPU load. --quality SEC
+ * decodes one sent VMX frame every SEC seconds and reports its PSNR/SSIM
+ * against the source picture (omt_quality) beside the bitrate. --proxy BASE
+ * also writes a low-resolution proxy recording (omt_proxy: downscaled, LQ
+ * VMX at a reduced rate within a CPU budget; --proxy-spec W[xH][@FPS][,CPU%])
+ * to check that the live rate holds while it runs. --shm MB offers same-host
+ * receivers (omt_receive --shm) the frames through an omt_shm ring of that size
+ * instead of their TCP socket. --multicast SPEC ([GROUP][:PORT][,FEC], or 1
+ * for the defaults) offers monitoring receivers (omt_receive --multicast) one
+ * shared omt_multicast transmission instead. With --codec nv12, receivers that
+ * accept NVLZ (omt_receive --nvlz, the app's viewer) get each frame LZ4
+ * compressed (omt_lz4) instead; --no-nvlz sends everyone NV12.
+ *
+ *   omt_source [--port 6500] [--name "OMT Source"] [--size 1920x1080] [--fps 30|30000/1001]
+ *              [--codec vmx1|nv12] [--pattern bars|zoneplate|ramp|noise] [--counter]
+ *              [--file in.nv12|in.y4m] [--audio] [--stamp] [--burn n] [--no-advertise] [--address ip]
+ *              [--duration sec] [--interval sec] [--quality sec] [--proxy BASE] [--proxy-spec spec]
+ *              [--shm MB] [--multicast SPEC] [--no-nvlz]
+ */
+#define LOG_TAG "omt_source"
+#include "omt_histogram.h"
+#include "omt_latency.h"
+#include "omt_log.h"
+#include "omt_mdns.h"
+#include "omt_pattern.h"
+#include "omt_pixel.h"
+#include "omt_protocol.h"
+#include "omt_proxy.h"
+#include "omt_quality.h"
+#include "omt_sender.h"
+#include "omt_stats.h"
+#include "omt_vmx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace omt;
+
+namespace {
+
+constexpr int AUDIO_SAMPLE_RATE = 48000;
+constexpr int AUDIO_CHANNELS = 2;
+constexpr int AUDIO_SAMPLES_PER_CHANNEL = 960; // 20 ms, as CameraStreamSender
+constexpr int64_t AUDIO_PERIOD_NS = 20000000;
+
+std::atomic<bool> s_stop{false};
+
+void onSignal(int) { s_stop.store(true); }
+
+int64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void sleepUntil(int64_t deadlineNs) {
+    timespec ts{(time_t)(deadlineNs / 1000000000LL), (long)(deadlineNs % 1000000000LL)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR && !s_stop.load()) { }
+}
+
+struct Options {
+    int port = 6500;
+    std::string name = "OMT Source";
+    std::string address;
+    bool advertise = true;
+    int width = 1920;
+    int height = 1080;
+    int fpsN = 30;
+    int fpsD = 1;
+    bool fpsGiven = false;
+    uint32_t codec = CODEC_VMX1;
+    const char* pattern = "bars"; // an omt_pattern name or "noise"
+    bool counter = false;
+    const char* file = nullptr;
+    bool audio = false;
+    bool stamp = false;
+    int burn = 0;
+    double durationSec = 0;
+    double intervalSec = 2;
+    double qualitySec = 0; // 0 = off
+    const char* proxyBase = nullptr;
+    const char* proxySpec = nullptr;
+    size_t shmBytes = 0;   // 0 = TCP only
+    const char* multicast = nullptr;
+    bool nvlz = true;
+};
+
+// ---- Frame sources ----
+
+/** Produces NV12 frames (tight strides: Y width, UV width). */
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+    /** Fill y/uv with frame n. */
+    virtual void render(int64_t n, uint8_t* y, uint8_t* uv) = 0;
+};
+
+/** One of the core test patterns (omt_pattern). */
+class PatternSource : public FrameSource {
+public:
+    PatternSource(PatternKind kind, int w, int h) : m_kind(kind) { m_pattern.configure(w, h); }
+    void render(int64_t n, uint8_t* y, uint8_t* uv) override {
+        m_pattern.render(m_kind, (uint64_t)n, y, m_pattern.width(), uv, m_pattern.width());
+    }
+
+private:
+    PatternKind m_kind;
+    TestPattern m_pattern;
+};
+
+/** Uniform noise: nothing to predict, so the largest and slowest VMX frames. */
+class NoiseSource : public FrameSource {
+public:
+    NoiseSource(int w, int h) : m_size((size_t)w * h) { }
+    void render(int64_t n, uint8_t* y, uint8_t* uv) override {
+        uint64_t x = 0x9E3779B97F4A7C15ull * (uint64_t)(n + 1);
+        auto fill = [&x](uint8_t* p, size_t len) {
+            for (size_t i = 0; i + 8 <= len; i += 8) {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                std::memcpy(p + i, &x, 8);
+            }
+        };
+        fill(y, m_size);
+        fill(uv, m_size / 2);
+    }
+
+private:
+    size_t m_size;
+};
+
+/** Raw NV12 or Y4M (4:2:0 planar) file, mmapped and looped. */
+class FileSource : public FrameSource {
+public:
+    ~FileSource() override {
+        if (m_map) munmap(m_map, m_mapLength);
+    }
+
+    /** width/height are required for raw NV12; Y4M supplies its own (and its rate). */
+    bool open(const char* path, int* width, int* height, int* fpsN, int* fpsD, bool* rateFromFile) {
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        struct stat st{};
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+            LOGE("Cannot open %s: %s", path, std::strerror(errno));
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        m_mapLength = (size_t)st.st_size;
+        void* map = mmap(nullptr, m_mapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            LOGE("mmap %s: %s", path, std::strerror(errno));
+            return false;
+        }
+        m_map = static_cast<uint8_t*>(map);
+        madvise(m_map, m_mapLength, MADV_SEQUENTIAL);
+        *rateFromFile = false;
+        if (m_mapLength > 10 && !std::memcmp(m_map, "YUV4MPEG2 ", 10))
+            return parseY4m(width, height, fpsN, fpsD, rateFromFile);
+
+        m_w = *width;
+        m_h = *height;
+        const size_t frameBytes = (size_t)m_w * m_h * 3 / 2;
+        for (size_t off = 0; off + frameBytes <= m_mapLength; off += frameBytes) m_frames.push_back(off);
+        if (m_frames.empty()) {
+            LOGE("%s is smaller than one %dx%d NV12 frame", path, m_w, m_h);
+            return false;
+        }
+        LOGI("%s: %zu raw NV12 frames %dx%d", path, m_frames.size(), m_w, m_h);
+        return true;
+    }
+
+    void render(int64_t n, uint8_t* y, uint8_t* uv) override {
+        const uint8_t* src = m_map + m_frames[(size_t)(n % (int64_t)m_frames.size())];
+        const size_t ySize = (size_t)m_w * m_h;
+        if (!m_planar) {
+            std::memcpy(y, src, ySize);
+            std::memcpy(uv, src + ySize, ySize / 2);
+            return;
+        }
+        const uint8_t* u = src + ySize;
+        const uint8_t* v = u + ySize / 4;
+        packNv12(src, m_w, u, m_w / 2, 1, v, m_w / 2, 1, y, uv, m_w, m_h);
+    }
+
+private:
+    bool parseY4m(int* width, int* height, int* fpsN, int* fpsD, bool* rateFromFile) {
+        const uint8_t* end = m_map + m_mapLength;
+        const uint8_t* eol = static_cast<const uint8_t*>(std::memchr(m_map, '\n', m_mapLength));
+        if (!eol) return false;
+        std::string header(reinterpret_cast<const char*>(m_map), (size_t)(eol - m_map));
+        int w = 0, h = 0, fn = 0, fd = 0;
+        std::string chroma = "420";
+        size_t pos = 0;
+        while ((pos = header.find(' ', pos)) != std::string::npos) {
+            const char* tok = header.c_str() + ++pos;
+            switch (*tok) {
+            case 'W': w = std::atoi(tok + 1); break;
+            case 'H': h = std::atoi(tok + 1); break;
+            case 'F': std::sscanf(tok + 1, "%d:%d", &fn, &fd); break;
+            case 'C': chroma = std::string(tok + 1, std::strcspn(tok + 1, " ")); break;
+            default: break;
+            }
+        }
+        if (w <= 0 || h <= 0 || (w | h) & 1 || chroma.compare(0, 3, "420") != 0) {
+            LOGE("Unsupported Y4M stream %dx%d C%s (need even 4:2:0)", w, h, chroma.c_str());
+            return false;
+        }
+        m_w = w;
+        m_h = h;
+        m_planar = true;
+        const size_t frameBytes = (size_t)w * h * 3 / 2;
+        for (const uint8_t* p = eol + 1; p + 5 < end && !std::memcmp(p, "FRAME", 5);) {
+            const uint8_t* nl = static_cast<const uint8_t*>(std::memchr(p, '\n', (size_t)(end - p)));
+            if (!nl || (size_t)(end - nl - 1) < frameBytes) break;
+            m_frames.push_back((size_t)(nl + 1 - m_map));
+            p = nl + 1 + frameBytes;
+        }
+        if (m_frames.empty()) {
+            LOGE("Y4M stream has no complete frames");
+            return false;
+        }
+        *width = w;
+        *height = h;
+        if (fn > 0 && fd > 0) {
+            *fpsN = fn;
+            *fpsD = fd;
+            *rateFromFile = true;
+        }
+        LOGI("Y4M: %zu frames %dx%d @ %d/%d", m_frames.size(), w, h, fn, fd);
+        return true;
+    }
+
+    uint8_t* m_map = nullptr;
+    size_t m_mapLength = 0;
+    std::vector<size_t> m_frames; // offsets of each frame's Y plane
+    int m_w = 0, m_h = 0;
+    bool m_planar = false;
+};
+
+// ---- Audio ----
+
+/** 1 kHz tone at -20 dBFS, packed as FPA1 planar float like CameraStreamSender. */
+class ToneSource {
+public:
+    ToneSource() : m_payload((size_t)AUDIO_SAMPLES_PER_CHANNEL * AUDIO_CHANNELS * 4) { }
+    const uint8_t* next() {
+        for (int i = 0; i < AUDIO_SAMPLES_PER_CHANNEL; i++) {
+            float s = 0.1f * std::sin(m_phase);
+            m_phase += 2.0f * (float)M_PI * 1000.0f / AUDIO_SAMPLE_RATE;
+            if (m_phase > 2.0f * (float)M_PI) m_phase -= 2.0f * (float)M_PI;
+            uint32_t bits;
+            std::memcpy(&bits, &s, 4);
+            for (int c = 0; c < AUDIO_CHANNELS; c++)
+                putU32(m_payload.data() + ((size_t)c * AUDIO_SAMPLES_PER_CHANNEL + i) * 4, bits);
+        }
+        return m_payload.data();
+    }
+    size_t size() const { return m_payload.size(); }
+
+private:
+    std::vector<uint8_t> m_payload;
+    float m_phase = 0;
+};
+
+// ---- Reporting ----
+
+struct Interval {
+    uint64_t frames = 0;
+    uint64_t late = 0;    // published after the following frame's deadline
+    uint64_t skipped = 0; // deadlines given up to catch up
+    uint64_t bytes = 0;
+    LatencyHistogram error;  // |actual send interval − frame period|
+    LatencyHistogram encode;
+    int64_t firstSendNs = 0;
+    int64_t lastSendNs = 0;
+    uint64_t qualitySamples = 0;
+    double psnrSum = 0;
+    double ssimSum = 0;
+    double psnrMin = 0;
+
+    void reset() {
+        frames = late = skipped = bytes = qualitySamples = 0;
+        error.reset();
+        encode.reset();
+        firstSendNs = lastSendNs = 0;
+        psnrSum = ssimSum = psnrMin = 0;
+    }
+    void sent(int64_t now) {
+        if (!firstSendNs) firstSendNs = now;
+        lastSendNs = now;
+    }
+    void measured(const QualityResult& q) {
+        psnrMin = qualitySamples ? std::min(psnrMin, q.psnr) : q.psnr;
+        qualitySamples++;
+        psnrSum += q.psnr;
+        ssimSum += q.ssim;
+    }
+};
+
+/** Rates are measured between the first and last send, so time without subscribers does not count. */
+void report(const char* prefix, const Interval& iv, double targetFps, const Sender& sender) {
+    const double seconds = (iv.lastSendNs - iv.firstSendNs) / 1e9;
+    if (iv.frames < 2 || seconds <= 0) {
+        std::printf("%s no subscribers | clients %d\n", prefix, sender.videoClientCount());
+        std::fflush(stdout);
+        return;
+    }
+    const double fps = (iv.frames - 1) / seconds;
+    HistogramSnapshot err = iv.error.snapshot();
+    HistogramSnapshot enc = iv.encode.snapshot();
+    char quality[96] = "";
+    if (iv.qualitySamples > 0)
+        std::snprintf(quality, sizeof(quality), " | psnr %.2f (min %.2f) dB ssim %.4f",
+                      iv.psnrSum / iv.qualitySamples, iv.psnrMin, iv.ssimSum / iv.qualitySamples);
+    char shm[64] = "";
+    if (sender.sharedMemoryClientCount() > 0 || sender.multicastClientCount() > 0 || sender.nvlzClientCount() > 0)
+        std::snprintf(shm, sizeof(shm), " (%d shm, %d multicast, %d nvlz)", sender.sharedMemoryClientCount(),
+                      sender.multicastClientCount(), sender.nvlzClientCount());
+    std::printf("%s %7.3f fps (%+.3f%%) | interval err p50=%.2f p99=%.2f max=%.2fms | late %llu skipped %llu"
+                " | enc %.2f/%.2fms | %6.1f Mbit/s%s | clients %d%s drops %llu\n",
+                prefix, fps, (fps / targetFps - 1) * 100, err.p50 / 1e6, err.p99 / 1e6, err.max / 1e6,
+                (unsigned long long)iv.late, (unsigned long long)iv.skipped, enc.mean / 1e6, enc.p99 / 1e6,
+                iv.bytes * 8 / seconds / 1e6, quality, sender.videoClientCount(), shm,
+                (unsigned long long)statsDropCount(DROP_SLOW_CLIENT));
+    std::fflush(stdout);
+}
+
+/** Proxy totals since start: frames written, due frames passed over, cost per frame. */
+void reportProxy(const char* prefix, const ProxyRecorder& proxy) {
+    std::printf("%s %llu frames %.1f MB | skipped busy %llu budget %llu | %.2f ms/frame (budget %d%% of a core)\n",
+                prefix, (unsigned long long)proxy.framesEncoded(), proxy.bytesWritten() / 1e6,
+                (unsigned long long)proxy.framesSkippedBusy(), (unsigned long long)proxy.framesSkippedBudget(),
+                proxy.meanCostNs() / 1e6, proxy.config().cpuPercent);
+    std::fflush(stdout);
+}
+
+void reportMulticast(const char* prefix, const MulticastSender& mcast) {
+    std::printf("%s %s:%d | %llu frames sent, %llu dropped | %llu datagrams %.1f MB\n", prefix,
+                mcast.config().group.c_str(), mcast.config().port, (unsigned long long)mcast.framesSent(),
+                (unsigned long long)mcast.framesDropped(), (unsigned long long)mcast.datagramsSent(),
+                mcast.bytesSent() / 1e6);
+    std::fflush(stdout);
+}
+
+bool parseSize(const char* s, int* w, int* h) {
+    return std::sscanf(s, "%dx%d", w, h) == 2 && *w > 0 && *h > 0 && !(*w & 1) && !(*h & 1);
+}
+
+bool parseRate(const char* s, int* n, int* d) {
+    if (std::sscanf(s, "%d/%d", n, d) == 2) return *n > 0 && *d > 0;
+    double fps = std::atof(s);
+    if (fps <= 0) return false;
+    *n = (int)std::lround(fps * 1000);
+    *d = 1000;
+    if (*n % 1000 == 0) { *n /= 1000; *d = 1; }
+    return true;
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: omt_source [--port n] [--name s] [--size WxH] [--fps r|n/d] [--codec vmx1|nv12]\n"
+                 "                  [--pattern bars|zoneplate|ramp|noise] [--counter]\n"
+                 "                  [--file in.nv12|in.y4m] [--audio] [--stamp]\n"
+                 "                  [--burn n] [--no-advertise] [--address ip] [--duration sec] [--interval sec]\n"
+                 "                  [--quality sec] [--proxy BASE] [--proxy-spec W[xH][@FPS][,CPU%%]] [--shm MB]\n"
+                 "                  [--multicast [GROUP][:PORT][,FEC]] [--no-nvlz]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--port") && hasValue) opt.port = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--name") && hasValue) opt.name = argv[++i];
+        else if (!std::strcmp(a, "--address") && hasValue) opt.address = argv[++i];
+        else if (!std::strcmp(a, "--no-advertise")) opt.advertise = false;
+        else if (!std::strcmp(a, "--size") && hasValue) {
+            if (!parseSize(argv[++i], &opt.width, &opt.height)) { usage(); return 2; }
+        } else if (!std::strcmp(a, "--fps") && hasValue) {
+            if (!parseRate(argv[++i], &opt.fpsN, &opt.fpsD)) { usage(); return 2; }
+            opt.fpsGiven = true;
+        } else if (!std::strcmp(a, "--codec") && hasValue) {
+            const char* c = argv[++i];
+            if (!strcasecmp(c, "vmx1")) opt.codec = CODEC_VMX1;
+            else if (!strcasecmp(c, "nv12")) opt.codec = CODEC_NV12;
+            else { usage(); return 2; }
+        } else if (!std::strcmp(a, "--pattern") && hasValue) {
+            PatternKind kind;
+            opt.pattern = argv[++i];
+            if (std::strcmp(opt.pattern, "noise") && !parsePatternKind(opt.pattern, &kind)) { usage(); return 2; }
+        } else if (!std::strcmp(a, "--file") && hasValue) opt.file = argv[++i];
+        else if (!std::strcmp(a, "--audio")) opt.audio = true;
+        else if (!std::strcmp(a, "--counter")) opt.counter = true;
+        else if (!std::strcmp(a, "--stamp")) opt.stamp = true;
+        else if (!std::strcmp(a, "--no-nvlz")) opt.nvlz = false;
+        else if (!std::strcmp(a, "--burn") && hasValue) opt.burn = std::max(0, std::atoi(argv[++i]));
+        else if (!std::strcmp(a, "--duration") && hasValue) opt.durationSec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--interval") && hasValue) opt.intervalSec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--quality") && hasValue) opt.qualitySec = std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--proxy") && hasValue) opt.proxyBase = argv[++i];
+        else if (!std::strcmp(a, "--proxy-spec") && hasValue) opt.proxySpec = argv[++i];
+        else if (!std::strcmp(a, "--shm") && hasValue) opt.shmBytes = (size_t)std::max(0, std::atoi(argv[++i])) << 20;
+        else if (!std::strcmp(a, "--multicast") && hasValue) {
+            MulticastConfig mc;
+            opt.multicast = argv[++i];
+            if (!parseMulticastSpec(opt.multicast, &mc)) { usage(); return 2; }
+        }
+        else { usage(); return 2; }
+    }
+    if (opt.port < 0 || opt.intervalSec <= 0 || opt.qualitySec < 0) { usage(); return 2; }
+    ProxyConfig proxyConfig;
+    if (opt.proxySpec && !parseProxySpec(opt.proxySpec, &proxyConfig)) { usage(); return 2; }
+
+    std::unique_ptr<FrameSource> source;
+    if (opt.file) {
+        auto file = std::make_unique<FileSource>();
+        bool rateFromFile = false;
+        int fpsN = opt.fpsN, fpsD = opt.fpsD;
+        if (!file->open(opt.file, &opt.width, &opt.height, &fpsN, &fpsD, &rateFromFile)) return 1;
+        if (rateFromFile && !opt.fpsGiven) {
+            opt.fpsN = fpsN;
+            opt.fpsD = fpsD;
+        }
+        source = std::move(file);
+    } else if (!std::strcmp(opt.pattern, "noise")) {
+        source = std::make_unique<NoiseSource>(opt.width, opt.height);
+    } else {
+        PatternKind kind = PATTERN_BARS;
+        parsePatternKind(opt.pattern, &kind);
+        source = std::make_unique<PatternSource>(kind, opt.width, opt.height);
+    }
+    TestPattern counter;
+    if (opt.counter) counter.configure(opt.width, opt.height);
+    const int w = opt.width, h = opt.height;
+    const size_t ySize = (size_t)w * h, uvSize = (size_t)w * (h / 2);
+
+    void* encoder = nullptr;
+    if (opt.codec == CODEC_VMX1) {
+        encoder = vmxLoad() ? vmxCreate(w, h, 0, "encoder") : nullptr;
+        if (!encoder) {
+            LOGE("VMX encoder unavailable for %dx%d (libvmx.so / OMT_LIBVMX); use --codec nv12", w, h);
+            return 1;
+        }
+    }
+    // Same bound as CameraStreamSender's vmxOutputBuf
+    const size_t payloadCapacity = opt.codec == CODEC_VMX1 ? ySize * 2 : ySize + uvSize;
+
+    // Quality sampling decodes a copy of the payload after it is published (the sender owns the packet).
+    void* decoder = nullptr;
+    QualityMeter meter;
+    std::vector<uint8_t> qualityCopy;
+    if (opt.qualitySec > 0) {
+        if (!encoder || !vmxCanDecode() || !(decoder = vmxCreate(w, h, 0, "decoder")) || !meter.configure(w, h)) {
+            LOGE("--quality needs --codec vmx1 and a libvmx with decode support");
+            if (encoder) vmxDestroy(encoder);
+            return 1;
+        }
+        qualityCopy.resize(payloadCapacity);
+        LOGI("Sampling quality every %.1f s (%s kernels)", opt.qualitySec, qualityKernelName());
+    }
+
+    std::unique_ptr<ProxyRecorder> proxy;
+    if (opt.proxyBase) {
+        proxyConfig.basePath = opt.proxyBase;
+        proxy = std::make_unique<ProxyRecorder>(proxyConfig);
+        if (!proxy->start()) return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    SenderConfig sc;
+    sc.port = opt.port;
+    sc.frameBytesHint = HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + payloadCapacity;
+    sc.sharedMemoryBytes = opt.shmBytes;
+    if (opt.multicast) sc.multicast = opt.multicast;
+    sc.nvlz = opt.nvlz;
+    Sender sender(sc);
+    if (!sender.start()) return 1;
+    LOGI("Serving %dx%d @ %d/%d %s on port %d", w, h, opt.fpsN, opt.fpsD,
+         opt.codec == CODEC_VMX1 ? "VMX1" : "NV12", sender.port());
+
+    MdnsAdvertiser mdns;
+    if (opt.advertise && !mdns.start(opt.name, sender.port(), opt.address))
+        LOGW("Not advertised; connect to port %d directly", sender.port());
+
+    std::vector<std::thread> burners;
+    std::atomic<bool> burning{true};
+    for (int i = 0; i < opt.burn; i++)
+        burners.emplace_back([&burning] {
+            volatile uint64_t x = 1;
+            while (burning.load(std::memory_order_relaxed)) x = x * 6364136223846793005ull + 1;
+        });
+
+    std::vector<uint8_t> frameY(ySize), frameUV(uvSize);
+    ToneSource tone;
+    VideoHeader vh;
+    vh.codec = opt.codec;
+    vh.width = w;
+    vh.height = h;
+    vh.frameRateN = opt.fpsN;
+    vh.frameRateD = opt.fpsD;
+    AudioHeader ah;
+    ah.samplesPerChannel = AUDIO_SAMPLES_PER_CHANNEL;
+    ah.channels = AUDIO_CHANNELS;
+
+    const double periodNs = 1e9 * opt.fpsD / opt.fpsN;
+    const double targetFps = (double)opt.fpsN / opt.fpsD;
+    const int64_t startNs = nowNs() + 100000000; // first frame 100 ms out
+    int64_t frameIndex = 0;                      // deadline n = start + n * period
+    int64_t frameNumber = 0;                     // frames actually produced (pattern/file position)
+    int64_t nextAudioNs = startNs;
+    int64_t lastSendNs = 0;
+    Interval interval, total;
+    int64_t nextReport = startNs + (int64_t)(opt.intervalSec * 1e9);
+    int64_t nextQuality = startNs;
+    const int64_t endNs = opt.durationSec > 0 ? startNs + (int64_t)(opt.durationSec * 1e9) : INT64_MAX;
+
+    while (!s_stop.load()) {
+        const int64_t videoDeadline = startNs + (int64_t)std::llround(frameIndex * periodNs);
+        if (opt.audio && nextAudioNs < videoDeadline) {
+            sleepUntil(nextAudioNs);
+            if (sender.audioClientCount() > 0) sender.sendAudio(ah, nextAudioNs / 100, tone.next(), tone.size());
+            nextAudioNs += AUDIO_PERIOD_NS;
+            continue;
+        }
+        if (videoDeadline >= endNs) break;
+        sleepUntil(videoDeadline);
+        if (s_stop.load()) break;
+
+        // Render and encode only for subscribers (or a due proxy frame), like the app; the clock keeps running.
+        const bool live = sender.videoClientCount() > 0;
+        const bool rendered = live || (proxy && proxy->due());
+        if (rendered) {
+            source->render(frameNumber, frameY.data(), frameUV.data());
+            if (opt.counter) counter.drawCounter((uint64_t)frameNumber, frameY.data(), w, frameUV.data(), w);
+            if (opt.stamp) timecodeStampNv12(frameY.data(), w, frameUV.data(), w, w, h, (uint64_t)(videoDeadline / 1000));
+            if (!live) frameNumber++;
+        }
+        if (live) {
+            Packet* packet = sender.beginVideo(payloadCapacity);
+            uint8_t* payload = packet->payload() + VIDEO_EXT_HEADER_SIZE;
+            const int64_t encStart = nowNs();
+            int len;
+            if (encoder) {
+                len = vmxEncode(encoder, frameY.data(), w, frameUV.data(), w, payload, (int)payloadCapacity);
+            } else {
+                std::memcpy(payload, frameY.data(), ySize);
+                std::memcpy(payload + ySize, frameUV.data(), uvSize);
+                len = (int)(ySize + uvSize);
+            }
+            const int64_t encNs = nowNs() - encStart;
+            if (len <= 0) {
+                LOGW("Encode failed on frame %lld", (long long)frameNumber);
+                statsRecordDrop(DROP_ENCODE_FAILED);
+                sender.discard(packet);
+            } else {
+                const bool sample = decoder && videoDeadline >= nextQuality;
+                if (sample) std::memcpy(qualityCopy.data(), payload, (size_t)len);
+                // Timestamps follow the schedule (100 ns units); send-time jitter shows up at receivers.
+                sender.publishVideo(packet, vh, videoDeadline / 100, (size_t)len);
+                const int64_t sentNs = nowNs();
+                QualityResult q;
+                if (sample) {
+                    nextQuality = videoDeadline + (int64_t)(opt.qualitySec * 1e9);
+                    if (meter.measureEncoded(decoder, qualityCopy.data(), len, frameY.data(), w, frameUV.data(), w, &q)) {
+                        interval.measured(q);
+                        total.measured(q);
+                    } else {
+                        LOGW("Quality sample: decode failed on frame %lld", (long long)frameNumber);
+                    }
+                }
+                for (Interval* iv : {&interval, &total}) {
+                    iv->sent(sentNs);
+                    iv->frames++;
+                    iv->bytes += HEADER_SIZE + VIDEO_EXT_HEADER_SIZE + (size_t)len;
+                    iv->encode.record((uint64_t)encNs);
+                    if (lastSendNs > 0) iv->error.record((uint64_t)std::llabs(sentNs - lastSendNs - (int64_t)periodNs));
+                }
+                lastSendNs = sentNs;
+                frameNumber++;
+            }
+        } else {
+            lastSendNs = 0;
+        }
+        // After the live send, so the proxy never delays it
+        if (proxy && rendered) proxy->offer(frameY.data(), w, frameUV.data(), w, w, h, videoDeadline / 100);
+        frameIndex++;
+
+        // A frame finished past the next deadline is late; more than a whole period behind, skip ahead.
+        const int64_t now = nowNs();
+        const int64_t nextDeadline = startNs + (int64_t)std::llround(frameIndex * periodNs);
+        if (now > nextDeadline && lastSendNs > 0) {
+            interval.late++;
+            total.late++;
+            const int64_t behind = (int64_t)((now - nextDeadline) / periodNs);
+            if (behind > 0) {
+                frameIndex += behind;
+                interval.skipped += (uint64_t)behind;
+                total.skipped += (uint64_t)behind;
+            }
+        }
+        if (now >= nextReport) {
+            report("[src]", interval, targetFps, sender);
+            if (proxy) reportProxy("[proxy]", *proxy);
+            if (sender.multicast()) reportMulticast("[multicast]", *sender.multicast());
+            interval.reset();
+            nextReport = now + (int64_t)(opt.intervalSec * 1e9);
+        }
+    }
+
+    burning.store(false);
+    for (auto& t : burners) t.join();
+    report("[summary]", total, targetFps, sender);
+    if (sender.multicast()) reportMulticast("[summary multicast]", *sender.multicast());
+    if (proxy) {
+        proxy->stop();
+        reportProxy("[summary proxy]", *proxy);
+    }
+    mdns.stop();
+    sender.stop();
+    if (decoder) vmxDestroy(decoder);
+    if (encoder) vmxDestroy(encoder);
+    return 0;
+}
@@ -0,0 +1,52 @@
+/**
+ * JNI bindings for the native span tracer in core/omt_trace.
+ * Span calls are cheap no-ops while tracing is disabled.
+ */
+#include <jni.h>
+#include <cstdint>
+
+#include "omt_trace.h"
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtTrace_nativeIsEnabled(JNIEnv* env, jclass) {
+    return omt::traceEnabled() ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtTrace_nativeSetEnabled(JNIEnv* env, jclass, jboolean enabled) {
+    omt::traceSetEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtTrace_nativeBegin(JNIEnv* env, jclass, jint nameId, jlong arg) {
+    omt::traceBegin((uint32_t)nameId, arg);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtTrace_nativeEnd(JNIEnv* env, jclass, jint nameId) {
+    omt::traceEnd((uint32_t)nameId);
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtTrace_nativeInstant(JNIEnv* env, jclass, jint nameId, jlong arg) {
+    omt::traceInstant((uint32_t)nameId, arg);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_omt_camera_OmtTrace_nativeDump(JNIEnv* env, jclass, jstring jPath) {
+    if (!jPath) return JNI_FALSE;
+    const char* path = env->GetStringUTFChars(jPath, nullptr);
+    if (!path) return JNI_FALSE;
+    bool ok = omt::traceDumpChromeJson(path);
+    env->ReleaseStringUTFChars(jPath, path);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_omt_camera_OmtTrace_nativeClear(JNIEnv* env, jclass) {
+    omt::traceClear();
+}
+
+} // extern "C"
@@ -0,0 +1,219 @@
+/**
+ * Stand-in libvmx for Linux hosts. Exports the same C symbols the JNI/core
+ * loader resolves (VMX_Create, VMX_EncodeNV12, VMX_SaveTo, VMX_LoadFrom,
+ * VMX_DecodeBGRA, VMX_GetThreads/SetThreads, VMX_Destroy) so the whole codec
+ * path can run without the proprietary library. Never packaged into the APK.
+ *
+ * The "bitstream" is a block-averaged copy of the image padded to a target
+ * size, so a round trip yields a recognisable (if soft) picture:
+ *
+ *   [0]  "VMXS"  [4] width  [8] height  [12] block factor  [16] base length
+ *   [20] Y blocks  | UV blocks (interleaved)  | filler up to the target size
+ *
+ * Cost and size are configurable per process through environment variables,
+ * read when an instance is created:
+ *   VMX_STUB_BPP            output bits per pixel (default 3.0, 2.0 for the OMT LQ
+ *                           profile; < 3 uses 4x4 blocks)
+ *   VMX_STUB_ENCODE_NS      encode cost in ns per pixel, single thread (default 6)
+ *   VMX_STUB_DECODE_NS      decode cost in ns per pixel, single thread (default 4)
+ *   VMX_STUB_FAIL_EVERY     make every Nth encode fail (default 0 = never)
+ * The cost is burned on the calling thread, divided by the thread count set
+ * through VMX_SetThreads, so wall time scales like a threaded codec would.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "omt_pixel.h"
+#include "omt_protocol.h"
+
+typedef struct { int width; int height; } VMX_SIZE;
+typedef unsigned char BYTE;
+
+namespace {
+
+enum { STUB_OK = 0, STUB_ERR = 1 };
+constexpr uint32_t kMagic = 0x53584D56; // "VMXS"
+constexpr int kStreamHeader = 20;
+constexpr int kProfileOmtLq = 133;
+
+struct StubCodec {
+    int width = 0;
+    int height = 0;
+    int profile = 0;
+    int threads = 1;
+    int factor = 2;
+    double bpp = 3.0;
+    double encodeNsPerPixel = 6.0;
+    double decodeNsPerPixel = 4.0;
+    long failEvery = 0;
+    long encodeCount = 0;
+    std::vector<uint8_t> stream;    // last encoded or loaded bitstream
+    std::vector<uint8_t> planeY;    // decode scratch (full-res NV12)
+    std::vector<uint8_t> planeUV;
+};
+
+double envDouble(const char* name, double def) {
+    const char* v = std::getenv(name);
+    return v && *v ? std::atof(v) : def;
+}
+
+int blocksFor(int size, int factor) { return (size + factor - 1) / factor; }
+
+/** Busy-wait until the configured per-frame cost has elapsed since start. */
+void burn(std::chrono::steady_clock::time_point start, double nsPerPixel, int pixels, int threads) {
+    if (nsPerPixel <= 0) return;
+    auto budget = std::chrono::nanoseconds((int64_t)(nsPerPixel * pixels / (threads > 0 ? threads : 1)));
+    while (std::chrono::steady_clock::now() - start < budget) { }
+}
+
+/** Average factor x factor blocks of a plane with `comps` interleaved components. */
+void downsample(const uint8_t* src, int stride, int w, int h, int comps, int factor, uint8_t* out) {
+    const int bw = blocksFor(w, factor), bh = blocksFor(h, factor);
+    for (int by = 0; by < bh; by++) {
+        for (int bx = 0; bx < bw; bx++) {
+            for (int c = 0; c < comps; c++) {
+                int sum = 0, n = 0;
+                for (int yy = by * factor; yy < h && yy < (by + 1) * factor; yy++)
+                    for (int xx = bx * factor; xx < w && xx < (bx + 1) * factor; xx++, n++)
+                        sum += src[(size_t)yy * stride + xx * comps + c];
+                *out++ = (uint8_t)(n ? (sum + n / 2) / n : 0);
+            }
+        }
+    }
+}
+
+void upsample(const uint8_t* blocks, int w, int h, int comps, int factor, uint8_t* dst) {
+    const int bw = blocksFor(w, factor);
+    for (int yy = 0; yy < h; yy++) {
+        const uint8_t* row = blocks + (size_t)(yy / factor) * bw * comps;
+        uint8_t* out = dst + (size_t)yy * w * comps;
+        for (int xx = 0; xx < w; xx++)
+            for (int c = 0; c < comps; c++) out[xx * comps + c] = row[(xx / factor) * comps + c];
+    }
+}
+
+size_t baseLength(int w, int h, int factor) {
+    size_t y = (size_t)blocksFor(w, factor) * blocksFor(h, factor);
+    size_t uv = (size_t)blocksFor(w / 2, factor) * blocksFor(h / 2, factor) * 2;
+    return y + uv;
+}
+
+} // namespace
+
+extern "C" {
+
+__attribute__((visibility("default")))
+void* VMX_Create(VMX_SIZE size, int profile, int colorSpace) {
+    (void)colorSpace;
+    if (size.width < 16 || size.height < 16 || (size.width & 1) || (size.height & 1)) return nullptr;
+    auto* c = new StubCodec();
+    c->width = size.width;
+    c->height = size.height;
+    c->profile = profile;
+    c->threads = (int)std::thread::hardware_concurrency();
+    if (c->threads <= 0) c->threads = 1;
+    c->bpp = envDouble("VMX_STUB_BPP", profile == kProfileOmtLq ? 2.0 : 3.0);
+    c->factor = c->bpp >= 3.0 ? 2 : 4;
+    c->encodeNsPerPixel = envDouble("VMX_STUB_ENCODE_NS", 6.0);
+    c->decodeNsPerPixel = envDouble("VMX_STUB_DECODE_NS", 4.0);
+    c->failEvery = (long)envDouble("VMX_STUB_FAIL_EVERY", 0);
+    size_t base = baseLength(c->width, c->height, c->factor);
+    size_t target = (size_t)(c->bpp * c->width * c->height / 8.0);
+    c->stream.reserve(kStreamHeader + (target > base ? target : base));
+    return c;
+}
+
+__attribute__((visibility("default")))
+void VMX_Destroy(void* inst) {
+    delete static_cast<StubCodec*>(inst);
+}
+
+__attribute__((visibility("default")))
+int VMX_GetThreads(void* inst) {
+    return inst ? static_cast<StubCodec*>(inst)->threads : 0;
+}
+
+__attribute__((visibility("default")))
+void VMX_SetThreads(void* inst, int numThreads) {
+    if (inst && numThreads > 0) static_cast<StubCodec*>(inst)->threads = numThreads;
+}
+
+__attribute__((visibility("default")))
+int VMX_EncodeNV12(void* inst, BYTE* srcY, int srcStrideY, BYTE* srcUV, int srcStrideUV, int interlaced) {
+    (void)interlaced;
+    auto* c = static_cast<StubCodec*>(inst);
+    if (!c || !srcY || !srcUV) return STUB_ERR;
+    auto start = std::chrono::steady_clock::now();
+    c->encodeCount++;
+    if (c->failEvery > 0 && c->encodeCount % c->failEvery == 0) return STUB_ERR;
+
+    const int w = c->width, h = c->height, f = c->factor;
+    const size_t base = baseLength(w, h, f);
+    size_t target = (size_t)(c->bpp * w * h / 8.0);
+    if (target < base) target = base;
+    c->stream.resize(kStreamHeader + target);
+    uint8_t* p = c->stream.data();
+    omt::putU32(p, kMagic);
+    omt::putU32(p + 4, (uint32_t)w);
+    omt::putU32(p + 8, (uint32_t)h);
+    omt::putU32(p + 12, (uint32_t)f);
+    omt::putU32(p + 16, (uint32_t)base);
+    uint8_t* yBlocks = p + kStreamHeader;
+    downsample(srcY, srcStrideY, w, h, 1, f, yBlocks);
+    downsample(srcUV, srcStrideUV, w / 2, h / 2, 2, f, yBlocks + (size_t)blocksFor(w, f) * blocksFor(h, f));
+    // Deterministic filler so compressibility looks like entropy-coded data
+    uint32_t x = (uint32_t)c->encodeCount * 2654435761u;
+    for (size_t i = kStreamHeader + base; i < c->stream.size(); i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        p[i] = (uint8_t)x;
+    }
+    burn(start, c->encodeNsPerPixel, w * h, c->threads);
+    return STUB_OK;
+}
+
+__attribute__((visibility("default")))
+int VMX_SaveTo(void* inst, BYTE* dst, int maxLen) {
+    auto* c = static_cast<StubCodec*>(inst);
+    if (!c || !dst || c->stream.empty()) return 0;
+    if ((size_t)maxLen < c->stream.size()) return 0;
+    std::memcpy(dst, c->stream.data(), c->stream.size());
+    return (int)c->stream.size();
+}
+
+__attribute__((visibility("default")))
+int VMX_LoadFrom(void* inst, BYTE* data, int dataLen) {
+    auto* c = static_cast<StubCodec*>(inst);
+    if (!c || !data || dataLen < kStreamHeader) return STUB_ERR;
+    if (omt::getU32(data) != kMagic) return STUB_ERR;
+    int w = (int)omt::getU32(data + 4), h = (int)omt::getU32(data + 8), f = (int)omt::getU32(data + 12);
+    size_t base = omt::getU32(data + 16);
+    if (w != c->width || h != c->height || (f != 2 && f != 4)) return STUB_ERR;
+    if (base != baseLength(w, h, f) || (size_t)dataLen < kStreamHeader + base) return STUB_ERR;
+    c->stream.assign(data, data + kStreamHeader + base);
+    return STUB_OK;
+}
+
+__attribute__((visibility("default")))
+int VMX_DecodeBGRA(void* inst, BYTE* dst, int stride) {
+    auto* c = static_cast<StubCodec*>(inst);
+    if (!c || !dst || c->stream.size() < (size_t)kStreamHeader) return STUB_ERR;
+    auto start = std::chrono::steady_clock::now();
+    const int w = c->width, h = c->height;
+    const int f = (int)omt::getU32(c->stream.data() + 12);
+    const uint8_t* yBlocks = c->stream.data() + kStreamHeader;
+    c->planeY.resize((size_t)w * h);
+    c->planeUV.resize((size_t)w * (h / 2));
+    upsample(yBlocks, w, h, 1, f, c->planeY.data());
+    upsample(yBlocks + (size_t)blocksFor(w, f) * blocksFor(h, f), w / 2, h / 2, 2, f, c->planeUV.data());
+    omt::nv12ToRgba(c->planeY.data(), w, c->planeUV.data(), w, dst, stride, w, h);
+    // libvmx hands out BGRA; the same swap turns our RGBA into it
+    for (int row = 0; row < h; row++) omt::swapBgraToRgba(dst + (size_t)row * stride, (size_t)w);
+    burn(start, c->decodeNsPerPixel, w * h, c->threads);
+    return STUB_OK;
+}
+
+} // extern "C"
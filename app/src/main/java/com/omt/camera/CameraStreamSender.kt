@@ -8,6 +8,7 @@ import android.media.AudioFormat
 import android.media.AudioRecord
 import android.media.MediaRecorder
 import android.os.Process
+import android.os.SystemClock
 import android.util.Log
 import androidx.camera.core.ImageProxy
 import androidx.core.content.ContextCompat
@@ -61,30 +62,62 @@ class CameraStreamSender(
         private const val AUDIO_CHANNELS = 2
         private const val AUDIO_SAMPLES_PER_CHANNEL = 960 // 48000 / 50
         private val SKIP_BUF = ByteArray(8192)
+        private const val MIN_SENSOR_PERIOD_NS = 4_000_000L // 240 fps
+        private const val MAX_CAPTURE_AGE_NS = 1_000_000_000L // sensor timestamp → callback, beyond any pipeline
     }
 
     private data class ClientChannel(
         val socket: Socket,
         val output: OutputStream,
         val subscribedVideo: AtomicBoolean = AtomicBoolean(false),
-        val subscribedAudio: AtomicBoolean = AtomicBoolean(false)
+        val subscribedAudio: AtomicBoolean = AtomicBoolean(false),
+        val statsSlot: Int = -1,
+        val latencyPeer: AtomicBoolean = AtomicBoolean(false), // sent <OMTClockRequest>: gets <OMTLatencyStamp>
+        val multicast: AtomicBoolean = AtomicBoolean(false), // joined the multicast group: media comes from there
+        val nvlz: AtomicBoolean = AtomicBoolean(false) // sent <OMTCodecs Accept="NVLZ" />: NV12 frames go out as NVLZ
     )
 
     @Volatile private var serverSocket: ServerSocket? = null
     private val channels = CopyOnWriteArrayList<ClientChannel>()
+    // Subscriber snapshots, rebuilt when a client subscribes or goes away so the per-frame
+    // paths read an array instead of filtering [channels] on every frame.
+    @Volatile private var videoSubscribers: Array<ClientChannel> = emptyArray()
+    @Volatile private var audioSubscriber: ClientChannel? = null
+    @Volatile private var multicastSubscribers = 0 // video clients taking media from the multicast group
+    @Volatile private var nvlzSubscribers = 0 // video clients on a socket that take NVLZ instead of NV12
+    private val statsSlots = BooleanArray(OmtStats.MAX_CLIENTS) // per-client latency histogram slots
 
     @Volatile private var vmxHandle: Long = 0L
     private var vmxWidth: Int = 0
     private var vmxHeight: Int = 0
     private var vmxOutputBuf: ByteArray? = null
     @Volatile private var vmxEncodeLogged = false
+    // NVLZ for receivers that accept it when VMX is unavailable (encode thread only)
+    private var lz4Handle = 0L
+    private var nvlzBuf: ByteArray? = null
+    // debug.omt.quality: decode one sent frame per period and compare (encode thread only)
+    private var qualityPeriodNs = 0L
+    private var qualityHandle = 0L
+    private var qualityWidth = 0
+    private var qualityHeight = 0
+    private var nextQualityAt = 0L
+    private var lastQuality: OmtQuality.Result? = null
+    // debug.omt.record: every frame sent is also copied to a local recording (encode + audio threads)
+    @Volatile private var recordHandle = 0L
+    // debug.omt.proxy: low-resolution proxy recording, offered each frame after it is sent (encode thread)
+    @Volatile private var proxyHandle = 0L
+    // debug.omt.multicast: one transmission per frame for every monitoring receiver that joined (encode + audio threads)
+    @Volatile private var multicastHandle = 0L
     @Volatile private var frameCount = 0L
     @Volatile private var noClientLogCount = 0
 
     private val running = AtomicBoolean(false)
+    @Volatile private var latencyMode = false
     private val audioEnabled = AtomicBoolean(true)
     private var acceptThread: Thread? = null
     private var encodeThread: Thread? = null
+    private var patternThread: Thread? = null
+    @Volatile private var patternMode = false // debug.omt.pattern: camera frames are ignored
     private var audioThread: Thread? = null
 
     fun setAudioEnabled(enabled: Boolean) {
@@ -100,6 +133,8 @@ class CameraStreamSender(
         var height = 0
         var yStride = 0
         var timestamp = 0L
+        var capturedAt = 0L // start of exposure on the System.nanoTime() clock (the render time for patterns)
+        var packedAt = 0L // System.nanoTime() when the NV12 snapshot completed
         var ready = false
     }
 
@@ -110,12 +145,33 @@ class CameraStreamSender(
     private var fpsFrameCount = 0L
     private var fpsLastLogTime = 0L
 
+    // Camera-side drop detection from sensor timestamp gaps (analyzer thread only)
+    private var lastSensorTimestamp = 0L
+    private var sensorPeriodNs = 0L
+    private val frameIntervalNs = 1_000_000_000L / targetFps.coerceAtLeast(1)
+
     // Reusable buffers to avoid allocation in hot paths
     private val metadataHdrBuf = ByteArray(OMT_HEADER_SIZE)
 
     fun start() {
         if (running.getAndSet(true)) return
+        OmtStats.reset(OmtStats.SIDE_SENDER)
+        lastSensorTimestamp = 0L; sensorPeriodNs = 0L
+        latencyMode = OmtLatency.isModeEnabled()
+        if (latencyMode) Log.i(TAG, "Latency measurement mode: stamping frames")
+        qualityPeriodNs = OmtQuality.periodNs()
+        if (qualityPeriodNs > 0) Log.i(TAG, "Quality sampling every ${qualityPeriodNs / 1_000_000} ms (${OmtQuality.kernelName()} kernels)")
+        OmtMetrics.startIfConfigured()
+        if (context != null && OmtRecorder.isConfigured()) recordHandle = OmtRecorder.start(context)
+        if (context != null && OmtProxy.isConfigured()) proxyHandle = OmtProxy.start(context)
+        if (OmtMulticast.isConfigured()) multicastHandle = OmtMulticast.start()
         encodeThread = thread(name = "OmtEncodeSend") { encodeSendLoop() }
+        val pattern = OmtTestPattern.configured()
+        patternMode = pattern != null
+        if (pattern != null) {
+            Log.i(TAG, "Test pattern mode: ${pattern.name} ${pattern.width}x${pattern.height} @ $targetFps fps")
+            patternThread = thread(name = "OmtPattern") { patternLoop(pattern) }
+        }
         acceptThread = thread(name = "OmtAccept") {
             try {
                 val server = ServerSocket()
@@ -160,9 +216,12 @@ class CameraStreamSender(
         client.sendBufferSize = 512 * 1024
         val channel = ClientChannel(
             socket = client,
-            output = BufferedOutputStream(client.getOutputStream(), 256 * 1024)
+            output = BufferedOutputStream(client.getOutputStream(), 256 * 1024),
+            statsSlot = acquireStatsSlot()
         )
         channels.add(channel)
+        OmtStats.setClientLabel(channel.statsSlot, client.inetAddress?.hostAddress ?: "?")
+        OmtStats.setGauge(OmtStats.GAUGE_CLIENTS, channels.size.toDouble())
         onClientConnected?.invoke(client.inetAddress?.hostAddress ?: "?")
         Log.i(TAG, "Client connected (channels=${channels.size})")
 
@@ -181,6 +240,7 @@ class CameraStreamSender(
         val input = try { DataInputStream(channel.socket.getInputStream()) }
         catch (e: Exception) { removeChannel(channel); return }
         val headerBuf = ByteArray(OMT_HEADER_SIZE)
+        var payload = ByteArray(1024) // grows to the largest metadata frame seen
         try {
             while (running.get() && channel.socket.isConnected) {
                 try {
@@ -195,26 +255,67 @@ class CameraStreamSender(
                     if (version != 1 || dataLen <= 0 || dataLen > 1024 * 1024) {
                         skipBytes(input, dataLen.coerceIn(0, 65536)); continue
                     }
-                    val payload = ByteArray(dataLen)
+                    if (payload.size < dataLen) payload = ByteArray(dataLen)
                     var read = 0
                     while (read < dataLen) {
                         val n = input.read(payload, read, dataLen - read)
                         if (n <= 0) { removeChannel(channel); return }
                         read += n
                     }
+                    val receivedUs = OmtLatency.nowUs()
                     val frameType = headerBuf[1].toInt() and 0xff
                     if (frameType == OMT_FRAME_METADATA) {
-                        val len = payload.indexOfFirst { it == 0.toByte() }.let { if (it < 0) payload.size else it }
+                        var len = 0
+                        while (len < dataLen && payload[len] != 0.toByte()) len++
                         val text = String(payload, 0, len, Charsets.UTF_8)
+                        if (text.contains("OMTClockRequest", ignoreCase = true)) {
+                            val t1 = OmtLatency.parseClockRequest(text)
+                            if (t1 != null) {
+                                channel.latencyPeer.set(true)
+                                try { synchronized(channel.output) {
+                                    OmtLatency.clockReplyXml(t1, receivedUs, OmtLatency.nowUs())
+                                        ?.let { sendMetadataToChannel(channel, it) }
+                                }} catch (_: Exception) {}
+                            }
+                            continue
+                        }
+                        if (text.contains("OMTMulticast", ignoreCase = true)) {
+                            // Without a group there is no answer and the receiver stays on TCP
+                            if (multicastHandle == 0L) continue
+                            if (text.contains("Attached", ignoreCase = true)) {
+                                channel.multicast.set(true)
+                                refreshSubscribers()
+                                Log.i(TAG, "${channel.socket.inetAddress} receiving media from multicast")
+                            } else {
+                                // Under the channels lock: stop() clears the handle under it before deleting the group
+                                val offer = synchronized(channels) {
+                                    multicastHandle.takeIf { it != 0L }?.let { OmtMulticast.offerXml(it) }
+                                }
+                                if (offer != null) {
+                                    try { synchronized(channel.output) { sendMetadataToChannel(channel, offer) } }
+                                    catch (_: Exception) {}
+                                }
+                            }
+                            continue
+                        }
+                        if (text.contains("OMTCodecs", ignoreCase = true)) {
+                            if (text.contains("NVLZ", ignoreCase = true) && OmtLz4.isAvailable() && !channel.nvlz.getAndSet(true)) {
+                                refreshSubscribers()
+                                Log.i(TAG, "${channel.socket.inetAddress} accepts NVLZ")
+                            }
+                            continue
+                        }
                         Log.d(TAG, "Metadata: ${text.take(80)}")
                         if (text.contains("Subscribe", ignoreCase = true) && text.contains("Video", ignoreCase = true)) {
                             channel.subscribedVideo.set(true)
                             // vMix often subscribes to video only; send audio to video clients too
                             channel.subscribedAudio.set(true)
+                            refreshSubscribers()
                             Log.d(TAG, "Subscribe Video from ${channel.socket.inetAddress}")
                         }
                         if (text.contains("Subscribe", ignoreCase = true) && text.contains("Audio", ignoreCase = true)) {
                             channel.subscribedAudio.set(true)
+                            refreshSubscribers()
                             Log.d(TAG, "Subscribe Audio from ${channel.socket.inetAddress}")
                             // Respond immediately to prevent vMix from resetting idle audio channel
                             try { synchronized(channel.output) {
@@ -231,33 +332,104 @@ class CameraStreamSender(
 
     private fun removeChannel(channel: ClientChannel) {
         if (channels.remove(channel)) {
+            refreshSubscribers()
             channel.socket.closeQuietly()
+            releaseStatsSlot(channel.statsSlot)
+            OmtStats.setGauge(OmtStats.GAUGE_CLIENTS, channels.size.toDouble())
             if (channels.none { it.subscribedVideo.get() }) onClientDisconnected?.invoke()
         }
     }
 
+    /** Camera frames are packed for the encode loop while a receiver, the recording or the proxy takes them. */
+    private fun hasVideoConsumers() =
+        videoSubscribers.isNotEmpty() || multicastSubscribers > 0 || recordHandle != 0L || proxyHandle != 0L
+
+    private fun refreshSubscribers() = synchronized(channels) {
+        // Clients on the multicast group get their media from it, not from a socket write each
+        val (grouped, video) = channels.filter { it.subscribedVideo.get() }.partition { it.multicast.get() }
+        videoSubscribers = video.toTypedArray()
+        multicastSubscribers = grouped.size
+        nvlzSubscribers = video.count { it.nvlz.get() }
+        // OMT multiplexes audio+video on one connection: audio goes to the first video client only
+        audioSubscriber = video.firstOrNull { it.subscribedAudio.get() }
+    }
+
     fun stop() {
         running.set(false)
         frameLock.withLock { frameAvailable.signalAll() }
         encodeThread?.join(2000); encodeThread = null
+        patternThread?.join(2000); patternThread = null
         audioThread?.join(2000); audioThread = null
         VmxEncoder.destroy(vmxHandle); vmxHandle = 0L
+        OmtLz4.destroy(lz4Handle); lz4Handle = 0L; nvlzBuf = null
+        OmtQuality.destroy(qualityHandle); qualityHandle = 0L; lastQuality = null; nextQualityAt = 0L
+        OmtRecorder.counters(recordHandle)?.let { Log.i(TAG, "Recording stopped: ${it.format()}") }
+        OmtRecorder.stop(recordHandle); recordHandle = 0L
+        OmtProxy.counters(proxyHandle)?.let { Log.i(TAG, "Proxy stopped: ${it.format()}") }
+        OmtProxy.stop(proxyHandle); proxyHandle = 0L
+        // Client readers may still be answering <OMTMulticast Request>: take the handle from them first
+        val multicast = synchronized(channels) { multicastHandle.also { multicastHandle = 0L } }
+        OmtMulticast.counters(multicast)?.let { Log.i(TAG, "Multicast stopped: ${it.format()}") }
+        OmtMulticast.stop(multicast)
         vmxEncodeLogged = false; frameCount = 0L; noClientLogCount = 0; fpsFrameCount = 0L
         vmxOutputBuf = null
         channels.forEach { it.socket.closeQuietly() }; channels.clear()
+        refreshSubscribers()
         serverSocket?.closeQuietly(); serverSocket = null
         acceptThread?.join(1000); acceptThread = null
+        OmtMetrics.stop()
         onClientDisconnected?.invoke()
     }
 
     fun sendFrame(image: ImageProxy) {
-        if (image.format != ImageFormat.YUV_420_888) return
-        val videoChannels = channels.filter { it.subscribedVideo.get() && it.socket.isConnected }
-        if (videoChannels.isEmpty()) {
+        if (image.format != ImageFormat.YUV_420_888 || patternMode) return
+        val callbackAt = System.nanoTime()
+        if (!hasVideoConsumers()) {
             if (++noClientLogCount <= 3 || noClientLogCount % 90 == 0)
                 Log.i(TAG, "No video clients (channels=${channels.size})")
+            lastSensorTimestamp = 0L
             return
         }
+        val sensorTimestamp = image.imageInfo.timestamp
+        countCameraSkips(sensorTimestamp)
+        OmtStats.count(OmtStats.FRAMES_CAPTURED)
+        OmtTrace.begin(OmtTrace.SEND_FRAME)
+        try {
+            packPendingFrame(image, callbackAt, sensorToMonotonic(sensorTimestamp, callbackAt))
+        } finally { OmtTrace.end(OmtTrace.SEND_FRAME) }
+    }
+
+    /**
+     * The sensor timestamp on the System.nanoTime() clock that latency stamps and the clock
+     * exchange use, so glass-to-glass includes exposure, the ISP and CameraX queueing. Devices
+     * report it on that clock (timestamp source UNKNOWN) or on elapsedRealtimeNanos() (REALTIME),
+     * which runs ahead by the time spent in deep sleep; the frame predates its callback, so the
+     * reading that does is the right one. Falls back to the callback time if neither fits.
+     */
+    private fun sensorToMonotonic(sensorNs: Long, callbackAt: Long): Long {
+        val oldest = callbackAt - MAX_CAPTURE_AGE_NS
+        if (sensorNs in oldest..callbackAt) return sensorNs
+        val realtime = sensorNs - (SystemClock.elapsedRealtimeNanos() - System.nanoTime())
+        return if (realtime in oldest..callbackAt) realtime else callbackAt
+    }
+
+    /**
+     * KEEP_ONLY_LATEST discards frames silently while the analyzer is busy; they show up as
+     * gaps in the sensor timestamps. The shortest gap seen approximates the sensor period,
+     * which may be longer than 1/targetFps when the camera cannot reach the requested rate.
+     */
+    private fun countCameraSkips(sensorTimestamp: Long) {
+        val last = lastSensorTimestamp
+        lastSensorTimestamp = sensorTimestamp
+        if (last == 0L || sensorTimestamp <= last) return
+        val gap = sensorTimestamp - last
+        if (sensorPeriodNs == 0L || gap < sensorPeriodNs) sensorPeriodNs = gap.coerceAtLeast(MIN_SENSOR_PERIOD_NS)
+        val skipped = (gap + sensorPeriodNs / 2) / sensorPeriodNs - 1
+        if (skipped > 0) OmtStats.recordDrop(OmtStats.DROP_CAMERA_BACKPRESSURE, skipped)
+    }
+
+    /** Snapshots the camera planes into [pendingFrame] as NV12 and wakes the encoder. */
+    private fun packPendingFrame(image: ImageProxy, callbackAt: Long, capturedAt: Long) {
         val width = image.width
         val height = image.height
         val yPlane = image.planes[0]
@@ -265,40 +437,132 @@ class CameraStreamSender(
         val vPlane = image.planes[2]
 
         frameLock.withLock {
+            if (pendingFrame.ready) OmtStats.recordDrop(OmtStats.DROP_PENDING_OVERWRITE)
             val ySize = width * height
-            val uvSize = width * (height / 2)
-            if (pendingFrame.yData == null || pendingFrame.yData!!.size != ySize)
-                pendingFrame.yData = ByteArray(ySize)
-            if (pendingFrame.uvData == null || pendingFrame.uvData!!.size != uvSize)
-                pendingFrame.uvData = ByteArray(uvSize)
-
-            val yBuf = yPlane.buffer.duplicate()
-            val rowStride = yPlane.rowStride
+            ensurePendingBuffers(width, height)
+
             val yArr = pendingFrame.yData!!
-            if (rowStride == width) {
-                yBuf.get(yArr, 0, ySize)
-            } else {
-                for (row in 0 until height) {
-                    yBuf.position(row * rowStride)
-                    yBuf.get(yArr, row * width, width)
+            val packed = VmxEncoder.packNv12(
+                yPlane.buffer, yPlane.rowStride,
+                uPlane.buffer, uPlane.rowStride, uPlane.pixelStride,
+                vPlane.buffer, vPlane.rowStride, vPlane.pixelStride,
+                yArr, pendingFrame.uvData!!, width, height
+            )
+            if (!packed) {
+                val yBuf = yPlane.buffer.duplicate()
+                val rowStride = yPlane.rowStride
+                if (rowStride == width) {
+                    yBuf.get(yArr, 0, ySize)
+                } else {
+                    for (row in 0 until height) {
+                        yBuf.position(row * rowStride)
+                        yBuf.get(yArr, row * width, width)
+                    }
                 }
+                fillNV12UVPlane(uPlane, vPlane, width, height, pendingFrame.uvData!!)
             }
-            fillNV12UVPlane(uPlane, vPlane, width, height, pendingFrame.uvData!!)
-            pendingFrame.width = width
-            pendingFrame.height = height
-            pendingFrame.yStride = width
-            pendingFrame.timestamp = System.nanoTime() / 100
-            pendingFrame.ready = true
-            frameAvailable.signal()
+            commitPendingFrame(width, height, callbackAt, capturedAt)
+        }
+    }
+
+    /** Size [pendingFrame]'s NV12 planes for width x height (frameLock held). */
+    private fun ensurePendingBuffers(width: Int, height: Int) {
+        val ySize = width * height
+        val uvSize = width * (height / 2)
+        if (pendingFrame.yData == null || pendingFrame.yData!!.size != ySize)
+            pendingFrame.yData = ByteArray(ySize)
+        if (pendingFrame.uvData == null || pendingFrame.uvData!!.size != uvSize)
+            pendingFrame.uvData = ByteArray(uvSize)
+    }
+
+    /** Mark the freshly filled [pendingFrame] ready and wake the encoder (frameLock held). */
+    private fun commitPendingFrame(width: Int, height: Int, callbackAt: Long, capturedAt: Long = callbackAt) {
+        pendingFrame.width = width
+        pendingFrame.height = height
+        pendingFrame.yStride = width
+        val packedAt = System.nanoTime()
+        OmtStats.record(OmtStats.STAGE_CAPTURE_TO_PACKED, packedAt - callbackAt)
+        pendingFrame.timestamp = packedAt / 100
+        pendingFrame.packedAt = packedAt
+        pendingFrame.capturedAt = capturedAt
+        pendingFrame.ready = true
+        OmtStats.setGauge(OmtStats.GAUGE_SENDER_PENDING, 1.0)
+        frameAvailable.signal()
+    }
+
+    /**
+     * Stands in for the camera analyzer in test-pattern mode: renders the pattern into
+     * [pendingFrame] at targetFps on absolute deadlines, so frames take the same
+     * encodeSendLoop path (and drop accounting) as camera frames.
+     */
+    private fun patternLoop(config: OmtTestPattern.Config) {
+        Process.setThreadPriority(Process.THREAD_PRIORITY_DISPLAY)
+        val handle = OmtTestPattern.create(config.width, config.height)
+        if (handle == 0L) {
+            Log.w(TAG, "Test pattern ${config.width}x${config.height} unavailable")
+            return
         }
+        try {
+            var deadline = System.nanoTime()
+            var frame = 0L
+            while (running.get()) {
+                val waitNs = deadline - System.nanoTime()
+                if (waitNs > 0) {
+                    Thread.sleep(waitNs / 1_000_000, (waitNs % 1_000_000).toInt())
+                } else if (-waitNs > frameIntervalNs) {
+                    deadline = System.nanoTime() // fell a whole frame behind: restart the schedule
+                }
+                deadline += frameIntervalNs
+                if (!hasVideoConsumers()) continue
+                val callbackAt = System.nanoTime()
+                OmtStats.count(OmtStats.FRAMES_CAPTURED)
+                frameLock.withLock {
+                    if (pendingFrame.ready) OmtStats.recordDrop(OmtStats.DROP_PENDING_OVERWRITE)
+                    ensurePendingBuffers(config.width, config.height)
+                    if (OmtTestPattern.render(handle, config.kind, frame, pendingFrame.yData!!, pendingFrame.uvData!!))
+                        commitPendingFrame(config.width, config.height, callbackAt)
+                }
+                frame++
+            }
+        } catch (_: InterruptedException) {
+        } finally { OmtTestPattern.destroy(handle) }
+    }
+
+    /** Decode the frame just sent and compare with its NV12 source; after the writes so clients never wait. */
+    private fun sampleQuality(y: ByteArray, uv: ByteArray, width: Int, height: Int, payloadLen: Int) {
+        if (qualityHandle == 0L || qualityWidth != width || qualityHeight != height) {
+            OmtQuality.destroy(qualityHandle)
+            qualityHandle = OmtQuality.create(width, height)
+            qualityWidth = width; qualityHeight = height
+            if (qualityHandle == 0L) {
+                Log.w(TAG, "Quality sampling unavailable (no VMX decoder); disabled")
+                qualityPeriodNs = 0L
+                return
+            }
+        }
+        lastQuality = OmtQuality.measure(qualityHandle, vmxOutputBuf!!, payloadLen, y, uv)
+    }
+
+    /** Compress the frame for the NVLZ receivers into [nvlzBuf]; -1 (they get NV12) if that fails. */
+    private fun packNvlz(y: ByteArray, uv: ByteArray, width: Int, height: Int): Int {
+        if (lz4Handle == 0L) lz4Handle = OmtLz4.create()
+        val bound = OmtLz4.bound(width, height)
+        if (lz4Handle == 0L || bound <= 0) return -1
+        if (nvlzBuf == null || nvlzBuf!!.size < bound) nvlzBuf = ByteArray(bound)
+        val length = OmtLz4.pack(lz4Handle, y, uv, width, height, nvlzBuf!!)
+        if (length < 0) Log.w(TAG, "NVLZ pack failed ${width}x$height")
+        return length
     }
 
     private fun encodeSendLoop() {
         Process.setThreadPriority(Process.THREAD_PRIORITY_URGENT_DISPLAY)
         var localY: ByteArray? = null
         var localUV: ByteArray? = null
-        var localW = 0; var localH = 0; var localTimestamp = 0L
+        var localW = 0; var localH = 0; var localTimestamp = 0L; var localPackedAt = 0L; var localCapturedAt = 0L
         val hdr = ByteBuffer.allocate(OMT_HEADER_SIZE + OMT_VIDEO_EXT_HEADER_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+        val nvlzHdr = ByteBuffer.allocate(OMT_HEADER_SIZE + OMT_VIDEO_EXT_HEADER_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+        var nvlzBytes = 0L // NVLZ payload bytes since the last log line, for the compression ratio
+        var nvlzFrames = 0L
         var encodeTimeTotal = 0L
 
         while (running.get()) {
@@ -309,17 +573,34 @@ class CameraStreamSender(
                 localY = pendingFrame.yData; localUV = pendingFrame.uvData
                 localW = pendingFrame.width; localH = pendingFrame.height
                 localTimestamp = pendingFrame.timestamp
+                localPackedAt = pendingFrame.packedAt
+                localCapturedAt = pendingFrame.capturedAt
                 pendingFrame.yData = tmpY; pendingFrame.uvData = tmpUV
                 pendingFrame.ready = false
+                OmtStats.setGauge(OmtStats.GAUGE_SENDER_PENDING, 0.0)
             }
             if (localY == null || localUV == null) continue
             val width = localW; val height = localH
             // Send to all video clients (matches GitHub alpha6; was take(1) which could cause sync issues)
-            val videoChannels = channels.filter { it.subscribedVideo.get() && it.socket.isConnected }
-            if (videoChannels.isEmpty()) continue
+            val videoChannels = videoSubscribers
+            val recording = recordHandle
+            val proxy = proxyHandle
+            val multicast = if (multicastSubscribers > 0) multicastHandle else 0L
+            if (videoChannels.isEmpty() && recording == 0L && multicast == 0L) {
+                if (proxy != 0L) OmtProxy.offer(proxy, localY!!, localUV!!, width, height, localTimestamp)
+                continue
+            }
+
+            // Stamp before encode so the code travels through the codec with the picture
+            val stampXml = if (latencyMode) {
+                val stampUs = localCapturedAt / 1000
+                OmtLatency.stampNv12(localY!!, localUV!!, width, height, stampUs)
+                OmtLatency.stampXml(stampUs, frameCount)
+            } else null
 
             try {
                 val encStart = System.nanoTime()
+                OmtStats.record(OmtStats.STAGE_PACKED_TO_ENCODE, encStart - localPackedAt)
                 var vmxPayloadLen = -1
 
                 if (VmxEncoder.isAvailable()) {
@@ -331,10 +612,13 @@ class CameraStreamSender(
                         if (vmxHandle == 0L) Log.w(TAG, "VMX create failed ${width}x$height")
                     }
                     if (vmxHandle != 0L && vmxOutputBuf != null) {
+                        OmtTrace.begin(OmtTrace.ENCODE)
                         vmxPayloadLen = VmxEncoder.encodeInto(
                             vmxHandle, localY!!, width, localUV!!, width, vmxOutputBuf!!
                         )
+                        OmtTrace.end(OmtTrace.ENCODE)
                         if (vmxPayloadLen < 0) {
+                            OmtStats.count(OmtStats.FRAMES_ENCODE_FALLBACK) // still sent, as NV12: not a drop
                             Log.w(TAG, "VMX encode failed ${width}x$height")
                         } else if (!vmxEncodeLogged) {
                             vmxEncodeLogged = true
@@ -343,10 +627,15 @@ class CameraStreamSender(
                         }
                     }
                 }
-                val encMs = (System.nanoTime() - encStart) / 1_000_000
+                val encNs = System.nanoTime() - encStart
+                val encMs = encNs / 1_000_000
                 encodeTimeTotal += encMs
 
                 val useVmx = vmxPayloadLen > 0
+                if (useVmx) {
+                    OmtStats.record(OmtStats.STAGE_ENCODE, encNs)
+                    OmtStats.count(OmtStats.FRAMES_ENCODED)
+                }
                 val codec = if (useVmx) CODEC_VMX1 else CODEC_NV12
 
                 hdr.clear()
@@ -356,43 +645,93 @@ class CameraStreamSender(
                 hdr.putInt(targetFps); hdr.putInt(1)
                 hdr.putFloat(16f / 9f); hdr.putInt(0); hdr.putInt(709)
                 val hdrBytes = hdr.array()
+                val queuedAt = System.nanoTime()
 
                 if (useVmx) {
                     val dataLength = OMT_VIDEO_EXT_HEADER_SIZE + vmxPayloadLen
                     writeIntLEAt12(hdrBytes, dataLength)
                     for (ch in videoChannels) {
-                        try { synchronized(ch.output) {
-                            ch.output.write(hdrBytes, 0, 48)
-                            ch.output.write(vmxOutputBuf!!, 0, vmxPayloadLen)
-                            ch.output.flush()
-                        }} catch (e: Exception) { handleSendError(ch, e) }
+                        OmtTrace.begin(OmtTrace.CLIENT_WRITE, ch.statsSlot.toLong())
+                        try {
+                            val writeStart = System.nanoTime()
+                            synchronized(ch.output) {
+                                if (stampXml != null && ch.latencyPeer.get()) sendMetadataToChannel(ch, stampXml)
+                                ch.output.write(hdrBytes, 0, 48)
+                                ch.output.write(vmxOutputBuf!!, 0, vmxPayloadLen)
+                                ch.output.flush()
+                            }
+                            recordClientWritten(ch, queuedAt, writeStart, 48L + vmxPayloadLen)
+                        } catch (e: Exception) { handleSendError(ch, e) }
+                        finally { OmtTrace.end(OmtTrace.CLIENT_WRITE) }
+                    }
+                    if (multicast != 0L) OmtMulticast.send(multicast, hdrBytes, 48, vmxOutputBuf, vmxPayloadLen)
+                    if (recording != 0L) OmtRecorder.record(recording, hdrBytes, 48, vmxOutputBuf, vmxPayloadLen)
+                    if (qualityPeriodNs > 0 && System.nanoTime() >= nextQualityAt) {
+                        sampleQuality(localY!!, localUV!!, width, height, vmxPayloadLen)
+                        nextQualityAt = System.nanoTime() + qualityPeriodNs
                     }
                 } else {
                     val ySize = width * height; val uvSize = width * (height / 2)
                     val dataLength = OMT_VIDEO_EXT_HEADER_SIZE + ySize + uvSize
                     writeIntLEAt12(hdrBytes, dataLength)
+                    // Compressed once before the writes, so each client is written in one pass in whichever form it takes
+                    val nvlzLen = if (nvlzSubscribers > 0) packNvlz(localY!!, localUV!!, width, height) else -1
+                    if (nvlzLen > 0) {
+                        nvlzHdr.clear()
+                        nvlzHdr.put(hdrBytes, 0, 48)
+                        nvlzHdr.putInt(12, OMT_VIDEO_EXT_HEADER_SIZE + nvlzLen)
+                        nvlzHdr.putInt(16, OmtLz4.CODEC_NVLZ)
+                        nvlzBytes += nvlzLen; nvlzFrames++
+                    }
                     for (ch in videoChannels) {
-                        try { synchronized(ch.output) {
-                            ch.output.write(hdrBytes, 0, 48)
-                            ch.output.write(localY, 0, ySize)
-                            ch.output.write(localUV, 0, uvSize)
-                            ch.output.flush()
-                        }} catch (e: Exception) { handleSendError(ch, e) }
+                        OmtTrace.begin(OmtTrace.CLIENT_WRITE, ch.statsSlot.toLong())
+                        try {
+                            val packed = nvlzLen > 0 && ch.nvlz.get()
+                            val writeStart = System.nanoTime()
+                            synchronized(ch.output) {
+                                if (stampXml != null && ch.latencyPeer.get()) sendMetadataToChannel(ch, stampXml)
+                                if (packed) {
+                                    ch.output.write(nvlzHdr.array(), 0, 48)
+                                    ch.output.write(nvlzBuf!!, 0, nvlzLen)
+                                } else {
+                                    ch.output.write(hdrBytes, 0, 48)
+                                    ch.output.write(localY, 0, ySize)
+                                    ch.output.write(localUV, 0, uvSize)
+                                }
+                                ch.output.flush()
+                            }
+                            recordClientWritten(ch, queuedAt, writeStart, 48L + if (packed) nvlzLen else ySize + uvSize)
+                        } catch (e: Exception) { handleSendError(ch, e) }
+                        finally { OmtTrace.end(OmtTrace.CLIENT_WRITE) }
                     }
+                    if (multicast != 0L) OmtMulticast.send(multicast, hdrBytes, 48, localY, ySize, localUV, uvSize)
+                    if (recording != 0L) OmtRecorder.record(recording, hdrBytes, 48, localY, ySize, localUV, uvSize)
                 }
+                // After every client has the frame: the proxy never delays the live stream
+                if (proxy != 0L) OmtProxy.offer(proxy, localY!!, localUV!!, width, height, localTimestamp)
 
                 frameCount++; fpsFrameCount++
+                OmtStats.count(OmtStats.FRAMES_SENT)
                 val now = System.nanoTime()
                 if (fpsLastLogTime == 0L) fpsLastLogTime = now
                 val elapsed = now - fpsLastLogTime
                 if (elapsed >= 3_000_000_000L) {
                     val fps = fpsFrameCount * 1_000_000_000.0 / elapsed
                     val avgEnc = if (fpsFrameCount > 0) encodeTimeTotal / fpsFrameCount else 0L
-                    Log.i(TAG, "FPS: %.1f | ${width}x$height ${if (useVmx) "VMX1" else "NV12"} | enc=${avgEnc}ms | ${videoChannels.size} client(s) | frame $frameCount".format(fps))
+                    val quality = lastQuality?.let { " | ${it.format()}" } ?: ""
+                    val proxyInfo = OmtProxy.counters(proxy)?.let { " | ${it.format()}" } ?: ""
+                    val multicastInfo = OmtMulticast.counters(multicast)?.let { " | ${multicastSubscribers} on ${it.format()}" } ?: ""
+                    val nvlzInfo = if (nvlzFrames > 0) {
+                        " | NVLZ x%.1f to $nvlzSubscribers".format(width * height * 1.5 * nvlzFrames / nvlzBytes)
+                    } else ""
+                    Log.i(TAG, "FPS: %.1f | ${width}x$height ${if (useVmx) "VMX1" else "NV12"} | enc=${avgEnc}ms | ${videoChannels.size} client(s) | frame $frameCount$quality$proxyInfo$multicastInfo$nvlzInfo".format(fps))
+                    OmtStats.setGauge(OmtStats.GAUGE_FPS_SENT, fps)
+                    logStageLatencies()
                     fpsFrameCount = 0; fpsLastLogTime = now; encodeTimeTotal = 0L
+                    nvlzBytes = 0L; nvlzFrames = 0L
 
                     // Send metadata keepalive to channels NOT receiving video (minimal payload like GitHub)
-                    val idleChannels = channels.filter { it.socket.isConnected } - videoChannels.toSet()
+                    val idleChannels = channels.filter { it.socket.isConnected && !it.subscribedVideo.get() }
                     for (ch in idleChannels) {
                         try { synchronized(ch.output) {
                             sendMetadataToChannel(ch, " ")
@@ -455,10 +794,10 @@ class CameraStreamSender(
                 if (read <= 0) continue
 
                 // OMT multiplexes audio+video on same connection — send audio only to video clients
-                val audioChannels = channels.filter {
-                    it.subscribedVideo.get() && it.subscribedAudio.get() && it.socket.isConnected
-                }.take(1) // same connection as video for proper multiplexing
-                if (audioChannels.isEmpty()) continue
+                val ch = audioSubscriber
+                val recording = recordHandle
+                val multicast = if (multicastSubscribers > 0) multicastHandle else 0L
+                if (ch == null && recording == 0L && multicast == 0L) continue
 
                 val samplesPerCh = read / AUDIO_CHANNELS
                 val payloadBytes = samplesPerCh * AUDIO_CHANNELS * 4
@@ -486,19 +825,21 @@ class CameraStreamSender(
                 for (i in 0 until samplesPerCh) planarBuf.putFloat(interleavedBuf[i * 2 + 1])   // right
                 val payloadArr = planarBuf.array()
 
+                if (recording != 0L) OmtRecorder.record(recording, hdrBytes, hdrBytes.size, payloadArr, payloadBytes)
+                if (multicast != 0L) OmtMulticast.send(multicast, hdrBytes, hdrBytes.size, payloadArr, payloadBytes)
+                if (ch == null) continue
                 if (audioLogCount++ < 3) {
-                    Log.i(TAG, "Audio send: ${samplesPerCh}samp/ch ${payloadBytes}B planar FPA1 to ${audioChannels.size} ch")
+                    Log.i(TAG, "Audio send: ${samplesPerCh}samp/ch ${payloadBytes}B planar FPA1 to ${ch.socket.inetAddress}")
                 }
 
-                for (ch in audioChannels) {
-                    try {
-                        synchronized(ch.output) {
-                            ch.output.write(hdrBytes)
-                            ch.output.write(payloadArr, 0, payloadBytes)
-                            ch.output.flush()
-                        }
-                    } catch (e: Exception) { handleSendError(ch, e) }
-                }
+                try {
+                    synchronized(ch.output) {
+                        ch.output.write(hdrBytes)
+                        ch.output.write(payloadArr, 0, payloadBytes)
+                        ch.output.flush()
+                    }
+                    OmtStats.addClientBytes(ch.statsSlot, (hdrBytes.size + payloadBytes).toLong())
+                } catch (e: Exception) { handleSendError(ch, e) }
             }
         } catch (e: Exception) {
             if (running.get()) Log.e(TAG, "Audio capture error: ${e.message}")
@@ -509,6 +850,51 @@ class CameraStreamSender(
         }
     }
 
+    // ---- Stats ----
+
+    private fun acquireStatsSlot(): Int = synchronized(statsSlots) {
+        val slot = statsSlots.indexOfFirst { !it }
+        if (slot >= 0) { statsSlots[slot] = true; OmtStats.resetClient(slot) }
+        slot
+    }
+
+    private fun releaseStatsSlot(slot: Int) {
+        if (slot < 0) return
+        OmtStats.setClientLabel(slot, null)
+        synchronized(statsSlots) { statsSlots[slot] = false }
+    }
+
+    /**
+     * The encode thread writes clients in turn, so a write that outlasts the frame interval
+     * holds back every client; the frames the camera produced meanwhile are overwritten in
+     * [pendingFrame]. Charging those intervals to the slow client separates network stalls
+     * from CPU starvation (pending overwrites without slow-client charges).
+     */
+    private fun recordClientWritten(ch: ClientChannel, queuedAt: Long, writeStart: Long, bytes: Long) {
+        val writtenAt = System.nanoTime()
+        OmtStats.recordClientWrite(ch.statsSlot, writtenAt - queuedAt)
+        OmtStats.addClientBytes(ch.statsSlot, bytes)
+        val stalledFrames = (writtenAt - writeStart) / frameIntervalNs
+        if (stalledFrames > 0) OmtStats.recordDrop(OmtStats.DROP_SLOW_CLIENT, stalledFrames, ch.statsSlot)
+    }
+
+    private fun logStageLatencies() {
+        val packed = OmtStats.snapshot(OmtStats.STAGE_CAPTURE_TO_PACKED) ?: return
+        val wait = OmtStats.snapshot(OmtStats.STAGE_PACKED_TO_ENCODE) ?: return
+        val enc = OmtStats.snapshot(OmtStats.STAGE_ENCODE) ?: return
+        val written = OmtStats.snapshot(OmtStats.STAGE_QUEUED_TO_WRITTEN) ?: return
+        Log.i(TAG, "Latency pack ${packed.format()} | wait ${wait.format()} | enc ${enc.format()} | write ${written.format()}")
+        OmtStats.drops()?.takeIf { it.total > 0 }?.let { Log.i(TAG, "Drops ${it.format()}") }
+        for (ch in channels) {
+            val slot = ch.statsSlot
+            val s = if (slot >= 0) OmtStats.snapshotClient(slot) else null
+            if (s != null && s.count > 0) {
+                val slow = OmtStats.dropsClient(slot)?.get(OmtStats.DROP_SLOW_CLIENT) ?: 0L
+                Log.d(TAG, "  client ${ch.socket.inetAddress?.hostAddress} write ${s.format()} slow=$slow")
+            }
+        }
+    }
+
     // ---- Helpers ----
 
     private fun sendMetadataToChannel(ch: ClientChannel, xml: String) {
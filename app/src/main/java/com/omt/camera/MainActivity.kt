@@ -450,6 +450,7 @@ class MainActivity : AppCompatActivity() {
         stopStreamingService()
         discoveryRegistration?.unregister(); discoveryRegistration = null
         streamSender?.stop(); streamSender = null
+        OmtTrace.dumpTo(this, "sender")
         setLive(false)
         statusText.text = getString(R.string.not_streaming)
         statusBadge.text = getString(R.string.not_streaming)
@@ -0,0 +1,114 @@
+package com.omt.camera
+
+import android.util.Log
+
+/**
+ * Glass-to-glass latency measurement mode. Enable with
+ * `adb shell setprop debug.omt.latency 1` on the sender (and viewer) before starting.
+ *
+ * The sender stamps each frame's capture time (the camera's sensor timestamp, converted to
+ * µs on the System.nanoTime() clock) as a
+ * pixel timecode in the top-left corner and as `<OMTLatencyStamp>` metadata, and answers
+ * `<OMTClockRequest>` with `<OMTClockReply>`. The viewer (or `omt_latency` on Linux)
+ * aligns clocks with those exchanges and records capture → presented latency.
+ */
+object OmtLatency {
+    private const val TAG = "OmtLatency"
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeModeEnabled(): Boolean
+    private external fun nativeStampNv12(y: ByteArray, uv: ByteArray, width: Int, height: Int, value: Long)
+    private external fun nativeReadRgba(rgba: ByteArray, width: Int, height: Int): Long
+    private external fun nativeClockRequestXml(t1: Long): String?
+    private external fun nativeClockReplyXml(t1: Long, t2: Long, t3: Long): String?
+    private external fun nativeStampXml(stampUs: Long, frame: Long): String?
+    private external fun nativeParseClockRequest(xml: String): Long
+    private external fun nativeOnClockReply(xml: String, t4: Long): Boolean
+    private external fun nativeParseStamp(xml: String): Long
+    private external fun nativeClockValid(): Boolean
+    private external fun nativeClockOffsetUs(): Long
+    private external fun nativeClockRttUs(): Long
+    private external fun nativeRecord(latencyUs: Long)
+    private external fun nativeSnapshot(): LongArray?
+    private external fun nativeReset()
+
+    /** Microseconds on the clock both ends stamp with. */
+    @JvmStatic
+    fun nowUs(): Long = System.nanoTime() / 1000
+
+    @JvmStatic
+    fun isModeEnabled(): Boolean = nativeLoaded && nativeModeEnabled()
+
+    /** Stamp [valueUs] into a packed NV12 frame (stride == width). */
+    @JvmStatic
+    fun stampNv12(y: ByteArray, uv: ByteArray, width: Int, height: Int, valueUs: Long) {
+        if (nativeLoaded) nativeStampNv12(y, uv, width, height, valueUs)
+    }
+
+    /** Read the pixel timecode from a decoded RGBA frame; -1 when absent or damaged. */
+    @JvmStatic
+    fun readRgba(rgba: ByteArray, width: Int, height: Int): Long =
+        if (nativeLoaded) nativeReadRgba(rgba, width, height) else -1L
+
+    @JvmStatic
+    fun clockRequestXml(t1: Long): String? = if (nativeLoaded) nativeClockRequestXml(t1) else null
+
+    @JvmStatic
+    fun clockReplyXml(t1: Long, t2: Long, t3: Long): String? =
+        if (nativeLoaded) nativeClockReplyXml(t1, t2, t3) else null
+
+    @JvmStatic
+    fun stampXml(stampUs: Long, frame: Long): String? = if (nativeLoaded) nativeStampXml(stampUs, frame) else null
+
+    /** T1 of a `<OMTClockRequest>`, or null if [xml] is not one. */
+    @JvmStatic
+    fun parseClockRequest(xml: String): Long? {
+        if (!nativeLoaded) return null
+        val t1 = nativeParseClockRequest(xml)
+        return if (t1 == Long.MIN_VALUE) null else t1
+    }
+
+    /** Feed a `<OMTClockReply>` received at [t4Us] into the clock estimate. */
+    @JvmStatic
+    fun onClockReply(xml: String, t4Us: Long): Boolean = nativeLoaded && nativeOnClockReply(xml, t4Us)
+
+    /** Capture time from `<OMTLatencyStamp>`, or -1. */
+    @JvmStatic
+    fun parseStamp(xml: String): Long = if (nativeLoaded) nativeParseStamp(xml) else -1L
+
+    @JvmStatic
+    fun clockValid(): Boolean = nativeLoaded && nativeClockValid()
+
+    /** Sender clock minus local clock, from the lowest-RTT exchange. */
+    @JvmStatic
+    fun clockOffsetUs(): Long = if (nativeLoaded) nativeClockOffsetUs() else 0L
+
+    @JvmStatic
+    fun clockRttUs(): Long = if (nativeLoaded) nativeClockRttUs() else 0L
+
+    @JvmStatic
+    fun record(latencyUs: Long) {
+        if (nativeLoaded) nativeRecord(latencyUs)
+    }
+
+    @JvmStatic
+    fun snapshot(): OmtStats.Snapshot? = if (nativeLoaded) nativeSnapshot()?.let {
+        OmtStats.Snapshot(it[0], it[1], it[2], it[3], it[4], it[5])
+    } else null
+
+    /** Forget the clock estimate and latency samples (new session / new source). */
+    @JvmStatic
+    fun reset() {
+        if (nativeLoaded) nativeReset()
+    }
+}
@@ -0,0 +1,62 @@
+package com.omt.camera
+
+import android.util.Log
+
+/**
+ * NVLZ: NV12 planes compressed with LZ4 (core/omt_lz4), lossless, for app-to-app links when
+ * libvmx is missing and raw NV12 (about 750 Mbit/s at 1080p30) would not fit over Wi-Fi.
+ *
+ * A receiver asks for it with `<OMTCodecs Accept="NVLZ" />`; the sender then sends it the
+ * NVLZ form of every NV12 frame and keeps sending everyone else (vMix) NV12. Payload after
+ * the video extended header: [Y block bytes][UV block bytes][LZ4 Y][LZ4 UV], little-endian.
+ */
+object OmtLz4 {
+    private const val TAG = "OmtLz4"
+
+    const val CODEC_NVLZ = 0x5A4C564E // "NVLZ"
+    const val ACCEPT_XML = "<OMTCodecs Accept=\"NVLZ\" />"
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeCreate(): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeBound(width: Int, height: Int): Int
+    private external fun nativePack(handle: Long, y: ByteArray, uv: ByteArray, width: Int, height: Int, out: ByteArray): Int
+    private external fun nativeUnpack(src: ByteArray, offset: Int, length: Int, width: Int, height: Int,
+                                      y: ByteArray, uv: ByteArray): Boolean
+
+    @JvmStatic
+    fun isAvailable(): Boolean = nativeLoaded
+
+    /** A compressor (16 KB of match state); use from one thread at a time. */
+    @JvmStatic
+    fun create(): Long = if (nativeLoaded) nativeCreate() else 0L
+
+    @JvmStatic
+    fun destroy(handle: Long) {
+        if (nativeLoaded && handle != 0L) nativeDestroy(handle)
+    }
+
+    /** Largest NVLZ payload for a width x height frame: the size [pack]'s output buffer needs. */
+    @JvmStatic
+    fun bound(width: Int, height: Int): Int = if (nativeLoaded) nativeBound(width, height) else -1
+
+    /** Compress tightly packed NV12 planes into [out]; returns the payload size, or -1. */
+    @JvmStatic
+    fun pack(handle: Long, y: ByteArray, uv: ByteArray, width: Int, height: Int, out: ByteArray): Int =
+        if (nativeLoaded && handle != 0L) nativePack(handle, y, uv, width, height, out) else -1
+
+    /** Expand the payload at [src] [offset] into tightly packed planes; false if it is corrupt. */
+    @JvmStatic
+    fun unpack(src: ByteArray, offset: Int, length: Int, width: Int, height: Int, y: ByteArray, uv: ByteArray): Boolean =
+        nativeLoaded && nativeUnpack(src, offset, length, width, height, y, uv)
+}
@@ -0,0 +1,40 @@
+package com.omt.camera
+
+import android.util.Log
+
+/**
+ * Optional Prometheus endpoint served by the native core (GET http://<phone>:<port>/metrics).
+ * Off unless a port is configured: `adb shell setprop debug.omt.metrics_port 9100`.
+ * The server thread sleeps in poll() until scraped, so an idle endpoint costs nothing per frame.
+ */
+object OmtMetrics {
+    private const val TAG = "OmtMetrics"
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeConfiguredPort(): Int
+    private external fun nativeStart(port: Int): Boolean
+    private external fun nativeStop()
+
+    /** Start on the configured port, if any. Safe to call when already running. */
+    @JvmStatic
+    fun startIfConfigured() {
+        if (!nativeLoaded) return
+        val port = nativeConfiguredPort()
+        if (port > 0 && !nativeStart(port)) Log.w(TAG, "Metrics endpoint failed to start on :$port")
+    }
+
+    @JvmStatic
+    fun stop() {
+        if (nativeLoaded) nativeStop()
+    }
+}
@@ -0,0 +1,82 @@
+package com.omt.camera
+
+import android.util.Log
+
+/**
+ * Multicast fan-out for preview and monitoring receivers. Enable with
+ * `adb shell setprop debug.omt.multicast 1` (group 239.255.X.Y from the phone's address, port 6501,
+ * one parity datagram per 8) or a spec such as `239.255.1.20:6600,4` before starting the stream.
+ *
+ * A receiver that sends `<OMTMulticast Request="true" />` is answered with the group; once it has
+ * joined and replied `Attached`, its video and audio come from the one transmission the native
+ * sender (core/omt_multicast) makes per frame instead of its own TCP socket. Receivers that never
+ * ask, such as vMix taking the program feed, stay on reliable TCP. Frames are cut into datagrams
+ * with sequence numbers and XOR parity, so a monitor rides out scattered losses; a frame the
+ * network or a full socket buffer took more of is simply skipped.
+ */
+object OmtMulticast {
+    private const val TAG = "OmtMulticast"
+
+    class Counters(val framesSent: Long, val framesDropped: Long, val datagrams: Long, val bytes: Long) {
+        fun format(): String = "multicast %d frames %.1f MB dropped %d".format(framesSent, bytes / 1e6, framesDropped)
+    }
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeConfigured(): Boolean
+    private external fun nativeStart(): Long
+    private external fun nativeStop(handle: Long)
+    private external fun nativeOfferXml(handle: Long): String?
+    private external fun nativeSend(
+        handle: Long, head: ByteArray, headLen: Int, body: ByteArray?, bodyLen: Int, tail: ByteArray?, tailLen: Int
+    ): Boolean
+    private external fun nativeCounters(handle: Long): LongArray?
+
+    /** debug.omt.multicast is set to a valid spec. */
+    @JvmStatic
+    fun isConfigured(): Boolean = nativeLoaded && nativeConfigured()
+
+    /** Open the group; 0 when off or unavailable (no multicast route, bad spec). */
+    @JvmStatic
+    fun start(): Long {
+        if (!nativeLoaded) return 0L
+        val handle = nativeStart()
+        if (handle == 0L) Log.w(TAG, "Multicast unavailable; monitoring receivers stay on TCP")
+        else Log.i(TAG, "Offering ${offerXml(handle)}")
+        return handle
+    }
+
+    @JvmStatic
+    fun stop(handle: Long) {
+        if (nativeLoaded && handle != 0L) nativeStop(handle)
+    }
+
+    /** Metadata answering a receiver's `<OMTMulticast Request="true" />`. */
+    @JvmStatic
+    fun offerXml(handle: Long): String? = if (nativeLoaded && handle != 0L) nativeOfferXml(handle) else null
+
+    /**
+     * Send one wire frame to the group, [head] (frame + extended header) then [body] and an
+     * optional [tail] (NV12: the Y and UV planes); never blocks, false if it was dropped.
+     */
+    @JvmStatic
+    fun send(handle: Long, head: ByteArray, headLen: Int, body: ByteArray?, bodyLen: Int,
+             tail: ByteArray? = null, tailLen: Int = 0): Boolean =
+        nativeLoaded && handle != 0L && nativeSend(handle, head, headLen, body, bodyLen, tail, tailLen)
+
+    @JvmStatic
+    fun counters(handle: Long): Counters? {
+        if (!nativeLoaded || handle == 0L) return null
+        val v = nativeCounters(handle) ?: return null
+        return Counters(v[0], v[1], v[2], v[3])
+    }
+}
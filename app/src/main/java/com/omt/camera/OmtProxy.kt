@@ -0,0 +1,74 @@
+package com.omt.camera
+
+import android.content.Context
+import android.util.Log
+import java.io.File
+
+/**
+ * Low-resolution proxy recording for editing after the show. Enable with
+ * `adb shell setprop debug.omt.proxy 1` (640 wide, 10 fps, 10% of a core) or a spec such as
+ * `640x360@15,20` (size, fps, CPU budget in percent of one core) before starting the stream.
+ *
+ * After each live frame is sent, the sender offers it here. The native proxy (core/omt_proxy)
+ * takes one at the proxy rate, downscales it, encodes it with its own single-threaded LQ VMX
+ * encoder on a low-priority thread and writes omt-proxy-<time>-0001.omt (+ .idx) to the app's
+ * external files dir. When the budget is spent or the encoder is still busy the frame is
+ * skipped, so the live stream never waits.
+ */
+object OmtProxy {
+    private const val TAG = "OmtProxy"
+
+    class Counters(val frames: Long, val skippedBusy: Long, val skippedBudget: Long, val bytes: Long, val costNs: Long) {
+        fun format(): String = "proxy %d frames %.1f MB skipped %d+%d %.2f ms/frame".format(
+            frames, bytes / 1e6, skippedBusy, skippedBudget, costNs / 1e6)
+    }
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeConfigured(): Boolean
+    private external fun nativeStart(basePath: String): Long
+    private external fun nativeStop(handle: Long)
+    private external fun nativeOffer(handle: Long, y: ByteArray, uv: ByteArray, width: Int, height: Int, timestamp: Long): Boolean
+    private external fun nativeCounters(handle: Long): LongArray?
+
+    /** debug.omt.proxy is set to a valid spec. */
+    @JvmStatic
+    fun isConfigured(): Boolean = nativeLoaded && nativeConfigured()
+
+    /** Start a proxy recording in the app's external files dir; 0 when off or unavailable. */
+    @JvmStatic
+    fun start(context: Context): Long {
+        if (!nativeLoaded) return 0L
+        val dir = context.getExternalFilesDir(null) ?: context.filesDir
+        val base = File(dir, "omt-proxy-${System.currentTimeMillis()}")
+        val handle = nativeStart(base.absolutePath)
+        if (handle == 0L) Log.w(TAG, "Cannot record a proxy to $base") else Log.i(TAG, "Proxy recording to $base-0001.omt")
+        return handle
+    }
+
+    @JvmStatic
+    fun stop(handle: Long) {
+        if (nativeLoaded && handle != 0L) nativeStop(handle)
+    }
+
+    /** Offer a sent frame (tight NV12); returns at once unless a proxy frame is due. */
+    @JvmStatic
+    fun offer(handle: Long, y: ByteArray, uv: ByteArray, width: Int, height: Int, timestamp: Long): Boolean =
+        nativeLoaded && handle != 0L && nativeOffer(handle, y, uv, width, height, timestamp)
+
+    @JvmStatic
+    fun counters(handle: Long): Counters? {
+        if (!nativeLoaded || handle == 0L) return null
+        val v = nativeCounters(handle) ?: return null
+        return Counters(v[0], v[1], v[2], v[3], v[4])
+    }
+}
@@ -0,0 +1,62 @@
+package com.omt.camera
+
+import android.util.Log
+
+/**
+ * Live encode-quality sampling for encoder tuning. Enable with
+ * `adb shell setprop debug.omt.quality 1` (seconds between samples) before starting the stream.
+ *
+ * Every period the sender decodes one VMX frame it has just sent and compares it with the
+ * NV12 it encoded (core/omt_quality: PSNR and SSIM on Y, Cb and Cr). The result is logged
+ * with the FPS line and exported as the omt_encode_quality metric. Each sample costs one
+ * decode on the encode thread, so keep the period at a second or more.
+ */
+object OmtQuality {
+    private const val TAG = "OmtQuality"
+
+    class Result(val psnr: Double, val ssim: Double, val psnrY: Double, val psnrCb: Double, val psnrCr: Double) {
+        fun format(): String = "PSNR %.2f dB (Y %.2f Cb %.2f Cr %.2f) SSIM %.4f".format(psnr, psnrY, psnrCb, psnrCr, ssim)
+    }
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativePeriodSec(): Double
+    private external fun nativeKernelName(): String?
+    private external fun nativeCreate(width: Int, height: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeMeasure(handle: Long, data: ByteArray, len: Int, y: ByteArray, uv: ByteArray, out: DoubleArray): Boolean
+
+    /** Sampling period from debug.omt.quality in nanoseconds, or 0 when sampling is off. */
+    @JvmStatic
+    fun periodNs(): Long = if (nativeLoaded) (nativePeriodSec() * 1e9).toLong() else 0L
+
+    @JvmStatic
+    fun kernelName(): String = if (nativeLoaded) nativeKernelName() ?: "?" else "?"
+
+    /** A meter with its own decoder for width x height, or 0 when libvmx cannot decode. */
+    @JvmStatic
+    fun create(width: Int, height: Int): Long = if (nativeLoaded) nativeCreate(width, height) else 0L
+
+    @JvmStatic
+    fun destroy(handle: Long) {
+        if (nativeLoaded && handle != 0L) nativeDestroy(handle)
+    }
+
+    /** Decode [data] (len bytes of VMX) and compare with the tight NV12 planes it was encoded from. */
+    @JvmStatic
+    fun measure(handle: Long, data: ByteArray, len: Int, y: ByteArray, uv: ByteArray): Result? {
+        if (!nativeLoaded || handle == 0L) return null
+        val v = DoubleArray(8)
+        if (!nativeMeasure(handle, data, len, y, uv, v)) return null
+        return Result(v[0], v[1], v[2], v[3], v[4])
+    }
+}
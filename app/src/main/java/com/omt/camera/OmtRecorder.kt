@@ -0,0 +1,80 @@
+package com.omt.camera
+
+import android.content.Context
+import android.util.Log
+import java.io.File
+
+/**
+ * Local recording of the stream the phone sends, as a backup ISO. Enable with
+ * `adb shell setprop debug.omt.record 1` before starting the stream.
+ *
+ * Every video and audio frame the sender builds is copied into the native recorder
+ * (core/omt_record), which writes it to omt-rec-<time>-0001.omt (+ .idx) in the app's
+ * external files dir on its own thread. The .omt file is the plain OMT stream, so
+ * omt_bench_decode and other stream tools read it as-is. When storage falls behind,
+ * frames are left out of the recording (OmtStats.DROP_RECORD_OVERFLOW) and the encode
+ * thread never waits.
+ */
+object OmtRecorder {
+    private const val TAG = "OmtRecorder"
+
+    class Counters(val framesWritten: Long, val framesDropped: Long, val bytesWritten: Long, val failed: Boolean) {
+        fun format(): String = "rec %d frames %.1f MB dropped %d%s".format(
+            framesWritten, bytesWritten / 1e6, framesDropped, if (failed) " FAILED" else "")
+    }
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeConfigured(): Boolean
+    private external fun nativeStart(basePath: String): Long
+    private external fun nativeStop(handle: Long)
+    private external fun nativeRecord(
+        handle: Long, head: ByteArray, headLen: Int, body: ByteArray?, bodyLen: Int, tail: ByteArray?, tailLen: Int
+    ): Boolean
+    private external fun nativeCounters(handle: Long): LongArray?
+
+    /** debug.omt.record is set. */
+    @JvmStatic
+    fun isConfigured(): Boolean = nativeLoaded && nativeConfigured()
+
+    /** Start a recording in the app's external files dir; 0 when it cannot be created. */
+    @JvmStatic
+    fun start(context: Context): Long {
+        if (!nativeLoaded) return 0L
+        val dir = context.getExternalFilesDir(null) ?: context.filesDir
+        val base = File(dir, "omt-rec-${System.currentTimeMillis()}")
+        val handle = nativeStart(base.absolutePath)
+        if (handle == 0L) Log.w(TAG, "Cannot record to $base") else Log.i(TAG, "Recording to $base-0001.omt")
+        return handle
+    }
+
+    @JvmStatic
+    fun stop(handle: Long) {
+        if (nativeLoaded && handle != 0L) nativeStop(handle)
+    }
+
+    /**
+     * Queue one wire frame, [head] (frame + extended header) then [body] and an optional [tail]
+     * (NV12: the Y and UV planes); copies and returns.
+     */
+    @JvmStatic
+    fun record(handle: Long, head: ByteArray, headLen: Int, body: ByteArray?, bodyLen: Int,
+               tail: ByteArray? = null, tailLen: Int = 0): Boolean =
+        nativeLoaded && handle != 0L && nativeRecord(handle, head, headLen, body, bodyLen, tail, tailLen)
+
+    @JvmStatic
+    fun counters(handle: Long): Counters? {
+        if (!nativeLoaded || handle == 0L) return null
+        val v = nativeCounters(handle) ?: return null
+        return Counters(v[0], v[1], v[2], v[3] != 0L)
+    }
+}
@@ -0,0 +1,167 @@
+package com.omt.camera
+
+import android.util.Log
+
+/**
+ * Per-stage frame latency histograms and frame-drop counters, recorded lock-free in native code.
+ * Sender stages: capture → packed → encode start → encoded → written (per client).
+ * Receiver stages: received → decoded → presented.
+ */
+object OmtStats {
+    private const val TAG = "OmtStats"
+
+    const val STAGE_CAPTURE_TO_PACKED = 0
+    const val STAGE_PACKED_TO_ENCODE = 1
+    const val STAGE_ENCODE = 2
+    const val STAGE_QUEUED_TO_WRITTEN = 3
+    const val STAGE_RECEIVE_TO_DECODED = 4
+    const val STAGE_DECODED_TO_PRESENT = 5
+
+    // Drop causes (see core/omt_stats.h)
+    const val DROP_CAMERA_BACKPRESSURE = 0
+    const val DROP_PENDING_OVERWRITE = 1
+    const val DROP_ENCODE_FAILED = 2
+    const val DROP_SLOW_CLIENT = 3
+    const val DROP_RECEIVER_REPLACED = 4
+    const val DROP_RECORD_OVERFLOW = 5
+    const val DROP_CAUSE_COUNT = 6
+
+    // Counters (see core/omt_stats.h)
+    const val FRAMES_CAPTURED = 0
+    const val FRAMES_ENCODED = 1
+    const val FRAMES_SENT = 2
+    const val FRAMES_RECEIVED = 3
+    const val FRAMES_PRESENTED = 4
+    const val BYTES_SENT = 5
+    const val BYTES_RECEIVED = 6
+    const val FRAMES_ENCODE_FALLBACK = 7 // encode failed, sent as raw NV12
+
+    // Gauges
+    const val GAUGE_FPS_SENT = 0
+    const val GAUGE_FPS_PRESENTED = 1
+    const val GAUGE_CLIENTS = 2
+    const val GAUGE_SENDER_PENDING = 3
+    const val GAUGE_VIEWER_PENDING = 4
+    const val GAUGE_VIEWER_POOL = 5
+    const val GAUGE_QUALITY_PSNR = 6
+    const val GAUGE_QUALITY_SSIM = 7
+
+    // Sides for reset (see core/omt_stats.h StatsSide)
+    const val SIDE_SENDER = 1
+    const val SIDE_RECEIVER = 2
+
+    /** Number of per-client write histograms; slots are handed out by the sender. */
+    const val MAX_CLIENTS = 16
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    /** Latency distribution in nanoseconds. */
+    data class Snapshot(
+        val count: Long, val p50: Long, val p99: Long, val p999: Long, val max: Long, val mean: Long
+    ) {
+        fun format(): String = "p50=%.1f p99=%.1f p99.9=%.1fms".format(p50 / 1e6, p99 / 1e6, p999 / 1e6)
+    }
+
+    /** Dropped-frame totals indexed by DROP_* cause. */
+    class Drops(private val counts: LongArray) {
+        operator fun get(cause: Int): Long = counts.getOrElse(cause) { 0L }
+        val total: Long get() = counts.sum()
+        fun format(): String =
+            "camera=${this[DROP_CAMERA_BACKPRESSURE]} pending=${this[DROP_PENDING_OVERWRITE]} " +
+            "encode=${this[DROP_ENCODE_FAILED]} slow=${this[DROP_SLOW_CLIENT]} replaced=${this[DROP_RECEIVER_REPLACED]} " +
+            "record=${this[DROP_RECORD_OVERFLOW]}"
+    }
+
+    private external fun nativeRecord(stage: Int, nanos: Long)
+    private external fun nativeRecordClientWrite(slot: Int, nanos: Long)
+    private external fun nativeSnapshot(stage: Int): LongArray?
+    private external fun nativeSnapshotClient(slot: Int): LongArray?
+    private external fun nativeRecordDrop(cause: Int, slot: Int, frames: Long)
+    private external fun nativeDrops(slot: Int): LongArray?
+    private external fun nativeAddCounter(counter: Int, delta: Long)
+    private external fun nativeSetGauge(gauge: Int, value: Double)
+    private external fun nativeAddClientBytes(slot: Int, bytes: Long)
+    private external fun nativeSetClientLabel(slot: Int, label: String?)
+    private external fun nativeResetClient(slot: Int)
+    private external fun nativeReset(sides: Int)
+
+    @JvmStatic
+    fun record(stage: Int, nanos: Long) {
+        if (nativeLoaded) nativeRecord(stage, nanos)
+    }
+
+    /** Queued → written for one client; also feeds [STAGE_QUEUED_TO_WRITTEN]. */
+    @JvmStatic
+    fun recordClientWrite(slot: Int, nanos: Long) {
+        if (nativeLoaded) nativeRecordClientWrite(slot, nanos)
+    }
+
+    @JvmStatic
+    fun snapshot(stage: Int): Snapshot? =
+        if (nativeLoaded) nativeSnapshot(stage)?.toSnapshot() else null
+
+    @JvmStatic
+    fun snapshotClient(slot: Int): Snapshot? =
+        if (nativeLoaded) nativeSnapshotClient(slot)?.toSnapshot() else null
+
+    /** Count [frames] lost to [cause]; a client [slot] ≥ 0 also charges that client. */
+    @JvmStatic
+    fun recordDrop(cause: Int, frames: Long = 1L, slot: Int = -1) {
+        if (nativeLoaded && frames > 0) nativeRecordDrop(cause, slot, frames)
+    }
+
+    @JvmStatic
+    fun drops(): Drops? = if (nativeLoaded) nativeDrops(-1)?.let { Drops(it) } else null
+
+    @JvmStatic
+    fun dropsClient(slot: Int): Drops? =
+        if (nativeLoaded && slot >= 0) nativeDrops(slot)?.let { Drops(it) } else null
+
+    @JvmStatic
+    fun count(counter: Int, delta: Long = 1L) {
+        if (nativeLoaded) nativeAddCounter(counter, delta)
+    }
+
+    @JvmStatic
+    fun setGauge(gauge: Int, value: Double) {
+        if (nativeLoaded) nativeSetGauge(gauge, value)
+    }
+
+    /** Bytes written to one client; also feeds [BYTES_SENT]. */
+    @JvmStatic
+    fun addClientBytes(slot: Int, bytes: Long) {
+        if (nativeLoaded) nativeAddClientBytes(slot, bytes)
+    }
+
+    /** Peer label for the client's exported series; null or "" hides the slot. */
+    @JvmStatic
+    fun setClientLabel(slot: Int, label: String?) {
+        if (nativeLoaded && slot >= 0) nativeSetClientLabel(slot, label)
+    }
+
+    /** Clears the slot's write histogram, drop counters, bytes and label. */
+    @JvmStatic
+    fun resetClient(slot: Int) {
+        if (nativeLoaded) nativeResetClient(slot)
+    }
+
+    /**
+     * Clears one side's stages, drop causes, counters and gauges ([SIDE_SENDER] also clears the
+     * client slots), leaving the other side's alone when a sender and a viewer share the process.
+     */
+    @JvmStatic
+    fun reset(sides: Int) {
+        if (nativeLoaded) nativeReset(sides)
+    }
+
+    private fun LongArray.toSnapshot() = Snapshot(this[0], this[1], this[2], this[3], this[4], this[5])
+}
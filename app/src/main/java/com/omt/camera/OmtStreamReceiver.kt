@@ -44,6 +44,9 @@ class OmtStreamReceiver(
         private const val CODEC_FPA1 = 0x31415046 // "FPA1" — Float Planar Audio
         private const val CONNECT_TIMEOUT_MS = 5000
         private const val READ_TIMEOUT_MS = 5000
+        private const val CLOCK_SYNC_FAST_COUNT = 16 // first exchanges go out quickly to settle the offset
+        private const val CLOCK_SYNC_FAST_US = 100_000L
+        private const val CLOCK_SYNC_US = 1_000_000L
     }
 
     private val running = AtomicBoolean(false)
@@ -58,14 +61,19 @@ class OmtStreamReceiver(
 
     // Reusable decode buffers
     private var bgraBuf: ByteArray? = null
+    private var bgraBuffer: ByteBuffer? = null // wraps bgraBuf for copyPixelsFromBuffer
+    private var pcm16Buf: ShortArray? = null
     private var nv12YBuf: ByteArray? = null
     private var nv12UvBuf: ByteArray? = null
 
     // Triple-buffered bitmap pool: receive thread takes from pool, writes pixels,
     // sets pending. Render thread takes pending, draws it, returns to pool.
     // This guarantees no bitmap is ever read and written simultaneously.
-    private val bitmapPool = ConcurrentLinkedQueue<Bitmap>()
-    private val pendingBitmap = AtomicReference<Bitmap?>(null)
+    // Each pooled bitmap carries its decode time for the decoded → present histogram,
+    // and in latency mode the sender's capture stamp (µs, sender clock).
+    private class PooledFrame(var bitmap: Bitmap, var decodedAt: Long = 0L, var stampUs: Long = -1L)
+    private val bitmapPool = ConcurrentLinkedQueue<PooledFrame>()
+    private val pendingBitmap = AtomicReference<PooledFrame?>(null)
 
     // Audio playback
     private var audioTrack: AudioTrack? = null
@@ -80,8 +88,18 @@ class OmtStreamReceiver(
     private var lastWidth = 0
     private var lastHeight = 0
 
+    // Glass-to-glass measurement (debug.omt.latency=1)
+    @Volatile private var latencyMode = false
+    private var pendingMetaStamp = -1L
+    private var clockRequestsSent = 0
+    private var nextClockRequestUs = 0L
+
     fun start() {
         if (running.getAndSet(true)) return
+        OmtStats.reset(OmtStats.SIDE_RECEIVER)
+        latencyMode = OmtLatency.isModeEnabled()
+        if (latencyMode) OmtLatency.reset()
+        OmtMetrics.startIfConfigured()
         receiveThread = thread(name = "OmtReceive") { receiveLoop() }
         renderThread = thread(name = "OmtRender") { renderLoop() }
     }
@@ -91,11 +109,12 @@ class OmtStreamReceiver(
         socket?.closeQuietly()
         receiveThread?.join(3000); receiveThread = null
         renderThread?.join(1000); renderThread = null
+        OmtMetrics.stop()
         VmxDecoder.destroy(vmxHandle); vmxHandle = 0L
         audioTrack?.stop(); audioTrack?.release(); audioTrack = null
-        pendingBitmap.getAndSet(null)?.recycle()
-        var bmp = bitmapPool.poll()
-        while (bmp != null) { bmp.recycle(); bmp = bitmapPool.poll() }
+        pendingBitmap.getAndSet(null)?.let { it.bitmap.recycle() }
+        var frame = bitmapPool.poll()
+        while (frame != null) { frame.bitmap.recycle(); frame = bitmapPool.poll() }
     }
 
     /**
@@ -105,10 +124,18 @@ class OmtStreamReceiver(
     private fun renderLoop() {
         Process.setThreadPriority(Process.THREAD_PRIORITY_DISPLAY)
         while (running.get()) {
-            val bmp = pendingBitmap.getAndSet(null)
-            if (bmp != null) {
-                onFrame(bmp)
-                bitmapPool.offer(bmp) // return to pool after render is done
+            val frame = pendingBitmap.getAndSet(null)
+            if (frame != null) {
+                OmtStats.setGauge(OmtStats.GAUGE_VIEWER_PENDING, 0.0)
+                OmtTrace.begin(OmtTrace.PRESENT)
+                onFrame(frame.bitmap)
+                OmtTrace.end(OmtTrace.PRESENT)
+                OmtStats.record(OmtStats.STAGE_DECODED_TO_PRESENT, System.nanoTime() - frame.decodedAt)
+                if (frame.stampUs >= 0 && OmtLatency.clockValid())
+                    OmtLatency.record(OmtLatency.nowUs() + OmtLatency.clockOffsetUs() - frame.stampUs)
+                bitmapPool.offer(frame) // return to pool after render is done
+                OmtStats.count(OmtStats.FRAMES_PRESENTED)
+                OmtStats.setGauge(OmtStats.GAUGE_VIEWER_POOL, bitmapPool.size.toDouble())
                 fpsCount++
                 val now = System.nanoTime()
                 if (fpsLastTime == 0L) fpsLastTime = now
@@ -116,6 +143,17 @@ class OmtStreamReceiver(
                 if (elapsed >= 3_000_000_000L) {
                     val fps = fpsCount * 1_000_000_000.0 / elapsed
                     Log.i(TAG, "Viewer FPS: %.1f | ${lastWidth}x$lastHeight | $lastCodecName".format(fps))
+                    val decoded = OmtStats.snapshot(OmtStats.STAGE_RECEIVE_TO_DECODED)
+                    val presented = OmtStats.snapshot(OmtStats.STAGE_DECODED_TO_PRESENT)
+                    if (decoded != null && presented != null)
+                        Log.i(TAG, "Latency decode ${decoded.format()} | present ${presented.format()}")
+                    OmtStats.drops()?.get(OmtStats.DROP_RECEIVER_REPLACED)?.takeIf { it > 0 }?.let {
+                        Log.i(TAG, "Drops replaced=$it (decoded faster than drawn)")
+                    }
+                    if (latencyMode) OmtLatency.snapshot()?.takeIf { it.count > 0 }?.let {
+                        Log.i(TAG, "Glass-to-glass ${it.format()} | n=${it.count} offset=${OmtLatency.clockOffsetUs()}us rtt=${OmtLatency.clockRttUs()}us")
+                    }
+                    OmtStats.setGauge(OmtStats.GAUGE_FPS_PRESENTED, fps)
                     onStatus("%.0f FPS — ${lastWidth}x$lastHeight".format(fps))
                     fpsCount = 0; fpsLastTime = now
                 }
@@ -142,6 +180,8 @@ class OmtStreamReceiver(
             val input = DataInputStream(sock.getInputStream())
 
             sendMetadataFrame(output, "<OMTSubscribe Metadata=\"true\" />")
+            // Before subscribing, so a sender without VMX never sends this link a raw NV12 frame
+            if (OmtLz4.isAvailable()) sendMetadataFrame(output, OmtLz4.ACCEPT_XML)
             sendMetadataFrame(output, "<OMTSubscribe Video=\"true\" />")
             sendMetadataFrame(output, "<OMTSubscribe Audio=\"true\" />")
             sendMetadataFrame(output, "<OMTSettings Quality=\"Default\" />")
@@ -149,8 +189,10 @@ class OmtStreamReceiver(
             onStatus("Subscribed — waiting for video…")
 
             val headerBuf = ByteArray(OMT_HEADER_SIZE)
+            var data = ByteArray(256 * 1024) // grows to the largest frame seen; reused for every frame
             var unknownTypeLogCount = 0
             while (running.get() && sock.isConnected) {
+                if (latencyMode) maybeSendClockRequest(output)
                 input.readFully(headerBuf)
                 val version = headerBuf[0].toInt() and 0xFF
                 val frameType = headerBuf[1].toInt() and 0xFF
@@ -162,12 +204,17 @@ class OmtStreamReceiver(
                     continue
                 }
 
-                val data = ByteArray(dataLen)
-                input.readFully(data)
+                OmtTrace.begin(OmtTrace.RECEIVE, frameType.toLong())
+                try {
+                    if (data.size < dataLen) data = ByteArray(dataLen + dataLen / 4)
+                    input.readFully(data, 0, dataLen)
+                } finally { OmtTrace.end(OmtTrace.RECEIVE) }
+                val receivedAt = System.nanoTime()
+                OmtStats.count(OmtStats.BYTES_RECEIVED, (OMT_HEADER_SIZE + dataLen).toLong())
 
                 when (frameType) {
-                    OMT_FRAME_METADATA -> handleMetadata(data)
-                    OMT_FRAME_VIDEO -> handleVideoFrame(data, dataLen)
+                    OMT_FRAME_METADATA -> handleMetadata(data, dataLen, receivedAt)
+                    OMT_FRAME_VIDEO -> handleVideoFrame(data, dataLen, receivedAt)
                     OMT_FRAME_AUDIO -> try {
                         handleAudioFrame(data, dataLen)
                     } catch (e: Exception) {
@@ -192,46 +239,80 @@ class OmtStreamReceiver(
         }
     }
 
-    private fun handleMetadata(data: ByteArray) {
-        val len = data.indexOfFirst { it == 0.toByte() }.let { if (it < 0) data.size else it }
+    /** Clock exchanges ride on the receive thread, so they need no extra locking on [output]. */
+    private fun maybeSendClockRequest(output: OutputStream) {
+        val now = OmtLatency.nowUs()
+        if (now < nextClockRequestUs) return
+        OmtLatency.clockRequestXml(now)?.let { sendMetadataFrame(output, it) }
+        clockRequestsSent++
+        nextClockRequestUs = now + if (clockRequestsSent < CLOCK_SYNC_FAST_COUNT) CLOCK_SYNC_FAST_US else CLOCK_SYNC_US
+    }
+
+    private fun handleMetadata(data: ByteArray, dataLen: Int, receivedAt: Long) {
+        var len = 0
+        while (len < dataLen && data[len] != 0.toByte()) len++
         val text = String(data, 0, len, Charsets.UTF_8)
+        if (latencyMode) {
+            if (text.contains("OMTClockReply")) { OmtLatency.onClockReply(text, receivedAt / 1000); return }
+            if (text.contains("OMTLatencyStamp")) { pendingMetaStamp = OmtLatency.parseStamp(text); return }
+        }
         Log.d(TAG, "Metadata: ${text.take(120)}")
         if (text.contains("Tally", ignoreCase = true)) onStatus("Receiving from $host")
     }
 
-    private fun handleVideoFrame(data: ByteArray, dataLen: Int) {
+    private fun handleVideoFrame(data: ByteArray, dataLen: Int, receivedAt: Long) {
         if (dataLen < OMT_VIDEO_EXT_HEADER_SIZE) return
-        val buf = ByteBuffer.wrap(data, 0, OMT_VIDEO_EXT_HEADER_SIZE).order(ByteOrder.LITTLE_ENDIAN)
-        val codec = buf.int; val width = buf.int; val height = buf.int
+        OmtStats.count(OmtStats.FRAMES_RECEIVED)
+        val codec = readIntLE(data, 0); val width = readIntLE(data, 4); val height = readIntLE(data, 8)
         if (width <= 0 || height <= 0 || width > 7680 || height > 4320) return
         val payloadLen = dataLen - OMT_VIDEO_EXT_HEADER_SIZE
         if (payloadLen <= 0) return
 
         val bgraSize = width * height * 4
-        if (bgraBuf == null || bgraBuf!!.size != bgraSize) bgraBuf = ByteArray(bgraSize)
-
-        val decoded = when (codec) {
-            CODEC_VMX1 -> { lastCodecName = "VMX1"; decodeVmx(data, payloadLen, width, height) }
-            CODEC_NV12 -> { lastCodecName = "NV12"; decodeNv12(data, payloadLen, width, height) }
-            else -> { Log.w(TAG, "Unknown codec: 0x${Integer.toHexString(codec)}"); false }
+        if (bgraBuf == null || bgraBuf!!.size != bgraSize) {
+            bgraBuf = ByteArray(bgraSize)
+            bgraBuffer = ByteBuffer.wrap(bgraBuf!!)
         }
+
+        OmtTrace.begin(OmtTrace.DECODE)
+        val decoded = try {
+            when (codec) {
+                CODEC_VMX1 -> { lastCodecName = "VMX1"; decodeVmx(data, payloadLen, width, height) }
+                CODEC_NV12 -> { lastCodecName = "NV12"; decodeNv12(data, payloadLen, width, height) }
+                OmtLz4.CODEC_NVLZ -> { lastCodecName = "NVLZ"; decodeNvlz(data, payloadLen, width, height) }
+                else -> { Log.w(TAG, "Unknown codec: 0x${Integer.toHexString(codec)}"); false }
+            }
+        } finally { OmtTrace.end(OmtTrace.DECODE) }
         if (!decoded) return
         lastWidth = width; lastHeight = height
 
         // Get a bitmap from the pool (or create one). Pool guarantees no
         // other thread is using it — render returns bitmaps after drawing.
-        var bitmap = bitmapPool.poll()
-        if (bitmap == null || bitmap.width != width || bitmap.height != height) {
-            bitmap?.recycle()
-            bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        var frame = bitmapPool.poll()
+        if (frame == null) {
+            frame = PooledFrame(Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888))
+        } else if (frame.bitmap.width != width || frame.bitmap.height != height) {
+            frame.bitmap.recycle()
+            frame.bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
         }
-        val bb = ByteBuffer.wrap(bgraBuf!!)
+        val bb = bgraBuffer!!
         bb.rewind()
-        bitmap.copyPixelsFromBuffer(bb)
+        frame.bitmap.copyPixelsFromBuffer(bb)
+        frame.decodedAt = System.nanoTime()
+        // Prefer the pixel code (proves this exact picture); fall back to the preceding metadata stamp
+        frame.stampUs = if (latencyMode) {
+            OmtLatency.readRgba(bgraBuf!!, width, height).takeIf { it >= 0 } ?: pendingMetaStamp
+        } else -1L
+        pendingMetaStamp = -1L
+        OmtStats.record(OmtStats.STAGE_RECEIVE_TO_DECODED, frame.decodedAt - receivedAt)
 
         // Swap into pending; return old (skipped) pending to pool
-        val old = pendingBitmap.getAndSet(bitmap)
-        if (old != null) bitmapPool.offer(old)
+        val old = pendingBitmap.getAndSet(frame)
+        OmtStats.setGauge(OmtStats.GAUGE_VIEWER_PENDING, 1.0)
+        if (old != null) {
+            bitmapPool.offer(old)
+            OmtStats.recordDrop(OmtStats.DROP_RECEIVER_REPLACED)
+        }
     }
 
     // ---- Audio ----
@@ -241,13 +322,11 @@ class OmtStreamReceiver(
     private fun handleAudioFrame(data: ByteArray, dataLen: Int) {
         if (dataLen < OMT_AUDIO_EXT_HEADER_SIZE) return
 
-        val buf = ByteBuffer.wrap(data, 0, OMT_AUDIO_EXT_HEADER_SIZE).order(ByteOrder.LITTLE_ENDIAN)
-
-        val codec = buf.getInt(0)
-        val sampleRate = buf.getInt(4)
-        val field8 = buf.getInt(8)
-        val field12 = buf.getInt(12)
-        val field16 = buf.getInt(16)
+        val codec = readIntLE(data, 0)
+        val sampleRate = readIntLE(data, 4)
+        val field8 = readIntLE(data, 8)
+        val field12 = readIntLE(data, 12)
+        val field16 = readIntLE(data, 16)
 
         // Two header layouts exist:
         // Ours (camera): [codec, sampleRate, channels, bitsPerSample, samplesPerChannel, reserved]
@@ -288,28 +367,29 @@ class OmtStreamReceiver(
                 interleaved = FloatArray(totalSamples)
                 audioInterleavedBuf = interleaved
             }
-            val floatBuf = ByteBuffer.wrap(data, payloadOffset,
-                minOf(payloadLen, samplesPerCh * channels * 4))
-                .order(ByteOrder.LITTLE_ENDIAN)
+            // Samples past the end of a short payload play as silence
+            val floats = minOf(payloadLen, samplesPerCh * channels * 4) / 4
+            fun sample(n: Int): Float = if (n < floats) Float.fromBits(readIntLE(data, payloadOffset + n * 4)) else 0f
             if (channels >= 2) {
-                for (i in 0 until samplesPerCh) {
-                    interleaved[i * 2] = if (floatBuf.hasRemaining()) floatBuf.float else 0f
-                }
-                for (i in 0 until samplesPerCh) {
-                    interleaved[i * 2 + 1] = if (floatBuf.hasRemaining()) floatBuf.float else 0f
-                }
+                for (i in 0 until samplesPerCh) interleaved[i * 2] = sample(i)
+                for (i in 0 until samplesPerCh) interleaved[i * 2 + 1] = sample(samplesPerCh + i)
             } else {
-                for (i in 0 until samplesPerCh) {
-                    interleaved[i] = if (floatBuf.hasRemaining()) floatBuf.float else 0f
-                }
+                for (i in 0 until samplesPerCh) interleaved[i] = sample(i)
             }
             audioTrack?.write(interleaved, 0, totalSamples, AudioTrack.WRITE_NON_BLOCKING)
         } else if (bitsPerSample == 16) {
             val totalSamples = samplesPerCh * channels
-            val pcm16 = ShortArray(totalSamples.coerceAtMost(payloadLen / 2))
-            val bb = ByteBuffer.wrap(data, payloadOffset, pcm16.size * 2).order(ByteOrder.LITTLE_ENDIAN)
-            for (i in pcm16.indices) pcm16[i] = bb.short
-            audioTrack?.write(pcm16, 0, pcm16.size)
+            val count = totalSamples.coerceAtMost(payloadLen / 2)
+            var pcm16 = pcm16Buf
+            if (pcm16 == null || pcm16.size < count) {
+                pcm16 = ShortArray(count)
+                pcm16Buf = pcm16
+            }
+            for (i in 0 until count) {
+                val p = payloadOffset + i * 2
+                pcm16[i] = ((data[p].toInt() and 0xFF) or (data[p + 1].toInt() shl 8)).toShort()
+            }
+            audioTrack?.write(pcm16, 0, count)
         } else {
             if (audioLogCount <= 8) {
                 Log.w(TAG, "Audio: unsupported codec=0x${Integer.toHexString(codec)} bits=$bitsPerSample")
@@ -366,9 +446,7 @@ class OmtStreamReceiver(
             }
             Log.i(TAG, "VMX decoder created: ${width}x$height")
         }
-        val offset = OMT_VIDEO_EXT_HEADER_SIZE
-        val vmxBytes = ByteArray(len).also { System.arraycopy(data, offset, it, 0, len) }
-        return VmxDecoder.decodeFrame(vmxHandle, vmxBytes, len, bgraBuf!!, width, height)
+        return VmxDecoder.decodeFrame(vmxHandle, data, OMT_VIDEO_EXT_HEADER_SIZE, len, bgraBuf!!, width, height)
     }
 
     private fun decodeNv12(data: ByteArray, len: Int, width: Int, height: Int): Boolean {
@@ -383,6 +461,18 @@ class OmtStreamReceiver(
         return true
     }
 
+    private fun decodeNvlz(data: ByteArray, len: Int, width: Int, height: Int): Boolean {
+        val ySize = width * height; val uvSize = width * (height / 2)
+        if (nv12YBuf == null || nv12YBuf!!.size != ySize) nv12YBuf = ByteArray(ySize)
+        if (nv12UvBuf == null || nv12UvBuf!!.size != uvSize) nv12UvBuf = ByteArray(uvSize)
+        if (!OmtLz4.unpack(data, OMT_VIDEO_EXT_HEADER_SIZE, len, width, height, nv12YBuf!!, nv12UvBuf!!)) {
+            Log.w(TAG, "Corrupt NVLZ frame ${width}x$height ($len bytes)")
+            return false
+        }
+        VmxDecoder.nv12ToBgra(nv12YBuf!!, nv12UvBuf!!, bgraBuf!!, width, height)
+        return true
+    }
+
     // ---- Protocol helpers ----
 
     private fun sendMetadataFrame(output: OutputStream, xml: String) {
@@ -393,9 +483,11 @@ class OmtStreamReceiver(
         output.write(hdr.array()); output.write(payload); output.flush()
     }
 
-    private fun readIntLEAt12(buf: ByteArray): Int =
-        (buf[12].toInt() and 0xFF) or ((buf[13].toInt() and 0xFF) shl 8) or
-        ((buf[14].toInt() and 0xFF) shl 16) or ((buf[15].toInt() and 0xFF) shl 24)
+    private fun readIntLEAt12(buf: ByteArray): Int = readIntLE(buf, 12)
+
+    private fun readIntLE(buf: ByteArray, at: Int): Int =
+        (buf[at].toInt() and 0xFF) or ((buf[at + 1].toInt() and 0xFF) shl 8) or
+        ((buf[at + 2].toInt() and 0xFF) shl 16) or ((buf[at + 3].toInt() and 0xFF) shl 24)
 
     private fun skipBytes(input: DataInputStream, count: Int) {
         val skip = ByteArray(minOf(count, 8192))
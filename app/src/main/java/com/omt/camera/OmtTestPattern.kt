@@ -0,0 +1,57 @@
+package com.omt.camera
+
+import android.util.Log
+
+/**
+ * Synthetic test patterns sent in place of the camera, for lining up vMix and measuring
+ * the encoder. Enable with `adb shell setprop debug.omt.pattern zoneplate` (bars, zoneplate
+ * or ramp, optionally `:3840x2160`; default 1920x1080) before starting the stream.
+ *
+ * Frames are rendered natively (core/omt_pattern) straight into the sender's NV12 buffers,
+ * with the frame number in the bottom-left corner, and go through the same encode/send path
+ * as camera frames.
+ */
+object OmtTestPattern {
+    private const val TAG = "OmtTestPattern"
+
+    class Config(val kind: Int, val width: Int, val height: Int) {
+        val name: String get() = when (kind) { 0 -> "bars"; 1 -> "zoneplate"; else -> "ramp" }
+    }
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeConfigured(): IntArray?
+    private external fun nativeCreate(width: Int, height: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeRender(handle: Long, kind: Int, frame: Long, y: ByteArray, uv: ByteArray): Boolean
+
+    /** The pattern requested through debug.omt.pattern, or null for the camera. */
+    @JvmStatic
+    fun configured(): Config? {
+        if (!nativeLoaded) return null
+        val v = nativeConfigured() ?: return null
+        return Config(v[0], v[1], v[2])
+    }
+
+    @JvmStatic
+    fun create(width: Int, height: Int): Long = if (nativeLoaded) nativeCreate(width, height) else 0L
+
+    @JvmStatic
+    fun destroy(handle: Long) {
+        if (nativeLoaded && handle != 0L) nativeDestroy(handle)
+    }
+
+    /** Render [frame] into tightly packed NV12 planes of the size given to [create]. */
+    @JvmStatic
+    fun render(handle: Long, kind: Int, frame: Long, y: ByteArray, uv: ByteArray): Boolean =
+        nativeLoaded && handle != 0L && nativeRender(handle, kind, frame, y, uv)
+}
@@ -0,0 +1,89 @@
+package com.omt.camera
+
+import android.content.Context
+import android.util.Log
+import java.io.File
+
+/**
+ * Native span tracer for the frame pipeline (per-thread rings, fixed-size events).
+ * Off by default; enable with `adb shell setprop debug.omt.trace 1` before starting
+ * a session, or [setEnabled]. [dumpTo] writes Chrome trace JSON that opens in
+ * chrome://tracing or ui.perfetto.dev.
+ */
+object OmtTrace {
+    private const val TAG = "OmtTrace"
+
+    const val SEND_FRAME = 0
+    const val ENCODE = 1
+    const val CLIENT_WRITE = 2
+    const val RECEIVE = 3
+    const val DECODE = 4
+    const val PRESENT = 5
+
+    private var nativeLoaded = false
+
+    init {
+        try {
+            System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "omt_vmx_jni not loaded", e)
+        }
+    }
+
+    private external fun nativeIsEnabled(): Boolean
+    private external fun nativeSetEnabled(enabled: Boolean)
+    private external fun nativeBegin(nameId: Int, arg: Long)
+    private external fun nativeEnd(nameId: Int)
+    private external fun nativeInstant(nameId: Int, arg: Long)
+    private external fun nativeDump(path: String): Boolean
+    private external fun nativeClear()
+
+    @JvmStatic
+    fun isEnabled(): Boolean = nativeLoaded && nativeIsEnabled()
+
+    @JvmStatic
+    fun setEnabled(enabled: Boolean) {
+        if (nativeLoaded) nativeSetEnabled(enabled)
+    }
+
+    /** [arg] is exported as args.v (e.g. a client slot); negative values are omitted. */
+    @JvmStatic
+    fun begin(nameId: Int, arg: Long = -1L) {
+        if (nativeLoaded) nativeBegin(nameId, arg)
+    }
+
+    @JvmStatic
+    fun end(nameId: Int) {
+        if (nativeLoaded) nativeEnd(nameId)
+    }
+
+    @JvmStatic
+    fun instant(nameId: Int, arg: Long = -1L) {
+        if (nativeLoaded) nativeInstant(nameId, arg)
+    }
+
+    @JvmStatic
+    fun clear() {
+        if (nativeLoaded) nativeClear()
+    }
+
+    /**
+     * Dump the retained events to `omt-<label>-<time>.json` in the app's external files dir,
+     * then clear them so the next dump covers only the next session.
+     * Returns the file, or null when tracing is off or the write failed.
+     */
+    @JvmStatic
+    fun dumpTo(context: Context, label: String): File? {
+        if (!isEnabled()) return null
+        val dir = context.getExternalFilesDir(null) ?: context.filesDir
+        val file = File(dir, "omt-$label-${System.currentTimeMillis()}.json")
+        if (!nativeDump(file.absolutePath)) {
+            Log.w(TAG, "Trace dump failed: $file")
+            return null
+        }
+        nativeClear()
+        Log.i(TAG, "Trace written: $file")
+        return file
+    }
+}
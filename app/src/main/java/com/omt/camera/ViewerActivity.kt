@@ -234,6 +234,7 @@ class ViewerActivity : AppCompatActivity() {
     private fun disconnect() {
         receiver?.stop()
         receiver = null
+        OmtTrace.dumpTo(this, "viewer")
         runOnUiThread {
             setConnectedUI(false)
             window.clearFlags(WindowManager.LayoutParams.FLAG_KEEP_SCREEN_ON)
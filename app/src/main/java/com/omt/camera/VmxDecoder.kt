@@ -33,7 +33,7 @@ object VmxDecoder {
     private external fun nativeCreate(width: Int, height: Int, numThreads: Int): Long
     private external fun nativeDestroy(handle: Long)
     private external fun nativeDecodeFrame(
-        handle: Long, vmxData: ByteArray, dataLen: Int,
+        handle: Long, vmxData: ByteArray, dataOffset: Int, dataLen: Int,
         dstBGRA: ByteArray, width: Int, height: Int
     ): Boolean
     private external fun nativeNv12ToBgra(
@@ -53,14 +53,16 @@ object VmxDecoder {
 
     /**
      * Decode a VMX compressed frame into RGBA pixel array.
+     * The frame is read in place from [vmxData] at [dataOffset], so a receive buffer
+     * can be passed without copying the payload out.
      * [dstBGRA] must be at least width*height*4 bytes.
      * Returns true on success.
      */
     @JvmStatic
-    fun decodeFrame(handle: Long, vmxData: ByteArray, dataLen: Int,
+    fun decodeFrame(handle: Long, vmxData: ByteArray, dataOffset: Int, dataLen: Int,
                     dstBGRA: ByteArray, width: Int, height: Int): Boolean {
         if (handle == 0L) return false
-        return nativeDecodeFrame(handle, vmxData, dataLen, dstBGRA, width, height)
+        return nativeDecodeFrame(handle, vmxData, dataOffset, dataLen, dstBGRA, width, height)
     }
 
     /**
@@ -1,16 +1,19 @@
 package com.omt.camera
 
 import android.util.Log
+import java.nio.ByteBuffer
 
 object VmxEncoder {
     private const val TAG = "VmxEncoder"
 
     @Volatile
     private var available: Boolean? = null
+    private var nativeLoaded = false
 
     init {
         try {
             System.loadLibrary("omt_vmx_jni")
+            nativeLoaded = true
         } catch (e: UnsatisfiedLinkError) {
             Log.w(TAG, "omt_vmx_jni not loaded", e)
         }
@@ -31,6 +34,12 @@ object VmxEncoder {
         handle: Long, y: ByteArray, strideY: Int, uv: ByteArray, strideUV: Int,
         output: ByteArray, maxOutputLen: Int
     ): Int
+    private external fun nativePackNv12(
+        y: ByteBuffer, yRowStride: Int,
+        u: ByteBuffer, uRowStride: Int, uPixelStride: Int,
+        v: ByteBuffer, vRowStride: Int, vPixelStride: Int,
+        dstY: ByteArray, dstUV: ByteArray, width: Int, height: Int
+    ): Boolean
 
     @JvmStatic
     fun create(width: Int, height: Int, numThreads: Int = Runtime.getRuntime().availableProcessors()): Long {
@@ -58,4 +67,21 @@ object VmxEncoder {
         if (handle == 0L || !isAvailable()) return -1
         return nativeEncodeInto(handle, yArr, strideY, uvArr, strideUV, output, output.size)
     }
+
+    /**
+     * Pack YUV_420_888 planes into tightly packed NV12 ([dstY] + interleaved [dstUV]) natively.
+     * Does NOT require libvmx. Returns false if the JNI library is missing or the planes
+     * are not direct buffers; callers then fall back to the Kotlin copy.
+     */
+    @JvmStatic
+    fun packNv12(
+        y: ByteBuffer, yRowStride: Int,
+        u: ByteBuffer, uRowStride: Int, uPixelStride: Int,
+        v: ByteBuffer, vRowStride: Int, vPixelStride: Int,
+        dstY: ByteArray, dstUV: ByteArray, width: Int, height: Int
+    ): Boolean {
+        if (!nativeLoaded || !y.isDirect || !u.isDirect || !v.isDirect) return false
+        return nativePackNv12(y, yRowStride, u, uRowStride, uPixelStride,
+            v, vRowStride, vPixelStride, dstY, dstUV, width, height)
+    }
 }